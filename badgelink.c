@@ -5,14 +5,23 @@
 #include "badgelink.h"
 #include "assert.h"
 #include "badgelink_appfs.h"
+#include "badgelink_bench.h"
+#include "badgelink_digest.h"
 #include "badgelink_fs.h"
+#include "badgelink_histogram.h"
 #include "badgelink_internal.h"
 #include "badgelink_nvs.h"
 #include "badgelink_startapp.h"
+#include "badgelink_stats.h"
+#include "badgelink_storage.h"
+#include "badgelink_trace.h"
 #include "cobs.h"
-#include "esp_crc.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "lzf.h"
 #include "nvs_flash.h"
 #include "pb_decode.h"
 #include "pb_encode.h"
@@ -20,176 +29,863 @@
 
 // Default queue size if not configured via sdkconfig
 #ifndef CONFIG_BADGELINK_QUEUE_SIZE
-#define CONFIG_BADGELINK_QUEUE_SIZE 256
+#define CONFIG_BADGELINK_QUEUE_SIZE 8192
 #endif
 
-// Set to 1 to see raw bytes before/after COBS encoding/decoding.
-#ifndef DUMP_RAW_BYTES
-#define DUMP_RAW_BYTES 0
+// Default number of TX buffers if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_TX_BUFFERS
+#define CONFIG_BADGELINK_TX_BUFFERS 2
 #endif
 
-static char const TAG[] = "badgelink";
+// Default upload window if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_UPLOAD_WINDOW
+#define CONFIG_BADGELINK_UPLOAD_WINDOW 4
+#endif
 
-typedef struct {
-    uint8_t data[31];
-    uint8_t len;
-} fragment_t;
+// Default number of transports if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_MAX_TRANSPORTS
+#define CONFIG_BADGELINK_MAX_TRANSPORTS 3
+#endif
 
-static usb_callback_t usb_send_data_cb = NULL;
+// Default task stack size if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_TASK_STACK_SIZE
+#define CONFIG_BADGELINK_TASK_STACK_SIZE 8192
+#endif
+
+// Default task core if not configured via sdkconfig; -1 means any core
+#ifndef CONFIG_BADGELINK_TASK_CORE
+#define CONFIG_BADGELINK_TASK_CORE -1
+#endif
+#if CONFIG_BADGELINK_TASK_CORE < 0
+#define BADGELINK_TASK_CORE tskNO_AFFINITY
+#else
+#define BADGELINK_TASK_CORE CONFIG_BADGELINK_TASK_CORE
+#endif
+
+static char const TAG[] = "badgelink";
 
 // Badgelink packet singleton used for both the request and its response.
-badgelink_Packet badgelink_packet;
-// What the current file transfer is for.
-badgelink_xfer_t badgelink_xfer_type = BADGELINK_XFER_NONE;
-// Whether the current file transfer is host->badge.
-bool             badgelink_xfer_is_upload;
-// Current transfer position.
-uint32_t         badgelink_xfer_pos;
-// Transfer file size.
-uint32_t         badgelink_xfer_size;
-
-// Next serial number received must be larger mod 32.
-static uint32_t next_serial = 0;
-// Buffer for transmitted / received frames.
-// Frame refers here to the networking term, not the computer graphics term.
-static uint8_t  frame_buffer[BADGELINK_BUF_CAP];
+badgelink_Packet* badgelink_packet;
+// Transfers that are in progress, indexed by `BADGELINK_XFER_SLOT`.
+badgelink_xfer_state_t  badgelink_xfers[BADGELINK_XFER_SLOTS];
+// Transfer the current request is for, or NULL if it isn't for one.
+badgelink_xfer_state_t* badgelink_xfer;
+// Transfer that was started last, which transfer requests without a session ID are for.
+static badgelink_xfer_state_t* last_xfer;
+// Session ID of the last transfer that was started.
+static uint32_t last_session;
+// Maximum size of chunk data sent to the host, as negotiated with the version request.
+uint32_t         badgelink_chunk_size = BADGELINK_CHUNK_DATA_DEFAULT;
+// Buffer for compressing and decompressing chunks, only allocated once a host negotiates compression.
+// Holds the hash table of the compressor, followed by room for the uncompressed and the compressed data of a chunk.
+static uint8_t*  lzf_buffer;
+#define LZF_BUFFER_HTAB_SIZE (LZF_HTAB_SIZE * sizeof(uint16_t))
+#define LZF_BUFFER_SIZE      (LZF_BUFFER_HTAB_SIZE + 2 * BADGELINK_CHUNK_DATA_MAX)
+
+// A link to a host, like USB, a UART or a TCP connection; each has its own frames and session.
+struct badgelink_transport {
+    // Sends data to the host.
+    usb_callback_t        send;
+    // Waits for sent data to have left the device, if the transport can tell.
+    flush_callback_t      flush;
+    // Starts sending data to the host without waiting for it, if the transport can.
+    async_send_callback_t async_send;
+    // Stream buffer that sends received data over to the BadgeLink thread.
+    StreamBufferHandle_t  rxstream;
+    // Buffer for received frames.
+    // Frame refers here to the networking term, not the computer graphics term.
+    uint8_t*              frame_buffer;
+    // Amount of received data in the frame buffer.
+    // The decoded frame is written to the start of the same buffer, which never overtakes the received data.
+    size_t                rxbuf_len;
+    // Decoder for the frame being received.
+    cobs_decoder_t        decoder;
+    // Microseconds spent COBS-decoding the frame being received so far.
+    uint32_t              cobs_us;
+    // Next serial number received must be larger mod 32.
+    uint32_t              next_serial;
+    // Bit n is set if serial number `next_serial - 1 - n` was handled.
+    // Lets a request that arrives after a later one was handled through, but not a retransmission.
+    uint32_t              seen;
+    // Negotiated protocol version (defaults to 1 for backwards compatibility).
+    uint16_t              version;
+    // Maximum size of chunk data sent to the host.
+    uint32_t              chunk_size;
+    // Whether the host negotiated compressed chunks.
+    bool                  compress;
+    // Digest the host negotiated for transfers.
+    badgelink_DigestType  digest;
+    // Task waiting in `badgelink_transport_reset` for the BadgeLink thread to reset the transport, if any.
+    volatile TaskHandle_t resetter;
+};
+
+// Transports that were added; the first is the one `badgelink_start` sets up.
+static badgelink_transport_t  transports[CONFIG_BADGELINK_MAX_TRANSPORTS];
+// Number of transports that were added, which is at least 1.
+static volatile size_t        transport_count = 1;
+// Transport of the request being handled, or of the last one that was.
+static badgelink_transport_t* transport = &transports[0];
+// Heap capabilities the frame buffers are allocated with.
+static uint32_t               frame_buffer_caps;
+
+// Buffer for a frame to be transmitted.
+typedef struct tx_frame {
+    // Transport to send the frame over.
+    badgelink_transport_t* transport;
+    // Next frame passed to the same asynchronous send, which completes along with this one.
+    struct tx_frame*       next;
+    // When the frame was passed to an asynchronous send.
+    int64_t                sent_at;
+    size_t                 len;
+    uint8_t                data[BADGELINK_BUF_CAP];
+} tx_frame_t;
+// Buffers for transmitted frames, so the next response can be encoded while the previous one is being sent.
+static tx_frame_t* tx_frames;
 
 // Protocol version constants.
-#define BADGELINK_PROTOCOL_VERSION 3
-// Negotiated protocol version (defaults to 1 for backwards compatibility).
-static uint16_t negotiated_version = 1;
+#define BADGELINK_PROTOCOL_VERSION 7
 
-// Queue that sends received data over to the BadgeLink thread.
-static QueueHandle_t rxqueue;
+// Given whenever a transport receives data, to wake up the BadgeLink thread.
+static SemaphoreHandle_t rxready;
+// Queue of filled TX buffers waiting to be sent by the TX thread.
+static QueueHandle_t txqueue;
+// Queue of TX buffers that have been sent and can be reused.
+static QueueHandle_t txfree;
 // Handle to the BadgeLink thread.
 static TaskHandle_t  badgelink_thread_handle;
+// Handle to the BadgeLink TX thread.
+static TaskHandle_t  badgelink_tx_thread_handle;
+// Given by each of the BadgeLink threads when it exits.
+static SemaphoreHandle_t stopped;
+// Tells the BadgeLink thread to exit.
+static volatile bool     stopping;
+// Whether the service was started by `badgelink_start_lazy`.
+static volatile bool     lazy;
+// Time without received data after which a lazily started service frees its resources.
+static TickType_t        lazy_idle_ticks;
+// Heap capabilities to allocate the buffers of a lazily started service with.
+static uint32_t          lazy_frame_caps, lazy_packet_caps;
+// Held while a lazily started service is being started or stopped, or is being sent data.
+static SemaphoreHandle_t lazy_lock;
 // Main function for the BadgeLink thread.
 static void          badgelink_thread_main(void*);
+// Main function for the BadgeLink TX thread.
+static void          badgelink_tx_thread_main(void*);
+
+// Allocate the buffers of a transport.
+// Returns false if there is not enough memory.
+static bool transport_alloc(badgelink_transport_t* t) {
+    t->frame_buffer = heap_caps_malloc(BADGELINK_BUF_CAP, frame_buffer_caps);
+    t->rxstream     = xStreamBufferCreate(CONFIG_BADGELINK_QUEUE_SIZE, 1);
+    t->rxbuf_len    = 0;
+    cobs_decoder_init(&t->decoder, t->frame_buffer, BADGELINK_BUF_CAP);
+    return t->frame_buffer && t->rxstream;
+}
+
+// Free the buffers of a transport.
+static void transport_free(badgelink_transport_t* t) {
+    if (t->rxstream) {
+        vStreamBufferDelete(t->rxstream);
+    }
+    heap_caps_free(t->frame_buffer);
+    t->rxstream     = NULL;
+    t->frame_buffer = NULL;
+}
+
+// Free everything `badgelink_init_with_caps` allocated.
+static void badgelink_free() {
+    for (size_t i = 0; i < transport_count; i++) {
+        transport_free(&transports[i]);
+    }
+    if (rxready) {
+        vSemaphoreDelete(rxready);
+    }
+    if (txqueue) {
+        vQueueDelete(txqueue);
+    }
+    if (txfree) {
+        vQueueDelete(txfree);
+    }
+    if (stopped) {
+        vSemaphoreDelete(stopped);
+    }
+    heap_caps_free(tx_frames);
+    heap_caps_free(badgelink_packet);
+    heap_caps_free(lzf_buffer);
+    rxready          = NULL;
+    txqueue          = NULL;
+    txfree           = NULL;
+    stopped          = NULL;
+    tx_frames        = NULL;
+    badgelink_packet = NULL;
+    lzf_buffer       = NULL;
+}
 
 // Prepare the data for the BadgeLink service to start.
-void badgelink_init() {
-    rxqueue = xQueueCreate(CONFIG_BADGELINK_QUEUE_SIZE, sizeof(fragment_t));
+// Returns false if there is not enough memory.
+bool badgelink_init() {
+    return badgelink_init_with_caps(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT);
+}
+
+// Prepare the data for the BadgeLink service to start, allocating the RX and TX frame buffers with `frame_caps`
+// and the packet with `packet_caps`.
+// Returns false if there is not enough memory.
+bool badgelink_init_with_caps(uint32_t frame_caps, uint32_t packet_caps) {
+    frame_buffer_caps = frame_caps;
+    tx_frames         = heap_caps_malloc(CONFIG_BADGELINK_TX_BUFFERS * sizeof(tx_frame_t), frame_caps);
+    badgelink_packet  = heap_caps_calloc(1, sizeof(badgelink_Packet), packet_caps);
+    rxready           = xSemaphoreCreateBinary();
+    txqueue           = xQueueCreate(CONFIG_BADGELINK_TX_BUFFERS, sizeof(tx_frame_t*));
+    txfree            = xQueueCreate(CONFIG_BADGELINK_TX_BUFFERS, sizeof(tx_frame_t*));
+    stopped           = xSemaphoreCreateCounting(2, 0);
+    bool ok           = tx_frames && badgelink_packet && rxready && txqueue && txfree && stopped;
+    for (size_t i = 0; ok && i < transport_count; i++) {
+        ok = transport_alloc(&transports[i]);
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Out of memory");
+        badgelink_free();
+        return false;
+    }
+
+    for (size_t i = 0; i < CONFIG_BADGELINK_TX_BUFFERS; i++) {
+        tx_frame_t* frame = &tx_frames[i];
+        xQueueSend(txfree, &frame, 0);
+    }
+    return true;
+}
+
+// Free the compression buffer once no transport uses compressed chunks anymore.
+static void lzf_release() {
+    for (size_t i = 0; i < transport_count; i++) {
+        if (transports[i].compress) {
+            return;
+        }
+    }
+    heap_caps_free(lzf_buffer);
+    lzf_buffer = NULL;
+}
+
+// Reset the session state of a transport for a new connection.
+static void reset_session(badgelink_transport_t* t) {
+    t->next_serial = 0;
+    t->seen        = 0;
+    t->version     = 1;
+    t->chunk_size  = BADGELINK_CHUNK_DATA_DEFAULT;
+    t->compress    = false;
+    t->digest      = badgelink_DigestType_DigestNone;
+    lzf_release();
+    // Another transport may be in the middle of a listing or trace dump of its own.
+    badgelink_nvs_release_cursor_of(t);
+    badgelink_fs_release_cursor_of(t);
+    badgelink_trace_resume(t);
+}
+
+// Make `t` the transport of the request being handled, switching to its negotiated session.
+static void use_transport(badgelink_transport_t* t) {
+    transport            = t;
+    badgelink_chunk_size = t->chunk_size;
+    badgelink_digest_negotiate(t->digest);
+}
+
+// Start the BadgeLink threads.
+static void start_threads() {
+    stopping = false;
+    xTaskCreatePinnedToCore(
+        badgelink_tx_thread_main, "BadgeLinkTX", 4096, NULL, CONFIG_BADGELINK_TASK_PRIORITY,
+        &badgelink_tx_thread_handle, BADGELINK_TASK_CORE
+    );
+    xTaskCreatePinnedToCore(
+        badgelink_thread_main, "BadgeLink", CONFIG_BADGELINK_TASK_STACK_SIZE, NULL, CONFIG_BADGELINK_TASK_PRIORITY,
+        &badgelink_thread_handle, BADGELINK_TASK_CORE
+    );
+}
+
+// Raise the priority of the BadgeLink threads while a transfer is in progress, if configured to.
+static void update_priority() {
+#if BADGELINK_XFER_TASK_PRIORITY > CONFIG_BADGELINK_TASK_PRIORITY
+    // The storage workers only run during their transfer, so they start out at the raised priority instead.
+    UBaseType_t prio = CONFIG_BADGELINK_TASK_PRIORITY;
+    for (size_t i = 0; i < BADGELINK_XFER_SLOTS; i++) {
+        if (badgelink_xfers[i].type != BADGELINK_XFER_NONE) {
+            prio = BADGELINK_XFER_TASK_PRIORITY;
+        }
+    }
+    if (uxTaskPriorityGet(NULL) != prio) {
+        vTaskPrioritySet(NULL, prio);
+        vTaskPrioritySet(badgelink_tx_thread_handle, prio);
+    }
+#endif
 }
 
 // Start the badgelink service.
 void badgelink_start(usb_callback_t usb_callback) {
-    usb_send_data_cb = usb_callback;
-    xTaskCreate(badgelink_thread_main, "BadgeLink", 8192, NULL, 0, &badgelink_thread_handle);
+    transports[0].send = usb_callback;
+    for (size_t i = 0; i < transport_count; i++) {
+        reset_session(&transports[i]);
+    }
+    badgelink_digest_reset();
+    start_threads();
+}
+
+// Start the badgelink service lazily, allocating its buffers and starting its threads once data is received.
+// Returns false if there is not enough memory.
+bool badgelink_start_lazy(usb_callback_t usb_callback, uint32_t idle_timeout_ms, uint32_t frame_caps,
+                          uint32_t packet_caps) {
+    if (!lazy_lock) {
+        lazy_lock = xSemaphoreCreateMutex();
+        if (!lazy_lock) {
+            return false;
+        }
+    }
+    transports[0].send = usb_callback;
+    lazy_idle_ticks    = pdMS_TO_TICKS(idle_timeout_ms);
+    lazy_frame_caps    = frame_caps;
+    lazy_packet_caps   = packet_caps;
+    for (size_t i = 0; i < transport_count; i++) {
+        reset_session(&transports[i]);
+    }
+    badgelink_digest_reset();
+    lazy = true;
+    return true;
+}
+
+// Add another transport the badgelink service can be reached over, which sends data with `send`.
+// Returns NULL if there is not enough memory or `CONFIG_BADGELINK_MAX_TRANSPORTS` were added already.
+badgelink_transport_t* badgelink_add_transport(usb_callback_t send) {
+    if (lazy) {
+        xSemaphoreTake(lazy_lock, portMAX_DELAY);
+    }
+    badgelink_transport_t* t = NULL;
+    if (transport_count < CONFIG_BADGELINK_MAX_TRANSPORTS) {
+        t       = &transports[transport_count];
+        t->send = send;
+        reset_session(t);
+        // Without buffers, the service isn't running; they're allocated along with the rest when it starts.
+        if (badgelink_packet && !transport_alloc(t)) {
+            ESP_LOGE(TAG, "Out of memory");
+            transport_free(t);
+            t = NULL;
+        } else {
+            // Only handed to the BadgeLink thread once it is ready to be used.
+            transport_count++;
+        }
+    }
+    if (lazy) {
+        xSemaphoreGive(lazy_lock);
+    }
+    return t;
+}
+
+// Set the callback that waits for data sent over the transport of `badgelink_start` to have left the device.
+void badgelink_set_flush_callback(flush_callback_t flush) {
+    transports[0].flush = flush;
+}
+
+// Set the callback that waits for data sent over `t` to have left the device.
+void badgelink_transport_set_flush_callback(badgelink_transport_t* t, flush_callback_t flush) {
+    t->flush = flush;
+}
+
+// Set the callback that starts sending data over the transport of `badgelink_start` without waiting for it.
+void badgelink_set_async_send_callback(async_send_callback_t send) {
+    transports[0].async_send = send;
 }
 
+// Set the callback that starts sending data over `t` without waiting for it.
+void badgelink_transport_set_async_send_callback(badgelink_transport_t* t, async_send_callback_t send) {
+    t->async_send = send;
+}
+
+// Stop the badgelink service and free everything `badgelink_init` allocated.
+void badgelink_stop() {
+    if (lazy) {
+        // Keep received data from starting it again; it may also have stopped on its own already.
+        xSemaphoreTake(lazy_lock, portMAX_DELAY);
+        lazy         = false;
+        bool running = badgelink_packet != NULL;
+        xSemaphoreGive(lazy_lock);
+        if (!running) {
+            return;
+        }
+    }
+
+    // The BadgeLink thread checks for this whenever it wakes up, so wake it up in case it is waiting for data.
+    stopping = true;
+    xSemaphoreGive(rxready);
+    xSemaphoreTake(stopped, portMAX_DELAY);
+
+    // The TX thread exits on a NULL frame, after sending the frames queued before it.
+    tx_frame_t* end = NULL;
+    xQueueSend(txqueue, &end, portMAX_DELAY);
+    xSemaphoreTake(stopped, portMAX_DELAY);
+
+    badgelink_free();
+}
+
+// Wait until all frames queued for transmission have been sent.
+void badgelink_tx_flush() {
+    // Take every TX buffer, which is only possible once the TX thread has released them all.
+    tx_frame_t* frames[CONFIG_BADGELINK_TX_BUFFERS];
+    for (size_t i = 0; i < CONFIG_BADGELINK_TX_BUFFERS; i++) {
+        xQueueReceive(txfree, &frames[i], portMAX_DELAY);
+    }
+    for (size_t i = 0; i < CONFIG_BADGELINK_TX_BUFFERS; i++) {
+        xQueueSend(txfree, &frames[i], 0);
+    }
+}
+
+// Wait until all frames queued for transmission have been sent and have left the device over the current transport.
+// Returns false if the transport can't tell, or they didn't leave within `timeout_ms` milliseconds.
+bool badgelink_tx_drain(uint32_t timeout_ms) {
+    badgelink_tx_flush();
+    return transport->flush && transport->flush(timeout_ms);
+}
+
+#ifndef CONFIG_BADGELINK_APPFS
+// Without AppFS requests, no CRC32s of apps are remembered.
+void badgelink_appfs_changed() {
+}
+#endif
+
+// Encode or decode a `badgelink_chunk_data_t` field without copying the data into the packet.
+bool badgelink_data_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    badgelink_chunk_data_t* data = field->pData;
+
+    if (istream) {
+        // Frames are always decoded from a buffer, so the data can be used right where it is.
+        if (istream->bytes_left > BADGELINK_CHUNK_DATA_MAX) {
+            PB_RETURN_ERROR(istream, "bytes overflow");
+        }
+        data->bytes = istream->state;
+        data->size  = istream->bytes_left;
+        data->read  = NULL;
+        if (PB_HTYPE(field->type) == PB_HTYPE_ONEOF) {
+            // nanopb leaves marking callback fields in a oneof as present to the callback.
+            *(pb_size_t*)field->pSize = field->tag;
+        }
+        return pb_read(istream, NULL, istream->bytes_left);
+    }
+
+    if (data->size == 0 && PB_HTYPE(field->type) != PB_HTYPE_ONEOF) {
+        // Empty bytes fields are not encoded in proto3.
+        return true;
+    }
+    if (data->read == NULL) {
+        return pb_encode_tag_for_field(ostream, field) && pb_encode_string(ostream, data->bytes, data->size);
+    }
+
+    if (!pb_encode_tag_for_field(ostream, field) || !pb_encode_varint(ostream, data->size)) {
+        return false;
+    }
+    if (ostream->callback == NULL) {
+        // Only calculating the size.
+        ostream->bytes_written += data->size;
+        return true;
+    }
+    // Packets are always encoded into a buffer, so read the data straight to where it belongs in the frame.
+    if (ostream->bytes_written + data->size > ostream->max_size) {
+        PB_RETURN_ERROR(ostream, "stream full");
+    }
+    if (!data->read(ostream->state, data->size)) {
+        PB_RETURN_ERROR(ostream, "chunk read failed");
+    }
+    ostream->state          = (pb_byte_t*)ostream->state + data->size;
+    ostream->bytes_written += data->size;
+    return true;
+}
+
+// Encode or decode the data of a chunk without copying it into the packet.
+bool badgelink_Chunk_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_Chunk_data_tag) {
+        return true;
+    }
+    return badgelink_data_callback(istream, ostream, field);
+}
+
+// Encode the sector CRC32s that `badgelink_appfs_sector_crc32` or `badgelink_fs_sector_crc32` stored in the arena as
+// packed fixed32s.
+bool badgelink_AppfsSectorCrcs_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_AppfsSectorCrcs_crc32_tag) {
+        return true;
+    }
+    if (istream) {
+        // Sector CRC32s are only ever sent by the badge.
+        return pb_read(istream, NULL, istream->bytes_left);
+    }
+
+    badgelink_list_arena_t const* list = field->pData;
+    if (list->len == 0) {
+        return true;
+    }
+    if (!pb_encode_tag(ostream, PB_WT_STRING, field->tag) || !pb_encode_varint(ostream, list->len)) {
+        return false;
+    }
+    for (size_t pos = 0; pos < list->len; pos += sizeof(uint32_t)) {
+        uint32_t crc;
+        memcpy(&crc, list->arena + pos, sizeof(crc));
+        if (!pb_encode_fixed32(ostream, &crc)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if !defined(CONFIG_BADGELINK_FS) || !defined(CONFIG_BADGELINK_NVS) || !defined(CONFIG_BADGELINK_BENCH)
+// Skip the data of a callback field of a request that isn't built; it is decoded before the request is unsupported.
+static bool skip_callback(pb_istream_t* istream) {
+    return !istream || pb_read(istream, NULL, istream->bytes_left);
+}
+#endif
+
+#ifndef CONFIG_BADGELINK_FS
+bool badgelink_FsDirentList_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+
+bool badgelink_FsStatManyReq_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+
+bool badgelink_FsStatManyResp_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+#endif
+
+#ifndef CONFIG_BADGELINK_NVS
+bool badgelink_NvsValue_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+
+bool badgelink_NvsEntriesList_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+#endif
+
+#ifndef CONFIG_BADGELINK_BENCH
+bool badgelink_EchoReq_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+
+bool badgelink_EchoResp_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    return skip_callback(istream);
+}
+#endif
+
 // Encode and send a packet.
-void badgelink_send_packet() {
+// Returns false if the packet could not be encoded, which for a chunk means the data could not be read.
+bool badgelink_send_packet() {
+    // From version 5, responses say which transfer they are for, since several can be in progress.
+    if (badgelink_packet->which_packet == badgelink_Packet_response_tag) {
+        badgelink_packet->packet.response.session =
+            transport->version >= 5 && badgelink_xfer ? badgelink_xfer->session : 0;
+    }
+    int64_t start = badgelink_stats_now();
+
     // Allocate memory to encode the packet.
     size_t packed_len;
-    bool   encodable = pb_get_encoded_size(&packed_len, &badgelink_Packet_msg, &badgelink_packet);
+    bool   encodable = pb_get_encoded_size(&packed_len, &badgelink_Packet_msg, badgelink_packet);
     if (!encodable) {
         ESP_LOGE(TAG, "[BUG] Packet is not encodable");
-        return;
+        return false;
     }
     size_t encoded_len = COBS_ENCODED_MAX_LENGTH(packed_len + 4);
     if (encoded_len >= BADGELINK_BUF_CAP) {
         ESP_LOGE(TAG, "[BUG] Too much data to send");
-        return;
+        return false;
     }
 
+    // Wait for a TX buffer to be freed by the TX thread.
+    tx_frame_t* frame;
+    xQueueReceive(txfree, &frame, portMAX_DELAY);
+    uint8_t* tx_buffer = frame->data;
+
     // Offset the data to be packed so it's placed at the end of the buffer.
     // This is needed so that the COBS encode doesn't overwrite any of the data before it's processed.
-    size_t offset = BADGELINK_BUF_CAP - packed_len - 4;
+    size_t offset = BADGELINK_BUF_CAP - packed_len;
 
-    // Encode packet and add CRC32 checksum.
-    pb_ostream_t encode_stream = pb_ostream_from_buffer(frame_buffer + offset, packed_len);
-    pb_encode(&encode_stream, &badgelink_Packet_msg, &badgelink_packet);
-    uint32_t crc                          = esp_crc32_le(0, frame_buffer + offset, packed_len);
-    frame_buffer[packed_len + offset]     = crc;
-    frame_buffer[packed_len + offset + 1] = crc >> 8;
-    frame_buffer[packed_len + offset + 2] = crc >> 16;
-    frame_buffer[packed_len + offset + 3] = crc >> 24;
-
-#if DUMP_RAW_BYTES
-    printf("Response:");
-    for (size_t i = 0; i < packed_len + 4; i++) {
-        printf(" %02x", frame_buffer[i + offset]);
+    // Encode packet.
+    pb_ostream_t encode_stream = pb_ostream_from_buffer(tx_buffer + offset, packed_len);
+    if (!pb_encode(&encode_stream, &badgelink_Packet_msg, badgelink_packet)) {
+        ESP_LOGE(TAG, "Failed to encode packet: %s", PB_GET_ERROR(&encode_stream));
+        xQueueSend(txfree, &frame, 0);
+        return false;
     }
-    printf("\n");
-#endif
 
-    // COBS-encode the buffer for sending.
-    encoded_len = cobs_encode(frame_buffer, frame_buffer + offset, packed_len + 4);
+    // COBS-encode the buffer for sending, computing and adding the CRC32 checksum in the same pass.
+    cobs_encoder_t encoder;
+    cobs_encoder_init(&encoder, tx_buffer);
+    cobs_encoder_write(&encoder, tx_buffer + offset, packed_len);
+    encoded_len = cobs_encoder_finish(&encoder);
 
-#if DUMP_RAW_BYTES
-    printf("Encoded:");
-    for (size_t i = 0; i < encoded_len; i++) {
-        printf(" %02x", frame_buffer[i]);
-    }
-    printf("\n");
-#endif
+    uint64_t encode_us         = badgelink_stats_since(start);
+    badgelink_stats.encode_us += encode_us;
+    badgelink_histogram_record(badgelink_HistogramStage_StageEncode, 0, encode_us);
+    badgelink_stats.frames_tx++;
+    badgelink_stats.bytes_tx += encoded_len;
+    badgelink_trace(badgelink_TraceEventType_TraceTxQueued, encoded_len);
 
-    // Send the raw frame.
-    if (usb_send_data_cb != NULL) {
-        usb_send_data_cb(frame_buffer, encoded_len);
-    }
+    // Hand the frame over to the TX thread, which sends it over the transport the request came from.
+    frame->transport = transport;
+    frame->len       = encoded_len;
+    xQueueSend(txqueue, &frame, portMAX_DELAY);
+    return true;
 }
 
 // Send a status response packet.
 void badgelink_send_status(badgelink_StatusCode code) {
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.which_resp  = 0;
-    badgelink_packet.packet.response.status_code = code;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.which_resp  = 0;
+    badgelink_packet->packet.response.status_code = code;
     badgelink_send_packet();
 }
 
+// Get the transport of the request being handled.
+badgelink_transport_t* badgelink_request_transport() {
+    return transport;
+}
+
 // Get the negotiated protocol version.
 uint16_t badgelink_get_protocol_version() {
-    return negotiated_version;
+    return transport->version;
 }
 
-// Handle a version negotiation request.
-static void handle_version_req() {
-    badgelink_VersionReq* req = &badgelink_packet.packet.request.req.version_req;
-    uint16_t client_version   = req->client_version;
+// Number of upload chunks the host may have in flight.
+// Limited to what the RX buffer can hold next to the chunk that is being handled.
+static uint32_t upload_window() {
+    uint32_t max_window = 1 + CONFIG_BADGELINK_QUEUE_SIZE / BADGELINK_BUF_CAP;
+    return CONFIG_BADGELINK_UPLOAD_WINDOW < max_window ? CONFIG_BADGELINK_UPLOAD_WINDOW : max_window;
+}
+
+// Bitmap of `badgelink_Capability` values of what this build can do besides what its protocol version says.
+static uint32_t capabilities() {
+    uint32_t caps = 0;
+#ifdef CONFIG_BADGELINK_FS
+    caps |= badgelink_Capability_CapFs | badgelink_Capability_CapTreeUpload | badgelink_Capability_CapFsStatMany;
+#endif
+#ifdef CONFIG_BADGELINK_APPFS
+    caps |= badgelink_Capability_CapAppfs;
+#endif
+#if defined(CONFIG_BADGELINK_FS) || defined(CONFIG_BADGELINK_APPFS)
+    caps |= badgelink_Capability_CapDelta | badgelink_Capability_CapResumable;
+#endif
+#ifdef CONFIG_BADGELINK_NVS
+    caps |= badgelink_Capability_CapNvs | badgelink_Capability_CapNvsBatch | badgelink_Capability_CapNvsSnapshot;
+#endif
+#ifdef CONFIG_BADGELINK_STARTAPP
+    caps |= badgelink_Capability_CapStartApp;
+#endif
+#ifdef CONFIG_BADGELINK_BENCH
+    caps |= badgelink_Capability_CapBench;
+#endif
+#ifdef CONFIG_BADGELINK_TRACE
+    caps |= badgelink_Capability_CapTrace;
+#endif
+#ifdef CONFIG_BADGELINK_HISTOGRAMS
+    caps |= badgelink_Capability_CapHistograms;
+#endif
+    return caps;
+}
+
+// Negotiate the protocol version and what comes with it for the current transport and fill in `resp`.
+static void negotiate(badgelink_VersionReq const* req, badgelink_VersionResp* resp) {
+    uint16_t client_version = req->client_version;
 
     // Negotiate: use the lower of client and server versions.
     uint16_t negotiated = client_version < BADGELINK_PROTOCOL_VERSION ? client_version : BADGELINK_PROTOCOL_VERSION;
-    negotiated_version  = negotiated;
+    transport->version  = negotiated;
+
+    // Send chunks as large as both sides can handle; clients that don't say can handle what older badges sent.
+    uint32_t client_chunk = req->max_chunk_size ? req->max_chunk_size : 4096;
+    transport->chunk_size = client_chunk < BADGELINK_CHUNK_DATA_MAX ? client_chunk : BADGELINK_CHUNK_DATA_MAX;
+    badgelink_chunk_size  = transport->chunk_size;
+
+    // Compress chunks if the client can; the buffer for it only exists while it's used.
+    badgelink_ChunkCompression compression = badgelink_ChunkCompression_CompressionNone;
+    if (req->compression == badgelink_ChunkCompression_CompressionLzf) {
+        if (!lzf_buffer) {
+            lzf_buffer = heap_caps_malloc(LZF_BUFFER_SIZE, MALLOC_CAP_DEFAULT);
+        }
+        if (lzf_buffer) {
+            compression = badgelink_ChunkCompression_CompressionLzf;
+        } else {
+            ESP_LOGW(TAG, "Out of memory; not compressing chunks");
+        }
+    }
+    transport->compress = compression == badgelink_ChunkCompression_CompressionLzf;
+    lzf_release();
+
+    // Transfers get a SHA-256 if the client wants one; it comes with the final response, which v1 doesn't have.
+    badgelink_DigestType digest =
+        badgelink_digest_negotiate(negotiated >= 2 ? req->digest : badgelink_DigestType_DigestNone);
+    transport->digest = digest;
 
     ESP_LOGI(TAG, "Version negotiation: client=%u, server=%u, negotiated=%u", client_version,
              BADGELINK_PROTOCOL_VERSION, negotiated);
 
+    *resp = (badgelink_VersionResp){
+        .server_version     = BADGELINK_PROTOCOL_VERSION,
+        .negotiated_version = negotiated,
+        .upload_window      = negotiated >= 4 ? upload_window() : 1,
+        .chunk_size         = badgelink_chunk_size,
+        .compression        = compression,
+        .digest             = digest,
+        .capabilities       = capabilities(),
+    };
+}
+
+// Handle a version negotiation request.
+static void handle_version_req() {
+    badgelink_VersionReq req = badgelink_packet->packet.request.req.version_req;
+
     // Send response with server version and negotiated version.
-    badgelink_packet.which_packet                                        = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code                         = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp                          = badgelink_Response_version_resp_tag;
-    badgelink_packet.packet.response.resp.version_resp.server_version    = BADGELINK_PROTOCOL_VERSION;
-    badgelink_packet.packet.response.resp.version_resp.negotiated_version = negotiated;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_version_resp_tag;
+    negotiate(&req, &badgelink_packet->packet.response.resp.version_resp);
     badgelink_send_packet();
 }
 
-// Abort / finish a transfer.
+// Set up a new transfer of type `type` and make it the one the current request is for.
+badgelink_xfer_state_t* badgelink_xfer_begin(badgelink_xfer_t type, bool is_upload, uint32_t size) {
+    badgelink_xfer_state_t* xfer = &badgelink_xfers[BADGELINK_XFER_SLOT(type)];
+    // Session IDs are never 0, which stands for the last transfer that was started.
+    if (++last_session == 0) {
+        last_session = 1;
+    }
+    xfer->type       = type;
+    xfer->session    = last_session;
+    xfer->is_upload  = is_upload;
+    xfer->pos        = 0;
+    xfer->start      = 0;
+    xfer->size       = size;
+    xfer->skip_align = 0;
+    xfer->credits    = 0;
+    xfer->transport  = transport;
+    xfer->version    = transport->version;
+    badgelink_xfer   = xfer;
+    last_xfer        = xfer;
+    badgelink_stats.xfers++;
+    return xfer;
+}
+
+// Check the range a download request asks for and work out where it ends in a `size`-byte file.
+badgelink_StatusCode badgelink_download_range(uint32_t offset, uint32_t length, uint32_t size, uint32_t* end) {
+    if ((offset || length) && transport->version < 7) {
+        // Older hosts don't know chunks may start anywhere but 0, and version 1 sends the CRC32 of the whole file.
+        return badgelink_StatusCode_StatusNotSupported;
+    } else if (offset > size) {
+        return badgelink_StatusCode_StatusMalformed;
+    }
+    *end = length && length < size - offset ? offset + length : size;
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Find the transfer with session ID `session`, or the last transfer that was started if it is 0.
+// Returns NULL if that transfer isn't in progress or belongs to another transport.
+static badgelink_xfer_state_t* xfer_find(uint32_t session) {
+    if (session == 0) {
+        return last_xfer && last_xfer->type != BADGELINK_XFER_NONE && last_xfer->transport == transport ? last_xfer
+                                                                                                          : NULL;
+    }
+    for (size_t i = 0; i < BADGELINK_XFER_SLOTS; i++) {
+        if (badgelink_xfers[i].type != BADGELINK_XFER_NONE && badgelink_xfers[i].session == session &&
+            badgelink_xfers[i].transport == transport) {
+            return &badgelink_xfers[i];
+        }
+    }
+    return NULL;
+}
+
+// Abort / finish the transfer the current request is for.
 static void xfer_stop(bool abnormal) {
-    switch (badgelink_xfer_type) {
+    // The upload is only complete once the storage worker has written everything that was acknowledged.
+    badgelink_StatusCode code = badgelink_storage_end();
+    if (!abnormal && code != badgelink_StatusCode_StatusOk) {
+        ESP_LOGE(TAG, "Transfer failed while finishing");
+        badgelink_send_status(code);
+        abnormal = true;
+    }
+    switch (badgelink_xfer->type) {
+#ifdef CONFIG_BADGELINK_APPFS
         case BADGELINK_XFER_APPFS:
             badgelink_appfs_xfer_stop(abnormal);
             break;
+#endif
+#ifdef CONFIG_BADGELINK_FS
         case BADGELINK_XFER_FS:
             badgelink_fs_xfer_stop(abnormal);
             break;
+#endif
+#ifdef CONFIG_BADGELINK_NVS
+        case BADGELINK_XFER_NVS:
+            badgelink_nvs_xfer_stop(abnormal);
+            break;
+#endif
         default:
             break;
     }
-    badgelink_xfer_type = BADGELINK_XFER_NONE;
+    badgelink_digest_abort(badgelink_xfer->type);
+    // The session ID stays so that responses sent after stopping are still marked with it.
+    badgelink_xfer->type       = BADGELINK_XFER_NONE;
+    badgelink_xfer->skip_align = 0;
+    badgelink_xfer->credits    = 0;
+    if (last_xfer == badgelink_xfer) {
+        last_xfer = NULL;
+    }
+}
+
+// Send an acknowledgement for all upload data received in order so far.
+static void xfer_send_ack(bool retransmit) {
+    badgelink_packet->which_packet                             = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code              = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp               = badgelink_Response_xfer_ack_tag;
+    badgelink_packet->packet.response.resp.xfer_ack.position   = badgelink_xfer->pos;
+    badgelink_packet->packet.response.resp.xfer_ack.retransmit = retransmit;
+    badgelink_send_packet();
 }
 
 // Handle an upload chunk.
 static void xfer_upload_chunk() {
-    badgelink_Chunk* chunk = &badgelink_packet.packet.request.req.upload_chunk;
-    if (chunk->position != badgelink_xfer_pos) {
-        ESP_LOGE(TAG, "Incorrect chunk position; expected %" PRIu32 " but got %" PRIu32, badgelink_xfer_pos,
+    badgelink_Chunk* chunk = &badgelink_packet->packet.request.req.upload_chunk;
+    // For protocol version 4+, the host may send multiple chunks before waiting for the acknowledgement.
+    bool windowed = transport->version >= 4;
+    // Delta uploads skip the parts that didn't change, so the same goes for them as long as it's aligned.
+    bool skip     = badgelink_xfer->skip_align && chunk->position > badgelink_xfer->pos &&
+                chunk->position % badgelink_xfer->skip_align == 0 && chunk->position <= badgelink_xfer->size;
+    if (skip) {
+        badgelink_xfer->pos = chunk->position;
+    } else if (windowed && chunk->position < badgelink_xfer->pos) {
+        // Retransmission of data that was already written; acknowledge it again.
+        xfer_send_ack(false);
+        return;
+    } else if (windowed && chunk->position > badgelink_xfer->pos) {
+        // A chunk before this one was lost; ask the host to resend from the last acknowledged position.
+        ESP_LOGW(TAG, "Chunk at %" PRIu32 " out of order; requesting retransmit from %" PRIu32, chunk->position,
+                 badgelink_xfer->pos);
+        xfer_send_ack(true);
+        return;
+    } else if (chunk->position != badgelink_xfer->pos) {
+        ESP_LOGE(TAG, "Incorrect chunk position; expected %" PRIu32 " but got %" PRIu32, badgelink_xfer->pos,
                  chunk->position);
         xfer_stop(true);
         badgelink_status_ill_state();
         return;
     }
-    if (badgelink_xfer_pos + chunk->data.size > badgelink_xfer_size) {
+    if (chunk->compressed) {
+        // Decompress the data where the modules expect it; they copy or write it before the buffer is reused.
+        uint8_t* raw = lzf_buffer + LZF_BUFFER_HTAB_SIZE;
+        size_t   len;
+        if (!lzf_buffer || !lzf_decompress(raw, BADGELINK_CHUNK_DATA_MAX, &len, chunk->data.bytes, chunk->data.size)) {
+            ESP_LOGE(TAG, "Malformed compressed chunk");
+            xfer_stop(true);
+            badgelink_status_malformed();
+            return;
+        }
+        chunk->data.bytes = raw;
+        chunk->data.size  = len;
+    }
+    if (badgelink_xfer->pos + chunk->data.size > badgelink_xfer->size) {
         ESP_LOGE(TAG, "Incorrect chunk size");
         xfer_stop(true);
         badgelink_status_ill_state();
@@ -199,47 +895,137 @@ static void xfer_upload_chunk() {
     // `chunk->data.size` will be overwritten by respone packet, save it.
     uint32_t chunk_len = chunk->data.size;
 
-    switch (badgelink_xfer_type) {
+    badgelink_StatusCode code;
+    switch (badgelink_xfer->type) {
+#ifdef CONFIG_BADGELINK_APPFS
         case BADGELINK_XFER_APPFS:
-            badgelink_appfs_xfer_upload();
+            code = badgelink_appfs_xfer_upload();
             break;
+#endif
+#ifdef CONFIG_BADGELINK_FS
         case BADGELINK_XFER_FS:
-            badgelink_fs_xfer_upload();
+            code = badgelink_fs_xfer_upload();
+            break;
+#endif
+#ifdef CONFIG_BADGELINK_NVS
+        case BADGELINK_XFER_NVS:
+            code = badgelink_nvs_xfer_upload();
             break;
+#endif
         default:
             ESP_LOGE(TAG, "Invalid internal transfer state");
-            badgelink_status_int_err();
+            code = badgelink_StatusCode_StatusInternalError;
             break;
     }
+    if (code != badgelink_StatusCode_StatusOk) {
+        badgelink_send_status(code);
+        return;
+    }
 
-    badgelink_xfer_pos += chunk_len;
+    badgelink_xfer->pos += chunk_len;
+    if (windowed) {
+        xfer_send_ack(false);
+    } else {
+        badgelink_status_ok();
+    }
+}
+
+// Compress a download chunk if the host negotiated it and the data gets smaller.
+// Returns false if the data could not be read.
+static bool compress_chunk(badgelink_Chunk* chunk) {
+    chunk->compressed = false;
+    if (!transport->compress || chunk->data.size < 16) {
+        return true;
+    }
+
+    uint16_t* htab   = (uint16_t*)lzf_buffer;
+    uint8_t*  raw    = lzf_buffer + LZF_BUFFER_HTAB_SIZE;
+    uint8_t*  packed = raw + BADGELINK_CHUNK_DATA_MAX;
+    if (chunk->data.read) {
+        // The data would be read while encoding the packet, but it is needed before that to compress it.
+        if (!chunk->data.read(raw, chunk->data.size)) {
+            return false;
+        }
+        chunk->data.bytes = raw;
+        chunk->data.read  = NULL;
+    }
+    size_t len = lzf_compress(packed, chunk->data.size - 1, chunk->data.bytes, chunk->data.size, htab);
+    if (len) {
+        chunk->data.bytes = packed;
+        chunk->data.size  = len;
+        chunk->compressed = true;
+    }
+    return true;
 }
 
 // Handle a download chunk.
-static void xfer_download_chunk() {
-    switch (badgelink_xfer_type) {
+// Returns whether a chunk was sent; on error, a status is sent instead.
+static bool xfer_download_chunk() {
+    badgelink_StatusCode code;
+    switch (badgelink_xfer->type) {
+#ifdef CONFIG_BADGELINK_APPFS
         case BADGELINK_XFER_APPFS:
-            badgelink_appfs_xfer_download();
+            code = badgelink_appfs_xfer_download();
             break;
+#endif
+#ifdef CONFIG_BADGELINK_FS
         case BADGELINK_XFER_FS:
-            badgelink_fs_xfer_download();
+            code = badgelink_fs_xfer_download();
+            break;
+#endif
+#ifdef CONFIG_BADGELINK_NVS
+        case BADGELINK_XFER_NVS:
+            code = badgelink_nvs_xfer_download();
             break;
+#endif
         default:
             ESP_LOGE(TAG, "Invalid internal transfer state");
-            badgelink_status_int_err();
+            code = badgelink_StatusCode_StatusInternalError;
             break;
     }
+    if (code != badgelink_StatusCode_StatusOk) {
+        badgelink_send_status(code);
+        return false;
+    }
 
-    badgelink_xfer_pos += badgelink_packet.packet.response.resp.download_chunk.data.size;
+    // The chunk data is read from the file while the packet is being encoded, unless it's compressed first.
+    badgelink_Chunk* chunk     = &badgelink_packet->packet.response.resp.download_chunk;
+    uint32_t         chunk_len = chunk->data.size;
+    bool             sent      = compress_chunk(chunk) && badgelink_send_packet();
+    badgelink_storage_release();
+    if (!sent) {
+        badgelink_status_int_err();
+        return false;
+    }
+    badgelink_xfer->pos += chunk_len;
+    return true;
+}
+
+// Handle a download credit grant; stream chunks back-to-back until the credits or the file run out.
+static void xfer_credit() {
+    if (badgelink_xfer->is_upload) {
+        ESP_LOGE(TAG, "Download credit sent while in upload transfer");
+        xfer_stop(true);
+        badgelink_status_ill_state();
+        return;
+    }
+
+    badgelink_xfer->credits += badgelink_packet->packet.request.req.xfer_credit;
+    while (badgelink_xfer->credits && badgelink_xfer->pos < badgelink_xfer->size) {
+        badgelink_xfer->credits--;
+        if (!xfer_download_chunk()) {
+            badgelink_xfer->credits = 0;
+        }
+    }
 }
 
 // Handle transfer control packet.
 static void xfer_ctrl() {
-    badgelink_XferReq ctrl = badgelink_packet.packet.request.req.xfer_ctrl;
+    badgelink_XferReq ctrl = badgelink_packet->packet.request.req.xfer_ctrl;
 
     switch (ctrl) {
         case badgelink_XferReq_XferContinue:
-            if (badgelink_xfer_is_upload) {
+            if (badgelink_xfer->is_upload) {
                 ESP_LOGE(TAG, "Download continue sent while in upload transfer");
                 xfer_stop(true);
                 badgelink_status_ill_state();
@@ -251,7 +1037,7 @@ static void xfer_ctrl() {
             xfer_stop(true);
             break;
         case badgelink_XferReq_XferFinish:
-            if (badgelink_xfer_pos != badgelink_xfer_size) {
+            if (badgelink_xfer->pos != badgelink_xfer->size && !badgelink_xfer->skip_align) {
                 ESP_LOGE(TAG, "Transfer finished too early");
                 badgelink_status_ill_state();
                 xfer_stop(true);
@@ -265,50 +1051,117 @@ static void xfer_ctrl() {
     }
 }
 
+// Kind of transfer the current request starts, if any.
+static badgelink_xfer_t xfer_started_by_request() {
+    badgelink_Request* req = &badgelink_packet->packet.request;
+    if (req->which_req == badgelink_Request_appfs_action_tag) {
+        badgelink_FsActionType type = req->req.appfs_action.type;
+        if (type == badgelink_FsActionType_FsActionUpload || type == badgelink_FsActionType_FsActionDownload) {
+            return BADGELINK_XFER_APPFS;
+        }
+    } else if (req->which_req == badgelink_Request_fs_action_tag) {
+        badgelink_FsActionType type = req->req.fs_action.type;
+        if (type == badgelink_FsActionType_FsActionUpload || type == badgelink_FsActionType_FsActionDownload ||
+            type == badgelink_FsActionType_FsActionTreeUpload) {
+            return BADGELINK_XFER_FS;
+        }
+    } else if (req->which_req == badgelink_Request_nvs_action_tag) {
+        badgelink_NvsActionType type = req->req.nvs_action.type;
+        if (type == badgelink_NvsActionType_NvsActionExport || type == badgelink_NvsActionType_NvsActionImport) {
+            return BADGELINK_XFER_NVS;
+        }
+    }
+    return BADGELINK_XFER_NONE;
+}
+
+// Check whether a request with serial number `serial` is new and, if so, mark it as handled.
+// The host may pipeline requests, so one may arrive after a request with a larger serial number.
+static bool serial_accept(uint32_t serial) {
+    uint32_t ahead = serial - transport->next_serial;
+    if (ahead < UINT32_MAX >> 1) {
+        transport->seen        = ahead >= 31 ? 1 : (transport->seen << (ahead + 1)) | 1;
+        transport->next_serial = serial + 1;
+        return true;
+    }
+    uint32_t behind = transport->next_serial - 1 - serial;
+    if (behind >= 32 || (transport->seen & (1u << behind))) {
+        return false;
+    }
+    transport->seen |= 1u << behind;
+    return true;
+}
+
 // Handle a received packet.
 static void handle_packet() {
-    if (badgelink_packet.which_packet == badgelink_Packet_sync_tag) {
-        if (!badgelink_packet.packet.sync) {
+    // A version request is only answered along with a sync packet, and not sent back with other responses.
+    bool hello                  = badgelink_packet->has_hello;
+    badgelink_packet->has_hello = false;
+
+    if (badgelink_packet->which_packet == badgelink_Packet_sync_tag) {
+        if (!badgelink_packet->packet.sync) {
             badgelink_status_malformed();
             return;
         }
         // Sync packet received; set next expected serial number and respond with the same sync packet.
         // Reset negotiated version to 1 for new connections.
-        next_serial        = badgelink_packet.serial + 1;
-        negotiated_version = 1;
+        reset_session(transport);
+        transport->next_serial = badgelink_packet->serial + 1;
+        transport->seen        = 1;
+        // A version request may come along, so the host is connected in one round trip.
+        if (hello) {
+            negotiate(&badgelink_packet->hello, &badgelink_packet->welcome);
+            badgelink_packet->has_welcome = true;
+        }
         badgelink_send_packet();
         return;
-    } else if (badgelink_packet.which_packet != badgelink_Packet_request_tag) {
+    } else if (badgelink_packet->which_packet != badgelink_Packet_request_tag) {
         badgelink_status_malformed();
         return;
-    } else if (badgelink_packet.serial - next_serial >= UINT32_MAX >> 1) {
-        // Sequence number is negative, ignore the packet.
+    } else if (!serial_accept(badgelink_packet->serial)) {
+        // Serial number was already handled or is too old, ignore the packet.
         // This serves primarily to ignore retransmissions.
+        badgelink_stats.retransmits++;
         return;
     }
 
-    next_serial = badgelink_packet.serial + 1;
+    pb_size_t which_req = badgelink_packet->packet.request.which_req;
+    bool      for_xfer  = which_req == badgelink_Request_upload_chunk_tag ||
+                    which_req == badgelink_Request_xfer_ctrl_tag ||
+                    (which_req == badgelink_Request_xfer_credit_tag && transport->version >= 4);
+    badgelink_xfer = for_xfer ? xfer_find(badgelink_packet->packet.request.session) : NULL;
 
-    if (badgelink_xfer_type != BADGELINK_XFER_NONE) {
-        if (badgelink_packet.packet.request.which_req == badgelink_Request_upload_chunk_tag) {
-            if (badgelink_xfer_is_upload) {
+    if (badgelink_xfer) {
+        if (which_req == badgelink_Request_upload_chunk_tag) {
+            if (badgelink_xfer->is_upload) {
                 xfer_upload_chunk();
             } else {
                 ESP_LOGE(TAG, "Upload chunk sent while in download transfer");
                 xfer_stop(true);
                 badgelink_status_ill_state();
             }
-            return;
-        } else if (badgelink_packet.packet.request.which_req == badgelink_Request_xfer_ctrl_tag) {
+        } else if (which_req == badgelink_Request_xfer_ctrl_tag) {
             xfer_ctrl();
-            return;
         } else {
-            ESP_LOGE(TAG, "Transfer cancelled abruptly");
-            xfer_stop(true);
+            xfer_credit();
         }
+        return;
+    } else if (!for_xfer) {
+        // Before version 5, any other request ends the transfer; after, only one that starts another of its kind.
+        // Either way, only transfers started over the same transport are affected.
+        badgelink_xfer_t starts = xfer_started_by_request();
+        for (size_t i = 0; i < BADGELINK_XFER_SLOTS; i++) {
+            if (badgelink_xfers[i].type != BADGELINK_XFER_NONE &&
+                badgelink_xfers[i].transport == transport &&
+                (transport->version < 5 || badgelink_xfers[i].type == starts)) {
+                ESP_LOGE(TAG, "Transfer cancelled abruptly");
+                badgelink_xfer = &badgelink_xfers[i];
+                xfer_stop(true);
+            }
+        }
+        badgelink_xfer = NULL;
     }
 
-    switch (badgelink_packet.packet.request.which_req) {
+    switch (badgelink_packet->packet.request.which_req) {
         case badgelink_Request_upload_chunk_tag:
             ESP_LOGE(TAG, "Transfer chunk without transfer in progress");
             badgelink_status_ill_state();
@@ -317,76 +1170,218 @@ static void handle_packet() {
             ESP_LOGE(TAG, "Transfer control without transfer in progress");
             badgelink_status_ill_state();
             break;
+        case badgelink_Request_xfer_credit_tag:
+            if (transport->version >= 4) {
+                ESP_LOGE(TAG, "Download credit without transfer in progress");
+                badgelink_status_ill_state();
+            } else {
+                badgelink_status_unsupported();
+            }
+            break;
+#ifdef CONFIG_BADGELINK_STARTAPP
         case badgelink_Request_start_app_tag:
             badgelink_startapp_handle();
             break;
+#endif
+#ifdef CONFIG_BADGELINK_NVS
         case badgelink_Request_nvs_action_tag:
             badgelink_nvs_handle();
             break;
+#endif
+#ifdef CONFIG_BADGELINK_APPFS
         case badgelink_Request_appfs_action_tag:
             badgelink_appfs_handle();
             break;
+#endif
+#ifdef CONFIG_BADGELINK_FS
         case badgelink_Request_fs_action_tag:
             badgelink_fs_handle();
             break;
+        case badgelink_Request_fs_stat_many_tag:
+            badgelink_fs_stat_many();
+            break;
+#endif
         case badgelink_Request_version_req_tag:
             handle_version_req();
             break;
+        case badgelink_Request_stats_req_tag:
+            badgelink_stats_handle();
+            break;
+#ifdef CONFIG_BADGELINK_TRACE
+        case badgelink_Request_trace_req_tag:
+            badgelink_trace_handle();
+            break;
+#endif
+#ifdef CONFIG_BADGELINK_HISTOGRAMS
+        case badgelink_Request_histogram_req_tag:
+            badgelink_histogram_handle();
+            break;
+#endif
+#ifdef CONFIG_BADGELINK_BENCH
+        case badgelink_Request_bench_req_tag:
+            badgelink_bench_handle();
+            break;
+        case badgelink_Request_echo_req_tag:
+            badgelink_bench_echo();
+            break;
+#endif
         default:
             badgelink_status_unsupported();
             break;
     }
 }
 
-// Handle a received frame.
-static void handle_frame(size_t len) {
-    if (len < 6) {
-        // Any frame cannot be smaller than the COBS-encoded length of 5 bytes.
-        // That is because this assumes no protobuf packet is smaller than a byte,
-        // and there is always a 4-byte CRC32 checksum.
+// Tell the host of transport `t` that a frame was corrupted, so it can resend without waiting for a timeout.
+// The NAK carries the serial number of the last request handled and the position the last upload is at.
+static void send_nak(badgelink_transport_t* t, badgelink_NakReason reason) {
+    use_transport(t);
+    if (transport->version < 6) {
         return;
     }
+    badgelink_xfer_state_t* xfer   = xfer_find(0);
+    badgelink_packet->which_packet = badgelink_Packet_nak_tag;
+    badgelink_packet->serial       = transport->next_serial - 1;
+    badgelink_packet->has_hello    = false;
+    badgelink_packet->has_welcome  = false;
+    badgelink_Nak* nak             = &badgelink_packet->packet.nak;
+    nak->reason                    = reason;
+    nak->session                   = xfer ? xfer->session : 0;
+    nak->position                  = xfer && xfer->is_upload ? xfer->pos : 0;
+    badgelink_stats.naks_sent++;
+    badgelink_send_packet();
+}
 
-#if DUMP_RAW_BYTES
-    ESP_LOGI(TAG, "Received %zu-byte frame", len);
-    printf("Data:");
-    for (size_t i = 0; i < len; i++) {
-        printf(" %02x", frame_buffer[i]);
+// Handle a frame received over transport `t`, which has already been decoded.
+static void handle_frame(badgelink_transport_t* t) {
+    cobs_decoder_t* decoder = &t->decoder;
+    badgelink_stats.frames_rx++;
+    // Check the CRC32, which has been computed while decoding.
+    switch (cobs_decoder_finish(decoder)) {
+        case COBS_FRAME_OK:
+            break;
+        case COBS_FRAME_MALFORMED:
+            // Any frame must be at least 5 bytes when decoded.
+            // That is because this assumes no protobuf packet is smaller than a byte,
+            // and there is always a 4-byte CRC32 checksum.
+            // An empty frame is just a delimiter the host may send to flush out noise, so it doesn't get a NAK.
+            if (decoder->len || decoder->malformed) {
+                badgelink_stats.framing_errors++;
+                send_nak(t, badgelink_NakReason_NakFraming);
+            }
+            return;
+        case COBS_FRAME_CRC_ERROR:
+            // CRC32 error; send a NAK and ignore the frame.
+            ESP_LOGE(TAG, "CRC32 error; packet: 0x%08" PRIx32 ", actual 0x%08" PRIx32, decoder->frame_crc,
+                     decoder->crc);
+            badgelink_stats.crc_errors++;
+            send_nak(t, badgelink_NakReason_NakCrc);
+            return;
     }
-    printf("\n");
-#endif
-
-    // Decode the COBS frame.
-    assert(frame_buffer[len - 1] == 0);
-    size_t decoded_len = cobs_decode(frame_buffer, frame_buffer, len);
 
-#if DUMP_RAW_BYTES
-    printf("Decoded:");
-    for (size_t i = 0; i < decoded_len; i++) {
-        printf(" %02x", frame_buffer[i]);
+    // Try to decode the packet.
+    int64_t      start          = badgelink_stats_now();
+    pb_istream_t decode_istream = pb_istream_from_buffer(decoder->output, decoder->len);
+    bool         decoded        = pb_decode(&decode_istream, &badgelink_Packet_msg, badgelink_packet);
+    uint64_t     decode_us      = badgelink_stats_since(start);
+    badgelink_stats.decode_us  += decode_us;
+    badgelink_histogram_record(badgelink_HistogramStage_StageDecode, 0, decode_us);
+    badgelink_trace(badgelink_TraceEventType_TraceDecoded, decoder->len);
+    if (!decoded) {
+        ESP_LOGE(TAG, "Failed to decode %zu-byte packet", decoder->len + 4);
+        badgelink_stats.decode_errors++;
+        send_nak(t, badgelink_NakReason_NakDecode);
+    } else {
+        // Handling includes encoding the response, which is also counted separately.
+        start = badgelink_stats_now();
+        pb_size_t which_req = badgelink_packet->which_packet == badgelink_Packet_request_tag
+                                  ? badgelink_packet->packet.request.which_req
+                                  : 0;
+        badgelink_trace(badgelink_TraceEventType_TraceHandleBegin, which_req);
+        use_transport(t);
+        handle_packet();
+        uint64_t handle_us         = badgelink_stats_since(start);
+        badgelink_stats.handle_us += handle_us;
+        badgelink_histogram_record(badgelink_HistogramStage_StageHandle, which_req, handle_us);
+        badgelink_trace(badgelink_TraceEventType_TraceHandleEnd, which_req);
     }
-    printf("\n");
+}
 
-    ESP_LOGI(TAG, "COBS-decoded successfully");
-#endif
+// Process the data transport `t` received; returns false if there was none.
+static bool transport_receive(badgelink_transport_t* t) {
+    if (t->rxbuf_len >= BADGELINK_BUF_CAP) {
+        // Frame is too long; drop the rest of it.
+        t->decoder.malformed = true;
+        t->rxbuf_len         = 0;
+    }
 
-    // Check the CRC32.
-    uint32_t actual_crc = esp_crc32_le(0, frame_buffer, decoded_len - 4);
-    uint32_t packet_crc = frame_buffer[decoded_len - 4] | (frame_buffer[decoded_len - 3] << 8) |
-                          (frame_buffer[decoded_len - 2] << 16) | (frame_buffer[decoded_len - 1] << 24);
+    // Receive directly into the frame buffer, after the partial frame received so far.
+    size_t received =
+        xStreamBufferReceive(t->rxstream, t->frame_buffer + t->rxbuf_len, BADGELINK_BUF_CAP - t->rxbuf_len, 0);
+    size_t end   = t->rxbuf_len + received;
+    size_t start = t->rxbuf_len;
+    badgelink_stats.bytes_rx += received;
+    if (start == 0 && received) {
+        badgelink_trace(badgelink_TraceEventType_TraceFrameStart, t - transports);
+    }
 
-    if (actual_crc != packet_crc) {
-        // CRC32 error; send CRC error response and ignore.
-        ESP_LOGE(TAG, "CRC32 error; packet: 0x%08" PRIx32 ", actual 0x%08" PRIx32, packet_crc, actual_crc);
-        return;
+    // Decode the data as it arrives, so the packet is ready as soon as the null-terminator is received.
+    while (start < end) {
+        int64_t feed_start        = badgelink_stats_now();
+        start                    += cobs_decoder_feed(&t->decoder, t->frame_buffer + start, end - start);
+        uint64_t feed_us          = badgelink_stats_since(feed_start);
+        badgelink_stats.cobs_us  += feed_us;
+        t->cobs_us               += feed_us;
+        if (t->decoder.complete) {
+            badgelink_histogram_record(badgelink_HistogramStage_StageCobs, 0, t->cobs_us);
+            t->cobs_us = 0;
+            badgelink_trace(badgelink_TraceEventType_TraceFrameEnd, t->decoder.len);
+            handle_frame(t);
+            update_priority();
+            // Move the start of the next frame, if any, to the start of the buffer.
+            memmove(t->frame_buffer, t->frame_buffer + start, end - start);
+            end   -= start;
+            start  = 0;
+            cobs_decoder_init(&t->decoder, t->frame_buffer, BADGELINK_BUF_CAP);
+            if (end) {
+                badgelink_trace(badgelink_TraceEventType_TraceFrameStart, t - transports);
+            }
+        }
     }
+    t->rxbuf_len = end;
+    return received != 0;
+}
 
-    // Try to decode the packet.
-    pb_istream_t decode_istream = pb_istream_from_buffer(frame_buffer, decoded_len - 4);
-    if (!pb_decode(&decode_istream, &badgelink_Packet_msg, &badgelink_packet)) {
-        ESP_LOGE(TAG, "Failed to decode %zu-byte packet", decoded_len);
-    } else {
-        handle_packet();
+// Reset the transports whose host disconnected, for the tasks waiting in `badgelink_transport_reset`.
+static void handle_resets() {
+    bool reset = false;
+    for (size_t i = 0; i < transport_count; i++) {
+        badgelink_transport_t* t      = &transports[i];
+        TaskHandle_t           waiter = t->resetter;
+        if (!waiter) {
+            continue;
+        }
+        // Nobody is left to answer what the host sent before it disconnected.
+        while (xStreamBufferReceive(t->rxstream, t->frame_buffer, BADGELINK_BUF_CAP, 0));
+        t->rxbuf_len = 0;
+        t->cobs_us   = 0;
+        cobs_decoder_init(&t->decoder, t->frame_buffer, BADGELINK_BUF_CAP);
+        // Only this transport can continue its transfers, so they're aborted like when stopping.
+        for (size_t j = 0; j < BADGELINK_XFER_SLOTS; j++) {
+            if (badgelink_xfers[j].type != BADGELINK_XFER_NONE && badgelink_xfers[j].transport == t) {
+                ESP_LOGW(TAG, "Host disconnected during a transfer");
+                use_transport(t);
+                badgelink_xfer = &badgelink_xfers[j];
+                xfer_stop(true);
+            }
+        }
+        badgelink_xfer = NULL;
+        reset_session(t);
+        t->resetter = NULL;
+        xTaskNotifyGive(waiter);
+        reset = true;
+    }
+    if (reset) {
+        update_priority();
     }
 }
 
@@ -394,49 +1389,235 @@ static void handle_frame(size_t len) {
 static void badgelink_thread_main(void* ignored) {
     (void)ignored;
 
-    // Amount of data in the receive buffer.
-    size_t     rxbuf_len = 0;
-    // Fragment received from USB or UART.
-    fragment_t frag;
-    // Frame being dropped because it's too long.
-    bool       toolong = false;
+    // Whether the thread is exiting because a lazily started service was idle.
+    bool idle = false;
 
     while (1) {
-        xQueueReceive(rxqueue, &frag, portMAX_DELAY);
-        for (size_t i = 0; i < frag.len; i++) {
-            if (rxbuf_len >= BADGELINK_BUF_CAP) {
-                toolong = true;
+        // Take turns between the transports, so a busy one can't keep the others waiting.
+        handle_resets();
+        bool received = false;
+        for (size_t i = 0; i < transport_count && !stopping; i++) {
+            received |= transport_receive(&transports[i]);
+        }
+        if (stopping) {
+            break;
+        } else if (received) {
+            continue;
+        }
+
+        // Wait for any of the transports to receive data.
+        if (!xSemaphoreTake(rxready, lazy ? lazy_idle_ticks : portMAX_DELAY) && lazy) {
+            // Idle for long enough to free everything, unless data arrived or `badgelink_stop` was called meanwhile.
+            xSemaphoreTake(lazy_lock, portMAX_DELAY);
+            bool pending = false;
+            for (size_t i = 0; i < transport_count; i++) {
+                pending |= xStreamBufferBytesAvailable(transports[i].rxstream) != 0 || transports[i].resetter;
             }
-            if (toolong) {
-                if (frag.data[i] == 0) {
-                    toolong   = false;
-                    rxbuf_len = 0;
-                }
-            } else {
-                frame_buffer[rxbuf_len++] = frag.data[i];
-                if (frag.data[i] == 0) {
-                    handle_frame(rxbuf_len);
-                    rxbuf_len = 0;
-                }
+            if (lazy && !pending) {
+                idle = true;
+                break;
             }
+            xSemaphoreGive(lazy_lock);
+        }
+    }
+
+    // Stopped by `badgelink_stop` or for being idle; don't leave any files open.
+    for (size_t i = 0; i < BADGELINK_XFER_SLOTS; i++) {
+        if (badgelink_xfers[i].type != BADGELINK_XFER_NONE) {
+            ESP_LOGW(TAG, "Stopping during a transfer");
+            use_transport(badgelink_xfers[i].transport);
+            badgelink_xfer = &badgelink_xfers[i];
+            xfer_stop(true);
         }
     }
+    badgelink_xfer = NULL;
+    // Don't keep a transport that disconnected meanwhile waiting.
+    handle_resets();
+    badgelink_nvs_release_cursor();
+    badgelink_fs_release_cursor();
+    badgelink_fs_forget_crcs();
+    if (idle) {
+        // Nobody is waiting in `badgelink_stop`, so stop the TX thread and free everything here.
+        // This still holds `lazy_lock`, so any received data waits until it can start the service again.
+        tx_frame_t* end = NULL;
+        xQueueSend(txqueue, &end, portMAX_DELAY);
+        xSemaphoreTake(stopped, portMAX_DELAY);
+        badgelink_free();
+        xSemaphoreGive(lazy_lock);
+    } else {
+        xSemaphoreGive(stopped);
+    }
+    vTaskDelete(NULL);
 }
 
-// Handle received data.
-void badgelink_rxdata_cb(uint8_t const* buf, size_t len) {
-    fragment_t frag;
-    while (len) {
-        if (len > sizeof(frag.data)) {
-            frag.len = sizeof(frag.data);
-        } else {
-            frag.len = len;
+// Tell BadgeLink that a transport is done with the frames passed to its asynchronous send callback.
+void badgelink_tx_complete(void* token) {
+    tx_frame_t* frame = token;
+    while (frame) {
+        // The buffer may be reused as soon as it's returned.
+        tx_frame_t* next = frame->next;
+        badgelink_histogram_record(badgelink_HistogramStage_StageTx, 0, badgelink_stats_since(frame->sent_at));
+        badgelink_trace(badgelink_TraceEventType_TraceTxDone, frame->len);
+        xQueueSend(txfree, &frame, portMAX_DELAY);
+        frame = next;
+    }
+}
+
+// Send a frame over a transport that can only send it while the TX thread waits.
+static void send_frame(tx_frame_t* frame) {
+    if (frame->transport->send != NULL) {
+        int64_t start = badgelink_stats_now();
+        frame->transport->send(frame->data, frame->len);
+        badgelink_histogram_record(badgelink_HistogramStage_StageTx, 0, badgelink_stats_since(start));
+    }
+    badgelink_trace(badgelink_TraceEventType_TraceTxDone, frame->len);
+    // Return the buffer so the next response can be encoded into it.
+    xQueueSend(txfree, &frame, portMAX_DELAY);
+}
+
+// Main function for the BadgeLink TX thread.
+static void badgelink_tx_thread_main(void* ignored) {
+    (void)ignored;
+
+    // Frame for another transport than the ones before it, which is sent next.
+    tx_frame_t* held = NULL;
+    bool        stop = false;
+    while (!stop) {
+        tx_frame_t* frame = held;
+        held              = NULL;
+        if (!frame) {
+            xQueueReceive(txqueue, &frame, portMAX_DELAY);
+        }
+        if (frame == NULL) {
+            // Stopped by `badgelink_stop`.
+            break;
         }
-        memcpy(frag.data, buf, frag.len);
-        if (xQueueSend(rxqueue, &frag, 0) != pdTRUE) {
-            ESP_LOGW(TAG, "Fragment dropped");
+        badgelink_transport_t* t = frame->transport;
+        if (!t->async_send) {
+            send_frame(frame);
+            continue;
         }
-        buf += frag.len;
-        len -= frag.len;
+
+        // Pass every frame queued for the same transport at once, so it can send them back to back.
+        badgelink_tx_segment_t segments[CONFIG_BADGELINK_TX_BUFFERS];
+        size_t                 count = 0;
+        tx_frame_t*            last  = frame;
+        tx_frame_t*            more;
+        segments[count++] = (badgelink_tx_segment_t){frame->data, frame->len};
+        while (count < CONFIG_BADGELINK_TX_BUFFERS && xQueueReceive(txqueue, &more, 0)) {
+            if (more == NULL) {
+                stop = true;
+                break;
+            } else if (more->transport != t) {
+                held = more;
+                break;
+            }
+            last->next        = more;
+            last              = more;
+            segments[count++] = (badgelink_tx_segment_t){more->data, more->len};
+        }
+        last->next  = NULL;
+        int64_t now = badgelink_stats_now();
+        for (tx_frame_t* f = frame; f; f = f->next) {
+            f->sent_at = now;
+        }
+        // The frames may be completed and reused before this returns.
+        t->async_send(segments, count, frame);
+    }
+
+    // Wait for the transports to be done with every frame before the buffers are freed.
+    badgelink_tx_flush();
+    xSemaphoreGive(stopped);
+    vTaskDelete(NULL);
+}
+
+// Hand data received over transport `t` to the BadgeLink thread, starting a lazily started service if needed.
+static size_t rxdata(badgelink_transport_t* t, uint8_t const* buf, size_t len, TickType_t ticks) {
+    size_t sent = 0;
+    if (lazy) {
+        xSemaphoreTake(lazy_lock, portMAX_DELAY);
+        if (!badgelink_packet && badgelink_init_with_caps(lazy_frame_caps, lazy_packet_caps)) {
+            start_threads();
+        }
+        if (t->rxstream) {
+            sent                         = xStreamBufferSend(t->rxstream, buf, len, ticks);
+            badgelink_stats.rx_overflow += len - sent;
+            xSemaphoreGive(rxready);
+        }
+        xSemaphoreGive(lazy_lock);
+        return sent;
+    }
+    if (!t->rxstream) {
+        // Not initialized; drop the data.
+        return len;
     }
+    sent                         = xStreamBufferSend(t->rxstream, buf, len, ticks);
+    badgelink_stats.rx_overflow += len - sent;
+    xSemaphoreGive(rxready);
+    return sent;
 }
+
+// Tell BadgeLink that the host of transport `t` disconnected, so its transfers are aborted and its session starts over.
+void badgelink_transport_reset(badgelink_transport_t* t) {
+    if (lazy) {
+        xSemaphoreTake(lazy_lock, portMAX_DELAY);
+    }
+    if (!badgelink_packet || !rxready) {
+        // The service isn't running, so there are no transfers and nothing else uses the session.
+        reset_session(t);
+        if (lazy) {
+            xSemaphoreGive(lazy_lock);
+        }
+        return;
+    }
+    // The BadgeLink thread does the rest, since it may be in the middle of a request for this transport.
+    t->resetter = xTaskGetCurrentTaskHandle();
+    xSemaphoreGive(rxready);
+    if (lazy) {
+        xSemaphoreGive(lazy_lock);
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// Handle received data.
+// Returns how many bytes were accepted; the rest did not fit and should be offered again later.
+size_t badgelink_rxdata_cb(uint8_t const* buf, size_t len) {
+    return rxdata(&transports[0], buf, len, 0);
+}
+
+// Handle received data, waiting up to `timeout_ms` milliseconds for space in the RX buffer.
+// Returns how many bytes were accepted before the timeout expired.
+size_t badgelink_rxdata_cb_timeout(uint8_t const* buf, size_t len, uint32_t timeout_ms) {
+    return rxdata(&transports[0], buf, len, pdMS_TO_TICKS(timeout_ms));
+}
+
+// Handle data received over a transport added with `badgelink_add_transport`.
+size_t badgelink_transport_rxdata(badgelink_transport_t* t, uint8_t const* buf, size_t len, uint32_t timeout_ms) {
+    return rxdata(t, buf, len, pdMS_TO_TICKS(timeout_ms));
+}
+
+#ifdef BADGELINK_FUZZ
+// Start the badgelink service for fuzzing, without the thread that handles received data.
+void badgelink_fuzz_start(usb_callback_t usb_callback) {
+    transports[0].send = usb_callback;
+    reset_session(&transports[0]);
+    badgelink_digest_reset();
+    stopping = false;
+    xTaskCreatePinnedToCore(
+        badgelink_tx_thread_main, "BadgeLinkTX", 4096, NULL, CONFIG_BADGELINK_TASK_PRIORITY,
+        &badgelink_tx_thread_handle, BADGELINK_TASK_CORE
+    );
+}
+
+// Handle data received by the service started with `badgelink_fuzz_start` on the calling thread.
+void badgelink_fuzz_rxdata(uint8_t const* buf, size_t len) {
+    badgelink_transport_t* t = &transports[0];
+    while (len) {
+        size_t sent  = xStreamBufferSend(t->rxstream, buf, len, 0);
+        buf         += sent;
+        len         -= sent;
+        while (transport_receive(t));
+    }
+    badgelink_tx_flush();
+}
+#endif
@@ -4,19 +4,118 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 typedef void (*usb_callback_t)(uint8_t const* data, size_t len);
+// Waits up to `timeout_ms` milliseconds for all data passed to a transport's send callback to have left the device.
+// Returns false if it didn't leave in time.
+typedef bool (*flush_callback_t)(uint32_t timeout_ms);
+
+// A piece of data for a transport to send.
+typedef struct {
+    uint8_t const* data;
+    size_t         len;
+} badgelink_tx_segment_t;
+// Starts sending `count` segments back to back without waiting for them to leave the device.
+// The data stays valid until the transport passes `token` to `badgelink_tx_complete`, which it must do for every call,
+// also if the data was dropped; the array of segments itself is only valid during the call.
+typedef void (*async_send_callback_t)(badgelink_tx_segment_t const* segments, size_t count, void* token);
+
+// A link to a host, like USB, a UART or a TCP connection, with its own frames and negotiated session.
+typedef struct badgelink_transport badgelink_transport_t;
 
 // Prepare the data for the BadgeLink service to start.
-void badgelink_init();
+// The frame buffers are allocated in internal DMA-capable RAM and the packet from the default heap.
+// Returns false if there is not enough memory.
+bool badgelink_init();
+
+// Prepare the data for the BadgeLink service to start, allocating the RX and TX frame buffers with `frame_caps`
+// and the packet with `packet_caps` (`MALLOC_CAP_*` flags from esp_heap_caps.h).
+// Large chunk sizes may need `MALLOC_CAP_SPIRAM` for both on boards that have it.
+// Returns false if there is not enough memory.
+bool badgelink_init_with_caps(uint32_t frame_caps, uint32_t packet_caps);
 
 // Start the badgelink service.
 void badgelink_start(usb_callback_t usb_callback);
 
+// Start the badgelink service lazily instead of calling `badgelink_init` and `badgelink_start`.
+// Nothing is allocated until data is received, at which point the buffers are allocated with `frame_caps` and
+// `packet_caps` like `badgelink_init_with_caps` and the threads are started.
+// After `idle_timeout_ms` milliseconds without received data they are freed again, aborting any transfer in progress;
+// the negotiated session is kept, so the host does not notice.
+// Returns false if there is not enough memory.
+bool badgelink_start_lazy(usb_callback_t usb_callback, uint32_t idle_timeout_ms, uint32_t frame_caps,
+                          uint32_t packet_caps);
+
+// Add another transport the badgelink service can be reached over, next to the one passed to `badgelink_start`.
+// Received data is passed to `badgelink_transport_rxdata` and responses are sent with `send`.
+// Each transport gets an RX buffer of its own, so it can be added before or after starting the service.
+// Returns NULL if there is not enough memory or `CONFIG_BADGELINK_MAX_TRANSPORTS` transports were added already.
+badgelink_transport_t* badgelink_add_transport(usb_callback_t send);
+
+// Set the callback that waits for data sent over the transport of `badgelink_start` to have left the device.
+// Where it matters, like before restarting into an app, BadgeLink waits a fixed time for transports without one.
+void badgelink_set_flush_callback(flush_callback_t flush);
+
+// Set the callback that waits for data sent over a transport added with `badgelink_add_transport` to have left the
+// device, like `badgelink_set_flush_callback`.
+void badgelink_transport_set_flush_callback(badgelink_transport_t* transport, flush_callback_t flush);
+
+// Set the callback that starts sending data over the transport of `badgelink_start` without waiting for it, used instead
+// of the one passed to `badgelink_start`.
+// Every frame queued by then is passed at once, so the transport can send them from the TX buffers without copying.
+void badgelink_set_async_send_callback(async_send_callback_t send);
+
+// Set the callback that starts sending data over a transport added with `badgelink_add_transport` without waiting for
+// it, like `badgelink_set_async_send_callback`.
+void badgelink_transport_set_async_send_callback(badgelink_transport_t* transport, async_send_callback_t send);
+
+// Tell BadgeLink that a transport is done with the data passed to its asynchronous send callback along with `token`.
+// Safe to call from any task, also from within the send callback.
+void badgelink_tx_complete(void* token);
+
+// Stop the badgelink service and free everything `badgelink_init` allocated.
+// Aborts the file transfer in progress, if any, and waits for queued responses to be sent.
+// Stop passing data to `badgelink_rxdata_cb` first; it discards data until `badgelink_init` is called again.
+// Also ends lazy mode, freeing the buffers if they are allocated.
+void badgelink_stop();
+
 // Handle received data.
-void badgelink_rxdata_cb(uint8_t const* data, size_t len);
+// Returns how many bytes were accepted; the rest did not fit and should be offered again later.
+size_t badgelink_rxdata_cb(uint8_t const* data, size_t len);
+
+// Handle received data, waiting up to `timeout_ms` milliseconds for space in the RX buffer.
+// Returns how many bytes were accepted before the timeout expired.
+// Blocks the calling task, so a USB callback can leave unread data in its FIFO and let the host wait.
+size_t badgelink_rxdata_cb_timeout(uint8_t const* data, size_t len, uint32_t timeout_ms);
+
+// Handle data received over a transport added with `badgelink_add_transport`.
+// Waits up to `timeout_ms` milliseconds for space in its RX buffer, like `badgelink_rxdata_cb_timeout`.
+// Returns how many bytes were accepted.
+size_t badgelink_transport_rxdata(badgelink_transport_t* transport, uint8_t const* data, size_t len,
+                                  uint32_t timeout_ms);
 
-// Get the negotiated protocol version.
+// Tell BadgeLink that the host of a transport added with `badgelink_add_transport` disconnected.
+// The transfers it started are aborted, like when the service stops, and the next host starts a new session.
+// Data it received but wasn't handled yet is dropped, so call this before passing on data from the next host.
+// Blocks the calling task until BadgeLink is done with the transport, and uses its task notification to wait.
+void badgelink_transport_reset(badgelink_transport_t* transport);
+
+// Get the negotiated protocol version of the transport that was used last.
 uint16_t badgelink_get_protocol_version();
+
+// Tell BadgeLink that AppFS was changed by something else, like an app installer on the badge.
+// BadgeLink then calculates the CRC32s of apps again instead of using those it remembered; safe to call from any task.
+void badgelink_appfs_changed();
+
+#ifdef BADGELINK_FUZZ
+// Start the badgelink service for fuzzing, like `badgelink_start` but without the thread that handles received data.
+// Received data is passed to `badgelink_fuzz_rxdata` instead, which handles it on the calling thread.
+void badgelink_fuzz_start(usb_callback_t usb_callback);
+
+// Handle data received by the service started with `badgelink_fuzz_start` on the calling thread.
+// Returns once every complete frame in it was handled and the responses were sent.
+void badgelink_fuzz_rxdata(uint8_t const* data, size_t len);
+#endif
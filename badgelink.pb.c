@@ -24,7 +24,49 @@ PB_BIND(badgelink_VersionReq, badgelink_VersionReq, AUTO)
 PB_BIND(badgelink_VersionResp, badgelink_VersionResp, AUTO)
 
 
-PB_BIND(badgelink_Chunk, badgelink_Chunk, 4)
+PB_BIND(badgelink_XferAck, badgelink_XferAck, AUTO)
+
+
+PB_BIND(badgelink_XferResult, badgelink_XferResult, AUTO)
+
+
+PB_BIND(badgelink_Nak, badgelink_Nak, AUTO)
+
+
+PB_BIND(badgelink_StatsReq, badgelink_StatsReq, AUTO)
+
+
+PB_BIND(badgelink_Stats, badgelink_Stats, AUTO)
+
+
+PB_BIND(badgelink_TraceReq, badgelink_TraceReq, AUTO)
+
+
+PB_BIND(badgelink_TraceDump, badgelink_TraceDump, 2)
+
+
+PB_BIND(badgelink_HistogramReq, badgelink_HistogramReq, AUTO)
+
+
+PB_BIND(badgelink_Histogram, badgelink_Histogram, AUTO)
+
+
+PB_BIND(badgelink_Histograms, badgelink_Histograms, 2)
+
+
+PB_BIND(badgelink_BenchReq, badgelink_BenchReq, 2)
+
+
+PB_BIND(badgelink_BenchResult, badgelink_BenchResult, AUTO)
+
+
+PB_BIND(badgelink_EchoReq, badgelink_EchoReq, AUTO)
+
+
+PB_BIND(badgelink_EchoResp, badgelink_EchoResp, AUTO)
+
+
+PB_BIND(badgelink_Chunk, badgelink_Chunk, AUTO)
 
 
 PB_BIND(badgelink_FsUsage, badgelink_FsUsage, AUTO)
@@ -39,6 +81,9 @@ PB_BIND(badgelink_AppfsActionReq, badgelink_AppfsActionReq, AUTO)
 PB_BIND(badgelink_AppfsList, badgelink_AppfsList, 2)
 
 
+PB_BIND(badgelink_AppfsSectorCrcs, badgelink_AppfsSectorCrcs, AUTO)
+
+
 PB_BIND(badgelink_AppfsActionResp, badgelink_AppfsActionResp, 2)
 
 
@@ -51,25 +96,43 @@ PB_BIND(badgelink_FsActionReq, badgelink_FsActionReq, 2)
 PB_BIND(badgelink_FsDirent, badgelink_FsDirent, 2)
 
 
-PB_BIND(badgelink_FsDirentList, badgelink_FsDirentList, 4)
+PB_BIND(badgelink_FsDirentList, badgelink_FsDirentList, AUTO)
+
+
+PB_BIND(badgelink_FsActionResp, badgelink_FsActionResp, AUTO)
 
 
-PB_BIND(badgelink_FsActionResp, badgelink_FsActionResp, 4)
+PB_BIND(badgelink_FsStatManyReq, badgelink_FsStatManyReq, AUTO)
 
 
-PB_BIND(badgelink_NvsValue, badgelink_NvsValue, 4)
+PB_BIND(badgelink_FsStatResult, badgelink_FsStatResult, AUTO)
+
+
+PB_BIND(badgelink_FsStatManyResp, badgelink_FsStatManyResp, AUTO)
+
+
+PB_BIND(badgelink_NvsValue, badgelink_NvsValue, AUTO)
 
 
 PB_BIND(badgelink_NvsEntry, badgelink_NvsEntry, AUTO)
 
 
-PB_BIND(badgelink_NvsActionReq, badgelink_NvsActionReq, 4)
+PB_BIND(badgelink_NvsActionReq, badgelink_NvsActionReq, 2)
+
+
+PB_BIND(badgelink_NvsBatchOp, badgelink_NvsBatchOp, AUTO)
+
+
+PB_BIND(badgelink_NvsEntriesList, badgelink_NvsEntriesList, AUTO)
+
+
+PB_BIND(badgelink_NvsActionResp, badgelink_NvsActionResp, 2)
 
 
-PB_BIND(badgelink_NvsEntriesList, badgelink_NvsEntriesList, 4)
+PB_BIND(badgelink_NvsBatchResp, badgelink_NvsBatchResp, 2)
 
 
-PB_BIND(badgelink_NvsActionResp, badgelink_NvsActionResp, 4)
+PB_BIND(badgelink_NvsBatchResult, badgelink_NvsBatchResult, AUTO)
 
 
 
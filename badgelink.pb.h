@@ -4,6 +4,7 @@
 #ifndef PB_BADGELINK_BADGELINK_PB_H_INCLUDED
 #define PB_BADGELINK_BADGELINK_PB_H_INCLUDED
 #include <pb.h>
+#include "badgelink_chunk.h"
 
 #if PB_PROTO_HEADER_VERSION != 40
 #error Regenerate this file with the current version of nanopb generator.
@@ -44,6 +45,98 @@ typedef enum _badgelink_XferReq {
     badgelink_XferReq_XferFinish = 2
 } badgelink_XferReq;
 
+typedef enum _badgelink_ChunkCompression {
+    /* Chunk data is sent as is. */
+    badgelink_ChunkCompression_CompressionNone = 0,
+    /* Chunks may be compressed with LZF. */
+    badgelink_ChunkCompression_CompressionLzf = 1
+} badgelink_ChunkCompression;
+
+typedef enum _badgelink_DigestType {
+    /* Transfers only get a CRC32. */
+    badgelink_DigestType_DigestNone = 0,
+    /* Transfers also get a SHA-256. */
+    badgelink_DigestType_DigestSha256 = 1
+} badgelink_DigestType;
+
+typedef enum _badgelink_NakReason {
+    /* The CRC32 of the frame didn't match. */
+    badgelink_NakReason_NakCrc = 0,
+    /* The frame was too short, too long or not valid COBS. */
+    badgelink_NakReason_NakFraming = 1,
+    /* The frame could not be decoded as a packet. */
+    badgelink_NakReason_NakDecode = 2
+} badgelink_NakReason;
+
+typedef enum _badgelink_TraceEventType {
+    /* First byte of a frame received; arg is the index of the transport. */
+    badgelink_TraceEventType_TraceFrameStart = 0,
+    /* Null-terminator of a frame received; arg is the decoded length. */
+    badgelink_TraceEventType_TraceFrameEnd = 1,
+    /* Packet decoded; arg is the decoded length. */
+    badgelink_TraceEventType_TraceDecoded = 2,
+    /* Request handler entered; arg is `which_req`. */
+    badgelink_TraceEventType_TraceHandleBegin = 3,
+    /* Request handler returned; arg is `which_req`. */
+    badgelink_TraceEventType_TraceHandleEnd = 4,
+    /* Storage read or write started; arg is the length. */
+    badgelink_TraceEventType_TraceStorageBegin = 5,
+    /* Storage read or write done; arg is the status code. */
+    badgelink_TraceEventType_TraceStorageEnd = 6,
+    /* Frame encoded and queued for sending; arg is the encoded length. */
+    badgelink_TraceEventType_TraceTxQueued = 7,
+    /* Frame handed to the transport; arg is the encoded length. */
+    badgelink_TraceEventType_TraceTxDone = 8
+} badgelink_TraceEventType;
+
+typedef enum _badgelink_HistogramStage {
+    /* COBS-decoding and checking the CRC32 of a frame. */
+    badgelink_HistogramStage_StageCobs = 0,
+    /* Decoding a packet. */
+    badgelink_HistogramStage_StageDecode = 1,
+    /* Handling a request, including encoding its response. */
+    badgelink_HistogramStage_StageHandle = 2,
+    /* Encoding a packet. */
+    badgelink_HistogramStage_StageEncode = 3,
+    /* A read or write of an AppFS transfer. */
+    badgelink_HistogramStage_StageStorageAppfs = 4,
+    /* A read or write of a filesystem transfer. */
+    badgelink_HistogramStage_StageStorageFs = 5,
+    /* Handing a frame to the transport. */
+    badgelink_HistogramStage_StageTx = 6
+} badgelink_HistogramStage;
+
+typedef enum _badgelink_Capability {
+    /* No capabilities. */
+    badgelink_Capability_CapNone = 0,
+    /* Filesystem requests. */
+    badgelink_Capability_CapFs = 1,
+    /* AppFS requests. */
+    badgelink_Capability_CapAppfs = 2,
+    /* NVS requests. */
+    badgelink_Capability_CapNvs = 4,
+    /* Start app requests. */
+    badgelink_Capability_CapStartApp = 8,
+    /* Self-benchmark and echo requests. */
+    badgelink_Capability_CapBench = 16,
+    /* Trace dump requests. */
+    badgelink_Capability_CapTrace = 32,
+    /* Latency histogram requests. */
+    badgelink_Capability_CapHistograms = 64,
+    /* Batched NVS operations. */
+    badgelink_Capability_CapNvsBatch = 128,
+    /* Sector CRC32s for delta uploads. */
+    badgelink_Capability_CapDelta = 256,
+    /* Tree uploads. */
+    badgelink_Capability_CapTreeUpload = 512,
+    /* Resumable uploads. */
+    badgelink_Capability_CapResumable = 1024,
+    /* NVS snapshot export and import. */
+    badgelink_Capability_CapNvsSnapshot = 2048,
+    /* Stat requests for many paths at once. */
+    badgelink_Capability_CapFsStatMany = 4096
+} badgelink_Capability;
+
 typedef enum _badgelink_FsActionType {
     /* List directory / whole AppFS. */
     badgelink_FsActionType_FsActionList = 0,
@@ -66,7 +159,11 @@ typedef enum _badgelink_FsActionType {
     /* Copy file. */
     badgelink_FsActionType_FsActionCopy = 9,
     /* Rename / move file. */
-    badgelink_FsActionType_FsActionRename = 10
+    badgelink_FsActionType_FsActionRename = 10,
+    /* Get the CRC32 of every sector of an AppFS file. */
+    badgelink_FsActionType_FsActionSectorCrc32 = 11,
+    /* Upload a tree of directories and files as one stream. */
+    badgelink_FsActionType_FsActionTreeUpload = 12
 } badgelink_FsActionType;
 
 typedef enum _badgelink_NvsActionType {
@@ -77,7 +174,13 @@ typedef enum _badgelink_NvsActionType {
     /* Write an NVS entry. */
     badgelink_NvsActionType_NvsActionWrite = 2,
     /* Delete an NVS entry. */
-    badgelink_NvsActionType_NvsActionDelete = 3
+    badgelink_NvsActionType_NvsActionDelete = 3,
+    /* Read, write and delete several NVS entries at once. */
+    badgelink_NvsActionType_NvsActionBatch = 4,
+    /* Download a snapshot of a namespace or all of NVS. */
+    badgelink_NvsActionType_NvsActionExport = 5,
+    /* Upload a snapshot and write all of its entries. */
+    badgelink_NvsActionType_NvsActionImport = 6
 } badgelink_NvsActionType;
 
 typedef enum _badgelink_NvsValueType {
@@ -108,6 +211,12 @@ typedef enum _badgelink_NvsValueType {
 typedef struct _badgelink_VersionReq {
     /* Highest protocol version supported by client. */
     uint32_t client_version;
+    /* Largest chunk the client can handle; 0 for the 4096 bytes of older clients. */
+    uint32_t max_chunk_size;
+    /* Compression the client supports for chunks. */
+    badgelink_ChunkCompression compression;
+    /* Digest the client wants transfers to get. */
+    badgelink_DigestType digest;
 } badgelink_VersionReq;
 
 /* Protocol version response. */
@@ -116,8 +225,190 @@ typedef struct _badgelink_VersionResp {
     uint32_t server_version;
     /* Negotiated protocol version (min of client and server). */
     uint32_t negotiated_version;
+    /* Number of upload chunks the client may have in flight (v4+). */
+    uint32_t upload_window;
+    /* Maximum size of chunk data the server sends. */
+    uint32_t chunk_size;
+    /* Compression either side may use for chunks. */
+    badgelink_ChunkCompression compression;
+    /* Digest transfers get, sent with `XferResult` when they finish. */
+    badgelink_DigestType digest;
+    /* Bitmap of `badgelink_Capability` values of what the server can do besides what its version says. */
+    uint32_t capabilities;
 } badgelink_VersionResp;
 
+/* Cumulative upload acknowledgement (v4+). */
+typedef struct _badgelink_XferAck {
+    /* Number of bytes received in order so far. */
+    uint32_t position;
+    /* Chunks were lost; resend everything starting at `position`. */
+    bool retransmit;
+} badgelink_XferAck;
+
+typedef PB_BYTES_ARRAY_T(32) badgelink_XferResult_sha256_t;
+/* Result of a finished transfer, if a digest was negotiated. */
+typedef struct _badgelink_XferResult {
+    /* CRC32 of the file. */
+    uint32_t crc32;
+    /* Size of the file. */
+    uint32_t size;
+    /* SHA-256 of the file. */
+    badgelink_XferResult_sha256_t sha256;
+} badgelink_XferResult;
+
+/* Sent when a received frame was corrupted, so the host can resend without waiting for a timeout (v6+). */
+typedef struct _badgelink_Nak {
+    /* Why the frame was rejected. */
+    badgelink_NakReason reason;
+    /* Last transfer started over the transport, or 0 if none is in progress. */
+    uint32_t session;
+    /* Next position that transfer expects an upload chunk for. */
+    uint32_t position;
+} badgelink_Nak;
+
+/* Request for the statistics counters. */
+typedef struct _badgelink_StatsReq {
+    /* Reset the counters after reading them. */
+    bool reset;
+} badgelink_StatsReq;
+
+/* Statistics counters, since the badge started or they were last reset. */
+typedef struct _badgelink_Stats {
+    /* Milliseconds the counters cover. */
+    uint32_t period_ms;
+    /* Frames received and sent. */
+    uint32_t frames_rx;
+    uint32_t frames_tx;
+    /* Bytes received and sent, including framing. */
+    uint64_t bytes_rx;
+    uint64_t bytes_tx;
+    /* Received bytes that didn't fit in the RX buffer and had to be offered again or were dropped. */
+    uint64_t rx_overflow;
+    /* Frames with a wrong CRC32, broken framing or that didn't decode. */
+    uint32_t crc_errors;
+    uint32_t framing_errors;
+    uint32_t decode_errors;
+    /* Requests ignored because their serial no. was already handled. */
+    uint32_t retransmits;
+    /* NAKs sent for corrupted frames. */
+    uint32_t naks_sent;
+    /* Microseconds spent COBS-decoding and checking CRC32s, decoding, handling requests, encoding and doing storage I/O. */
+    uint64_t cobs_us;
+    uint64_t decode_us;
+    uint64_t handle_us;
+    uint64_t encode_us;
+    uint64_t storage_us;
+    /* Transfers started. */
+    uint32_t xfers;
+} badgelink_Stats;
+
+/* Request for a page of the trace ring. */
+typedef struct _badgelink_TraceReq {
+    /* Index of the first event to send, counting from the oldest; 0 starts a new dump. */
+    uint32_t offset;
+    /* Empty the ring once the last page was sent. */
+    bool clear;
+} badgelink_TraceReq;
+
+typedef PB_BYTES_ARRAY_T(1440) badgelink_TraceDump_events_t;
+/* A page of the trace ring. */
+typedef struct _badgelink_TraceDump {
+    /* Number of events in the ring. */
+    uint32_t total;
+    /* Number of events recorded, including those that were overwritten. */
+    uint32_t recorded;
+    /* Offset of the next page, or 0 if this is the last one. */
+    uint32_t next;
+    /* Events of 12 bytes each: uint32 time_us, uint32 arg, uint8 type, uint8 core and 2 reserved bytes, little-endian. */
+    badgelink_TraceDump_events_t events;
+} badgelink_TraceDump;
+
+/* Request for a page of the latency histograms. */
+typedef struct _badgelink_HistogramReq {
+    /* Index of the first histogram to send; 0 for the first page. */
+    uint32_t offset;
+    /* Empty the histograms once the last page was sent. */
+    bool reset;
+} badgelink_HistogramReq;
+
+/* Latency histogram of a stage, or of handling one type of request. */
+typedef struct _badgelink_Histogram {
+    /* Stage that was timed. */
+    badgelink_HistogramStage stage;
+    /* For `StageHandle`, the type of request, or 0 for all of them. */
+    uint32_t which_req;
+    /* Sum of the times, in microseconds. */
+    uint64_t total_us;
+    /* Bucket 0 counts times under 1 us and bucket n times from 2^(n-1) us up to 2^n us; the last also counts all longer times. */
+    pb_size_t buckets_count;
+    uint32_t buckets[24];
+} badgelink_Histogram;
+
+/* A page of the latency histograms. */
+typedef struct _badgelink_Histograms {
+    /* Milliseconds since the badge started or the histograms were last reset. */
+    uint32_t period_ms;
+    /* Histograms that aren't empty. */
+    pb_size_t histograms_count;
+    badgelink_Histogram histograms[8];
+    /* Offset of the next page, or 0 if this is the last one. */
+    uint32_t next;
+} badgelink_Histograms;
+
+/* Request to benchmark the stages a transfer goes through on the badge itself. */
+typedef struct _badgelink_BenchReq {
+    /* File to write and read back to time the filesystem, or empty to skip it. */
+    char path[256];
+    /* Bytes to put through each stage; 0 for 256 KiB. */
+    uint32_t size;
+    /* Also time writing and reading a temporary AppFS file. */
+    bool appfs;
+} badgelink_BenchReq;
+
+/* Time each stage took to process `size` bytes, in microseconds; 0 if a stage was skipped. */
+typedef struct _badgelink_BenchResult {
+    /* Bytes put through each stage. */
+    uint32_t size;
+    /* Size of the chunks the data was processed in. */
+    uint32_t chunk_size;
+    /* Erasing the AppFS file. */
+    uint32_t appfs_erase_us;
+    /* Writing to the erased AppFS file. */
+    uint32_t appfs_write_us;
+    /* Reading the AppFS file. */
+    uint32_t appfs_read_us;
+    /* Writing the file at `path`, including closing it. */
+    uint32_t fs_write_us;
+    /* Reading the file at `path`. */
+    uint32_t fs_read_us;
+    /* Calculating the CRC32. */
+    uint32_t crc32_us;
+    /* COBS-encoding chunk-sized frames, including their CRC32. */
+    uint32_t cobs_encode_us;
+    /* COBS-decoding and checking those frames. */
+    uint32_t cobs_decode_us;
+    /* Protobuf-encoding full `Chunk`s. */
+    uint32_t pb_encode_us;
+    /* Protobuf-decoding those `Chunk`s. */
+    uint32_t pb_decode_us;
+} badgelink_BenchResult;
+
+/* Request to echo or discard data, to measure the link without storage. */
+typedef struct _badgelink_EchoReq {
+    /* Data to send over the link; discarded by the badge. */
+    badgelink_chunk_data_t data;
+    /* Bytes of data to send back, at most the chunk size; 0 to only acknowledge. */
+    uint32_t reply_size;
+} badgelink_EchoReq;
+
+/* Response to an echo request. */
+typedef struct _badgelink_EchoResp {
+    /* Bytes of data the badge received. */
+    uint32_t received;
+    /* Data sent back: the received data repeated, or a pattern if none was received. */
+    badgelink_chunk_data_t data;
+} badgelink_EchoResp;
+
 typedef struct _badgelink_StartAppReq {
     /* App slug. */
     char slug[48];
@@ -125,13 +416,14 @@ typedef struct _badgelink_StartAppReq {
     char arg[128];
 } badgelink_StartAppReq;
 
-typedef PB_BYTES_ARRAY_T(4096) badgelink_Chunk_data_t;
 /* Upload / download chunk; */
 typedef struct _badgelink_Chunk {
     /* File position. */
     uint32_t position;
     /* File data. */
-    badgelink_Chunk_data_t data;
+    badgelink_chunk_data_t data;
+    /* Whether the data is compressed. */
+    bool compressed;
 } badgelink_Chunk;
 
 /* Filesystem usage statistics. */
@@ -140,6 +432,8 @@ typedef struct _badgelink_FsUsage {
     uint32_t size;
     /* Used amount. */
     uint32_t used;
+    /* Number of bytes `size` and `used` are counted in, or 0 for 1. */
+    uint32_t unit;
 } badgelink_FsUsage;
 
 typedef struct _badgelink_AppfsMetadata {
@@ -153,6 +447,7 @@ typedef struct _badgelink_AppfsMetadata {
     uint32_t size;
 } badgelink_AppfsMetadata;
 
+typedef PB_BYTES_ARRAY_T(32) badgelink_AppfsActionReq_sha256_t;
 typedef struct _badgelink_AppfsActionReq {
     /* Action to perform. */
     badgelink_FsActionType type;
@@ -165,8 +460,20 @@ typedef struct _badgelink_AppfsActionReq {
     } id;
     /* CRC32 checksum (for upload). */
     uint32_t crc32;
-    /* AppFS list offset. */
+    /* AppFS list offset (for list) or first sector (for sector CRC32s). */
     uint32_t list_offset;
+    /* Update the existing app in place, skipping unchanged sectors (for upload). */
+    bool delta;
+    /* Size of the LZF-compressed stream that is sent instead of the app, or 0 if it is not compressed (for upload). */
+    uint32_t compressed_size;
+    /* SHA-256 the app must have, or empty (for upload). */
+    badgelink_AppfsActionReq_sha256_t sha256;
+    /* Position to start at (for download). */
+    uint32_t offset;
+    /* Number of bytes to send, or 0 for up to the end of the app (for download). */
+    uint32_t length;
+    /* Keep the partial app if aborted, and continue an earlier one that was (for upload). */
+    bool resumable;
 } badgelink_AppfsActionReq;
 
 typedef struct _badgelink_AppfsList {
@@ -177,6 +484,17 @@ typedef struct _badgelink_AppfsList {
     uint32_t total_size;
 } badgelink_AppfsList;
 
+typedef struct _badgelink_AppfsSectorCrcs {
+    /* Index of the first sector in this page of CRC32s. */
+    uint32_t offset;
+    /* CRC32 of each sector. */
+    badgelink_list_arena_t crc32;
+    /* Total number of sectors in the app. */
+    uint32_t total_sectors;
+    /* Size of a sector in bytes. */
+    uint32_t sector_size;
+} badgelink_AppfsSectorCrcs;
+
 typedef struct _badgelink_AppfsActionResp {
     pb_size_t which_val;
     union _badgelink_AppfsActionResp_val {
@@ -188,6 +506,8 @@ typedef struct _badgelink_AppfsActionResp {
         badgelink_AppfsList list;
         /* Usage statistics. */
         badgelink_FsUsage usage;
+        /* CRC32 of each sector (for sector CRC32s). */
+        badgelink_AppfsSectorCrcs sector_crcs;
     } val;
     /* App size (for download). */
     uint32_t size;
@@ -206,6 +526,7 @@ typedef struct _badgelink_FsStat {
     bool is_dir;
 } badgelink_FsStat;
 
+typedef PB_BYTES_ARRAY_T(32) badgelink_FsActionReq_sha256_t;
 typedef struct _badgelink_FsActionReq {
     /* Action to perform. */
     badgelink_FsActionType type;
@@ -219,6 +540,28 @@ typedef struct _badgelink_FsActionReq {
     uint32_t size;
     /* Destination path (for copy/rename). */
     char dest_path[1024];
+    /* Block size (for sector CRC32s and delta upload). */
+    uint32_t block_size;
+    /* Patch the existing file in place (for upload). */
+    bool delta;
+    /* Cursor from the previous page for list, or 0 to start a new listing. */
+    uint32_t cursor;
+    /* Whether the client understands cursors for list. */
+    bool use_cursor;
+    /* Don't count the total number of dirents for a new listing with a cursor. */
+    bool skip_total;
+    /* Include the size and modification time of every dirent (for list). */
+    bool with_stat;
+    /* Also remove or copy everything in the directory (for rmdir and copy). */
+    bool recursive;
+    /* SHA-256 the file must have, or empty (for upload). */
+    badgelink_FsActionReq_sha256_t sha256;
+    /* Position to start at (for download). */
+    uint32_t offset;
+    /* Number of bytes to send, or 0 for up to the end of the file (for download). */
+    uint32_t length;
+    /* Keep the partial file if aborted, and continue an earlier one that was (for upload). */
+    bool resumable;
 } badgelink_FsActionReq;
 
 typedef struct _badgelink_FsDirent {
@@ -226,14 +569,21 @@ typedef struct _badgelink_FsDirent {
     char name[256];
     /* Is a directory. */
     bool is_dir;
+    /* File size, if `has_stat`. */
+    uint32_t size;
+    /* Last modification time in milliseconds, if `has_stat`. */
+    uint64_t mtime;
+    /* Whether `size` and `mtime` are filled in. */
+    bool has_stat;
 } badgelink_FsDirent;
 
 typedef struct _badgelink_FsDirentList {
     /* List of dirents. */
-    pb_size_t list_count;
-    badgelink_FsDirent list[16];
+    badgelink_list_arena_t list;
     /* Total number of dirents. */
     uint32_t total_size;
+    /* Cursor to continue the listing with, or 0 if there are no more dirents. */
+    uint32_t cursor;
 } badgelink_FsDirentList;
 
 typedef struct _badgelink_FsActionResp {
@@ -247,12 +597,39 @@ typedef struct _badgelink_FsActionResp {
         badgelink_FsDirentList list;
         /* Filesystem usage statistics. */
         badgelink_FsUsage usage;
+        /* CRC32 of each block (for sector CRC32s). */
+        badgelink_AppfsSectorCrcs sector_crcs;
     } val;
     /* File size (for download). */
     uint32_t size;
+    /* Number of files and directories (for recursive rmdir and copy). */
+    uint32_t count;
 } badgelink_FsActionResp;
 
-typedef PB_BYTES_ARRAY_T(4096) badgelink_NvsValue_blobval_t;
+/* Request to stat many paths at once. */
+typedef struct _badgelink_FsStatManyReq {
+    /* Paths to stat, each followed by a 0 byte. */
+    badgelink_chunk_data_t paths;
+} badgelink_FsStatManyReq;
+
+typedef struct _badgelink_FsStatResult {
+    /* Status of the stat of this path. */
+    badgelink_StatusCode status;
+    /* File stat info, if found. */
+    bool has_stat;
+    badgelink_FsStat stat;
+    /* CRC32 of the file, if `has_crc32`. */
+    uint32_t crc32;
+    /* Whether the badge remembered the CRC32 of the file, so `crc32` is filled in. */
+    bool has_crc32;
+} badgelink_FsStatResult;
+
+/* Response to a request to stat many paths. */
+typedef struct _badgelink_FsStatManyResp {
+    /* Result for each path, in order; paths that didn't fit in the response are left out. */
+    badgelink_list_arena_t results;
+} badgelink_FsStatManyResp;
+
 typedef struct _badgelink_NvsValue {
     /* Value type. */
     badgelink_NvsValueType type;
@@ -261,9 +638,9 @@ typedef struct _badgelink_NvsValue {
         /* Numeric value. */
         uint64_t numericval;
         /* String value. */
-        char stringval[4096];
+        badgelink_chunk_data_t stringval;
         /* Blob value. */
-        badgelink_NvsValue_blobval_t blobval;
+        badgelink_chunk_data_t blobval;
     } val;
 } badgelink_NvsValue;
 
@@ -276,6 +653,20 @@ typedef struct _badgelink_NvsEntry {
     char key[17];
 } badgelink_NvsEntry;
 
+typedef struct _badgelink_NvsBatchOp {
+    /* Action to perform; read, write or delete. */
+    badgelink_NvsActionType type;
+    /* NVS namespace. */
+    char namespc[17];
+    /* NVS key. */
+    char key[17];
+    /* NVS value for writes. */
+    bool has_wdata;
+    badgelink_NvsValue wdata;
+    /* NVS read type. */
+    badgelink_NvsValueType read_type;
+} badgelink_NvsBatchOp;
+
 typedef struct _badgelink_NvsActionReq {
     /* Action to perform. */
     badgelink_NvsActionType type;
@@ -290,6 +681,19 @@ typedef struct _badgelink_NvsActionReq {
     uint32_t list_offset;
     /* NVS read type (because one ns/key pair can have a value per type). */
     badgelink_NvsValueType read_type;
+    /* Operations to perform (for batch). */
+    pb_size_t batch_count;
+    badgelink_NvsBatchOp batch[24];
+    /* Cursor from the previous page for list, or 0 to start a new listing. */
+    uint32_t cursor;
+    /* Whether the client understands cursors for list. */
+    bool use_cursor;
+    /* Don't count the total number of entries for a new listing with a cursor. */
+    bool skip_total;
+    /* Size of the snapshot (for import). */
+    uint32_t size;
+    /* CRC32 of the snapshot (for import). */
+    uint32_t crc32;
 } badgelink_NvsActionReq;
 
 typedef struct _badgelink_Request {
@@ -309,17 +713,48 @@ typedef struct _badgelink_Request {
         badgelink_XferReq xfer_ctrl;
         /* Protocol version request. */
         badgelink_VersionReq version_req;
+        /* Number of download chunks the badge may send without further requests (v4+). */
+        uint32_t xfer_credit;
+        /* Statistics request. */
+        badgelink_StatsReq stats_req;
+        /* Trace dump request. */
+        badgelink_TraceReq trace_req;
+        /* Latency histogram request. */
+        badgelink_HistogramReq histogram_req;
+        /* On-badge benchmark request. */
+        badgelink_BenchReq bench_req;
+        /* Link benchmark request. */
+        badgelink_EchoReq echo_req;
+        /* Stat many paths at once. */
+        badgelink_FsStatManyReq fs_stat_many;
     } req;
+    /* Transfer an upload chunk, transfer control or credit is for, or 0 for the last one started (v5+). */
+    uint32_t session;
 } badgelink_Request;
 
 typedef struct _badgelink_NvsEntriesList {
     /* List of NVS entries. */
-    pb_size_t entries_count;
-    badgelink_NvsEntry entries[128];
+    badgelink_list_arena_t entries;
     /* Total number of entries (before and/or after). */
     uint32_t total_entries;
+    /* Cursor to continue the listing with, or 0 if there are no more entries. */
+    uint32_t cursor;
 } badgelink_NvsEntriesList;
 
+typedef struct _badgelink_NvsBatchResult {
+    /* Status of this operation. */
+    badgelink_StatusCode status;
+    /* NVS value (for reads). */
+    bool has_rdata;
+    badgelink_NvsValue rdata;
+} badgelink_NvsBatchResult;
+
+typedef struct _badgelink_NvsBatchResp {
+    /* Result of each operation, in the order they were requested. */
+    pb_size_t results_count;
+    badgelink_NvsBatchResult results[24];
+} badgelink_NvsBatchResp;
+
 typedef struct _badgelink_NvsActionResp {
     pb_size_t which_val;
     union _badgelink_NvsActionResp_val {
@@ -327,7 +762,13 @@ typedef struct _badgelink_NvsActionResp {
         badgelink_NvsValue rdata;
         /* List of NVS entries. */
         badgelink_NvsEntriesList entries;
+        /* Results of a batch. */
+        badgelink_NvsBatchResp batch;
     } val;
+    /* Size of the snapshot (for export). */
+    uint32_t size;
+    /* CRC32 of the snapshot (for export). */
+    uint32_t crc32;
 } badgelink_NvsActionResp;
 
 typedef struct _badgelink_Response {
@@ -345,7 +786,25 @@ typedef struct _badgelink_Response {
         badgelink_NvsActionResp nvs_resp;
         /* Protocol version response. */
         badgelink_VersionResp version_resp;
+        /* Upload chunk acknowledgement (v4+). */
+        badgelink_XferAck xfer_ack;
+        /* Result of a finished transfer, if a digest was negotiated. */
+        badgelink_XferResult xfer_result;
+        /* Statistics counters. */
+        badgelink_Stats stats;
+        /* Page of the trace ring. */
+        badgelink_TraceDump trace;
+        /* Page of the latency histograms. */
+        badgelink_Histograms histograms;
+        /* Result of an on-badge benchmark. */
+        badgelink_BenchResult bench;
+        /* Response to a link benchmark request. */
+        badgelink_EchoResp echo;
+        /* Response to a request to stat many paths. */
+        badgelink_FsStatManyResp fs_stats;
     } resp;
+    /* Transfer the response is for, or 0 if it isn't for one (v5+). */
+    uint32_t session;
 } badgelink_Response;
 
 typedef struct _badgelink_Packet {
@@ -359,7 +818,15 @@ typedef struct _badgelink_Packet {
         badgelink_Response response;
         /* Sync packet; set initial serial no. if true. */
         bool sync;
+        /* Negative acknowledgement badge -> host; the serial no. is that of the last request handled. */
+        badgelink_Nak nak;
     } packet;
+    /* Version negotiation host -> badge along with a sync packet, to connect in one round trip. */
+    bool has_hello;
+    badgelink_VersionReq hello;
+    /* Result of the version negotiation badge -> host along with a sync packet. */
+    bool has_welcome;
+    badgelink_VersionResp welcome;
 } badgelink_Packet;
 
 
@@ -376,13 +843,37 @@ extern "C" {
 #define _badgelink_XferReq_MAX badgelink_XferReq_XferFinish
 #define _badgelink_XferReq_ARRAYSIZE ((badgelink_XferReq)(badgelink_XferReq_XferFinish+1))
 
+#define _badgelink_ChunkCompression_MIN badgelink_ChunkCompression_CompressionNone
+#define _badgelink_ChunkCompression_MAX badgelink_ChunkCompression_CompressionLzf
+#define _badgelink_ChunkCompression_ARRAYSIZE ((badgelink_ChunkCompression)(badgelink_ChunkCompression_CompressionLzf+1))
+
+#define _badgelink_DigestType_MIN badgelink_DigestType_DigestNone
+#define _badgelink_DigestType_MAX badgelink_DigestType_DigestSha256
+#define _badgelink_DigestType_ARRAYSIZE ((badgelink_DigestType)(badgelink_DigestType_DigestSha256+1))
+
+#define _badgelink_NakReason_MIN badgelink_NakReason_NakCrc
+#define _badgelink_NakReason_MAX badgelink_NakReason_NakDecode
+#define _badgelink_NakReason_ARRAYSIZE ((badgelink_NakReason)(badgelink_NakReason_NakDecode+1))
+
+#define _badgelink_TraceEventType_MIN badgelink_TraceEventType_TraceFrameStart
+#define _badgelink_TraceEventType_MAX badgelink_TraceEventType_TraceTxDone
+#define _badgelink_TraceEventType_ARRAYSIZE ((badgelink_TraceEventType)(badgelink_TraceEventType_TraceTxDone+1))
+
+#define _badgelink_HistogramStage_MIN badgelink_HistogramStage_StageCobs
+#define _badgelink_HistogramStage_MAX badgelink_HistogramStage_StageTx
+#define _badgelink_HistogramStage_ARRAYSIZE ((badgelink_HistogramStage)(badgelink_HistogramStage_StageTx+1))
+
+#define _badgelink_Capability_MIN badgelink_Capability_CapNone
+#define _badgelink_Capability_MAX badgelink_Capability_CapFsStatMany
+#define _badgelink_Capability_ARRAYSIZE ((badgelink_Capability)(badgelink_Capability_CapFsStatMany+1))
+
 #define _badgelink_FsActionType_MIN badgelink_FsActionType_FsActionList
-#define _badgelink_FsActionType_MAX badgelink_FsActionType_FsActionRename
-#define _badgelink_FsActionType_ARRAYSIZE ((badgelink_FsActionType)(badgelink_FsActionType_FsActionRename+1))
+#define _badgelink_FsActionType_MAX badgelink_FsActionType_FsActionTreeUpload
+#define _badgelink_FsActionType_ARRAYSIZE ((badgelink_FsActionType)(badgelink_FsActionType_FsActionTreeUpload+1))
 
 #define _badgelink_NvsActionType_MIN badgelink_NvsActionType_NvsActionList
-#define _badgelink_NvsActionType_MAX badgelink_NvsActionType_NvsActionDelete
-#define _badgelink_NvsActionType_ARRAYSIZE ((badgelink_NvsActionType)(badgelink_NvsActionType_NvsActionDelete+1))
+#define _badgelink_NvsActionType_MAX badgelink_NvsActionType_NvsActionImport
+#define _badgelink_NvsActionType_ARRAYSIZE ((badgelink_NvsActionType)(badgelink_NvsActionType_NvsActionImport+1))
 
 #define _badgelink_NvsValueType_MIN badgelink_NvsValueType_NvsValueUint8
 #define _badgelink_NvsValueType_MAX badgelink_NvsValueType_NvsValueBlob
@@ -391,6 +882,15 @@ extern "C" {
 
 #define badgelink_Request_req_xfer_ctrl_ENUMTYPE badgelink_XferReq
 
+#define badgelink_VersionReq_compression_ENUMTYPE badgelink_ChunkCompression
+#define badgelink_VersionReq_digest_ENUMTYPE badgelink_DigestType
+
+#define badgelink_VersionResp_compression_ENUMTYPE badgelink_ChunkCompression
+#define badgelink_VersionResp_digest_ENUMTYPE badgelink_DigestType
+
+#define badgelink_Nak_reason_ENUMTYPE badgelink_NakReason
+
+
 #define badgelink_Response_status_code_ENUMTYPE badgelink_StatusCode
 
 
@@ -407,6 +907,8 @@ extern "C" {
 
 
 
+#define badgelink_FsStatResult_status_ENUMTYPE badgelink_StatusCode
+
 #define badgelink_NvsValue_type_ENUMTYPE badgelink_NvsValueType
 
 #define badgelink_NvsEntry_type_ENUMTYPE badgelink_NvsValueType
@@ -414,58 +916,111 @@ extern "C" {
 #define badgelink_NvsActionReq_type_ENUMTYPE badgelink_NvsActionType
 #define badgelink_NvsActionReq_read_type_ENUMTYPE badgelink_NvsValueType
 
+#define badgelink_NvsBatchOp_type_ENUMTYPE badgelink_NvsActionType
+#define badgelink_NvsBatchOp_read_type_ENUMTYPE badgelink_NvsValueType
+
+#define badgelink_Histogram_stage_ENUMTYPE badgelink_HistogramStage
+
 
 
 
 /* Initializer values for message structs */
-#define badgelink_Packet_init_default            {0, 0, {badgelink_Request_init_default}}
-#define badgelink_Request_init_default           {0, {badgelink_Chunk_init_default}}
-#define badgelink_Response_init_default          {_badgelink_StatusCode_MIN, 0, {badgelink_Chunk_init_default}}
+#define badgelink_Packet_init_default            {0, 0, {badgelink_Request_init_default}, false, badgelink_VersionReq_init_default, false, badgelink_VersionResp_init_default}
+#define badgelink_Request_init_default           {0, {badgelink_Chunk_init_default}, 0}
+#define badgelink_Response_init_default          {_badgelink_StatusCode_MIN, 0, {badgelink_Chunk_init_default}, 0}
 #define badgelink_StartAppReq_init_default       {"", ""}
-#define badgelink_Chunk_init_default             {0, {0, {0}}}
-#define badgelink_FsUsage_init_default           {0, 0}
+#define badgelink_VersionReq_init_default        {0, 0, _badgelink_ChunkCompression_MIN, _badgelink_DigestType_MIN}
+#define badgelink_VersionResp_init_default       {0, 0, 0, 0, _badgelink_ChunkCompression_MIN, _badgelink_DigestType_MIN, 0}
+#define badgelink_Chunk_init_default             {0, {0}, 0}
+#define badgelink_FsUsage_init_default           {0, 0, 0}
 #define badgelink_AppfsMetadata_init_default     {"", "", 0, 0}
-#define badgelink_AppfsActionReq_init_default    {_badgelink_FsActionType_MIN, 0, {badgelink_AppfsMetadata_init_default}, 0, 0}
+#define badgelink_AppfsActionReq_init_default    {_badgelink_FsActionType_MIN, 0, {badgelink_AppfsMetadata_init_default}, 0, 0, 0, 0, {0, {0}}, 0, 0, 0}
 #define badgelink_AppfsList_init_default         {0, {badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default, badgelink_AppfsMetadata_init_default}, 0}
+#define badgelink_AppfsSectorCrcs_init_default   {0, {NULL, 0}, 0, 0}
 #define badgelink_AppfsActionResp_init_default   {0, {badgelink_AppfsMetadata_init_default}, 0}
 #define badgelink_FsStat_init_default            {0, 0, 0, 0, 0}
-#define badgelink_FsActionReq_init_default       {_badgelink_FsActionType_MIN, "", 0, 0, 0, ""}
-#define badgelink_FsDirent_init_default          {"", 0}
-#define badgelink_FsDirentList_init_default      {0, {badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default, badgelink_FsDirent_init_default}, 0}
-#define badgelink_FsActionResp_init_default      {0, {badgelink_FsStat_init_default}, 0}
+#define badgelink_FsActionReq_init_default       {_badgelink_FsActionType_MIN, "", 0, 0, 0, "", 0, 0, 0, 0, 0, 0, 0, {0, {0}}, 0, 0, 0}
+#define badgelink_FsDirent_init_default          {"", 0, 0, 0, 0}
+#define badgelink_FsDirentList_init_default      {{NULL, 0}, 0, 0}
+#define badgelink_FsActionResp_init_default      {0, {badgelink_FsStat_init_default}, 0, 0}
+#define badgelink_FsStatManyReq_init_default     {{0}}
+#define badgelink_FsStatResult_init_default      {_badgelink_StatusCode_MIN, false, badgelink_FsStat_init_default, 0, 0}
+#define badgelink_FsStatManyResp_init_default    {{NULL, 0}}
 #define badgelink_NvsValue_init_default          {_badgelink_NvsValueType_MIN, 0, {0}}
 #define badgelink_NvsEntry_init_default          {_badgelink_NvsValueType_MIN, "", ""}
-#define badgelink_NvsActionReq_init_default      {_badgelink_NvsActionType_MIN, "", "", false, badgelink_NvsValue_init_default, 0, _badgelink_NvsValueType_MIN}
-#define badgelink_NvsEntriesList_init_default    {0, {badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default, badgelink_NvsEntry_init_default}, 0}
-#define badgelink_NvsActionResp_init_default     {0, {badgelink_NvsValue_init_default}}
-#define badgelink_Packet_init_zero               {0, 0, {badgelink_Request_init_zero}}
-#define badgelink_Request_init_zero              {0, {badgelink_Chunk_init_zero}}
-#define badgelink_Response_init_zero             {_badgelink_StatusCode_MIN, 0, {badgelink_Chunk_init_zero}}
+#define badgelink_NvsBatchOp_init_default        {_badgelink_NvsActionType_MIN, "", "", false, badgelink_NvsValue_init_default, _badgelink_NvsValueType_MIN}
+#define badgelink_NvsActionReq_init_default      {_badgelink_NvsActionType_MIN, "", "", false, badgelink_NvsValue_init_default, 0, _badgelink_NvsValueType_MIN, 0, {badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default, badgelink_NvsBatchOp_init_default}, 0, 0, 0, 0, 0}
+#define badgelink_NvsEntriesList_init_default    {{NULL, 0}, 0, 0}
+#define badgelink_NvsBatchResult_init_default    {_badgelink_StatusCode_MIN, false, badgelink_NvsValue_init_default}
+#define badgelink_NvsBatchResp_init_default      {0, {badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default, badgelink_NvsBatchResult_init_default}}
+#define badgelink_NvsActionResp_init_default     {0, {badgelink_NvsValue_init_default}, 0, 0}
+#define badgelink_XferAck_init_default           {0, 0}
+#define badgelink_XferResult_init_default        {0, 0, {0, {0}}}
+#define badgelink_Nak_init_default               {_badgelink_NakReason_MIN, 0, 0}
+#define badgelink_StatsReq_init_default          {0}
+#define badgelink_Stats_init_default             {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define badgelink_TraceReq_init_default          {0, 0}
+#define badgelink_TraceDump_init_default         {0, 0, 0, {0, {0}}}
+#define badgelink_HistogramReq_init_default      {0, 0}
+#define badgelink_Histogram_init_default         {_badgelink_HistogramStage_MIN, 0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}}
+#define badgelink_Histograms_init_default        {0, 0, {badgelink_Histogram_init_default, badgelink_Histogram_init_default, badgelink_Histogram_init_default, badgelink_Histogram_init_default, badgelink_Histogram_init_default, badgelink_Histogram_init_default, badgelink_Histogram_init_default, badgelink_Histogram_init_default}, 0}
+#define badgelink_BenchReq_init_default          {"", 0, 0}
+#define badgelink_BenchResult_init_default       {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define badgelink_EchoReq_init_default           {{0}, 0}
+#define badgelink_EchoResp_init_default          {0, {0}}
+#define badgelink_Packet_init_zero               {0, 0, {badgelink_Request_init_zero}, false, badgelink_VersionReq_init_zero, false, badgelink_VersionResp_init_zero}
+#define badgelink_Request_init_zero              {0, {badgelink_Chunk_init_zero}, 0}
+#define badgelink_Response_init_zero             {_badgelink_StatusCode_MIN, 0, {badgelink_Chunk_init_zero}, 0}
 #define badgelink_StartAppReq_init_zero          {"", ""}
-#define badgelink_Chunk_init_zero                {0, {0, {0}}}
-#define badgelink_FsUsage_init_zero              {0, 0}
+#define badgelink_VersionReq_init_zero           {0, 0, _badgelink_ChunkCompression_MIN, _badgelink_DigestType_MIN}
+#define badgelink_VersionResp_init_zero          {0, 0, 0, 0, _badgelink_ChunkCompression_MIN, _badgelink_DigestType_MIN, 0}
+#define badgelink_Chunk_init_zero                {0, {0}, 0}
+#define badgelink_FsUsage_init_zero              {0, 0, 0}
 #define badgelink_AppfsMetadata_init_zero        {"", "", 0, 0}
-#define badgelink_AppfsActionReq_init_zero       {_badgelink_FsActionType_MIN, 0, {badgelink_AppfsMetadata_init_zero}, 0, 0}
+#define badgelink_AppfsActionReq_init_zero       {_badgelink_FsActionType_MIN, 0, {badgelink_AppfsMetadata_init_zero}, 0, 0, 0, 0, {0, {0}}, 0, 0, 0}
 #define badgelink_AppfsList_init_zero            {0, {badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero, badgelink_AppfsMetadata_init_zero}, 0}
+#define badgelink_AppfsSectorCrcs_init_zero      {0, {NULL, 0}, 0, 0}
 #define badgelink_AppfsActionResp_init_zero      {0, {badgelink_AppfsMetadata_init_zero}, 0}
 #define badgelink_FsStat_init_zero               {0, 0, 0, 0, 0}
-#define badgelink_FsActionReq_init_zero          {_badgelink_FsActionType_MIN, "", 0, 0, 0, ""}
-#define badgelink_FsDirent_init_zero             {"", 0}
-#define badgelink_FsDirentList_init_zero         {0, {badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero, badgelink_FsDirent_init_zero}, 0}
-#define badgelink_FsActionResp_init_zero         {0, {badgelink_FsStat_init_zero}, 0}
+#define badgelink_FsActionReq_init_zero          {_badgelink_FsActionType_MIN, "", 0, 0, 0, "", 0, 0, 0, 0, 0, 0, 0, {0, {0}}, 0, 0, 0}
+#define badgelink_FsDirent_init_zero             {"", 0, 0, 0, 0}
+#define badgelink_FsDirentList_init_zero         {{NULL, 0}, 0, 0}
+#define badgelink_FsActionResp_init_zero         {0, {badgelink_FsStat_init_zero}, 0, 0}
+#define badgelink_FsStatManyReq_init_zero        {{0}}
+#define badgelink_FsStatResult_init_zero         {_badgelink_StatusCode_MIN, false, badgelink_FsStat_init_zero, 0, 0}
+#define badgelink_FsStatManyResp_init_zero       {{NULL, 0}}
 #define badgelink_NvsValue_init_zero             {_badgelink_NvsValueType_MIN, 0, {0}}
 #define badgelink_NvsEntry_init_zero             {_badgelink_NvsValueType_MIN, "", ""}
-#define badgelink_NvsActionReq_init_zero         {_badgelink_NvsActionType_MIN, "", "", false, badgelink_NvsValue_init_zero, 0, _badgelink_NvsValueType_MIN}
-#define badgelink_NvsEntriesList_init_zero       {0, {badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero, badgelink_NvsEntry_init_zero}, 0}
-#define badgelink_NvsActionResp_init_zero        {0, {badgelink_NvsValue_init_zero}}
+#define badgelink_NvsBatchOp_init_zero           {_badgelink_NvsActionType_MIN, "", "", false, badgelink_NvsValue_init_zero, _badgelink_NvsValueType_MIN}
+#define badgelink_NvsActionReq_init_zero         {_badgelink_NvsActionType_MIN, "", "", false, badgelink_NvsValue_init_zero, 0, _badgelink_NvsValueType_MIN, 0, {badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero, badgelink_NvsBatchOp_init_zero}, 0, 0, 0, 0, 0}
+#define badgelink_NvsEntriesList_init_zero       {{NULL, 0}, 0, 0}
+#define badgelink_NvsBatchResult_init_zero       {_badgelink_StatusCode_MIN, false, badgelink_NvsValue_init_zero}
+#define badgelink_NvsBatchResp_init_zero         {0, {badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero, badgelink_NvsBatchResult_init_zero}}
+#define badgelink_NvsActionResp_init_zero        {0, {badgelink_NvsValue_init_zero}, 0, 0}
+#define badgelink_XferAck_init_zero              {0, 0}
+#define badgelink_XferResult_init_zero           {0, 0, {0, {0}}}
+#define badgelink_Nak_init_zero                  {_badgelink_NakReason_MIN, 0, 0}
+#define badgelink_StatsReq_init_zero             {0}
+#define badgelink_Stats_init_zero                {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define badgelink_TraceReq_init_zero             {0, 0}
+#define badgelink_TraceDump_init_zero            {0, 0, 0, {0, {0}}}
+#define badgelink_HistogramReq_init_zero         {0, 0}
+#define badgelink_Histogram_init_zero            {_badgelink_HistogramStage_MIN, 0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}}
+#define badgelink_Histograms_init_zero           {0, 0, {badgelink_Histogram_init_zero, badgelink_Histogram_init_zero, badgelink_Histogram_init_zero, badgelink_Histogram_init_zero, badgelink_Histogram_init_zero, badgelink_Histogram_init_zero, badgelink_Histogram_init_zero, badgelink_Histogram_init_zero}, 0}
+#define badgelink_BenchReq_init_zero             {"", 0, 0}
+#define badgelink_BenchResult_init_zero          {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define badgelink_EchoReq_init_zero              {{0}, 0}
+#define badgelink_EchoResp_init_zero             {0, {0}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define badgelink_StartAppReq_slug_tag           1
 #define badgelink_StartAppReq_arg_tag            2
 #define badgelink_Chunk_position_tag             2
 #define badgelink_Chunk_data_tag                 3
+#define badgelink_Chunk_compressed_tag           4
 #define badgelink_FsUsage_size_tag               1
 #define badgelink_FsUsage_used_tag               2
+#define badgelink_FsUsage_unit_tag               3
 #define badgelink_AppfsMetadata_slug_tag         1
 #define badgelink_AppfsMetadata_title_tag        2
 #define badgelink_AppfsMetadata_version_tag      3
@@ -475,13 +1030,24 @@ extern "C" {
 #define badgelink_AppfsActionReq_slug_tag        3
 #define badgelink_AppfsActionReq_crc32_tag       4
 #define badgelink_AppfsActionReq_list_offset_tag 5
+#define badgelink_AppfsActionReq_delta_tag       6
+#define badgelink_AppfsActionReq_compressed_size_tag 7
+#define badgelink_AppfsActionReq_sha256_tag      8
+#define badgelink_AppfsActionReq_offset_tag      9
+#define badgelink_AppfsActionReq_length_tag      10
+#define badgelink_AppfsActionReq_resumable_tag   11
 #define badgelink_AppfsList_list_tag             1
 #define badgelink_AppfsList_total_size_tag       2
+#define badgelink_AppfsSectorCrcs_offset_tag     1
+#define badgelink_AppfsSectorCrcs_crc32_tag      2
+#define badgelink_AppfsSectorCrcs_total_sectors_tag 3
+#define badgelink_AppfsSectorCrcs_sector_size_tag 4
 #define badgelink_AppfsActionResp_metadata_tag   1
 #define badgelink_AppfsActionResp_crc32_tag      2
 #define badgelink_AppfsActionResp_list_tag       3
 #define badgelink_AppfsActionResp_usage_tag      4
 #define badgelink_AppfsActionResp_size_tag       5
+#define badgelink_AppfsActionResp_sector_crcs_tag 6
 #define badgelink_FsStat_size_tag                1
 #define badgelink_FsStat_mtime_tag               2
 #define badgelink_FsStat_ctime_tag               3
@@ -493,15 +1059,38 @@ extern "C" {
 #define badgelink_FsActionReq_list_offset_tag    4
 #define badgelink_FsActionReq_size_tag           5
 #define badgelink_FsActionReq_dest_path_tag      6
+#define badgelink_FsActionReq_block_size_tag     7
+#define badgelink_FsActionReq_delta_tag          8
+#define badgelink_FsActionReq_cursor_tag         9
+#define badgelink_FsActionReq_use_cursor_tag     10
+#define badgelink_FsActionReq_skip_total_tag     11
+#define badgelink_FsActionReq_with_stat_tag      12
+#define badgelink_FsActionReq_recursive_tag      13
+#define badgelink_FsActionReq_sha256_tag         14
+#define badgelink_FsActionReq_offset_tag         15
+#define badgelink_FsActionReq_length_tag         16
+#define badgelink_FsActionReq_resumable_tag      17
 #define badgelink_FsDirent_name_tag              1
 #define badgelink_FsDirent_is_dir_tag            2
+#define badgelink_FsDirent_size_tag              3
+#define badgelink_FsDirent_mtime_tag             4
+#define badgelink_FsDirent_has_stat_tag          5
 #define badgelink_FsDirentList_list_tag          1
 #define badgelink_FsDirentList_total_size_tag    2
+#define badgelink_FsDirentList_cursor_tag        3
 #define badgelink_FsActionResp_stat_tag          1
 #define badgelink_FsActionResp_crc32_tag         2
 #define badgelink_FsActionResp_list_tag          3
 #define badgelink_FsActionResp_usage_tag         4
+#define badgelink_FsActionResp_sector_crcs_tag   6
 #define badgelink_FsActionResp_size_tag          5
+#define badgelink_FsActionResp_count_tag         7
+#define badgelink_FsStatManyReq_paths_tag        1
+#define badgelink_FsStatResult_status_tag        1
+#define badgelink_FsStatResult_stat_tag          2
+#define badgelink_FsStatResult_crc32_tag         3
+#define badgelink_FsStatResult_has_crc32_tag     4
+#define badgelink_FsStatManyResp_results_tag     1
 #define badgelink_NvsValue_type_tag              1
 #define badgelink_NvsValue_numericval_tag        2
 #define badgelink_NvsValue_stringval_tag         3
@@ -515,6 +1104,17 @@ extern "C" {
 #define badgelink_NvsActionReq_wdata_tag         4
 #define badgelink_NvsActionReq_list_offset_tag   5
 #define badgelink_NvsActionReq_read_type_tag     6
+#define badgelink_NvsActionReq_batch_tag         7
+#define badgelink_NvsActionReq_cursor_tag        8
+#define badgelink_NvsActionReq_use_cursor_tag    9
+#define badgelink_NvsActionReq_skip_total_tag    10
+#define badgelink_NvsActionReq_size_tag          11
+#define badgelink_NvsActionReq_crc32_tag         12
+#define badgelink_NvsBatchOp_type_tag            1
+#define badgelink_NvsBatchOp_namespc_tag         2
+#define badgelink_NvsBatchOp_key_tag             3
+#define badgelink_NvsBatchOp_wdata_tag           4
+#define badgelink_NvsBatchOp_read_type_tag       5
 #define badgelink_Request_upload_chunk_tag       1
 #define badgelink_Request_appfs_action_tag       2
 #define badgelink_Request_fs_action_tag          3
@@ -522,34 +1122,134 @@ extern "C" {
 #define badgelink_Request_start_app_tag          5
 #define badgelink_Request_xfer_ctrl_tag          6
 #define badgelink_Request_version_req_tag        7
+#define badgelink_Request_xfer_credit_tag        8
+#define badgelink_Request_session_tag            9
+#define badgelink_Request_stats_req_tag          10
+#define badgelink_Request_trace_req_tag          11
+#define badgelink_Request_histogram_req_tag      12
+#define badgelink_Request_bench_req_tag          13
+#define badgelink_Request_echo_req_tag           14
+#define badgelink_Request_fs_stat_many_tag       15
 #define badgelink_VersionReq_client_version_tag  1
+#define badgelink_VersionReq_max_chunk_size_tag  2
+#define badgelink_VersionReq_compression_tag     3
+#define badgelink_VersionReq_digest_tag          4
 #define badgelink_VersionResp_server_version_tag 1
 #define badgelink_VersionResp_negotiated_version_tag 2
+#define badgelink_VersionResp_upload_window_tag  3
+#define badgelink_VersionResp_chunk_size_tag     4
+#define badgelink_VersionResp_compression_tag    5
+#define badgelink_VersionResp_digest_tag         6
+#define badgelink_XferAck_position_tag           1
+#define badgelink_XferAck_retransmit_tag         2
+#define badgelink_XferResult_crc32_tag           1
+#define badgelink_XferResult_size_tag            2
+#define badgelink_XferResult_sha256_tag          3
+#define badgelink_Nak_reason_tag                 1
+#define badgelink_Nak_session_tag                2
+#define badgelink_Nak_position_tag               3
+#define badgelink_StatsReq_reset_tag             1
+#define badgelink_Stats_period_ms_tag            1
+#define badgelink_Stats_frames_rx_tag            2
+#define badgelink_Stats_frames_tx_tag            3
+#define badgelink_Stats_bytes_rx_tag             4
+#define badgelink_Stats_bytes_tx_tag             5
+#define badgelink_Stats_rx_overflow_tag          6
+#define badgelink_Stats_crc_errors_tag           7
+#define badgelink_Stats_framing_errors_tag       8
+#define badgelink_Stats_decode_errors_tag        9
+#define badgelink_Stats_retransmits_tag          10
+#define badgelink_Stats_naks_sent_tag            11
+#define badgelink_Stats_cobs_us_tag              12
+#define badgelink_Stats_decode_us_tag            13
+#define badgelink_Stats_handle_us_tag            14
+#define badgelink_Stats_encode_us_tag            15
+#define badgelink_Stats_storage_us_tag           16
+#define badgelink_Stats_xfers_tag                17
+#define badgelink_TraceReq_offset_tag            1
+#define badgelink_TraceReq_clear_tag             2
+#define badgelink_TraceDump_total_tag            1
+#define badgelink_TraceDump_recorded_tag         2
+#define badgelink_TraceDump_next_tag             3
+#define badgelink_TraceDump_events_tag           4
+#define badgelink_HistogramReq_offset_tag        1
+#define badgelink_HistogramReq_reset_tag         2
+#define badgelink_Histogram_stage_tag            1
+#define badgelink_Histogram_which_req_tag        2
+#define badgelink_Histogram_total_us_tag         3
+#define badgelink_Histogram_buckets_tag          4
+#define badgelink_Histograms_period_ms_tag       1
+#define badgelink_Histograms_histograms_tag      2
+#define badgelink_Histograms_next_tag            3
+#define badgelink_BenchReq_path_tag              1
+#define badgelink_BenchReq_size_tag              2
+#define badgelink_BenchReq_appfs_tag             3
+#define badgelink_BenchResult_size_tag           1
+#define badgelink_BenchResult_chunk_size_tag     2
+#define badgelink_BenchResult_appfs_erase_us_tag 3
+#define badgelink_BenchResult_appfs_write_us_tag 4
+#define badgelink_BenchResult_appfs_read_us_tag  5
+#define badgelink_BenchResult_fs_write_us_tag    6
+#define badgelink_BenchResult_fs_read_us_tag     7
+#define badgelink_BenchResult_crc32_us_tag       8
+#define badgelink_BenchResult_cobs_encode_us_tag 9
+#define badgelink_BenchResult_cobs_decode_us_tag 10
+#define badgelink_BenchResult_pb_encode_us_tag   11
+#define badgelink_BenchResult_pb_decode_us_tag   12
+#define badgelink_EchoReq_data_tag               1
+#define badgelink_EchoReq_reply_size_tag         2
+#define badgelink_EchoResp_received_tag          1
+#define badgelink_EchoResp_data_tag              2
 #define badgelink_NvsEntriesList_entries_tag     1
 #define badgelink_NvsEntriesList_total_entries_tag 2
+#define badgelink_NvsEntriesList_cursor_tag      3
 #define badgelink_NvsActionResp_rdata_tag        1
 #define badgelink_NvsActionResp_entries_tag      2
+#define badgelink_NvsActionResp_batch_tag        3
+#define badgelink_NvsActionResp_size_tag         4
+#define badgelink_NvsActionResp_crc32_tag        5
+#define badgelink_NvsBatchResp_results_tag       1
+#define badgelink_NvsBatchResult_status_tag      1
+#define badgelink_NvsBatchResult_rdata_tag       2
 #define badgelink_Response_status_code_tag       1
 #define badgelink_Response_download_chunk_tag    2
 #define badgelink_Response_appfs_resp_tag        3
 #define badgelink_Response_fs_resp_tag           4
 #define badgelink_Response_nvs_resp_tag          5
 #define badgelink_Response_version_resp_tag      6
+#define badgelink_Response_xfer_ack_tag          7
+#define badgelink_Response_xfer_result_tag       8
+#define badgelink_Response_stats_tag             10
+#define badgelink_Response_trace_tag             11
+#define badgelink_Response_histograms_tag        12
+#define badgelink_Response_bench_tag             13
+#define badgelink_Response_echo_tag              14
+#define badgelink_Response_fs_stats_tag          15
+#define badgelink_Response_session_tag           9
 #define badgelink_Packet_serial_tag              1
 #define badgelink_Packet_request_tag             2
 #define badgelink_Packet_response_tag            3
 #define badgelink_Packet_sync_tag                4
+#define badgelink_Packet_nak_tag                 5
+#define badgelink_Packet_hello_tag               6
+#define badgelink_Packet_welcome_tag             7
 
 /* Struct field encoding specification for nanopb */
 #define badgelink_Packet_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT64,   serial,            1) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (packet,request,packet.request),   2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (packet,response,packet.response),   3) \
-X(a, STATIC,   ONEOF,    BOOL,     (packet,sync,packet.sync),   4)
+X(a, STATIC,   ONEOF,    BOOL,     (packet,sync,packet.sync),   4) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (packet,nak,packet.nak),   5) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  hello,             6) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  welcome,           7)
 #define badgelink_Packet_CALLBACK NULL
 #define badgelink_Packet_DEFAULT NULL
 #define badgelink_Packet_packet_request_MSGTYPE badgelink_Request
 #define badgelink_Packet_packet_response_MSGTYPE badgelink_Response
+#define badgelink_Packet_packet_nak_MSGTYPE badgelink_Nak
+#define badgelink_Packet_hello_MSGTYPE badgelink_VersionReq
+#define badgelink_Packet_welcome_MSGTYPE badgelink_VersionResp
 
 #define badgelink_Request_FIELDLIST(X, a) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (req,upload_chunk,req.upload_chunk),   1) \
@@ -558,7 +1258,15 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (req,fs_action,req.fs_action),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (req,nvs_action,req.nvs_action),   4) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (req,start_app,req.start_app),   5) \
 X(a, STATIC,   ONEOF,    UENUM,    (req,xfer_ctrl,req.xfer_ctrl),   6) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (req,version_req,req.version_req),   7)
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,version_req,req.version_req),   7) \
+X(a, STATIC,   ONEOF,    UINT32,   (req,xfer_credit,req.xfer_credit),   8) \
+X(a, STATIC,   SINGULAR, UINT32,   session,           9) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,stats_req,req.stats_req),  10) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,trace_req,req.trace_req),  11) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,histogram_req,req.histogram_req),  12) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,bench_req,req.bench_req),  13) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,echo_req,req.echo_req),  14) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (req,fs_stat_many,req.fs_stat_many),  15)
 #define badgelink_Request_CALLBACK NULL
 #define badgelink_Request_DEFAULT NULL
 #define badgelink_Request_req_upload_chunk_MSGTYPE badgelink_Chunk
@@ -567,6 +1275,12 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (req,version_req,req.version_req),   7)
 #define badgelink_Request_req_nvs_action_MSGTYPE badgelink_NvsActionReq
 #define badgelink_Request_req_start_app_MSGTYPE badgelink_StartAppReq
 #define badgelink_Request_req_version_req_MSGTYPE badgelink_VersionReq
+#define badgelink_Request_req_stats_req_MSGTYPE badgelink_StatsReq
+#define badgelink_Request_req_trace_req_MSGTYPE badgelink_TraceReq
+#define badgelink_Request_req_histogram_req_MSGTYPE badgelink_HistogramReq
+#define badgelink_Request_req_bench_req_MSGTYPE badgelink_BenchReq
+#define badgelink_Request_req_echo_req_MSGTYPE badgelink_EchoReq
+#define badgelink_Request_req_fs_stat_many_MSGTYPE badgelink_FsStatManyReq
 
 #define badgelink_Response_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UENUM,    status_code,       1) \
@@ -574,7 +1288,16 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (resp,download_chunk,resp.download_chunk),
 X(a, STATIC,   ONEOF,    MESSAGE,  (resp,appfs_resp,resp.appfs_resp),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (resp,fs_resp,resp.fs_resp),   4) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (resp,nvs_resp,resp.nvs_resp),   5) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (resp,version_resp,resp.version_resp),   6)
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,version_resp,resp.version_resp),   6) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,xfer_ack,resp.xfer_ack),   7) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,xfer_result,resp.xfer_result),   8) \
+X(a, STATIC,   SINGULAR, UINT32,   session,           9) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,stats,resp.stats),  10) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,trace,resp.trace),  11) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,histograms,resp.histograms),  12) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,bench,resp.bench),  13) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,echo,resp.echo),  14) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (resp,fs_stats,resp.fs_stats),  15)
 #define badgelink_Response_CALLBACK NULL
 #define badgelink_Response_DEFAULT NULL
 #define badgelink_Response_resp_download_chunk_MSGTYPE badgelink_Chunk
@@ -582,18 +1305,153 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (resp,version_resp,resp.version_resp),   6)
 #define badgelink_Response_resp_fs_resp_MSGTYPE badgelink_FsActionResp
 #define badgelink_Response_resp_nvs_resp_MSGTYPE badgelink_NvsActionResp
 #define badgelink_Response_resp_version_resp_MSGTYPE badgelink_VersionResp
+#define badgelink_Response_resp_xfer_ack_MSGTYPE badgelink_XferAck
+#define badgelink_Response_resp_xfer_result_MSGTYPE badgelink_XferResult
+#define badgelink_Response_resp_stats_MSGTYPE badgelink_Stats
+#define badgelink_Response_resp_trace_MSGTYPE badgelink_TraceDump
+#define badgelink_Response_resp_histograms_MSGTYPE badgelink_Histograms
+#define badgelink_Response_resp_bench_MSGTYPE badgelink_BenchResult
+#define badgelink_Response_resp_echo_MSGTYPE badgelink_EchoResp
+#define badgelink_Response_resp_fs_stats_MSGTYPE badgelink_FsStatManyResp
 
 #define badgelink_VersionReq_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, UINT32,   client_version,    1)
+X(a, STATIC,   SINGULAR, UINT32,   client_version,    1) \
+X(a, STATIC,   SINGULAR, UINT32,   max_chunk_size,    2) \
+X(a, STATIC,   SINGULAR, UENUM,    compression,       3) \
+X(a, STATIC,   SINGULAR, UENUM,    digest,            4)
 #define badgelink_VersionReq_CALLBACK NULL
 #define badgelink_VersionReq_DEFAULT NULL
 
 #define badgelink_VersionResp_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   server_version,    1) \
-X(a, STATIC,   SINGULAR, UINT32,   negotiated_version, 2)
+X(a, STATIC,   SINGULAR, UINT32,   negotiated_version, 2) \
+X(a, STATIC,   SINGULAR, UINT32,   upload_window,     3) \
+X(a, STATIC,   SINGULAR, UINT32,   chunk_size,        4) \
+X(a, STATIC,   SINGULAR, UENUM,    compression,       5) \
+X(a, STATIC,   SINGULAR, UENUM,    digest,            6) \
+X(a, STATIC,   SINGULAR, UINT32,   capabilities,      7)
 #define badgelink_VersionResp_CALLBACK NULL
 #define badgelink_VersionResp_DEFAULT NULL
 
+#define badgelink_XferAck_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   position,          1) \
+X(a, STATIC,   SINGULAR, BOOL,     retransmit,        2)
+#define badgelink_XferAck_CALLBACK NULL
+#define badgelink_XferAck_DEFAULT NULL
+
+#define badgelink_XferResult_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   crc32,             1) \
+X(a, STATIC,   SINGULAR, UINT32,   size,              2) \
+X(a, STATIC,   SINGULAR, BYTES,    sha256,            3)
+#define badgelink_XferResult_CALLBACK NULL
+#define badgelink_XferResult_DEFAULT NULL
+
+#define badgelink_Nak_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UENUM,    reason,            1) \
+X(a, STATIC,   SINGULAR, UINT32,   session,           2) \
+X(a, STATIC,   SINGULAR, UINT32,   position,          3)
+#define badgelink_Nak_CALLBACK NULL
+#define badgelink_Nak_DEFAULT NULL
+
+#define badgelink_StatsReq_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, BOOL,     reset,             1)
+#define badgelink_StatsReq_CALLBACK NULL
+#define badgelink_StatsReq_DEFAULT NULL
+
+#define badgelink_Stats_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   period_ms,         1) \
+X(a, STATIC,   SINGULAR, UINT32,   frames_rx,         2) \
+X(a, STATIC,   SINGULAR, UINT32,   frames_tx,         3) \
+X(a, STATIC,   SINGULAR, UINT64,   bytes_rx,          4) \
+X(a, STATIC,   SINGULAR, UINT64,   bytes_tx,          5) \
+X(a, STATIC,   SINGULAR, UINT64,   rx_overflow,       6) \
+X(a, STATIC,   SINGULAR, UINT32,   crc_errors,        7) \
+X(a, STATIC,   SINGULAR, UINT32,   framing_errors,    8) \
+X(a, STATIC,   SINGULAR, UINT32,   decode_errors,     9) \
+X(a, STATIC,   SINGULAR, UINT32,   retransmits,      10) \
+X(a, STATIC,   SINGULAR, UINT32,   naks_sent,        11) \
+X(a, STATIC,   SINGULAR, UINT64,   cobs_us,          12) \
+X(a, STATIC,   SINGULAR, UINT64,   decode_us,        13) \
+X(a, STATIC,   SINGULAR, UINT64,   handle_us,        14) \
+X(a, STATIC,   SINGULAR, UINT64,   encode_us,        15) \
+X(a, STATIC,   SINGULAR, UINT64,   storage_us,       16) \
+X(a, STATIC,   SINGULAR, UINT32,   xfers,            17)
+#define badgelink_Stats_CALLBACK NULL
+#define badgelink_Stats_DEFAULT NULL
+
+#define badgelink_TraceReq_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   offset,            1) \
+X(a, STATIC,   SINGULAR, BOOL,     clear,             2)
+#define badgelink_TraceReq_CALLBACK NULL
+#define badgelink_TraceReq_DEFAULT NULL
+
+#define badgelink_TraceDump_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   total,             1) \
+X(a, STATIC,   SINGULAR, UINT32,   recorded,          2) \
+X(a, STATIC,   SINGULAR, UINT32,   next,              3) \
+X(a, STATIC,   SINGULAR, BYTES,    events,            4)
+#define badgelink_TraceDump_CALLBACK NULL
+#define badgelink_TraceDump_DEFAULT NULL
+
+#define badgelink_HistogramReq_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   offset,            1) \
+X(a, STATIC,   SINGULAR, BOOL,     reset,             2)
+#define badgelink_HistogramReq_CALLBACK NULL
+#define badgelink_HistogramReq_DEFAULT NULL
+
+#define badgelink_Histogram_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UENUM,    stage,             1) \
+X(a, STATIC,   SINGULAR, UINT32,   which_req,         2) \
+X(a, STATIC,   SINGULAR, UINT64,   total_us,          3) \
+X(a, STATIC,   REPEATED, UINT32,   buckets,           4)
+#define badgelink_Histogram_CALLBACK NULL
+#define badgelink_Histogram_DEFAULT NULL
+
+#define badgelink_Histograms_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   period_ms,         1) \
+X(a, STATIC,   REPEATED, MESSAGE,  histograms,        2) \
+X(a, STATIC,   SINGULAR, UINT32,   next,              3)
+#define badgelink_Histograms_CALLBACK NULL
+#define badgelink_Histograms_DEFAULT NULL
+#define badgelink_Histograms_histograms_MSGTYPE badgelink_Histogram
+
+#define badgelink_BenchReq_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, STRING,   path,              1) \
+X(a, STATIC,   SINGULAR, UINT32,   size,              2) \
+X(a, STATIC,   SINGULAR, BOOL,     appfs,             3)
+#define badgelink_BenchReq_CALLBACK NULL
+#define badgelink_BenchReq_DEFAULT NULL
+
+#define badgelink_BenchResult_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   size,              1) \
+X(a, STATIC,   SINGULAR, UINT32,   chunk_size,        2) \
+X(a, STATIC,   SINGULAR, UINT32,   appfs_erase_us,    3) \
+X(a, STATIC,   SINGULAR, UINT32,   appfs_write_us,    4) \
+X(a, STATIC,   SINGULAR, UINT32,   appfs_read_us,     5) \
+X(a, STATIC,   SINGULAR, UINT32,   fs_write_us,       6) \
+X(a, STATIC,   SINGULAR, UINT32,   fs_read_us,        7) \
+X(a, STATIC,   SINGULAR, UINT32,   crc32_us,          8) \
+X(a, STATIC,   SINGULAR, UINT32,   cobs_encode_us,    9) \
+X(a, STATIC,   SINGULAR, UINT32,   cobs_decode_us,   10) \
+X(a, STATIC,   SINGULAR, UINT32,   pb_encode_us,     11) \
+X(a, STATIC,   SINGULAR, UINT32,   pb_decode_us,     12)
+#define badgelink_BenchResult_CALLBACK NULL
+#define badgelink_BenchResult_DEFAULT NULL
+
+#define badgelink_EchoReq_FIELDLIST(X, a) \
+X(a, CALLBACK, SINGULAR, BYTES,    data,              1) \
+X(a, STATIC,   SINGULAR, UINT32,   reply_size,        2)
+extern bool badgelink_EchoReq_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_EchoReq_CALLBACK badgelink_EchoReq_callback
+#define badgelink_EchoReq_DEFAULT NULL
+
+#define badgelink_EchoResp_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   received,          1) \
+X(a, CALLBACK, SINGULAR, BYTES,    data,              2)
+extern bool badgelink_EchoResp_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_EchoResp_CALLBACK badgelink_EchoResp_callback
+#define badgelink_EchoResp_DEFAULT NULL
+
 #define badgelink_StartAppReq_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, STRING,   slug,              1) \
 X(a, STATIC,   SINGULAR, STRING,   arg,               2)
@@ -602,13 +1460,16 @@ X(a, STATIC,   SINGULAR, STRING,   arg,               2)
 
 #define badgelink_Chunk_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   position,          2) \
-X(a, STATIC,   SINGULAR, BYTES,    data,              3)
-#define badgelink_Chunk_CALLBACK NULL
+X(a, CALLBACK, SINGULAR, BYTES,    data,              3) \
+X(a, STATIC,   SINGULAR, BOOL,     compressed,        4)
+extern bool badgelink_Chunk_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_Chunk_CALLBACK badgelink_Chunk_callback
 #define badgelink_Chunk_DEFAULT NULL
 
 #define badgelink_FsUsage_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   size,              1) \
-X(a, STATIC,   SINGULAR, UINT32,   used,              2)
+X(a, STATIC,   SINGULAR, UINT32,   used,              2) \
+X(a, STATIC,   SINGULAR, UINT32,   unit,              3)
 #define badgelink_FsUsage_CALLBACK NULL
 #define badgelink_FsUsage_DEFAULT NULL
 
@@ -625,7 +1486,13 @@ X(a, STATIC,   SINGULAR, UENUM,    type,              1) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (id,metadata,id.metadata),   2) \
 X(a, STATIC,   ONEOF,    STRING,   (id,slug,id.slug),   3) \
 X(a, STATIC,   SINGULAR, UINT32,   crc32,             4) \
-X(a, STATIC,   SINGULAR, UINT32,   list_offset,       5)
+X(a, STATIC,   SINGULAR, UINT32,   list_offset,       5) \
+X(a, STATIC,   SINGULAR, BOOL,     delta,             6) \
+X(a, STATIC,   SINGULAR, UINT32,   compressed_size,   7) \
+X(a, STATIC,   SINGULAR, BYTES,    sha256,            8) \
+X(a, STATIC,   SINGULAR, UINT32,   offset,            9) \
+X(a, STATIC,   SINGULAR, UINT32,   length,           10) \
+X(a, STATIC,   SINGULAR, BOOL,     resumable,        11)
 #define badgelink_AppfsActionReq_CALLBACK NULL
 #define badgelink_AppfsActionReq_DEFAULT NULL
 #define badgelink_AppfsActionReq_id_metadata_MSGTYPE badgelink_AppfsMetadata
@@ -637,17 +1504,28 @@ X(a, STATIC,   SINGULAR, UINT32,   total_size,        2)
 #define badgelink_AppfsList_DEFAULT NULL
 #define badgelink_AppfsList_list_MSGTYPE badgelink_AppfsMetadata
 
+#define badgelink_AppfsSectorCrcs_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   offset,            1) \
+X(a, CALLBACK, REPEATED, FIXED32,  crc32,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   total_sectors,     3) \
+X(a, STATIC,   SINGULAR, UINT32,   sector_size,       4)
+extern bool badgelink_AppfsSectorCrcs_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_AppfsSectorCrcs_CALLBACK badgelink_AppfsSectorCrcs_callback
+#define badgelink_AppfsSectorCrcs_DEFAULT NULL
+
 #define badgelink_AppfsActionResp_FIELDLIST(X, a) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (val,metadata,val.metadata),   1) \
 X(a, STATIC,   ONEOF,    UINT32,   (val,crc32,val.crc32),   2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (val,list,val.list),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (val,usage,val.usage),   4) \
-X(a, STATIC,   SINGULAR, UINT32,   size,              5)
+X(a, STATIC,   SINGULAR, UINT32,   size,              5) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (val,sector_crcs,val.sector_crcs),   6)
 #define badgelink_AppfsActionResp_CALLBACK NULL
 #define badgelink_AppfsActionResp_DEFAULT NULL
 #define badgelink_AppfsActionResp_val_metadata_MSGTYPE badgelink_AppfsMetadata
 #define badgelink_AppfsActionResp_val_list_MSGTYPE badgelink_AppfsList
 #define badgelink_AppfsActionResp_val_usage_MSGTYPE badgelink_FsUsage
+#define badgelink_AppfsActionResp_val_sector_crcs_MSGTYPE badgelink_AppfsSectorCrcs
 
 #define badgelink_FsStat_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   size,              1) \
@@ -664,20 +1542,36 @@ X(a, STATIC,   SINGULAR, STRING,   path,              2) \
 X(a, STATIC,   SINGULAR, UINT32,   crc32,             3) \
 X(a, STATIC,   SINGULAR, UINT32,   list_offset,       4) \
 X(a, STATIC,   SINGULAR, UINT32,   size,              5) \
-X(a, STATIC,   SINGULAR, STRING,   dest_path,         6)
+X(a, STATIC,   SINGULAR, STRING,   dest_path,         6) \
+X(a, STATIC,   SINGULAR, UINT32,   block_size,        7) \
+X(a, STATIC,   SINGULAR, BOOL,     delta,             8) \
+X(a, STATIC,   SINGULAR, UINT32,   cursor,            9) \
+X(a, STATIC,   SINGULAR, BOOL,     use_cursor,       10) \
+X(a, STATIC,   SINGULAR, BOOL,     skip_total,       11) \
+X(a, STATIC,   SINGULAR, BOOL,     with_stat,        12) \
+X(a, STATIC,   SINGULAR, BOOL,     recursive,        13) \
+X(a, STATIC,   SINGULAR, BYTES,    sha256,           14) \
+X(a, STATIC,   SINGULAR, UINT32,   offset,           15) \
+X(a, STATIC,   SINGULAR, UINT32,   length,           16) \
+X(a, STATIC,   SINGULAR, BOOL,     resumable,        17)
 #define badgelink_FsActionReq_CALLBACK NULL
 #define badgelink_FsActionReq_DEFAULT NULL
 
 #define badgelink_FsDirent_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, STRING,   name,              1) \
-X(a, STATIC,   SINGULAR, BOOL,     is_dir,            2)
+X(a, STATIC,   SINGULAR, BOOL,     is_dir,            2) \
+X(a, STATIC,   SINGULAR, UINT32,   size,              3) \
+X(a, STATIC,   SINGULAR, UINT64,   mtime,             4) \
+X(a, STATIC,   SINGULAR, BOOL,     has_stat,          5)
 #define badgelink_FsDirent_CALLBACK NULL
 #define badgelink_FsDirent_DEFAULT NULL
 
 #define badgelink_FsDirentList_FIELDLIST(X, a) \
-X(a, STATIC,   REPEATED, MESSAGE,  list,              1) \
-X(a, STATIC,   SINGULAR, UINT32,   total_size,        2)
-#define badgelink_FsDirentList_CALLBACK NULL
+X(a, CALLBACK, REPEATED, MESSAGE,  list,              1) \
+X(a, STATIC,   SINGULAR, UINT32,   total_size,        2) \
+X(a, STATIC,   SINGULAR, UINT32,   cursor,            3)
+extern bool badgelink_FsDirentList_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_FsDirentList_CALLBACK badgelink_FsDirentList_callback
 #define badgelink_FsDirentList_DEFAULT NULL
 #define badgelink_FsDirentList_list_MSGTYPE badgelink_FsDirent
 
@@ -686,19 +1580,45 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (val,stat,val.stat),   1) \
 X(a, STATIC,   ONEOF,    UINT32,   (val,crc32,val.crc32),   2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (val,list,val.list),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (val,usage,val.usage),   4) \
-X(a, STATIC,   SINGULAR, UINT32,   size,              5)
+X(a, STATIC,   SINGULAR, UINT32,   size,              5) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (val,sector_crcs,val.sector_crcs),   6) \
+X(a, STATIC,   SINGULAR, UINT32,   count,             7)
 #define badgelink_FsActionResp_CALLBACK NULL
 #define badgelink_FsActionResp_DEFAULT NULL
 #define badgelink_FsActionResp_val_stat_MSGTYPE badgelink_FsStat
 #define badgelink_FsActionResp_val_list_MSGTYPE badgelink_FsDirentList
 #define badgelink_FsActionResp_val_usage_MSGTYPE badgelink_FsUsage
+#define badgelink_FsActionResp_val_sector_crcs_MSGTYPE badgelink_AppfsSectorCrcs
+
+#define badgelink_FsStatManyReq_FIELDLIST(X, a) \
+X(a, CALLBACK, SINGULAR, BYTES,    paths,             1)
+extern bool badgelink_FsStatManyReq_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_FsStatManyReq_CALLBACK badgelink_FsStatManyReq_callback
+#define badgelink_FsStatManyReq_DEFAULT NULL
+
+#define badgelink_FsStatResult_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UENUM,    status,            1) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  stat,              2) \
+X(a, STATIC,   SINGULAR, UINT32,   crc32,             3) \
+X(a, STATIC,   SINGULAR, BOOL,     has_crc32,         4)
+#define badgelink_FsStatResult_CALLBACK NULL
+#define badgelink_FsStatResult_DEFAULT NULL
+#define badgelink_FsStatResult_stat_MSGTYPE badgelink_FsStat
+
+#define badgelink_FsStatManyResp_FIELDLIST(X, a) \
+X(a, CALLBACK, REPEATED, MESSAGE,  results,           1)
+extern bool badgelink_FsStatManyResp_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_FsStatManyResp_CALLBACK badgelink_FsStatManyResp_callback
+#define badgelink_FsStatManyResp_DEFAULT NULL
+#define badgelink_FsStatManyResp_results_MSGTYPE badgelink_FsStatResult
 
 #define badgelink_NvsValue_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UENUM,    type,              1) \
 X(a, STATIC,   ONEOF,    UINT64,   (val,numericval,val.numericval),   2) \
-X(a, STATIC,   ONEOF,    STRING,   (val,stringval,val.stringval),   3) \
-X(a, STATIC,   ONEOF,    BYTES,    (val,blobval,val.blobval),   4)
-#define badgelink_NvsValue_CALLBACK NULL
+X(a, CALLBACK, ONEOF,    STRING,   (val,stringval,val.stringval),   3) \
+X(a, CALLBACK, ONEOF,    BYTES,    (val,blobval,val.blobval),   4)
+extern bool badgelink_NvsValue_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_NvsValue_CALLBACK badgelink_NvsValue_callback
 #define badgelink_NvsValue_DEFAULT NULL
 
 #define badgelink_NvsEntry_FIELDLIST(X, a) \
@@ -714,25 +1634,61 @@ X(a, STATIC,   SINGULAR, STRING,   namespc,           2) \
 X(a, STATIC,   SINGULAR, STRING,   key,               3) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  wdata,             4) \
 X(a, STATIC,   SINGULAR, UINT32,   list_offset,       5) \
-X(a, STATIC,   SINGULAR, UENUM,    read_type,         6)
+X(a, STATIC,   SINGULAR, UENUM,    read_type,         6) \
+X(a, STATIC,   REPEATED, MESSAGE,  batch,             7) \
+X(a, STATIC,   SINGULAR, UINT32,   cursor,            8) \
+X(a, STATIC,   SINGULAR, BOOL,     use_cursor,        9) \
+X(a, STATIC,   SINGULAR, BOOL,     skip_total,       10) \
+X(a, STATIC,   SINGULAR, UINT32,   size,             11) \
+X(a, STATIC,   SINGULAR, UINT32,   crc32,            12)
 #define badgelink_NvsActionReq_CALLBACK NULL
 #define badgelink_NvsActionReq_DEFAULT NULL
 #define badgelink_NvsActionReq_wdata_MSGTYPE badgelink_NvsValue
+#define badgelink_NvsActionReq_batch_MSGTYPE badgelink_NvsBatchOp
+
+#define badgelink_NvsBatchOp_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UENUM,    type,              1) \
+X(a, STATIC,   SINGULAR, STRING,   namespc,           2) \
+X(a, STATIC,   SINGULAR, STRING,   key,               3) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  wdata,             4) \
+X(a, STATIC,   SINGULAR, UENUM,    read_type,         5)
+#define badgelink_NvsBatchOp_CALLBACK NULL
+#define badgelink_NvsBatchOp_DEFAULT NULL
+#define badgelink_NvsBatchOp_wdata_MSGTYPE badgelink_NvsValue
 
 #define badgelink_NvsEntriesList_FIELDLIST(X, a) \
-X(a, STATIC,   REPEATED, MESSAGE,  entries,           1) \
-X(a, STATIC,   SINGULAR, UINT32,   total_entries,     2)
-#define badgelink_NvsEntriesList_CALLBACK NULL
+X(a, CALLBACK, REPEATED, MESSAGE,  entries,           1) \
+X(a, STATIC,   SINGULAR, UINT32,   total_entries,     2) \
+X(a, STATIC,   SINGULAR, UINT32,   cursor,            3)
+extern bool badgelink_NvsEntriesList_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field);
+#define badgelink_NvsEntriesList_CALLBACK badgelink_NvsEntriesList_callback
 #define badgelink_NvsEntriesList_DEFAULT NULL
 #define badgelink_NvsEntriesList_entries_MSGTYPE badgelink_NvsEntry
 
 #define badgelink_NvsActionResp_FIELDLIST(X, a) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (val,rdata,val.rdata),   1) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (val,entries,val.entries),   2)
+X(a, STATIC,   ONEOF,    MESSAGE,  (val,entries,val.entries),   2) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (val,batch,val.batch),   3) \
+X(a, STATIC,   SINGULAR, UINT32,   size,              4) \
+X(a, STATIC,   SINGULAR, UINT32,   crc32,             5)
 #define badgelink_NvsActionResp_CALLBACK NULL
 #define badgelink_NvsActionResp_DEFAULT NULL
 #define badgelink_NvsActionResp_val_rdata_MSGTYPE badgelink_NvsValue
 #define badgelink_NvsActionResp_val_entries_MSGTYPE badgelink_NvsEntriesList
+#define badgelink_NvsActionResp_val_batch_MSGTYPE badgelink_NvsBatchResp
+
+#define badgelink_NvsBatchResp_FIELDLIST(X, a) \
+X(a, STATIC,   REPEATED, MESSAGE,  results,           1)
+#define badgelink_NvsBatchResp_CALLBACK NULL
+#define badgelink_NvsBatchResp_DEFAULT NULL
+#define badgelink_NvsBatchResp_results_MSGTYPE badgelink_NvsBatchResult
+
+#define badgelink_NvsBatchResult_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UENUM,    status,            1) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  rdata,             2)
+#define badgelink_NvsBatchResult_CALLBACK NULL
+#define badgelink_NvsBatchResult_DEFAULT NULL
+#define badgelink_NvsBatchResult_rdata_MSGTYPE badgelink_NvsValue
 
 extern const pb_msgdesc_t badgelink_Packet_msg;
 extern const pb_msgdesc_t badgelink_Request_msg;
@@ -740,22 +1696,43 @@ extern const pb_msgdesc_t badgelink_Response_msg;
 extern const pb_msgdesc_t badgelink_StartAppReq_msg;
 extern const pb_msgdesc_t badgelink_VersionReq_msg;
 extern const pb_msgdesc_t badgelink_VersionResp_msg;
+extern const pb_msgdesc_t badgelink_XferAck_msg;
+extern const pb_msgdesc_t badgelink_XferResult_msg;
+extern const pb_msgdesc_t badgelink_Nak_msg;
+extern const pb_msgdesc_t badgelink_StatsReq_msg;
+extern const pb_msgdesc_t badgelink_Stats_msg;
+extern const pb_msgdesc_t badgelink_TraceReq_msg;
+extern const pb_msgdesc_t badgelink_TraceDump_msg;
+extern const pb_msgdesc_t badgelink_HistogramReq_msg;
+extern const pb_msgdesc_t badgelink_Histogram_msg;
+extern const pb_msgdesc_t badgelink_Histograms_msg;
+extern const pb_msgdesc_t badgelink_BenchReq_msg;
+extern const pb_msgdesc_t badgelink_BenchResult_msg;
+extern const pb_msgdesc_t badgelink_EchoReq_msg;
+extern const pb_msgdesc_t badgelink_EchoResp_msg;
 extern const pb_msgdesc_t badgelink_Chunk_msg;
 extern const pb_msgdesc_t badgelink_FsUsage_msg;
 extern const pb_msgdesc_t badgelink_AppfsMetadata_msg;
 extern const pb_msgdesc_t badgelink_AppfsActionReq_msg;
 extern const pb_msgdesc_t badgelink_AppfsList_msg;
+extern const pb_msgdesc_t badgelink_AppfsSectorCrcs_msg;
 extern const pb_msgdesc_t badgelink_AppfsActionResp_msg;
 extern const pb_msgdesc_t badgelink_FsStat_msg;
 extern const pb_msgdesc_t badgelink_FsActionReq_msg;
 extern const pb_msgdesc_t badgelink_FsDirent_msg;
 extern const pb_msgdesc_t badgelink_FsDirentList_msg;
 extern const pb_msgdesc_t badgelink_FsActionResp_msg;
+extern const pb_msgdesc_t badgelink_FsStatManyReq_msg;
+extern const pb_msgdesc_t badgelink_FsStatResult_msg;
+extern const pb_msgdesc_t badgelink_FsStatManyResp_msg;
 extern const pb_msgdesc_t badgelink_NvsValue_msg;
 extern const pb_msgdesc_t badgelink_NvsEntry_msg;
 extern const pb_msgdesc_t badgelink_NvsActionReq_msg;
+extern const pb_msgdesc_t badgelink_NvsBatchOp_msg;
 extern const pb_msgdesc_t badgelink_NvsEntriesList_msg;
 extern const pb_msgdesc_t badgelink_NvsActionResp_msg;
+extern const pb_msgdesc_t badgelink_NvsBatchResp_msg;
+extern const pb_msgdesc_t badgelink_NvsBatchResult_msg;
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
 #define badgelink_Packet_fields &badgelink_Packet_msg
@@ -764,47 +1741,89 @@ extern const pb_msgdesc_t badgelink_NvsActionResp_msg;
 #define badgelink_StartAppReq_fields &badgelink_StartAppReq_msg
 #define badgelink_VersionReq_fields &badgelink_VersionReq_msg
 #define badgelink_VersionResp_fields &badgelink_VersionResp_msg
+#define badgelink_XferAck_fields &badgelink_XferAck_msg
+#define badgelink_XferResult_fields &badgelink_XferResult_msg
+#define badgelink_Nak_fields &badgelink_Nak_msg
+#define badgelink_StatsReq_fields &badgelink_StatsReq_msg
+#define badgelink_Stats_fields &badgelink_Stats_msg
+#define badgelink_TraceReq_fields &badgelink_TraceReq_msg
+#define badgelink_TraceDump_fields &badgelink_TraceDump_msg
+#define badgelink_HistogramReq_fields &badgelink_HistogramReq_msg
+#define badgelink_Histogram_fields &badgelink_Histogram_msg
+#define badgelink_Histograms_fields &badgelink_Histograms_msg
+#define badgelink_BenchReq_fields &badgelink_BenchReq_msg
+#define badgelink_BenchResult_fields &badgelink_BenchResult_msg
+#define badgelink_EchoReq_fields &badgelink_EchoReq_msg
+#define badgelink_EchoResp_fields &badgelink_EchoResp_msg
 #define badgelink_Chunk_fields &badgelink_Chunk_msg
 #define badgelink_FsUsage_fields &badgelink_FsUsage_msg
 #define badgelink_AppfsMetadata_fields &badgelink_AppfsMetadata_msg
 #define badgelink_AppfsActionReq_fields &badgelink_AppfsActionReq_msg
 #define badgelink_AppfsList_fields &badgelink_AppfsList_msg
+#define badgelink_AppfsSectorCrcs_fields &badgelink_AppfsSectorCrcs_msg
 #define badgelink_AppfsActionResp_fields &badgelink_AppfsActionResp_msg
 #define badgelink_FsStat_fields &badgelink_FsStat_msg
 #define badgelink_FsActionReq_fields &badgelink_FsActionReq_msg
 #define badgelink_FsDirent_fields &badgelink_FsDirent_msg
 #define badgelink_FsDirentList_fields &badgelink_FsDirentList_msg
 #define badgelink_FsActionResp_fields &badgelink_FsActionResp_msg
+#define badgelink_FsStatManyReq_fields &badgelink_FsStatManyReq_msg
+#define badgelink_FsStatResult_fields &badgelink_FsStatResult_msg
+#define badgelink_FsStatManyResp_fields &badgelink_FsStatManyResp_msg
 #define badgelink_NvsValue_fields &badgelink_NvsValue_msg
 #define badgelink_NvsEntry_fields &badgelink_NvsEntry_msg
 #define badgelink_NvsActionReq_fields &badgelink_NvsActionReq_msg
+#define badgelink_NvsBatchOp_fields &badgelink_NvsBatchOp_msg
 #define badgelink_NvsEntriesList_fields &badgelink_NvsEntriesList_msg
 #define badgelink_NvsActionResp_fields &badgelink_NvsActionResp_msg
+#define badgelink_NvsBatchResp_fields &badgelink_NvsBatchResp_msg
+#define badgelink_NvsBatchResult_fields &badgelink_NvsBatchResult_msg
 
 /* Maximum encoded size of messages (where known) */
-#define BADGELINK_BADGELINK_PB_H_MAX_SIZE        badgelink_Packet_size
-#define badgelink_AppfsActionReq_size            142
-#define badgelink_AppfsActionResp_size           1039
+/* badgelink_Packet_size depends on runtime parameters */
+/* badgelink_Request_size depends on runtime parameters */
+/* badgelink_Response_size depends on runtime parameters */
+/* badgelink_Chunk_size depends on runtime parameters */
+/* badgelink_EchoReq_size depends on runtime parameters */
+/* badgelink_EchoResp_size depends on runtime parameters */
+/* badgelink_AppfsSectorCrcs_size depends on runtime parameters */
+/* badgelink_AppfsActionResp_size depends on runtime parameters */
+/* badgelink_FsDirentList_size depends on runtime parameters */
+/* badgelink_FsActionResp_size depends on runtime parameters */
+/* badgelink_FsStatManyReq_size depends on runtime parameters */
+/* badgelink_FsStatManyResp_size depends on runtime parameters */
+/* badgelink_NvsValue_size depends on runtime parameters */
+/* badgelink_NvsActionReq_size depends on runtime parameters */
+/* badgelink_NvsEntriesList_size depends on runtime parameters */
+/* badgelink_NvsActionResp_size depends on runtime parameters */
+/* badgelink_NvsBatchOp_size depends on runtime parameters */
+/* badgelink_NvsBatchResp_size depends on runtime parameters */
+/* badgelink_NvsBatchResult_size depends on runtime parameters */
+#define BADGELINK_BADGELINK_PB_H_MAX_SIZE        badgelink_FsActionReq_size
+#define badgelink_AppfsActionReq_size            198
 #define badgelink_AppfsList_size                 1030
 #define badgelink_AppfsMetadata_size             126
-#define badgelink_Chunk_size                     4105
-#define badgelink_FsActionReq_size               2072
-#define badgelink_FsActionResp_size              4223
-#define badgelink_FsDirentList_size              4214
-#define badgelink_FsDirent_size                  260
+#define badgelink_FsActionReq_size               2143
+#define badgelink_FsDirent_size                  279
 #define badgelink_FsStat_size                    41
-#define badgelink_FsUsage_size                   12
-#define badgelink_NvsActionReq_size              4150
-#define badgelink_NvsActionResp_size             5129
-#define badgelink_NvsEntriesList_size            5126
+#define badgelink_FsStatResult_size              53
+#define badgelink_FsUsage_size                   18
+#define badgelink_Nak_size                       14
 #define badgelink_NvsEntry_size                  38
-#define badgelink_NvsValue_size                  4101
-#define badgelink_Packet_size                    5148
-#define badgelink_Request_size                   4153
-#define badgelink_Response_size                  5134
 #define badgelink_StartAppReq_size               179
-#define badgelink_VersionReq_size                6
-#define badgelink_VersionResp_size               12
+#define badgelink_StatsReq_size                  2
+#define badgelink_Stats_size                     144
+#define badgelink_TraceDump_size                 1461
+#define badgelink_TraceReq_size                  8
+#define badgelink_HistogramReq_size              8
+#define badgelink_Histogram_size                 142
+#define badgelink_Histograms_size                1172
+#define badgelink_BenchReq_size                  266
+#define badgelink_BenchResult_size               72
+#define badgelink_VersionReq_size                16
+#define badgelink_VersionResp_size               34
+#define badgelink_XferAck_size                   8
+#define badgelink_XferResult_size                46
 
 #ifdef __cplusplus
 } /* extern "C" */
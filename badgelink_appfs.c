@@ -3,39 +3,218 @@
 // SPDX-License-Identifier: MIT
 
 #include "badgelink_appfs.h"
+#include "badgelink_digest.h"
+#include "badgelink_journal.h"
+#include "badgelink_storage.h"
 #include "appfs.h"
 #include "esp_crc.h"
 #include "esp_log.h"
+#include "lzf.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+#include "stdlib.h"
+#include "string.h"
 
 static char const TAG[] = "badgelink_appfs";
 
+// Size of the flash sectors that delta uploads erase and rewrite.
+#define APPFS_SECTOR_SIZE 4096
+// Maximum amount of app data in one frame of a compressed upload.
+#define APPFS_FRAME_SIZE  4096
+// Flag in the header of a compressed upload frame for data that is stored as-is.
+#define APPFS_FRAME_STORED 0x8000
+// Size of the buffer for reading apps that can't be mapped to calculate their CRC32.
+#define APPFS_CRC_BUF_SIZE 4096
+// Upload data is programmed to flash in bursts of up to this many bytes that end at a multiple of it.
+#define APPFS_STAGE_SIZE   APPFS_SECTOR_SIZE
+// Number of apps whose CRC32 is remembered; shares its setting with the FS CRC32 cache.
+#ifndef CONFIG_BADGELINK_CRC_CACHE_SIZE
+#define CONFIG_BADGELINK_CRC_CACHE_SIZE 8
+#endif
+
 // AppFS FD used for file transfer.
 static appfs_handle_t xfer_fd;
 // CRC32 of file transferred.
 static uint32_t       xfer_crc32;
 // Running CRC32 computed during upload.
 static uint32_t       running_crc;
+// How much of the AppFS file being uploaded has been erased.
+static uint32_t       xfer_erased;
+// How much of the AppFS file being uploaded is erased at a time.
+static uint32_t       xfer_erase_size;
+// End of the last data written to the AppFS file being uploaded.
+static uint32_t       xfer_written;
+// Size of the AppFS file being uploaded; differs from the transfer size for compressed uploads.
+static uint32_t       xfer_app_size;
+// Whether the upload keeps the partial AppFS file if it is aborted, so it can be resumed.
+static bool           xfer_resumable;
+// Upload data that is yet to be programmed to flash, or NULL to program every chunk as it is.
+static uint8_t*       stage_buf;
+// Position in the AppFS file of the data in `stage_buf`.
+static uint32_t       stage_pos;
+// How much data is in `stage_buf`.
+static size_t         stage_len;
+// Buffer for the current frame of a compressed upload followed by the data it decompresses to, or NULL.
+static uint8_t*       inflate_buf;
+// How much of the current frame of a compressed upload has been received, including its header.
+static size_t         inflate_have;
+#ifdef ESP_PLATFORM
+typedef spi_flash_mmap_handle_t app_mmap_handle_t;
+#else
+typedef int app_mmap_handle_t;
+#endif
+
+// Flash mapping of the AppFS file being downloaded, or NULL if it is read through the storage worker.
+static uint8_t const*    xfer_map;
+// Handle of `xfer_map`.
+static app_mmap_handle_t xfer_map_handle;
+
+// A remembered CRC32 of an app, valid while it is in the same place with the same size and version.
+typedef struct {
+    appfs_handle_t fd;
+    char           slug[sizeof(((badgelink_AppfsMetadata*)0)->slug)];
+    int            size;
+    uint16_t       version;
+    uint32_t       crc;
+} app_crc_entry_t;
+
+// Remembered CRC32s of apps, of which the oldest is replaced by the next that is calculated.
+static app_crc_entry_t app_crc_cache[CONFIG_BADGELINK_CRC_CACHE_SIZE];
+static size_t          app_crc_count;
+static size_t          app_crc_next;
+// Set by `badgelink_appfs_changed` from any task to make the BadgeLink task forget the remembered CRC32s.
+static volatile bool   app_crc_stale;
+
+// Continue calculating a CRC32 over `len` bytes of an AppFS file starting at `start`, reading it piece by piece.
+static uint32_t calc_crc32_read(appfs_handle_t fd, uint32_t crc, uint32_t start, uint32_t len) {
+    uint8_t  stack_buf[512];
+    size_t   buf_size = len > sizeof(stack_buf) ? APPFS_CRC_BUF_SIZE : sizeof(stack_buf);
+    uint8_t* buf      = buf_size > sizeof(stack_buf) ? malloc(buf_size) : NULL;
+    if (!buf) {
+        buf      = stack_buf;
+        buf_size = sizeof(stack_buf);
+    }
+    for (uint32_t i = 0; i < len; i += buf_size) {
+        uint32_t max = buf_size;
+        if (max > len - i) {
+            max = len - i;
+        }
+        appfsRead(fd, start + i, buf, max);
+        crc = esp_crc32_le(crc, buf, max);
+    }
+    if (buf != stack_buf) {
+        free(buf);
+    }
+    return crc;
+}
 
-// Calculate the CRC32 of an AppFS file.
-static uint32_t calc_app_crc32(appfs_handle_t fd) {
-    uint8_t  buffer[128];
-    int      size;
-    uint32_t crc = 0;
-    appfsEntryInfo(fd, NULL, &size);
-    for (int i = 0; i < size; i += sizeof(buffer)) {
-        int max = sizeof(buffer);
-        if (max > size - i) {
-            max = size - i;
+// Map the first `len` bytes of an AppFS file into memory.
+// Returns NULL if it can't be mapped, for example because there are not enough free MMU pages for a large app.
+static uint8_t const* app_mmap(appfs_handle_t fd, uint32_t len, app_mmap_handle_t* handle) {
+#ifdef ESP_PLATFORM
+    void const* ptr;
+    if (len > 0 && appfsMmap(fd, 0, len, &ptr, SPI_FLASH_MMAP_DATA, handle) == ESP_OK) {
+        return ptr;
+    }
+#endif
+    (void)fd;
+    (void)len;
+    (void)handle;
+    return NULL;
+}
+
+// Release a mapping made by `app_mmap`.
+static void app_munmap(app_mmap_handle_t handle) {
+#ifdef ESP_PLATFORM
+    appfsMunmap(handle);
+#endif
+    (void)handle;
+}
+
+// Continue calculating a CRC32 over `len` bytes of an AppFS file starting at `start`.
+// Mapping the file lets the ROM CRC32 run over it in one go instead of copying it out a piece at a time.
+static uint32_t calc_crc32_range(appfs_handle_t fd, uint32_t crc, uint32_t start, uint32_t len) {
+    app_mmap_handle_t handle;
+    uint8_t const*    map = app_mmap(fd, start + len, &handle);
+    if (!map) {
+        return calc_crc32_read(fd, crc, start, len);
+    }
+    crc = esp_crc32_le(crc, map + start, len);
+    app_munmap(handle);
+    return crc;
+}
+
+// Forget all remembered app CRC32s.
+static void app_crc_forget() {
+    app_crc_stale = false;
+    app_crc_count = 0;
+    app_crc_next  = 0;
+}
+
+// Find the remembered CRC32 of an AppFS file, if it didn't change since.
+static app_crc_entry_t* app_crc_find(appfs_handle_t fd, char const* slug, int size, uint16_t version) {
+    if (app_crc_stale) {
+        app_crc_forget();
+    }
+    for (size_t i = 0; i < app_crc_count; i++) {
+        app_crc_entry_t* ent = &app_crc_cache[i];
+        if (ent->fd == fd && ent->size == size && ent->version == version && !strcmp(ent->slug, slug)) {
+            return ent;
         }
-        appfsRead(fd, i, buffer, max);
-        crc = esp_crc32_le(crc, buffer, max);
     }
+    return NULL;
+}
+
+// Remember the CRC32 of an AppFS file.
+static void app_crc_store(appfs_handle_t fd, uint32_t crc) {
+    char const* slug;
+    uint16_t    version;
+    int         size;
+    appfsEntryInfoExt(fd, &slug, NULL, &version, &size);
+    app_crc_entry_t* ent = app_crc_find(fd, slug, size, version);
+    if (!ent) {
+        ent          = &app_crc_cache[app_crc_next];
+        app_crc_next = (app_crc_next + 1) % CONFIG_BADGELINK_CRC_CACHE_SIZE;
+        if (app_crc_count < CONFIG_BADGELINK_CRC_CACHE_SIZE) {
+            app_crc_count++;
+        }
+    }
+    ent->fd      = fd;
+    ent->size    = size;
+    ent->version = version;
+    ent->crc     = crc;
+    strlcpy(ent->slug, slug, sizeof(ent->slug));
+}
+
+// Calculate the CRC32 of an AppFS file, or get it from the ones remembered.
+static uint32_t calc_app_crc32(appfs_handle_t fd) {
+    char const* slug;
+    uint16_t    version;
+    int         size;
+    appfsEntryInfoExt(fd, &slug, NULL, &version, &size);
+    app_crc_entry_t const* ent = app_crc_find(fd, slug, size, version);
+    if (ent) {
+        return ent->crc;
+    }
+    uint32_t crc = calc_crc32_range(fd, 0, 0, size);
+    app_crc_store(fd, crc);
     return crc;
 }
 
+// Tell BadgeLink that AppFS was changed without it.
+void badgelink_appfs_changed() {
+    app_crc_stale = true;
+}
+
 // Handle an AppFS request packet.
 void badgelink_appfs_handle() {
-    switch (badgelink_packet.packet.request.req.appfs_action.type) {
+    // A new app may take the place of one that was deleted, so only uploads through BadgeLink are remembered.
+    badgelink_FsActionType type = badgelink_packet->packet.request.req.appfs_action.type;
+    if (type == badgelink_FsActionType_FsActionUpload || type == badgelink_FsActionType_FsActionDelete) {
+        app_crc_forget();
+    }
+
+    switch (type) {
         case badgelink_FsActionType_FsActionList:
             badgelink_appfs_list();
             break;
@@ -57,98 +236,333 @@ void badgelink_appfs_handle() {
         case badgelink_FsActionType_FsActionGetUsage:
             badgelink_appfs_usage();
             break;
+        case badgelink_FsActionType_FsActionSectorCrc32:
+            badgelink_appfs_sector_crc32();
+            break;
         default:
             badgelink_status_unsupported();
             break;
     }
 }
 
-// Handle an AppFS upload (host->badge) transfer.
-void badgelink_appfs_xfer_upload() {
-    badgelink_Chunk* chunk = &badgelink_packet.packet.request.req.upload_chunk;
-    esp_err_t        ec    = appfsWrite(xfer_fd, badgelink_xfer_pos, chunk->data.bytes, chunk->data.size);
+// Hash `len` bytes of the AppFS file being uploaded starting at `start`, which a delta upload skipped.
+static void xfer_hash_skipped(uint32_t start, uint32_t len) {
+    if (!badgelink_digest_active(BADGELINK_XFER_APPFS)) {
+        running_crc = calc_crc32_range(xfer_fd, running_crc, start, len);
+        return;
+    }
+    app_mmap_handle_t handle;
+    uint8_t const*    map = app_mmap(xfer_fd, start + len, &handle);
+    if (map) {
+        running_crc = esp_crc32_le(running_crc, map + start, len);
+        badgelink_digest_update(BADGELINK_XFER_APPFS, map + start, len);
+        app_munmap(handle);
+        return;
+    }
+    uint8_t buf[512];
+    for (uint32_t i = 0; i < len; i += sizeof(buf)) {
+        uint32_t max = sizeof(buf);
+        if (max > len - i) {
+            max = len - i;
+        }
+        appfsRead(xfer_fd, start + i, buf, max);
+        running_crc = esp_crc32_le(running_crc, buf, max);
+        badgelink_digest_update(BADGELINK_XFER_APPFS, buf, max);
+    }
+}
+
+// Program `len` bytes of upload data to the AppFS file at `pos`, which must be erased already.
+static badgelink_StatusCode stage_program(uint32_t pos, uint8_t* buf, size_t len) {
+    esp_err_t ec = appfsWrite(xfer_fd, pos, buf, len);
     if (ec) {
         ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
-        badgelink_status_int_err();
-    } else {
-        running_crc = esp_crc32_le(running_crc, chunk->data.bytes, chunk->data.size);
-        badgelink_status_ok();
+        return badgelink_StatusCode_StatusInternalError;
     }
+    return badgelink_StatusCode_StatusOk;
 }
 
-// Handle an AppFS download (badge->host) transfer.
-void badgelink_appfs_xfer_download() {
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_download_chunk_tag;
-    badgelink_Chunk* chunk                       = &badgelink_packet.packet.response.resp.download_chunk;
-
-    chunk->position  = badgelink_xfer_pos;
-    chunk->data.size = sizeof(chunk->data.bytes) < badgelink_xfer_size - badgelink_xfer_pos
-                           ? sizeof(chunk->data.bytes)
-                           : badgelink_xfer_size - badgelink_xfer_pos;
-    esp_err_t ec     = appfsRead(xfer_fd, badgelink_xfer_pos, chunk->data.bytes, chunk->data.size);
+// Program the upload data collected in `stage_buf`.
+static badgelink_StatusCode stage_flush() {
+    size_t len = stage_len;
+    stage_len  = 0;
+    return len ? stage_program(stage_pos, stage_buf, len) : badgelink_StatusCode_StatusOk;
+}
+
+// Program upload data in sector-aligned bursts, so how the host happens to slice it doesn't matter.
+// Data is collected in `stage_buf` up to the end of a sector, and whole sectors are programmed straight from `buf`.
+static badgelink_StatusCode stage_write(uint32_t pos, uint8_t* buf, size_t len) {
+    badgelink_StatusCode code = badgelink_StatusCode_StatusOk;
+    if (stage_len && pos != stage_pos + stage_len) {
+        // A delta upload skipped ahead.
+        code = stage_flush();
+    }
+    while (len && code == badgelink_StatusCode_StatusOk) {
+        if (!stage_buf || (!stage_len && pos % APPFS_STAGE_SIZE == 0 && len >= APPFS_STAGE_SIZE)) {
+            size_t direct  = stage_buf ? len - len % APPFS_STAGE_SIZE : len;
+            code           = stage_program(pos, buf, direct);
+            pos           += direct;
+            buf           += direct;
+            len           -= direct;
+            continue;
+        }
+        if (!stage_len) {
+            stage_pos = pos;
+        }
+        size_t room  = APPFS_STAGE_SIZE - (stage_pos + stage_len) % APPFS_STAGE_SIZE;
+        size_t copy  = len < room ? len : room;
+        memcpy(stage_buf + stage_len, buf, copy);
+        stage_len   += copy;
+        pos         += copy;
+        buf         += copy;
+        len         -= copy;
+        if ((stage_pos + stage_len) % APPFS_STAGE_SIZE == 0) {
+            code = stage_flush();
+        }
+    }
+    return code;
+}
+
+// Write upload data to the AppFS file at `pos`.
+static badgelink_StatusCode xfer_write(uint32_t pos, uint8_t* buf, size_t len) {
+    // Delta uploads skip the sectors that didn't change, which still count towards the CRC32 and digest.
+    if (pos > xfer_written) {
+        xfer_hash_skipped(xfer_written, pos - xfer_written);
+    }
+
+    // Erase the file just ahead of the data, so the upload doesn't wait for all of it up front.
+    // Skipped parts stay as they are; AppFS files always span whole pages, so this stays within the file.
+    if (xfer_erased < pos - pos % xfer_erase_size) {
+        xfer_erased = pos - pos % xfer_erase_size;
+    }
+    while (xfer_erased < pos + len) {
+        esp_err_t ec = appfsErase(xfer_fd, xfer_erased, xfer_erase_size);
+        if (ec) {
+            ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
+            return badgelink_StatusCode_StatusInternalError;
+        }
+        xfer_erased += xfer_erase_size;
+    }
+
+    badgelink_StatusCode code = stage_write(pos, buf, len);
+    if (code != badgelink_StatusCode_StatusOk) {
+        return code;
+    }
+    running_crc  = esp_crc32_le(running_crc, buf, len);
+    xfer_written = pos + len;
+    badgelink_digest_update(BADGELINK_XFER_APPFS, buf, len);
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Inflate compressed upload data and write it to the end of the AppFS file.
+// The data is a stream of frames that each start with a 2-byte little-endian header holding the length of the frame
+// and `APPFS_FRAME_STORED` if it isn't compressed; the frames are received in order, so `pos` is not needed.
+static badgelink_StatusCode xfer_inflate(uint32_t pos, uint8_t* buf, size_t len) {
+    (void)pos;
+    uint8_t* frame = inflate_buf;
+    uint8_t* raw   = inflate_buf + 2 + APPFS_FRAME_SIZE;
+    while (len) {
+        // Collect the header first and then the rest of the frame.
+        uint16_t header    = inflate_have >= 2 ? frame[0] | frame[1] << 8 : 0;
+        size_t   frame_len = inflate_have >= 2 ? 2 + (header & ~APPFS_FRAME_STORED) : 2;
+        size_t   copy      = frame_len - inflate_have < len ? frame_len - inflate_have : len;
+        memcpy(frame + inflate_have, buf, copy);
+        inflate_have += copy;
+        buf          += copy;
+        len          -= copy;
+        if (inflate_have < frame_len) {
+            break;
+        } else if (frame_len == 2) {
+            header = frame[0] | frame[1] << 8;
+            if (!(header & ~APPFS_FRAME_STORED) || (header & ~APPFS_FRAME_STORED) > APPFS_FRAME_SIZE) {
+                ESP_LOGE(TAG, "Malformed compressed upload frame");
+                return badgelink_StatusCode_StatusMalformed;
+            }
+            continue;
+        }
+
+        // The frame is complete.
+        uint8_t* data     = frame + 2;
+        size_t   data_len = frame_len - 2;
+        if (!(header & APPFS_FRAME_STORED)) {
+            if (!lzf_decompress(raw, APPFS_FRAME_SIZE, &data_len, frame + 2, frame_len - 2)) {
+                ESP_LOGE(TAG, "Malformed compressed upload frame");
+                return badgelink_StatusCode_StatusMalformed;
+            }
+            data = raw;
+        }
+        if (data_len > xfer_app_size - xfer_written) {
+            ESP_LOGE(TAG, "Compressed upload is larger than the app");
+            return badgelink_StatusCode_StatusMalformed;
+        }
+        badgelink_StatusCode code = xfer_write(xfer_written, data, data_len);
+        if (code != badgelink_StatusCode_StatusOk) {
+            return code;
+        }
+        inflate_have = 0;
+    }
+    return badgelink_StatusCode_StatusOk;
+}
 
+// Read download data from the AppFS file at `pos`.
+static badgelink_StatusCode xfer_read(uint32_t pos, uint8_t* buf, size_t len) {
+    esp_err_t ec = appfsRead(xfer_fd, pos, buf, len);
     if (ec) {
         ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
-        badgelink_status_int_err();
-    } else {
-        // For protocol version 2+, compute streaming CRC during download.
-        if (badgelink_get_protocol_version() >= 2) {
-            running_crc = esp_crc32_le(running_crc, chunk->data.bytes, chunk->data.size);
-        }
-        badgelink_send_packet();
+        return badgelink_StatusCode_StatusInternalError;
     }
+    // For protocol version 2+, compute streaming CRC during download.
+    // This runs on the storage worker while other transports' requests are handled, so use the transfer's version.
+    if (badgelink_xfers[BADGELINK_XFER_SLOT(BADGELINK_XFER_APPFS)].version >= 2) {
+        running_crc = esp_crc32_le(running_crc, buf, len);
+    }
+    badgelink_digest_update(BADGELINK_XFER_APPFS, buf, len);
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Map the AppFS file being downloaded into memory so the chunks can be sent straight from flash.
+// Returns false if it can't be mapped, for example because there are not enough free MMU pages for a large app.
+static bool xfer_mmap(appfs_handle_t fd, int size) {
+    xfer_map = app_mmap(fd, size, &xfer_map_handle);
+    return xfer_map != NULL;
+}
+
+// Release the mapping made by `xfer_mmap`, if any.
+static void xfer_munmap() {
+    if (xfer_map) {
+        app_munmap(xfer_map_handle);
+    }
+    xfer_map = NULL;
+}
+
+// Handle an AppFS upload (host->badge) transfer.
+badgelink_StatusCode badgelink_appfs_xfer_upload() {
+    badgelink_Chunk* chunk = &badgelink_packet->packet.request.req.upload_chunk;
+    return badgelink_storage_write(badgelink_xfer->pos, chunk->data.bytes, chunk->data.size);
+}
+
+// Handle an AppFS download (badge->host) transfer.
+badgelink_StatusCode badgelink_appfs_xfer_download() {
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_download_chunk_tag;
+    badgelink_Chunk* chunk                        = &badgelink_packet->packet.response.resp.download_chunk;
+
+    chunk->position = badgelink_xfer->pos;
+    if (!xfer_map) {
+        return badgelink_storage_read(&chunk->data);
+    }
+
+    // The file is mapped, so there is nothing to read ahead.
+    chunk->data.bytes = (pb_byte_t*)xfer_map + badgelink_xfer->pos;
+    chunk->data.read  = NULL;
+    chunk->data.size  = badgelink_chunk_size < badgelink_xfer->size - badgelink_xfer->pos
+                            ? badgelink_chunk_size
+                            : badgelink_xfer->size - badgelink_xfer->pos;
+    // For protocol version 2+, compute streaming CRC during download.
+    if (badgelink_xfer->version >= 2) {
+        running_crc = esp_crc32_le(running_crc, chunk->data.bytes, chunk->data.size);
+    }
+    badgelink_digest_update(BADGELINK_XFER_APPFS, chunk->data.bytes, chunk->data.size);
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Delete the AppFS file of an upload that failed.
+static void xfer_delete() {
+    // AppFS can delete by fd so this is the workaround.
+    char const* name_ptr;
+    appfsEntryInfo(xfer_fd, &name_ptr, NULL);
+    char name[64];
+    strlcpy(name, name_ptr, sizeof(name));
+    appfsDeleteFile(name);
 }
 
 // Finish an AppFS transfer.
 void badgelink_appfs_xfer_stop(bool abnormal) {
-    if (badgelink_xfer_is_upload) {
-        if (abnormal) {
+    if (badgelink_xfer->is_upload) {
+        if (abnormal && xfer_resumable && xfer_written && stage_flush() == badgelink_StatusCode_StatusOk) {
+            // Storage writes were drained and flushed before this, so everything up to `xfer_written` is in the file.
+            ESP_LOGE(TAG, "AppFS upload aborted; can be resumed at %" PRIu32, xfer_written);
+            char const* slug;
+            appfsEntryInfo(xfer_fd, &slug, NULL);
+            badgelink_journal_t journal = {
+                .size        = xfer_app_size,
+                .crc32       = xfer_crc32,
+                .pos         = xfer_written,
+                .running_crc = running_crc,
+                .erased      = xfer_erased,
+            };
+            strlcpy(journal.name, slug, sizeof(journal.name));
+            badgelink_journal_save(BADGELINK_XFER_APPFS, &journal);
+
+        } else if (abnormal) {
             ESP_LOGE(TAG, "AppFS upload aborted");
+            xfer_delete();
 
-            // AppFS can delete by fd so this is the workaround.
-            char const* name_ptr;
-            appfsEntryInfo(xfer_fd, &name_ptr, NULL);
-            char name[64];
-            strlcpy(name, name_ptr, sizeof(name));
-            appfsDeleteFile(name);
+        } else if (stage_flush() != badgelink_StatusCode_StatusOk) {
+            badgelink_status_int_err();
+            xfer_delete();
+
+        } else if (inflate_buf && (inflate_have || xfer_written != xfer_app_size)) {
+            ESP_LOGE(TAG, "Compressed upload ended before the end of the app");
+            badgelink_status_malformed();
+            xfer_delete();
 
         } else {
+            if (xfer_resumable) {
+                badgelink_journal_clear(BADGELINK_XFER_APPFS);
+            }
+            // The end of the app may have been skipped by a delta upload.
+            if (xfer_written < xfer_app_size) {
+                xfer_hash_skipped(xfer_written, xfer_app_size - xfer_written);
+            }
             if (running_crc != xfer_crc32) {
                 ESP_LOGE(TAG, "AppFS upload CRC32 mismatch; expected %08" PRIx32 ", actual %08" PRIx32, xfer_crc32,
                          running_crc);
                 badgelink_status_int_err();
-
-                // AppFS can delete by fd so this is the workaround.
-                char const* name_ptr;
-                appfsEntryInfo(xfer_fd, &name_ptr, NULL);
-                char name[64];
-                strlcpy(name, name_ptr, sizeof(name));
-                appfsDeleteFile(name);
+                xfer_delete();
+            } else if (!badgelink_digest_finish(BADGELINK_XFER_APPFS)) {
+                badgelink_status_int_err();
+                xfer_delete();
             } else {
                 ESP_LOGI(TAG, "AppFS upload finished");
-                badgelink_status_ok();
+                app_crc_store(xfer_fd, running_crc);
+                if (!badgelink_digest_send(BADGELINK_XFER_APPFS, running_crc, xfer_app_size)) {
+                    badgelink_status_ok();
+                }
             }
         }
+        free(inflate_buf);
+        inflate_buf = NULL;
+        free(stage_buf);
+        stage_buf = NULL;
+        stage_len = 0;
     } else {
+        xfer_munmap();
         if (abnormal) {
             ESP_LOGE(TAG, "AppFS download aborted");
         } else {
             ESP_LOGI(TAG, "AppFS download finished");
+            // Only the CRC32 of the whole app is worth remembering.
+            int size;
+            appfsEntryInfo(xfer_fd, NULL, &size);
+            if (badgelink_xfer->version >= 2 && badgelink_xfer->start == 0 && badgelink_xfer->size == size) {
+                app_crc_store(xfer_fd, running_crc);
+            }
 
-            // For protocol version 2+, send the final CRC.
-            if (badgelink_get_protocol_version() >= 2) {
-                badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-                badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-                badgelink_packet.packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
-                badgelink_AppfsActionResp* resp              = &badgelink_packet.packet.response.resp.appfs_resp;
-                resp->which_val                              = badgelink_AppfsActionResp_crc32_tag;
-                resp->val.crc32                              = running_crc;
-                resp->size                                   = badgelink_xfer_size;
-                badgelink_send_packet();
-            } else {
+            // For protocol version 2+, send the final CRC, which comes with the digest if one was negotiated.
+            badgelink_digest_finish(BADGELINK_XFER_APPFS);
+            if (badgelink_xfer->version < 2) {
                 badgelink_status_ok();
+            } else if (!badgelink_digest_send(BADGELINK_XFER_APPFS, running_crc,
+                                              badgelink_xfer->size - badgelink_xfer->start)) {
+                badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+                badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+                badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+                badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+                resp->which_val                               = badgelink_AppfsActionResp_crc32_tag;
+                resp->val.crc32                               = running_crc;
+                resp->size                                    = badgelink_xfer->size;
+                badgelink_send_packet();
             }
         }
     }
@@ -158,7 +572,7 @@ void badgelink_appfs_xfer_stop(bool abnormal) {
 void badgelink_appfs_list() {
     // Validate request.
     // Note: AppFS fds can be 0 so we don't check its presence here.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->crc32 || req->which_id != 0) {
         badgelink_status_malformed();
         return;
@@ -167,13 +581,13 @@ void badgelink_appfs_list() {
     int skip = req->list_offset;
 
     // Format response.
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
-    badgelink_AppfsActionResp* resp              = &badgelink_packet.packet.response.resp.appfs_resp;
-    resp->which_val                              = badgelink_AppfsActionResp_list_tag;
-    resp->val.list.list_count                    = 0;
-    resp->val.list.total_size                    = 0;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = badgelink_AppfsActionResp_list_tag;
+    resp->val.list.list_count                     = 0;
+    resp->val.list.total_size                     = 0;
 
     // Read all handles in AppFS.
     appfs_handle_t handle  = appfsNextEntry(APPFS_INVALID_FD);
@@ -214,7 +628,7 @@ void badgelink_appfs_list() {
 // Handle an AppFS delete request.
 void badgelink_appfs_delete() {
     // Validate request.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->crc32 || req->which_id != badgelink_AppfsActionReq_slug_tag) {
         badgelink_status_malformed();
         return;
@@ -233,59 +647,172 @@ void badgelink_appfs_delete() {
     }
 }
 
+// Whether the existing app `fd` has the same metadata as `meta`.
+static bool app_matches(appfs_handle_t fd, badgelink_AppfsMetadata const* meta) {
+    char const* title;
+    uint16_t    version;
+    int         size;
+    appfsEntryInfoExt(fd, NULL, &title, &version, &size);
+    return (uint32_t)size == meta->size && version == meta->version && !strcmp(title, meta->title);
+}
+
+// Open the existing app for a delta upload.
+// AppFS can't change the metadata of a file, so the new app must have the same; otherwise it is uploaded normally.
+static bool delta_open(badgelink_AppfsMetadata const* meta) {
+    appfs_handle_t fd = appfsOpen(meta->slug);
+    if (fd == APPFS_INVALID_FD) {
+        badgelink_status_not_found();
+        return false;
+    }
+
+    if (!app_matches(fd, meta)) {
+        ESP_LOGE(TAG, "Delta upload metadata differs from the existing app");
+        badgelink_status_ill_state();
+        return false;
+    }
+    xfer_fd = fd;
+    return true;
+}
+
+// Open the partial app of an aborted resumable upload and check that what was written of it is still there.
+// Returns the position to continue from, or 0 if the upload has to start over.
+static uint32_t resume_open(badgelink_AppfsActionReq const* req, uint8_t const* expected_sha256) {
+    badgelink_journal_t journal;
+    if (!badgelink_journal_find(BADGELINK_XFER_APPFS, req->id.metadata.slug, req->id.metadata.size, req->crc32,
+                                &journal)) {
+        return 0;
+    }
+    appfs_handle_t fd = appfsOpen(req->id.metadata.slug);
+    if (fd == APPFS_INVALID_FD || !app_matches(fd, &req->id.metadata)) {
+        return 0;
+    }
+
+    // The part that was written is hashed again, which also checks the app wasn't changed in the meantime.
+    xfer_fd = fd;
+    xfer_hash_skipped(0, journal.pos);
+    if (running_crc != journal.running_crc) {
+        ESP_LOGW(TAG, "AppFS upload cannot be resumed; starting over");
+        running_crc = 0;
+        badgelink_digest_begin(BADGELINK_XFER_APPFS, expected_sha256);
+        return 0;
+    }
+    xfer_erased = journal.erased;
+    return journal.pos;
+}
+
 // Handle an AppFS upload request.
 void badgelink_appfs_upload() {
     // Validate request.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->which_id != badgelink_AppfsActionReq_metadata_tag) {
         badgelink_status_malformed();
         return;
-    } else if (badgelink_xfer_type != BADGELINK_XFER_NONE) {
+    } else if (badgelink_xfer_busy(BADGELINK_XFER_APPFS)) {
         badgelink_status_ill_state();
         return;
-    }
-
-    // Try to create the new file.
-    esp_err_t ec = appfsCreateFileExt(req->id.metadata.slug, req->id.metadata.title, req->id.metadata.version,
-                                      req->id.metadata.size, &xfer_fd);
-    if (ec == ESP_ERR_NO_MEM) {
-        ESP_LOGE(TAG, "Out of space for uploading");
-        badgelink_status_no_space();
+    } else if (req->delta && req->compressed_size) {
+        // Delta uploads skip ahead in the app, which a compressed stream can't.
+        badgelink_status_malformed();
         return;
-    } else if (ec) {
-        ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
-        badgelink_status_int_err();
+    } else if (req->resumable && (req->delta || req->compressed_size)) {
+        // Neither is written in order from the start, so there is no position to continue an aborted one from.
+        badgelink_status_malformed();
+        return;
+    } else if (!badgelink_digest_valid(req->sha256.size)) {
+        badgelink_status_malformed();
         return;
     }
 
-    // Erase the entire file explicitly because AppFS doesn't do that for some reason.
-    uint32_t rounded_size = req->id.metadata.size;
-    if (rounded_size % SPI_FLASH_MMU_PAGE_SIZE) {
-        rounded_size += SPI_FLASH_MMU_PAGE_SIZE - rounded_size % SPI_FLASH_MMU_PAGE_SIZE;
+    // A compressed upload is inflated on the fly, one frame at a time.
+    if (req->compressed_size) {
+        inflate_buf = malloc(2 + 2 * APPFS_FRAME_SIZE);
+        if (!inflate_buf) {
+            ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+            badgelink_status_int_err();
+            return;
+        }
+    }
+
+    // A resumable upload continues where an aborted upload of the same app stopped, if that part is still there.
+    uint8_t const* expected_sha256 = req->sha256.size ? req->sha256.bytes : NULL;
+    uint32_t       pos             = 0;
+    running_crc                    = 0;
+    xfer_erased                    = 0;
+    badgelink_digest_begin(BADGELINK_XFER_APPFS, expected_sha256);
+    if (req->resumable) {
+        pos = resume_open(req, expected_sha256);
+    }
+
+    if (req->delta) {
+        // Update the existing file in place.
+        if (!delta_open(&req->id.metadata)) {
+            badgelink_digest_abort(BADGELINK_XFER_APPFS);
+            return;
+        }
+    } else if (!pos) {
+        // Try to create the new file.
+        esp_err_t ec = appfsCreateFileExt(req->id.metadata.slug, req->id.metadata.title, req->id.metadata.version,
+                                          req->id.metadata.size, &xfer_fd);
+        if (ec == ESP_ERR_NO_MEM) {
+            ESP_LOGE(TAG, "Out of space for uploading");
+            badgelink_status_no_space();
+            badgelink_digest_abort(BADGELINK_XFER_APPFS);
+            free(inflate_buf);
+            inflate_buf = NULL;
+            return;
+        } else if (ec) {
+            ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
+            badgelink_status_int_err();
+            badgelink_digest_abort(BADGELINK_XFER_APPFS);
+            free(inflate_buf);
+            inflate_buf = NULL;
+            return;
+        }
     }
-    appfsErase(xfer_fd, 0, rounded_size);
 
-    // File created successfully, initiate transfer.
-    badgelink_xfer_type      = BADGELINK_XFER_APPFS;
-    badgelink_xfer_is_upload = true;
-    badgelink_xfer_pos       = 0;
-    badgelink_xfer_size      = req->id.metadata.size;
-    xfer_crc32               = req->crc32;
-    running_crc              = 0;
+    // File opened successfully, initiate transfer.
+    // A delta upload only sends the sectors that changed, so it may skip ahead to the start of a sector.
+    uint32_t                size = req->compressed_size ? req->compressed_size : req->id.metadata.size;
+    badgelink_xfer_state_t* xfer = badgelink_xfer_begin(BADGELINK_XFER_APPFS, true, size);
+    xfer->skip_align             = req->delta ? APPFS_SECTOR_SIZE : 0;
+    xfer->pos                    = pos;
+    xfer_crc32                   = req->crc32;
+    xfer_erase_size              = req->delta ? APPFS_SECTOR_SIZE : SPI_FLASH_MMU_PAGE_SIZE;
+    xfer_written                 = pos;
+    xfer_app_size                = req->id.metadata.size;
+    xfer_resumable               = req->resumable;
+    inflate_have                 = 0;
+    // Without the staging buffer, every chunk is programmed as it comes in, which is slower but still works.
+    stage_buf                    = malloc(APPFS_STAGE_SIZE);
+    stage_len                    = 0;
+    if (xfer_resumable) {
+        badgelink_journal_clear(BADGELINK_XFER_APPFS);
+    }
+    badgelink_storage_begin(inflate_buf ? xfer_inflate : xfer_write);
 
-    // This OK response officially starts the transfer.
-    ESP_LOGI(TAG, "AppFS upload started");
-    badgelink_status_ok();
+    // This response officially starts the transfer; a resumable upload is told where to continue from.
+    ESP_LOGI(TAG, "AppFS upload started at %" PRIu32, pos);
+    if (!xfer_resumable) {
+        badgelink_status_ok();
+        return;
+    }
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = 0;
+    resp->size                                    = pos;
+    badgelink_send_packet();
 }
 
 // Handle an AppFS download request.
 void badgelink_appfs_download() {
     // Validate request.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->crc32 || req->which_id != badgelink_AppfsActionReq_slug_tag) {
         badgelink_status_malformed();
         return;
-    } else if (badgelink_xfer_type != BADGELINK_XFER_NONE) {
+    } else if (badgelink_xfer_busy(BADGELINK_XFER_APPFS)) {
         badgelink_status_ill_state();
         return;
     }
@@ -300,30 +827,39 @@ void badgelink_appfs_download() {
     uint32_t crc = 0;
     int      size;
     appfsEntryInfo(fd, NULL, &size);
+    uint32_t             end;
+    badgelink_StatusCode code = badgelink_download_range(req->offset, req->length, size, &end);
+    if (code != badgelink_StatusCode_StatusOk) {
+        badgelink_send_status(code);
+        return;
+    }
 
     if (badgelink_get_protocol_version() >= 2) {
-        // Protocol version 2+: CRC will be computed during transfer.
+        // Protocol version 2+: CRC will be computed during transfer, over just the range that is sent.
         running_crc = 0;
     } else {
         // Protocol version 1: calculate CRC32 upfront by reading entire file.
         crc = calc_app_crc32(fd);
     }
 
-    // Set up transfer.
-    badgelink_xfer_type      = BADGELINK_XFER_APPFS;
-    badgelink_xfer_is_upload = false;
-    badgelink_xfer_pos       = 0;
-    badgelink_xfer_size      = size;
-    xfer_fd                  = fd;
+    // Set up transfer; chunks of a range have the position in the app, so a host can resume where it left off.
+    badgelink_xfer_state_t* xfer = badgelink_xfer_begin(BADGELINK_XFER_APPFS, false, end);
+    xfer->pos                    = req->offset;
+    xfer->start                  = req->offset;
+    xfer_fd                      = fd;
+    badgelink_digest_begin(BADGELINK_XFER_APPFS, NULL);
+    if (!xfer_mmap(fd, size)) {
+        badgelink_storage_begin(xfer_read);
+    }
 
     // Format response.
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
-    badgelink_AppfsActionResp* resp              = &badgelink_packet.packet.response.resp.appfs_resp;
-    resp->which_val                              = badgelink_AppfsActionResp_crc32_tag;
-    resp->size                                   = size;
-    resp->val.crc32                              = crc;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = badgelink_AppfsActionResp_crc32_tag;
+    resp->size                                    = end;
+    resp->val.crc32                               = crc;
 
     // Send response.
     badgelink_send_packet();
@@ -332,7 +868,7 @@ void badgelink_appfs_download() {
 // Handle an AppFS stat request.
 void badgelink_appfs_stat() {
     // Validate request.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->crc32 || req->which_id != badgelink_AppfsActionReq_slug_tag) {
         badgelink_status_malformed();
         return;
@@ -353,11 +889,11 @@ void badgelink_appfs_stat() {
     appfsEntryInfoExt(fd, &name, &title, &version, &size);
 
     // Format response.
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
-    badgelink_AppfsActionResp* resp              = &badgelink_packet.packet.response.resp.appfs_resp;
-    resp->which_val                              = badgelink_AppfsActionResp_metadata_tag;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = badgelink_AppfsActionResp_metadata_tag;
     strlcpy(resp->val.metadata.slug, name, sizeof(resp->val.metadata.slug));
     strlcpy(resp->val.metadata.title, title, sizeof(resp->val.metadata.title));
     resp->val.metadata.version = version;
@@ -370,7 +906,7 @@ void badgelink_appfs_stat() {
 // Handle an AppFS crc32 request.
 void badgelink_appfs_crc32() {
     // Validate request.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->crc32 || req->which_id != badgelink_AppfsActionReq_slug_tag) {
         badgelink_status_malformed();
         return;
@@ -387,12 +923,12 @@ void badgelink_appfs_crc32() {
     uint32_t crc = calc_app_crc32(fd);
 
     // Format response.
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
-    badgelink_AppfsActionResp* resp              = &badgelink_packet.packet.response.resp.appfs_resp;
-    resp->which_val                              = badgelink_AppfsActionResp_crc32_tag;
-    resp->val.crc32                              = crc;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = badgelink_AppfsActionResp_crc32_tag;
+    resp->val.crc32                               = crc;
 
     // Send response.
     badgelink_send_packet();
@@ -401,20 +937,82 @@ void badgelink_appfs_crc32() {
 // Handle an AppFS usage statistics request.
 void badgelink_appfs_usage() {
     // Validate request.
-    badgelink_AppfsActionReq* req = &badgelink_packet.packet.request.req.appfs_action;
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
     if (req->crc32 || req->which_id != 0) {
         badgelink_status_malformed();
         return;
     }
 
     // Format response.
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_AppfsActionResp* resp              = &badgelink_packet.packet.response.resp.appfs_resp;
-    resp->which_val                              = badgelink_AppfsActionResp_usage_tag;
-    resp->val.usage.size                         = appfsGetTotalMem();
-    resp->val.usage.used                         = resp->val.usage.size - appfsGetFreeMem();
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = badgelink_AppfsActionResp_usage_tag;
+    resp->val.usage.size                          = appfsGetTotalMem();
+    resp->val.usage.used                          = resp->val.usage.size - appfsGetFreeMem();
+
+    badgelink_send_packet();
+}
+
+// Handle an AppFS sector CRC32s request.
+void badgelink_appfs_sector_crc32() {
+    // Validate request.
+    badgelink_AppfsActionReq* req = &badgelink_packet->packet.request.req.appfs_action;
+    if (req->crc32 || req->which_id != badgelink_AppfsActionReq_slug_tag) {
+        badgelink_status_malformed();
+        return;
+    }
+
+    // Find the file.
+    appfs_handle_t fd = appfsOpen(req->id.slug);
+    if (fd == APPFS_INVALID_FD) {
+        badgelink_status_not_found();
+        return;
+    }
+    int size;
+    appfsEntryInfo(fd, NULL, &size);
+
+    // Send as many CRC32s from the requested sector on as fit in a chunk; they only exist while being sent.
+    uint32_t total = (size + APPFS_SECTOR_SIZE - 1) / APPFS_SECTOR_SIZE;
+    uint32_t first = req->list_offset < total ? req->list_offset : total;
+    uint32_t count = (badgelink_chunk_size - 8) / sizeof(uint32_t);
+    if (count > total - first) {
+        count = total - first;
+    }
+    pb_byte_t* arena = malloc(count * sizeof(uint32_t) + 1);
+    if (!arena) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        badgelink_status_int_err();
+        return;
+    }
+    // The whole app is mapped once rather than for every sector.
+    app_mmap_handle_t handle;
+    uint8_t const*    map = app_mmap(fd, size, &handle);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t start = (first + i) * APPFS_SECTOR_SIZE;
+        uint32_t len   = size - start < APPFS_SECTOR_SIZE ? size - start : APPFS_SECTOR_SIZE;
+        uint32_t crc   = map ? esp_crc32_le(0, map + start, len) : calc_crc32_read(fd, 0, start, len);
+        memcpy(arena + i * sizeof(uint32_t), &crc, sizeof(crc));
+    }
+    if (map) {
+        app_munmap(handle);
+    }
+
+    // Format response.
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_appfs_resp_tag;
+    badgelink_AppfsActionResp* resp               = &badgelink_packet->packet.response.resp.appfs_resp;
+    resp->which_val                               = badgelink_AppfsActionResp_sector_crcs_tag;
+    resp->size                                    = size;
+    resp->val.sector_crcs.offset                  = first;
+    resp->val.sector_crcs.crc32.arena             = arena;
+    resp->val.sector_crcs.crc32.len               = count * sizeof(uint32_t);
+    resp->val.sector_crcs.total_sectors           = total;
+    resp->val.sector_crcs.sector_size             = APPFS_SECTOR_SIZE;
 
+    // Send response.
     badgelink_send_packet();
+    free(arena);
 }
@@ -9,9 +9,11 @@
 // Handle an AppFS request packet.
 void badgelink_appfs_handle();
 // Handle an AppFS upload (host->badge) transfer.
-void badgelink_appfs_xfer_upload();
+// Hands the chunk to the storage worker but does not respond; the caller acknowledges it.
+badgelink_StatusCode badgelink_appfs_xfer_upload();
 // Handle an AppFS download (badge->host) transfer.
-void badgelink_appfs_xfer_download();
+// Prepares the chunk response with data from the storage worker but does not send it.
+badgelink_StatusCode badgelink_appfs_xfer_download();
 // Finish an AppFS transfer.
 void badgelink_appfs_xfer_stop(bool abnormal);
 
@@ -29,3 +31,5 @@ void badgelink_appfs_stat();
 void badgelink_appfs_crc32();
 // Handle an AppFS usage statistics request.
 void badgelink_appfs_usage();
+// Handle an AppFS sector CRC32s request.
+void badgelink_appfs_sector_crc32();
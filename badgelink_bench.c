@@ -0,0 +1,340 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_bench.h"
+#ifdef CONFIG_BADGELINK_APPFS
+#include "appfs.h"
+#endif
+#include "badgelink_appfs.h"
+#include "badgelink_fs.h"
+#include "badgelink_stats.h"
+#include "cobs.h"
+#include "esp_crc.h"
+#include "esp_log.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "sys/stat.h"
+
+static char const TAG[] = "badgelink_bench";
+
+// Bytes put through each stage if the host doesn't say.
+#define BENCH_SIZE_DEFAULT (256 * 1024)
+// Most bytes put through each stage, so a benchmark can't keep the BadgeLink task busy for minutes.
+#define BENCH_SIZE_MAX     (4 * 1024 * 1024)
+// Slug of the temporary AppFS file.
+#define BENCH_APPFS_SLUG   "badgelink-bench"
+// Room for the other fields of an encoded `Chunk` next to its data.
+#define BENCH_CHUNK_EXTRA  16
+
+// Data an echo response repeats; it points into the received frame until the response is encoded.
+static pb_byte_t const* echo_src;
+static size_t           echo_src_len;
+
+// Fill `buf` with pseudo-random data, so nothing along the way can take a shortcut on it.
+static void bench_fill(uint8_t* buf, size_t len) {
+    uint32_t state = 0x9e3779b9;
+    for (size_t i = 0; i < len; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        buf[i] = state;
+    }
+}
+
+#ifdef CONFIG_BADGELINK_FS
+// Time writing and reading back `size` bytes at `path` in chunks of `chunk` bytes.
+// Sends an error response and returns false if the file can't be written or read.
+static bool bench_fs(char const* path, uint8_t* buf, uint32_t chunk, uint32_t size, badgelink_BenchResult* res) {
+    // Never overwrite a file the user cares about.
+    struct stat statbuf;
+    if (stat(path, &statbuf) == 0) {
+        ESP_LOGE(TAG, "%s: %s already exists", __FUNCTION__, path);
+        badgelink_status_exists();
+        return false;
+    }
+
+    FILE* fd = badgelink_fs_fopen(path, "wb");
+    if (!fd) {
+        ESP_LOGE(TAG, "%s: Cannot create %s", __FUNCTION__, path);
+        badgelink_status_not_found();
+        return false;
+    }
+    bool    ok    = true;
+    int64_t start = badgelink_stats_now();
+    for (uint32_t pos = 0; ok && pos < size; pos += chunk) {
+        ok = fwrite(buf, 1, chunk, fd) == chunk;
+    }
+    // Closing flushes the last of the data, so it counts towards writing.
+    badgelink_fs_fclose(fd);
+    res->fs_write_us = badgelink_stats_since(start);
+    if (!ok) {
+        ESP_LOGE(TAG, "%s: Out of space writing %s", __FUNCTION__, path);
+        remove(path);
+        badgelink_status_no_space();
+        return false;
+    }
+
+    fd = badgelink_fs_fopen(path, "rb");
+    if (!fd) {
+        ESP_LOGE(TAG, "%s: Cannot open %s", __FUNCTION__, path);
+        remove(path);
+        badgelink_status_int_err();
+        return false;
+    }
+    start = badgelink_stats_now();
+    for (uint32_t pos = 0; ok && pos < size; pos += chunk) {
+        ok = fread(buf, 1, chunk, fd) == chunk;
+    }
+    res->fs_read_us = badgelink_stats_since(start);
+    badgelink_fs_fclose(fd);
+    remove(path);
+    if (!ok) {
+        ESP_LOGE(TAG, "%s: Cannot read %s", __FUNCTION__, path);
+        badgelink_status_int_err();
+        return false;
+    }
+    return true;
+}
+#endif
+
+#ifdef CONFIG_BADGELINK_APPFS
+// Time erasing, writing and reading back a temporary AppFS file of `size` bytes in chunks of `chunk` bytes.
+// Sends an error response and returns false if the file can't be created, written or read.
+static bool bench_appfs(uint8_t* buf, uint32_t chunk, uint32_t size, badgelink_BenchResult* res) {
+    appfs_handle_t fd;
+    esp_err_t      ec = appfsCreateFileExt(BENCH_APPFS_SLUG, "BadgeLink benchmark", 0, size, &fd);
+    if (ec == ESP_ERR_NO_MEM) {
+        ESP_LOGE(TAG, "Out of space for benchmarking AppFS");
+        badgelink_status_no_space();
+        return false;
+    } else if (ec) {
+        ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
+        badgelink_status_int_err();
+        return false;
+    }
+    badgelink_appfs_changed();
+
+    // Uploads erase a page at a time as the data comes in; erasing it all at once times the flash alone.
+    uint32_t erase_size = (size + SPI_FLASH_MMU_PAGE_SIZE - 1) / SPI_FLASH_MMU_PAGE_SIZE * SPI_FLASH_MMU_PAGE_SIZE;
+    int64_t  start      = badgelink_stats_now();
+    ec                  = appfsErase(fd, 0, erase_size);
+    res->appfs_erase_us = badgelink_stats_since(start);
+
+    start = badgelink_stats_now();
+    for (uint32_t pos = 0; !ec && pos < size; pos += chunk) {
+        ec = appfsWrite(fd, pos, buf, chunk);
+    }
+    res->appfs_write_us = badgelink_stats_since(start);
+
+    start = badgelink_stats_now();
+    for (uint32_t pos = 0; !ec && pos < size; pos += chunk) {
+        ec = appfsRead(fd, pos, buf, chunk);
+    }
+    res->appfs_read_us = badgelink_stats_since(start);
+
+    appfsDeleteFile(BENCH_APPFS_SLUG);
+    if (ec) {
+        ESP_LOGE(TAG, "%s: error %s", __FUNCTION__, esp_err_to_name(ec));
+        badgelink_status_int_err();
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Time the CRC32, protobuf and COBS stages a chunk of `chunk` bytes goes through, for `size` bytes of chunks.
+// Sends an error response and returns false if out of memory.
+static bool bench_cpu(uint8_t* buf, uint32_t chunk, uint32_t size, badgelink_BenchResult* res) {
+    size_t   packed_cap = chunk + BENCH_CHUNK_EXTRA;
+    uint8_t* packed     = malloc(packed_cap);
+    uint8_t* frame      = malloc(COBS_ENCODED_MAX_LENGTH(packed_cap + 4));
+    uint8_t* decoded    = malloc(packed_cap + 4);
+    if (!packed || !frame || !decoded) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        free(packed);
+        free(frame);
+        free(decoded);
+        badgelink_status_int_err();
+        return false;
+    }
+    bool ok = true;
+
+    uint32_t crc   = 0;
+    int64_t  start = badgelink_stats_now();
+    for (uint32_t pos = 0; pos < size; pos += chunk) {
+        crc = esp_crc32_le(crc, buf, chunk);
+    }
+    res->crc32_us = badgelink_stats_since(start);
+    (void)crc;
+
+    // Encode the chunks the way downloads do, each at its own position.
+    badgelink_Chunk msg = badgelink_Chunk_init_zero;
+    msg.data.bytes      = buf;
+    msg.data.size       = chunk;
+    size_t packed_len   = 0;
+    start               = badgelink_stats_now();
+    for (uint32_t pos = 0; ok && pos < size; pos += chunk) {
+        msg.position    = pos;
+        pb_ostream_t os = pb_ostream_from_buffer(packed, packed_cap);
+        ok              = pb_encode(&os, badgelink_Chunk_fields, &msg);
+        packed_len      = os.bytes_written;
+    }
+    res->pb_encode_us = badgelink_stats_since(start);
+
+    start = badgelink_stats_now();
+    for (uint32_t pos = 0; ok && pos < size; pos += chunk) {
+        pb_istream_t is = pb_istream_from_buffer(packed, packed_len);
+        ok              = pb_decode(&is, badgelink_Chunk_fields, &msg) && msg.data.size == chunk;
+    }
+    res->pb_decode_us = badgelink_stats_since(start);
+
+    // Frame the last encoded chunk, which is as long as any of them.
+    cobs_encoder_t enc;
+    size_t         frame_len = 0;
+    start                    = badgelink_stats_now();
+    for (uint32_t pos = 0; ok && pos < size; pos += chunk) {
+        cobs_encoder_init(&enc, frame);
+        cobs_encoder_write(&enc, packed, packed_len);
+        frame_len = cobs_encoder_finish(&enc);
+    }
+    res->cobs_encode_us = badgelink_stats_since(start);
+
+    cobs_decoder_t dec;
+    start = badgelink_stats_now();
+    for (uint32_t pos = 0; ok && pos < size; pos += chunk) {
+        cobs_decoder_init(&dec, decoded, packed_cap + 4);
+        cobs_decoder_feed(&dec, frame, frame_len);
+        ok = dec.complete && cobs_decoder_finish(&dec) == COBS_FRAME_OK && dec.len == packed_len;
+    }
+    res->cobs_decode_us = badgelink_stats_since(start);
+
+    free(packed);
+    free(frame);
+    free(decoded);
+    if (!ok) {
+        ESP_LOGE(TAG, "[BUG] %s: Chunk did not survive encoding and decoding", __FUNCTION__);
+        badgelink_status_int_err();
+        return false;
+    }
+    return true;
+}
+
+// Handle a benchmark request.
+void badgelink_bench_handle() {
+    badgelink_BenchReq* req = &badgelink_packet->packet.request.req.bench_req;
+
+    // A transfer in progress would slow down the stages and be slowed down by them.
+    if (badgelink_xfer_busy(BADGELINK_XFER_APPFS) || badgelink_xfer_busy(BADGELINK_XFER_FS)) {
+        badgelink_status_ill_state();
+        return;
+    }
+    // Stages of request types that aren't built can't be timed.
+#ifndef CONFIG_BADGELINK_FS
+    if (req->path[0]) {
+        ESP_LOGE(TAG, "FS requests are not supported");
+        badgelink_status_unsupported();
+        return;
+    }
+#endif
+#ifndef CONFIG_BADGELINK_APPFS
+    if (req->appfs) {
+        ESP_LOGE(TAG, "AppFS requests are not supported");
+        badgelink_status_unsupported();
+        return;
+    }
+#endif
+
+    // Every stage works in whole chunks of the size the link uses.
+    badgelink_BenchResult res   = badgelink_BenchResult_init_zero;
+    uint32_t              chunk = badgelink_chunk_size;
+    uint32_t              size  = req->size ? req->size : BENCH_SIZE_DEFAULT;
+    if (size > BENCH_SIZE_MAX) {
+        size = BENCH_SIZE_MAX;
+    }
+    size           = (size + chunk - 1) / chunk * chunk;
+    res.size       = size;
+    res.chunk_size = chunk;
+
+    uint8_t* buf = malloc(chunk);
+    if (!buf) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        badgelink_status_int_err();
+        return;
+    }
+    bench_fill(buf, chunk);
+
+    // The request is overwritten by the response, so it is only used until the response is prepared.
+    bool ok = bench_cpu(buf, chunk, size, &res);
+#ifdef CONFIG_BADGELINK_FS
+    if (ok && req->path[0]) {
+        ok = bench_fs(req->path, buf, chunk, size, &res);
+    }
+#endif
+#ifdef CONFIG_BADGELINK_APPFS
+    if (ok && req->appfs) {
+        ok = bench_appfs(buf, chunk, size, &res);
+    }
+#endif
+    free(buf);
+    if (!ok) {
+        return;
+    }
+
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_bench_tag;
+    badgelink_packet->packet.response.resp.bench  = res;
+    badgelink_send_packet();
+}
+
+// Encode or decode the data of an echo request without copying it into the packet.
+bool badgelink_EchoReq_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_EchoReq_data_tag) {
+        return true;
+    }
+    return badgelink_data_callback(istream, ostream, field);
+}
+
+// Encode or decode the data of an echo response without copying it into the packet.
+bool badgelink_EchoResp_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_EchoResp_data_tag) {
+        return true;
+    }
+    return badgelink_data_callback(istream, ostream, field);
+}
+
+// Fill the data of an echo response with the received data, repeated as often as needed.
+static bool echo_read(pb_byte_t* buf, pb_size_t len) {
+    if (!echo_src_len) {
+        for (pb_size_t i = 0; i < len; i++) {
+            buf[i] = i;
+        }
+        return true;
+    }
+    for (pb_size_t pos = 0; pos < len; pos += echo_src_len) {
+        memcpy(buf + pos, echo_src, len - pos < echo_src_len ? len - pos : echo_src_len);
+    }
+    return true;
+}
+
+// Handle an echo request.
+void badgelink_bench_echo() {
+    badgelink_EchoReq* req        = &badgelink_packet->packet.request.req.echo_req;
+    uint32_t           reply_size = req->reply_size < badgelink_chunk_size ? req->reply_size : badgelink_chunk_size;
+    uint32_t           received   = req->data.size;
+    echo_src                      = req->data.bytes;
+    echo_src_len                  = received;
+
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_echo_tag;
+    badgelink_EchoResp* resp                      = &badgelink_packet->packet.response.resp.echo;
+    resp->received                                = received;
+    resp->data.bytes                              = NULL;
+    resp->data.size                               = reply_size;
+    resp->data.read                               = echo_read;
+    badgelink_send_packet();
+}
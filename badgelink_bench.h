@@ -0,0 +1,13 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+
+// Handle a benchmark request.
+// Times every stage a transfer goes through on the badge itself, without the link, and responds with the times.
+void badgelink_bench_handle();
+// Handle an echo request.
+// Discards the received data and sends back as much data as asked, to measure the link without storage.
+void badgelink_bench_echo();
@@ -0,0 +1,41 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <pb.h>
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifndef CONFIG_BADGELINK_CHUNK_SIZE
+#define CONFIG_BADGELINK_CHUNK_SIZE 4096
+#endif
+
+// Maximum size of the data in a chunk.
+// This also limits the size of NVS values and of one page of a directory or NVS listing.
+#define BADGELINK_CHUNK_DATA_MAX CONFIG_BADGELINK_CHUNK_SIZE
+
+// Maximum size of chunk data sent to hosts that did not negotiate a chunk size, which expect at most 4096 bytes.
+#define BADGELINK_CHUNK_DATA_DEFAULT (BADGELINK_CHUNK_DATA_MAX < 4096 ? BADGELINK_CHUNK_DATA_MAX : 4096)
+
+// Data of a `Chunk` or NVS value, which is encoded and decoded without copying it into the packet.
+typedef struct {
+    // Pointer to the data; when decoding, this points into the received frame.
+    pb_byte_t* bytes;
+    // Length of the data.
+    pb_size_t  size;
+    // If set, called while encoding to read the data straight into the packet instead of copying it from `bytes`.
+    bool (*read)(pb_byte_t* buf, pb_size_t len);
+} badgelink_chunk_data_t;
+
+// Entries of a list response, packed into a buffer that is only allocated while the response is sent.
+// The layout of the entries is private to the list's callback.
+typedef struct {
+    // Packed entries.
+    pb_byte_t* arena;
+    // Number of bytes used in `arena`.
+    size_t     len;
+} badgelink_list_arena_t;
@@ -0,0 +1,118 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_digest.h"
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+#include "string.h"
+
+static char const TAG[] = "badgelink_digest";
+
+// Digest state of a transfer slot.
+typedef struct {
+    // Whether the data of the transfer is being hashed.
+    bool                   active;
+    // SHA-256 of the transfer so far; uses the SHA peripheral where the chip has one.
+    mbedtls_sha256_context ctx;
+    // SHA-256 the data of the upload must have, if `has_expected`.
+    uint8_t                expected_sha256[BADGELINK_SHA256_SIZE];
+    bool                   has_expected;
+    // SHA-256 of the last transfer of this kind that finished.
+    uint8_t                result_sha256[BADGELINK_SHA256_SIZE];
+} digest_t;
+
+// Digest the host asked transfers to get.
+static badgelink_DigestType negotiated_digest;
+// Digest state of each transfer slot; they are updated by their own storage workers.
+static digest_t             digests[BADGELINK_XFER_SLOTS];
+
+// Set which digest transfers get, as requested by the host in the version request.
+badgelink_DigestType badgelink_digest_negotiate(badgelink_DigestType type) {
+    negotiated_digest = type == badgelink_DigestType_DigestSha256 ? type : badgelink_DigestType_DigestNone;
+    return negotiated_digest;
+}
+
+// Forget the negotiated digest, for a new session.
+void badgelink_digest_reset() {
+    badgelink_digest_abort(BADGELINK_XFER_APPFS);
+    badgelink_digest_abort(BADGELINK_XFER_FS);
+    negotiated_digest = badgelink_DigestType_DigestNone;
+}
+
+// Check the SHA-256 an upload request expects the data to have, which is either empty or a full digest.
+bool badgelink_digest_valid(pb_size_t expected_len) {
+    return expected_len == 0 || expected_len == BADGELINK_SHA256_SIZE;
+}
+
+// Start hashing the data of the transfer that was just set up, if a digest was negotiated or `expected` is not NULL.
+void badgelink_digest_begin(badgelink_xfer_t type, uint8_t const* expected) {
+    digest_t* d = &digests[BADGELINK_XFER_SLOT(type)];
+    badgelink_digest_abort(type);
+    d->has_expected = expected != NULL;
+    if (d->has_expected) {
+        memcpy(d->expected_sha256, expected, BADGELINK_SHA256_SIZE);
+    }
+    if (!d->has_expected && negotiated_digest != badgelink_DigestType_DigestSha256) {
+        return;
+    }
+    mbedtls_sha256_init(&d->ctx);
+    mbedtls_sha256_starts(&d->ctx, 0);
+    d->active = true;
+}
+
+// Whether the data of the current transfer is being hashed.
+bool badgelink_digest_active(badgelink_xfer_t type) {
+    return digests[BADGELINK_XFER_SLOT(type)].active;
+}
+
+// Hash the next `len` bytes of transfer data.
+void badgelink_digest_update(badgelink_xfer_t type, void const* data, size_t len) {
+    digest_t* d = &digests[BADGELINK_XFER_SLOT(type)];
+    if (d->active && len) {
+        mbedtls_sha256_update(&d->ctx, data, len);
+    }
+}
+
+// Finish hashing the transfer.
+// Returns false if the data doesn't have the SHA-256 the upload expected.
+bool badgelink_digest_finish(badgelink_xfer_t type) {
+    digest_t* d = &digests[BADGELINK_XFER_SLOT(type)];
+    if (!d->active) {
+        return true;
+    }
+    mbedtls_sha256_finish(&d->ctx, d->result_sha256);
+    mbedtls_sha256_free(&d->ctx);
+    d->active = false;
+    if (d->has_expected && memcmp(d->result_sha256, d->expected_sha256, BADGELINK_SHA256_SIZE)) {
+        ESP_LOGE(TAG, "SHA-256 mismatch");
+        return false;
+    }
+    return true;
+}
+
+// Stop hashing a transfer that was aborted; does nothing if it already finished.
+void badgelink_digest_abort(badgelink_xfer_t type) {
+    digest_t* d = &digests[BADGELINK_XFER_SLOT(type)];
+    if (d->active) {
+        mbedtls_sha256_free(&d->ctx);
+        d->active = false;
+    }
+}
+
+// Send the result of a finished transfer with its digest, if a digest was negotiated.
+// Returns false if not, in which case the caller sends the response it would otherwise send.
+bool badgelink_digest_send(badgelink_xfer_t type, uint32_t crc32, uint32_t size) {
+    if (negotiated_digest != badgelink_DigestType_DigestSha256) {
+        return false;
+    }
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_xfer_result_tag;
+    badgelink_XferResult* resp                    = &badgelink_packet->packet.response.resp.xfer_result;
+    resp->crc32                                   = crc32;
+    resp->size                                    = size;
+    resp->sha256.size                             = BADGELINK_SHA256_SIZE;
+    memcpy(resp->sha256.bytes, digests[BADGELINK_XFER_SLOT(type)].result_sha256, BADGELINK_SHA256_SIZE);
+    badgelink_send_packet();
+    return true;
+}
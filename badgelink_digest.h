@@ -0,0 +1,33 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+
+// Size of a SHA-256 digest.
+#define BADGELINK_SHA256_SIZE 32
+
+// Set which digest transfers get, as requested by the host in the version request.
+// Returns the digest that was agreed on.
+badgelink_DigestType badgelink_digest_negotiate(badgelink_DigestType type);
+// Forget the negotiated digest, for a new session.
+void                 badgelink_digest_reset();
+// Check the SHA-256 an upload request expects the data to have, which is either empty or a full digest.
+bool                 badgelink_digest_valid(pb_size_t expected_len);
+// Each kind of transfer is hashed separately, since an AppFS and a filesystem transfer can be in progress at once.
+// Start hashing the data of the transfer that was just set up, if a digest was negotiated or `expected` is not NULL.
+// `expected` is the SHA-256 the data of an upload must have.
+void                 badgelink_digest_begin(badgelink_xfer_t type, uint8_t const* expected);
+// Whether the data of the transfer of type `type` is being hashed.
+bool                 badgelink_digest_active(badgelink_xfer_t type);
+// Hash the next `len` bytes of transfer data.
+void                 badgelink_digest_update(badgelink_xfer_t type, void const* data, size_t len);
+// Finish hashing the transfer.
+// Returns false if the data doesn't have the SHA-256 the upload expected.
+bool                 badgelink_digest_finish(badgelink_xfer_t type);
+// Stop hashing a transfer that was aborted; does nothing if it already finished.
+void                 badgelink_digest_abort(badgelink_xfer_t type);
+// Send the result of a finished transfer with its digest, if a digest was negotiated.
+// Returns false if not, in which case the caller sends the response it would otherwise send.
+bool                 badgelink_digest_send(badgelink_xfer_t type, uint32_t crc32, uint32_t size);
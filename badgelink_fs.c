@@ -3,13 +3,20 @@
 // SPDX-License-Identifier: MIT
 
 #include "badgelink_fs.h"
+#include "badgelink_digest.h"
+#include "badgelink_journal.h"
+#include "badgelink_storage.h"
 #include "dirent.h"
 #include "errno.h"
 #include "esp_crc.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_vfs_fat.h"
 #include "fcntl.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
 #include "stdio.h"
+#include "stdlib.h"
 #include "string.h"
 #include "sys/stat.h"
 #include "sys/types.h"
@@ -17,42 +24,93 @@
 
 static char const TAG[] = "badgelink_fs";
 
+// Block size for sector CRC32s and delta uploads if the host doesn't pick one.
+#define FS_BLOCK_SIZE_DEFAULT 4096
+// Smallest block size the host may pick.
+#define FS_BLOCK_SIZE_MIN     512
+
+// Record types in a tree upload stream.
+#define FS_TREE_DIR         0
+#define FS_TREE_FILE        1
+// Size of the header of a record in a tree upload stream: type, path length, size and CRC32.
+#define FS_TREE_HEADER_SIZE 11
+// Maximum length of the path of a record in a tree upload stream.
+#define FS_TREE_PATH_MAX    255
+// Suffix of the file an upload is written to before it replaces the file at its path.
+#define FS_PART_SUFFIX      ".part"
+// Suffix of the old file while a finished upload replaces it; no longer than `FS_PART_SUFFIX`.
+#define FS_OLD_SUFFIX       ".old"
+
+// Maximum nesting of directories for recursive rmdir and copy.
+#define FS_TREE_DEPTH_MAX   16
+// Size of the buffer for copying files on the device; smaller ones down to `FS_COPY_BUF_MIN` are tried if it doesn't fit.
+#ifndef CONFIG_BADGELINK_COPY_BUF_SIZE
+#define CONFIG_BADGELINK_COPY_BUF_SIZE 32768
+#endif
+#define FS_COPY_BUF_MIN   4096
+// Alignment of the copy buffer, a cache line on all targets, so the SD driver can DMA straight into it.
+#define FS_COPY_BUF_ALIGN 64
+
+// Number of files whose CRC32 is remembered, so checking files that didn't change doesn't read them again.
+#ifndef CONFIG_BADGELINK_CRC_CACHE_SIZE
+#define CONFIG_BADGELINK_CRC_CACHE_SIZE 8
+#endif
+
+// Upper bound of the encoded size of a result of a stat of many paths, with its tag and length.
+#define FS_STAT_RESULT_MAX (badgelink_FsStatResult_size + 2)
+
+// Mount point whose usage is reported if the request has no path.
+#define FS_USAGE_DEFAULT_PATH "/int"
+
+// Flags at the start of a dirent packed into the arena by `badgelink_fs_list`.
+#define FS_DIRENT_IS_DIR 0x01
+// The name is followed by the 4-byte size and 8-byte mtime in native byte order.
+#define FS_DIRENT_STAT   0x02
+
 // Fast SD I/O helpers - use internal DMA RAM for stdio buffers
 #ifdef CONFIG_FATFS_USE_FASTOPEN
 #ifndef CONFIG_FATFS_STDIO_BUF_SIZE
 #define CONFIG_FATFS_STDIO_BUF_SIZE 8192
 #endif
 #define BADGELINK_STDIO_BUF_SIZE CONFIG_FATFS_STDIO_BUF_SIZE
+// Number of files that can have a fast buffer at once: both ends of a copy.
+#define BADGELINK_STDIO_POOL_SIZE 2
 
-static FILE*  bl_fast_file   = NULL;
-static void*  bl_fast_buffer = NULL;
+static FILE*  bl_fast_file[BADGELINK_STDIO_POOL_SIZE];
+static void*  bl_fast_buffer[BADGELINK_STDIO_POOL_SIZE];
 
 static FILE* bl_sd_fopen(const char* path, const char* mode) {
     FILE* f = fopen(path, mode);
     if (f == NULL) return NULL;
 
+    // Find a free slot; without one the file just keeps its default buffer
+    size_t slot = 0;
+    while (slot < BADGELINK_STDIO_POOL_SIZE && bl_fast_file[slot] != NULL) slot++;
+    if (slot == BADGELINK_STDIO_POOL_SIZE) return f;
+
     // Allocate stdio buffer in internal DMA-capable RAM for fast SD card access
     void* buf = heap_caps_malloc(BADGELINK_STDIO_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
     if (buf != NULL) {
         setvbuf(f, buf, _IOFBF, BADGELINK_STDIO_BUF_SIZE);
-        bl_fast_file   = f;
-        bl_fast_buffer = buf;
+        bl_fast_file[slot]   = f;
+        bl_fast_buffer[slot] = buf;
     }
     return f;
 }
 
 static void bl_sd_fclose(FILE* f) {
     if (f == NULL) return;
+    fclose(f);
 
-    // Check if this file has a tracked fast buffer
-    if (bl_fast_file == f && bl_fast_buffer != NULL) {
-        fclose(f);
-        free(bl_fast_buffer);
-        bl_fast_file   = NULL;
-        bl_fast_buffer = NULL;
-        return;
+    // Free the fast buffer if this file has one
+    for (size_t slot = 0; slot < BADGELINK_STDIO_POOL_SIZE; slot++) {
+        if (bl_fast_file[slot] == f) {
+            free(bl_fast_buffer[slot]);
+            bl_fast_file[slot]   = NULL;
+            bl_fast_buffer[slot] = NULL;
+            break;
+        }
     }
-    fclose(f);
 }
 #else
 // Fallback: just use regular fopen/fclose
@@ -65,15 +123,89 @@ static inline void bl_sd_fclose(FILE* f) {
 }
 #endif
 
+// Open a file the way transfers do, with a fast stdio buffer if it is on the SD card.
+FILE* badgelink_fs_fopen(char const* path, char const* mode) {
+    return strncmp(path, "/sd", 3) == 0 ? bl_sd_fopen(path, mode) : fopen(path, mode);
+}
+
+// Close a file opened with `badgelink_fs_fopen`.
+void badgelink_fs_fclose(FILE* fd) {
+    bl_sd_fclose(fd);
+}
+
 static char     xfer_path[256];
+// File the upload is written to, which is renamed to `xfer_path` once it is complete and checked.
+static char     xfer_part_path[sizeof(xfer_path) + sizeof(FS_PART_SUFFIX) - 1];
+// Path of the file that is being written, which is either of the above; a delta upload patches the file in place.
+static char*    xfer_file;
 static FILE*    xfer_fd;
 static bool     xfer_is_sd;
 static uint32_t xfer_crc32;
 static uint32_t running_crc;
+// Whether the file being uploaded is patched in place.
+static bool     xfer_delta;
+// End of the last data written to the file being uploaded.
+static uint32_t xfer_written;
+// Whether the upload keeps the partial file if it is aborted, so it can be resumed.
+static bool     xfer_resumable;
+
+// Whether the upload is a stream of directories and files.
+static bool     xfer_tree;
+// Path of the record being received in a tree upload, after the tree's root directory and a slash.
+static char*    tree_path;
+static size_t   tree_root_len;
+// Header of the record being received and how much of it and its path was received so far.
+static uint8_t  tree_header[FS_TREE_HEADER_SIZE];
+static size_t   tree_have;
+// Whether `xfer_fd` is a file of the tree being written, how much of it is left and its CRC32 so far.
+static bool     tree_file_open;
+static uint32_t tree_left;
+static uint32_t tree_crc;
+
+// Directory kept open between pages for a client that uses cursors, so the next page continues where the last one ended.
+static DIR*     list_dir;
+// Path of `list_dir`.
+static char*    list_path;
+// Dirent that was read from `list_dir` but didn't fit in the last page, if any.
+static char*    list_next;
+static bool     list_next_dir;
+// Cursor the client sends back to continue with `list_dir`, or 0 if there is none.
+static uint32_t list_cursor;
+// Last cursor handed out.
+static uint32_t last_cursor;
+// Index of the next dirent of `list_dir`.
+static uint32_t list_pos;
+// Total number of dirents, if counted when the listing started.
+static uint32_t list_total;
+
+// Transport that was handed `list_cursor`, which is the only one that can continue the listing.
+static badgelink_transport_t* list_owner;
+
+// A remembered CRC32, valid while the file keeps the same size and mtime.
+typedef struct {
+    char*    path;
+    uint32_t size;
+    uint64_t mtime;
+    uint32_t crc;
+} crc_cache_entry_t;
+
+// Remembered CRC32s, of which the oldest is replaced by the next that is calculated.
+static crc_cache_entry_t crc_cache[CONFIG_BADGELINK_CRC_CACHE_SIZE];
+static size_t            crc_cache_next;
 
 // Handle a FS request packet.
 void badgelink_fs_handle() {
-    switch (badgelink_packet.packet.request.req.fs_action.type) {
+    // A directory kept open for a cursor can't continue past changes to the filesystem, which it may also block.
+    badgelink_FsActionType type = badgelink_packet->packet.request.req.fs_action.type;
+    if (type != badgelink_FsActionType_FsActionList && type != badgelink_FsActionType_FsActionDownload &&
+        type != badgelink_FsActionType_FsActionStat && type != badgelink_FsActionType_FsActionCrc23 &&
+        type != badgelink_FsActionType_FsActionSectorCrc32 && type != badgelink_FsActionType_FsActionGetUsage) {
+        badgelink_fs_release_cursor();
+        // FAT mtimes only have a 2-second resolution, so a file changed through BadgeLink may keep its mtime.
+        badgelink_fs_forget_crcs();
+    }
+
+    switch (type) {
         case badgelink_FsActionType_FsActionList:
             badgelink_fs_list();
             break;
@@ -92,12 +224,12 @@ void badgelink_fs_handle() {
         case badgelink_FsActionType_FsActionStat:
             badgelink_fs_stat();
             break;
-        // case badgelink_FsActionType_FsActionCrc23:
-        //     badgelink_fs_crc32();
-        //     break;
-        // case badgelink_FsActionType_FsActionGetUsage:
-        //     badgelink_fs_usage();
-        //     break;
+        case badgelink_FsActionType_FsActionCrc23:
+            badgelink_fs_crc32();
+            break;
+        case badgelink_FsActionType_FsActionGetUsage:
+            badgelink_fs_usage();
+            break;
         case badgelink_FsActionType_FsActionRmdir:
             badgelink_fs_rmdir();
             break;
@@ -107,81 +239,491 @@ void badgelink_fs_handle() {
         case badgelink_FsActionType_FsActionRename:
             badgelink_fs_rename();
             break;
+        case badgelink_FsActionType_FsActionSectorCrc32:
+            badgelink_fs_sector_crc32();
+            break;
+        case badgelink_FsActionType_FsActionTreeUpload:
+            badgelink_fs_tree_upload();
+            break;
         default:
             badgelink_status_unsupported();
             break;
     }
 }
 
-// Handle a FS upload (host->badge) transfer.
-void badgelink_fs_xfer_upload() {
-    badgelink_Chunk* chunk = &badgelink_packet.packet.request.req.upload_chunk;
+// Continue calculating a CRC32 over `len` bytes of `fd` starting at `start`, reading through `buf` of `buf_size` bytes.
+// Returns false if the file couldn't be read that far.
+static bool calc_crc32_range_buf(FILE* fd, uint32_t* crc, uint32_t start, uint32_t len, uint8_t* buf, size_t buf_size) {
+    if (len && fseek(fd, start, SEEK_SET)) {
+        return false;
+    }
+    while (len) {
+        size_t max = len < buf_size ? len : buf_size;
+        if (fread(buf, 1, max, fd) < max) {
+            return false;
+        }
+        *crc  = esp_crc32_le(*crc, buf, max);
+        len  -= max;
+    }
+    return true;
+}
 
-    size_t len = fwrite(chunk->data.bytes, 1, chunk->data.size, xfer_fd);
-    if (len < chunk->data.size) {
-        if (errno == ENOSPC) {
-            badgelink_status_no_space();
-        } else {
+// Continue calculating a CRC32 over `len` bytes of `fd` starting at `start`.
+// Returns false if the file couldn't be read that far.
+static bool calc_crc32_range(FILE* fd, uint32_t* crc, uint32_t start, uint32_t len) {
+    uint8_t tmp[512];
+    return calc_crc32_range_buf(fd, crc, start, len, tmp, sizeof(tmp));
+}
+
+// Allocate a buffer for copying or checksumming files, in DMA-capable RAM if the SD card is involved.
+// Halves the size until it fits, so a copy still works on a fragmented heap; free it with `heap_caps_free`.
+static uint8_t* copy_buf_alloc(bool sd, size_t* size) {
+    uint32_t caps = sd ? MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL : MALLOC_CAP_8BIT;
+    for (*size = CONFIG_BADGELINK_COPY_BUF_SIZE; *size >= FS_COPY_BUF_MIN; *size /= 2) {
+        uint8_t* buf = heap_caps_aligned_alloc(FS_COPY_BUF_ALIGN, *size, caps);
+        if (buf) {
+            return buf;
+        }
+    }
+    *size = FS_COPY_BUF_MIN;
+    return malloc(FS_COPY_BUF_MIN);
+}
+
+// Modification time of a file in milliseconds, as sent in an FsStat.
+static uint64_t stat_mtime(struct stat const* statbuf) {
+    return statbuf->st_mtim.tv_sec * 1000 + statbuf->st_mtim.tv_nsec / 1000000l;
+}
+
+// Convert the result of `stat` to an FsStat.
+static void convert_stat(badgelink_FsStat* out, struct stat const* statbuf) {
+    out->size   = statbuf->st_size;
+    out->mtime  = stat_mtime(statbuf);
+    out->ctime  = statbuf->st_ctim.tv_sec * 1000 + statbuf->st_ctim.tv_nsec / 1000000l;
+    out->atime  = statbuf->st_atim.tv_sec * 1000 + statbuf->st_atim.tv_nsec / 1000000l;
+    out->is_dir = (statbuf->st_mode & S_IFMT) == S_IFDIR;
+}
+
+// Look up the remembered CRC32 of the file at `path`, if its size and mtime didn't change.
+static bool crc_cache_find(char const* path, struct stat const* statbuf, uint32_t* crc) {
+    for (size_t i = 0; i < CONFIG_BADGELINK_CRC_CACHE_SIZE; i++) {
+        crc_cache_entry_t const* ent = &crc_cache[i];
+        if (ent->path && ent->size == statbuf->st_size && ent->mtime == stat_mtime(statbuf) && !strcmp(ent->path, path)) {
+            *crc = ent->crc;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Remember the CRC32 of the file at `path`, replacing what was remembered about it before.
+static void crc_cache_store(char const* path, struct stat const* statbuf, uint32_t crc) {
+    crc_cache_entry_t* ent = NULL;
+    for (size_t i = 0; i < CONFIG_BADGELINK_CRC_CACHE_SIZE && !ent; i++) {
+        if (crc_cache[i].path && !strcmp(crc_cache[i].path, path)) {
+            ent = &crc_cache[i];
+        }
+    }
+    if (!ent) {
+        ent            = &crc_cache[crc_cache_next];
+        crc_cache_next = (crc_cache_next + 1) % CONFIG_BADGELINK_CRC_CACHE_SIZE;
+        free(ent->path);
+        ent->path = strdup(path);
+    }
+    ent->size  = statbuf->st_size;
+    ent->mtime = stat_mtime(statbuf);
+    ent->crc   = crc;
+}
+
+// Calculate the CRC32 of the whole file `fd` at `path`, or get it from the ones remembered.
+// Reads through a big buffer if there is memory for it; the CRC32 is otherwise limited by the many small reads.
+// Returns false if the file couldn't be read.
+static bool calc_file_crc32(FILE* fd, char const* path, struct stat const* statbuf, uint32_t* crc) {
+    *crc = 0;
+    if (crc_cache_find(path, statbuf, crc)) {
+        return true;
+    }
+    size_t   buf_size;
+    uint8_t* buf = copy_buf_alloc(strncmp(path, "/sd", 3) == 0, &buf_size);
+    bool     ok  = buf ? calc_crc32_range_buf(fd, crc, 0, statbuf->st_size, buf, buf_size)
+                       : calc_crc32_range(fd, crc, 0, statbuf->st_size);
+    heap_caps_free(buf);
+    if (ok) {
+        crc_cache_store(path, statbuf, *crc);
+    }
+    return ok;
+}
+
+// Forget all remembered CRC32s.
+void badgelink_fs_forget_crcs() {
+    for (size_t i = 0; i < CONFIG_BADGELINK_CRC_CACHE_SIZE; i++) {
+        free(crc_cache[i].path);
+        crc_cache[i].path = NULL;
+    }
+    crc_cache_next = 0;
+}
+
+// Hash `len` bytes of the file being uploaded starting at `start`, which a delta upload skipped.
+// Returns false if the file couldn't be read that far.
+static bool xfer_hash_skipped(uint32_t start, uint32_t len) {
+    if (!badgelink_digest_active(BADGELINK_XFER_FS)) {
+        return calc_crc32_range(xfer_fd, &running_crc, start, len);
+    }
+    uint8_t tmp[512];
+    if (len && fseek(xfer_fd, start, SEEK_SET)) {
+        return false;
+    }
+    while (len) {
+        size_t max = len < sizeof(tmp) ? len : sizeof(tmp);
+        if (fread(tmp, 1, max, xfer_fd) < max) {
+            return false;
+        }
+        running_crc  = esp_crc32_le(running_crc, tmp, max);
+        badgelink_digest_update(BADGELINK_XFER_FS, tmp, max);
+        len         -= max;
+    }
+    return true;
+}
+
+// Write upload data to the file at `pos`.
+static badgelink_StatusCode xfer_write(uint32_t pos, uint8_t* buf, size_t len) {
+    if (pos != xfer_written) {
+        // A delta upload skipped blocks that didn't change, which still count towards the CRC32 and digest.
+        if (!xfer_hash_skipped(xfer_written, pos - xfer_written) || fseek(xfer_fd, pos, SEEK_SET)) {
             ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
-            badgelink_status_int_err();
+            return badgelink_StatusCode_StatusInternalError;
         }
-    } else {
-        running_crc = esp_crc32_le(running_crc, chunk->data.bytes, chunk->data.size);
-        badgelink_status_ok();
     }
+    if (fwrite(buf, 1, len, xfer_fd) < len) {
+        if (errno == ENOSPC) {
+            return badgelink_StatusCode_StatusNoSpace;
+        }
+        ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+    running_crc  = esp_crc32_le(running_crc, buf, len);
+    xfer_written = pos + len;
+    badgelink_digest_update(BADGELINK_XFER_FS, buf, len);
+    return badgelink_StatusCode_StatusOk;
 }
 
-// Handle a FS download (badge->host) transfer.
-void badgelink_fs_xfer_download() {
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_download_chunk_tag;
-    badgelink_Chunk* chunk                       = &badgelink_packet.packet.response.resp.download_chunk;
-
-    chunk->position  = badgelink_xfer_pos;
-    chunk->data.size = fread(chunk->data.bytes, 1, sizeof(chunk->data.bytes), xfer_fd);
-    if (ferror(xfer_fd)) {
+// Read download data from the file; it is read in order, so `pos` is where the file is at.
+static badgelink_StatusCode xfer_read(uint32_t pos, uint8_t* buf, size_t len) {
+    (void)pos;
+    if (fread(buf, 1, len, xfer_fd) < len) {
         ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+    // For protocol version 2+, compute streaming CRC during download.
+    // This runs on the storage worker while other transports' requests are handled, so use the transfer's version.
+    if (badgelink_xfers[BADGELINK_XFER_SLOT(BADGELINK_XFER_FS)].version >= 2) {
+        running_crc = esp_crc32_le(running_crc, buf, len);
+    }
+    badgelink_digest_update(BADGELINK_XFER_FS, buf, len);
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Translate the errno of a failed file operation.
+static badgelink_StatusCode errno_status() {
+    switch (errno) {
+        case ENOENT:
+            return badgelink_StatusCode_StatusNotFound;
+        case EEXIST:
+            return badgelink_StatusCode_StatusExists;
+        case EISDIR:
+            return badgelink_StatusCode_StatusIsDir;
+        case ENOTDIR:
+            return badgelink_StatusCode_StatusIsFile;
+        case ENOSPC:
+            return badgelink_StatusCode_StatusNoSpace;
+        default:
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            return badgelink_StatusCode_StatusInternalError;
+    }
+}
+
+// Close the file of a tree upload that was written completely and check its CRC32.
+static badgelink_StatusCode tree_close_file() {
+    uint32_t expected = tree_header[7] | tree_header[8] << 8 | tree_header[9] << 16 | (uint32_t)tree_header[10] << 24;
+    tree_file_open    = false;
+    if (xfer_is_sd) {
+        bl_sd_fclose(xfer_fd);
+    } else {
+        fclose(xfer_fd);
+    }
+    if (tree_crc != expected) {
+        ESP_LOGE(TAG, "%s: CRC32 mismatch; expected %08" PRIx32 ", actual %08" PRIx32, tree_path, expected, tree_crc);
+        unlink(tree_path);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Create the directory or file of a tree upload record once its header and path are received.
+static badgelink_StatusCode tree_start_record() {
+    size_t path_len = tree_header[1] | tree_header[2] << 8;
+    char*  path     = tree_path + tree_root_len + 1;
+    path[path_len]  = 0;
+
+    // The path must stay inside the tree, so it can't be absolute nor have empty, `.` or `..` components.
+    if (strlen(path) != path_len) {
+        return badgelink_StatusCode_StatusMalformed;
+    }
+    for (char const* comp = path; comp;) {
+        char const* slash = strchr(comp, '/');
+        size_t      len   = slash ? (size_t)(slash - comp) : strlen(comp);
+        if (!len || (len == 1 && comp[0] == '.') || (len == 2 && comp[0] == '.' && comp[1] == '.')) {
+            return badgelink_StatusCode_StatusMalformed;
+        }
+        comp = slash ? slash + 1 : NULL;
+    }
+
+    if (tree_header[0] == FS_TREE_DIR) {
+        // A directory that already exists is fine, so a tree can be uploaded over an older version of it.
+        struct stat statbuf;
+        if (mkdir(tree_path, 0777) && !(errno == EEXIST && !stat(tree_path, &statbuf) && S_ISDIR(statbuf.st_mode))) {
+            return errno_status();
+        }
+        return badgelink_StatusCode_StatusOk;
+    }
+
+    xfer_fd = xfer_is_sd ? bl_sd_fopen(tree_path, "wb") : fopen(tree_path, "wb");
+    if (!xfer_fd) {
+        return errno_status();
+    }
+    tree_file_open = true;
+    tree_left      = tree_header[3] | tree_header[4] << 8 | tree_header[5] << 16 | (uint32_t)tree_header[6] << 24;
+    tree_crc       = 0;
+    return tree_left ? badgelink_StatusCode_StatusOk : tree_close_file();
+}
+
+// Write tree upload data, which is a series of records that each start with a header:
+// - type: 1 byte, `FS_TREE_DIR` or `FS_TREE_FILE`;
+// - path length: 2 bytes, up to `FS_TREE_PATH_MAX`;
+// - size: 4 bytes, 0 for directories;
+// - CRC32 of the data: 4 bytes, 0 for directories.
+// All little-endian, followed by the path relative to the tree's root directory and then the data of files.
+// It is written in order, so `pos` is where the stream is at.
+static badgelink_StatusCode xfer_tree_write(uint32_t pos, uint8_t* buf, size_t len) {
+    (void)pos;
+    running_crc = esp_crc32_le(running_crc, buf, len);
+    badgelink_digest_update(BADGELINK_XFER_FS, buf, len);
+    while (len) {
+        size_t               part;
+        badgelink_StatusCode code = badgelink_StatusCode_StatusOk;
+        if (tree_file_open) {
+            // Data of the current file.
+            part = len < tree_left ? len : tree_left;
+            if (fwrite(buf, 1, part, xfer_fd) < part) {
+                return errno_status();
+            }
+            tree_crc   = esp_crc32_le(tree_crc, buf, part);
+            tree_left -= part;
+            if (!tree_left) {
+                code = tree_close_file();
+            }
+
+        } else if (tree_have < FS_TREE_HEADER_SIZE) {
+            // Header of the next record.
+            part = FS_TREE_HEADER_SIZE - tree_have;
+            part = len < part ? len : part;
+            memcpy(tree_header + tree_have, buf, part);
+            tree_have += part;
+            if (tree_have == FS_TREE_HEADER_SIZE) {
+                size_t path_len = tree_header[1] | tree_header[2] << 8;
+                bool   is_dir   = tree_header[0] == FS_TREE_DIR;
+                if ((!is_dir && tree_header[0] != FS_TREE_FILE) || !path_len || path_len > FS_TREE_PATH_MAX ||
+                    (is_dir && memcmp(tree_header + 3, "\0\0\0\0\0\0\0\0", 8))) {
+                    ESP_LOGE(TAG, "Malformed tree upload record header");
+                    return badgelink_StatusCode_StatusMalformed;
+                }
+            }
+
+        } else {
+            // Path of the next record.
+            size_t path_len = tree_header[1] | tree_header[2] << 8;
+            size_t have     = tree_have - FS_TREE_HEADER_SIZE;
+            part            = len < path_len - have ? len : path_len - have;
+            memcpy(tree_path + tree_root_len + 1 + have, buf, part);
+            tree_have += part;
+            if (have + part == path_len) {
+                tree_have = 0;
+                code      = tree_start_record();
+            }
+        }
+        if (code != badgelink_StatusCode_StatusOk) {
+            return code;
+        }
+        buf += part;
+        len -= part;
+    }
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Finish a FS tree upload.
+static void tree_stop(bool abnormal) {
+    bool complete = !tree_file_open && !tree_have;
+    if (tree_file_open) {
+        // Only the file that was being written is removed; the ones before it are complete.
+        if (xfer_is_sd) {
+            bl_sd_fclose(xfer_fd);
+        } else {
+            fclose(xfer_fd);
+        }
+        unlink(tree_path);
+        tree_file_open = false;
+    }
+    free(tree_path);
+    tree_path = NULL;
+    xfer_tree = false;
+
+    if (abnormal) {
+        ESP_LOGE(TAG, "FS tree upload aborted");
+    } else if (!complete) {
+        ESP_LOGE(TAG, "FS tree upload ended in the middle of a record");
+        badgelink_status_malformed();
+    } else if (running_crc != xfer_crc32) {
+        ESP_LOGE(TAG, "FS tree upload CRC32 mismatch; expected %08" PRIx32 ", actual %08" PRIx32, xfer_crc32,
+                 running_crc);
+        badgelink_status_int_err();
+    } else if (!badgelink_digest_finish(BADGELINK_XFER_FS)) {
         badgelink_status_int_err();
     } else {
-        // For protocol version 2+, compute streaming CRC during download.
-        if (badgelink_get_protocol_version() >= 2) {
-            running_crc = esp_crc32_le(running_crc, chunk->data.bytes, chunk->data.size);
+        ESP_LOGI(TAG, "FS tree upload finished");
+        if (!badgelink_digest_send(BADGELINK_XFER_FS, running_crc, badgelink_xfer->size)) {
+            badgelink_status_ok();
         }
-        badgelink_send_packet();
     }
 }
 
+// Outcome of moving the file of a finished upload to its path.
+typedef enum {
+    // The new file is at the path.
+    PART_COMMITTED,
+    // The new file couldn't be moved, and the old one is still at the path.
+    PART_KEPT_OLD,
+    // Neither file is at the path; the new one is still in the `.part` file and the old one in the `.old` file.
+    PART_STRANDED,
+} part_commit_t;
+
+// Move the file of a finished upload to its path, replacing the file that was there.
+static part_commit_t part_commit() {
+    if (!rename(xfer_part_path, xfer_path)) {
+        return PART_COMMITTED;
+    } else if (errno != EEXIST) {
+        return PART_KEPT_OLD;
+    }
+
+    // FAT doesn't replace a file by renaming another over it, so the old one is moved aside first and only deleted
+    // once the new one is in place. One left over from an earlier upload is older than the one at the path.
+    char backup[sizeof(xfer_part_path)];
+    snprintf(backup, sizeof(backup), "%s" FS_OLD_SUFFIX, xfer_path);
+    unlink(backup);
+    if (rename(xfer_path, backup)) {
+        return PART_KEPT_OLD;
+    }
+    if (rename(xfer_part_path, xfer_path)) {
+        int  err      = errno;
+        bool restored = !rename(backup, xfer_path);
+        errno         = err;
+        return restored ? PART_KEPT_OLD : PART_STRANDED;
+    }
+    unlink(backup);
+    return PART_COMMITTED;
+}
+
+// Handle a FS upload (host->badge) transfer.
+badgelink_StatusCode badgelink_fs_xfer_upload() {
+    badgelink_Chunk* chunk = &badgelink_packet->packet.request.req.upload_chunk;
+    return badgelink_storage_write(badgelink_xfer->pos, chunk->data.bytes, chunk->data.size);
+}
+
+// Handle a FS download (badge->host) transfer.
+badgelink_StatusCode badgelink_fs_xfer_download() {
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_download_chunk_tag;
+    badgelink_Chunk* chunk                        = &badgelink_packet->packet.response.resp.download_chunk;
+
+    chunk->position = badgelink_xfer->pos;
+    return badgelink_storage_read(&chunk->data);
+}
+
 // Finish a FS transfer.
 void badgelink_fs_xfer_stop(bool abnormal) {
-    if (abnormal) {
+    if (xfer_tree) {
+        tree_stop(abnormal);
+    } else if (abnormal) {
         if (xfer_is_sd) {
             bl_sd_fclose(xfer_fd);
         } else {
             fclose(xfer_fd);
         }
-        if (badgelink_xfer_is_upload) {
+        if (badgelink_xfer->is_upload && xfer_resumable && xfer_written) {
+            // Storage writes were drained before this, so everything up to `xfer_written` is in the file.
+            ESP_LOGE(TAG, "FS upload aborted; can be resumed at %" PRIu32, xfer_written);
+            badgelink_journal_t journal = {
+                .size        = badgelink_xfer->size,
+                .crc32       = xfer_crc32,
+                .pos         = xfer_written,
+                .running_crc = running_crc,
+            };
+            strlcpy(journal.name, xfer_path, sizeof(journal.name));
+            badgelink_journal_save(BADGELINK_XFER_FS, &journal);
+        } else if (badgelink_xfer->is_upload) {
+            // The file at the path stays as it was, unless it was being patched.
             ESP_LOGE(TAG, "FS upload aborted");
-            unlink(xfer_path);
+            unlink(xfer_file);
         } else {
             ESP_LOGE(TAG, "FS download aborted");
         }
 
-    } else if (badgelink_xfer_is_upload) {
+    } else if (badgelink_xfer->is_upload) {
+        if (xfer_resumable) {
+            badgelink_journal_clear(BADGELINK_XFER_FS);
+        }
+        // A patched file may have gotten shorter, and a delta upload may have skipped the end of it.
+        bool          patched = true;
+        part_commit_t commit  = PART_COMMITTED;
+        if (xfer_delta) {
+            patched = !fflush(xfer_fd) && !ftruncate(fileno(xfer_fd), badgelink_xfer->size) &&
+                      xfer_hash_skipped(xfer_written, badgelink_xfer->size - xfer_written);
+        }
         if (xfer_is_sd) {
             bl_sd_fclose(xfer_fd);
         } else {
             fclose(xfer_fd);
         }
 
-        if (running_crc != xfer_crc32) {
+        if (!patched) {
+            ESP_LOGE(TAG, "FS upload failed to patch file; errno %d", errno);
+            unlink(xfer_file);
+            badgelink_status_int_err();
+        } else if (running_crc != xfer_crc32) {
             ESP_LOGE(TAG, "FS upload CRC32 mismatch; expected %08" PRIx32 ", actual %08" PRIx32, xfer_crc32,
                      running_crc);
-            unlink(xfer_path);
+            unlink(xfer_file);
+            badgelink_status_int_err();
+        } else if (!badgelink_digest_finish(BADGELINK_XFER_FS)) {
+            unlink(xfer_file);
             badgelink_status_int_err();
+        } else if (xfer_file == xfer_part_path && (commit = part_commit()) == PART_KEPT_OLD) {
+            ESP_LOGE(TAG, "FS upload failed to replace %s; errno %d", xfer_path, errno);
+            unlink(xfer_file);
+            badgelink_status_int_err();
+        } else if (commit == PART_STRANDED) {
+            // The `.part` file is the only complete copy of the new file now, so it stays.
+            ESP_LOGE(TAG, "FS upload failed to replace %s and to put it back; errno %d", xfer_path, errno);
+            badgelink_status_ill_state();
         } else {
+            // The host is likely to check the file again, for example after a deploy.
+            struct stat statbuf;
+            if (!stat(xfer_path, &statbuf)) {
+                crc_cache_store(xfer_path, &statbuf, running_crc);
+            }
             ESP_LOGI(TAG, "FS upload finished");
-            badgelink_status_ok();
+            if (!badgelink_digest_send(BADGELINK_XFER_FS, running_crc, badgelink_xfer->size)) {
+                badgelink_status_ok();
+            }
         }
 
     } else {
@@ -192,75 +734,285 @@ void badgelink_fs_xfer_stop(bool abnormal) {
             fclose(xfer_fd);
         }
 
-        // For protocol version 2+, send the final CRC.
-        if (badgelink_get_protocol_version() >= 2) {
-            badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-            badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-            badgelink_packet.packet.response.which_resp  = badgelink_Response_fs_resp_tag;
-            badgelink_FsActionResp* resp                 = &badgelink_packet.packet.response.resp.fs_resp;
-            resp->which_val                              = badgelink_FsActionResp_crc32_tag;
-            resp->val.crc32                              = running_crc;
-            resp->size                                   = badgelink_xfer_size;
-            badgelink_send_packet();
-        } else {
+        // For protocol version 2+, send the final CRC, which comes with the digest if one was negotiated.
+        badgelink_digest_finish(BADGELINK_XFER_FS);
+        if (badgelink_xfer->version < 2) {
             badgelink_status_ok();
+        } else if (!badgelink_digest_send(BADGELINK_XFER_FS, running_crc,
+                                          badgelink_xfer->size - badgelink_xfer->start)) {
+            badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+            badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+            badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_resp_tag;
+            badgelink_FsActionResp* resp                  = &badgelink_packet->packet.response.resp.fs_resp;
+            resp->which_val                               = badgelink_FsActionResp_crc32_tag;
+            resp->val.crc32                               = running_crc;
+            resp->size                                    = badgelink_xfer->size;
+            badgelink_send_packet();
+        }
+    }
+}
+
+// Encode the dirents that `badgelink_fs_list` packed into the arena as `flags, name, 0[, size, mtime]` records.
+bool badgelink_FsDirentList_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_FsDirentList_list_tag) {
+        return true;
+    }
+    if (istream) {
+        // Listings are only ever sent by the badge.
+        return pb_read(istream, NULL, istream->bytes_left);
+    }
+
+    badgelink_list_arena_t const* list = field->pData;
+    size_t                        pos  = 0;
+    while (pos < list->len) {
+        badgelink_FsDirent ent   = badgelink_FsDirent_init_zero;
+        uint8_t            flags = list->arena[pos++];
+        size_t             len   = strlen((char const*)list->arena + pos);
+        ent.is_dir               = flags & FS_DIRENT_IS_DIR;
+        memcpy(ent.name, list->arena + pos, len + 1);
+        pos += len + 1;
+        if (flags & FS_DIRENT_STAT) {
+            ent.has_stat = true;
+            memcpy(&ent.size, list->arena + pos, sizeof(ent.size));
+            memcpy(&ent.mtime, list->arena + pos + sizeof(ent.size), sizeof(ent.mtime));
+            pos += sizeof(ent.size) + sizeof(ent.mtime);
+        }
+        if (!pb_encode_tag_for_field(ostream, field) ||
+            !pb_encode_submessage(ostream, badgelink_FsDirent_fields, &ent)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Close the directory kept for a cursor, if any.
+void badgelink_fs_release_cursor() {
+    if (list_dir) {
+        closedir(list_dir);
+        list_dir = NULL;
+    }
+    free(list_path);
+    free(list_next);
+    list_path   = NULL;
+    list_next   = NULL;
+    list_cursor = 0;
+}
+
+// Close the directory kept for a cursor if transport `t` was handed it.
+void badgelink_fs_release_cursor_of(badgelink_transport_t* t) {
+    if (list_owner == t) {
+        badgelink_fs_release_cursor();
+    }
+}
+
+// Whether a dirent is the `.` or `..` entry.
+static bool is_dot_dirent(struct dirent const* ent) {
+    return !strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..");
+}
+
+// Count the dirents in a directory, not counting the `.` and `..` entries.
+static bool count_dirents(char const* path, uint32_t* count) {
+    DIR* dp = opendir(path);
+    if (!dp) {
+        return false;
+    }
+    *count = 0;
+    for (struct dirent* ent = readdir(dp); ent; ent = readdir(dp)) {
+        if (!is_dot_dirent(ent)) {
+            (*count)++;
         }
     }
+    closedir(dp);
+    return true;
 }
 
 // Handle a FS list request.
 void badgelink_fs_list() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    // Without a cursor, every page reads the whole directory to count the dirents, like it always has.
+    // With one, the dirents are counted once when the listing starts, if at all, and the next page continues here.
+    bool     use_cursor = req->use_cursor;
+    bool     with_stat  = req->with_stat;
+    uint32_t skip       = 0;
+    uint32_t total      = 0;
+    uint32_t pos        = 0;
+    DIR*     dp;
+    char*    path     = NULL;
+    char*    next     = NULL;
+    bool     next_dir = false;
+    if (use_cursor && req->cursor && req->cursor == list_cursor && req->list_offset == list_pos &&
+        !strcmp(req->path, list_path) && list_owner == badgelink_request_transport()) {
+        dp          = list_dir;
+        path        = list_path;
+        next        = list_next;
+        next_dir    = list_next_dir;
+        pos         = list_pos;
+        total       = list_total;
+        list_dir    = NULL;
+        list_path   = NULL;
+        list_next   = NULL;
+        list_cursor = 0;
 
-    // Open directory.
-    DIR* dp = opendir(req->path);
-    if (!dp && errno == ENOENT) {
-        badgelink_status_not_found();
-        return;
-    } else if (!dp) {
-        ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+    } else {
+        badgelink_fs_release_cursor();
+        skip = req->list_offset;
+
+        // Open directory.
+        dp = opendir(req->path);
+        if (!dp && errno == ENOENT) {
+            badgelink_status_not_found();
+            return;
+        } else if (!dp) {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            badgelink_status_int_err();
+            return;
+        }
+
+        if (use_cursor && !(path = strdup(req->path))) {
+            ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+            closedir(dp);
+            badgelink_status_int_err();
+            return;
+        } else if (use_cursor && !req->skip_total && !count_dirents(req->path, &total)) {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            free(path);
+            closedir(dp);
+            badgelink_status_int_err();
+            return;
+        }
+    }
+
+    // The dirents are only stored for as long as it takes to send them.
+    // The path of each dirent to stat is built after the directory's path, without its trailing slashes.
+    pb_byte_t* arena     = malloc(badgelink_chunk_size);
+    size_t     dir_len   = strlen(req->path);
+    char*      stat_path = NULL;
+    while (dir_len && req->path[dir_len - 1] == '/') {
+        dir_len--;
+    }
+    if (with_stat && (stat_path = malloc(dir_len + 1 + sizeof(((badgelink_FsDirent*)0)->name)))) {
+        memcpy(stat_path, req->path, dir_len);
+        stat_path[dir_len] = '/';
+    }
+    if (!arena || (with_stat && !stat_path)) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        closedir(dp);
+        free(path);
+        free(next);
+        free(arena);
+        free(stat_path);
         badgelink_status_int_err();
         return;
     }
 
-    uint32_t skip = req->list_offset;
-
     // Format response.
-    badgelink_packet.which_packet                           = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code            = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp             = badgelink_Response_fs_resp_tag;
-    badgelink_packet.packet.response.resp.fs_resp.which_val = badgelink_FsActionResp_list_tag;
-    badgelink_FsDirentList* resp                            = &badgelink_packet.packet.response.resp.fs_resp.val.list;
-    resp->list_count                                        = 0;
-    resp->total_size                                        = 0;
-
-    // Read all the dirents.
-    struct dirent* ent       = readdir(dp);
-    size_t const   max_count = sizeof(resp->list) / sizeof(badgelink_FsDirent);
-    while (ent) {
-        if (strcmp(ent->d_name, ".") || strcmp(ent->d_name, "..")) {
-            // Only count entries that are not the `.` nor `..` entries.
-            resp->total_size++;
-
-            if (skip) {
-                // Skip the first entries until the specified offset is reached.
-                skip--;
-            } else if (resp->list_count < max_count) {
-                // Add entries until the array is full.
-                strlcpy(resp->list[resp->list_count].name, ent->d_name, sizeof(resp->list->name));
-                resp->list[resp->list_count].is_dir = ent->d_type == DT_DIR;
-                resp->list_count++;
+    badgelink_packet->which_packet                           = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code            = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp             = badgelink_Response_fs_resp_tag;
+    badgelink_packet->packet.response.resp.fs_resp.which_val = badgelink_FsActionResp_list_tag;
+    badgelink_FsDirentList* resp                             = &badgelink_packet->packet.response.resp.fs_resp.val.list;
+    resp->list.arena                                         = arena;
+    resp->list.len                                           = 0;
+    resp->total_size                                         = 0;
+    resp->cursor                                             = 0;
+
+    // Read the dirents, starting with the one that didn't fit in the last page.
+    size_t encoded = 0;
+    bool   full    = false;
+    bool   end     = false;
+    while (true) {
+        char const* name;
+        bool        is_dir;
+        if (next) {
+            name   = next;
+            is_dir = next_dir;
+        } else {
+            struct dirent* ent = readdir(dp);
+            if (!ent) {
+                end = true;
+                break;
+            } else if (is_dot_dirent(ent)) {
+                // Only count entries that are not the `.` nor `..` entries.
+                continue;
             }
+            name   = ent->d_name;
+            is_dir = ent->d_type == DT_DIR;
         }
-        ent = readdir(dp);
+
+        // An encoded dirent takes at most 8 bytes more than its name, and the stat 19 more.
+        size_t len = strnlen(name, sizeof(((badgelink_FsDirent*)0)->name) - 1);
+        size_t max = len + 8 + (with_stat ? 19 : 0);
+        if (skip) {
+            // Skip the first entries until the specified offset is reached.
+            skip--;
+        } else if (!full && encoded + max <= badgelink_chunk_size) {
+            // Add entries until the response is full; a dirent that can't be stated is sent without it.
+            struct stat statbuf;
+            bool        has_stat = false;
+            if (with_stat) {
+                memcpy(stat_path + dir_len + 1, name, len + 1);
+                has_stat = !stat(stat_path, &statbuf);
+            }
+            arena[resp->list.len++] = (is_dir ? FS_DIRENT_IS_DIR : 0) | (has_stat ? FS_DIRENT_STAT : 0);
+            memcpy(arena + resp->list.len, name, len);
+            resp->list.len         += len;
+            arena[resp->list.len++] = 0;
+            encoded                += max;
+            if (has_stat) {
+                uint32_t size  = statbuf.st_size;
+                uint64_t mtime = statbuf.st_mtim.tv_sec * 1000 + statbuf.st_mtim.tv_nsec / 1000000l;
+                memcpy(arena + resp->list.len, &size, sizeof(size));
+                memcpy(arena + resp->list.len + sizeof(size), &mtime, sizeof(mtime));
+                resp->list.len += sizeof(size) + sizeof(mtime);
+            }
+        } else if (use_cursor) {
+            // Keep the dirent that didn't fit for the next page.
+            if (!next && !(next = strndup(name, len))) {
+                ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+                closedir(dp);
+                free(path);
+                free(arena);
+                free(stat_path);
+                badgelink_status_int_err();
+                return;
+            }
+            next_dir = is_dir;
+            break;
+        } else {
+            // Later entries must not be sent either, or the client would miss the one that did not fit.
+            full = true;
+        }
+        pos++;
+        free(next);
+        next = NULL;
+    }
+
+    if (end) {
+        closedir(dp);
+        free(path);
+    } else {
+        // Cursors are never 0, which means there are no more dirents.
+        list_dir      = dp;
+        list_path     = path;
+        list_next     = next;
+        list_next_dir = next_dir;
+        list_pos      = pos;
+        list_total    = total;
+        list_cursor   = ++last_cursor ? last_cursor : ++last_cursor;
+        list_owner    = badgelink_request_transport();
+        resp->cursor  = list_cursor;
     }
+    resp->total_size = use_cursor ? total : pos;
 
     badgelink_send_packet();
+    free(arena);
+    free(stat_path);
 }
 
 // Handle a FS delete request.
 void badgelink_fs_delete() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
     if (unlink(req->path)) {
         if (errno == ENOENT) {
@@ -278,7 +1030,7 @@ void badgelink_fs_delete() {
 
 // Handle a FS mkdir request.
 void badgelink_fs_mkdir() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
     if (mkdir(req->path, 0777)) {
         if (errno == EEXIST) {
@@ -296,17 +1048,47 @@ void badgelink_fs_mkdir() {
 
 // Handle a FS upload request.
 void badgelink_fs_upload() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
-    if (badgelink_xfer_type != BADGELINK_XFER_NONE) {
+    if (badgelink_xfer_busy(BADGELINK_XFER_FS)) {
         badgelink_status_ill_state();
         return;
     }
 
-    // Open target file for writing.
+    // A delta upload may skip ahead to the start of any block, leaving the blocks in between as they are.
+    // It can't be resumed, since the blocks it skipped aren't known to match until the end.
+    uint32_t block_size = req->block_size ? req->block_size : FS_BLOCK_SIZE_DEFAULT;
+    if ((req->delta && block_size < FS_BLOCK_SIZE_MIN) || (req->delta && req->resumable) ||
+        !badgelink_digest_valid(req->sha256.size)) {
+        badgelink_status_malformed();
+        return;
+    }
+
+    // Anything but a delta upload is written next to the file at the path and only replaces it once it is checked,
+    // so a failed upload leaves the old file as it was.
+    if (strlen(req->path) >= sizeof(xfer_path)) {
+        badgelink_status_malformed();
+        return;
+    }
     strlcpy(xfer_path, req->path, sizeof(xfer_path));
-    xfer_is_sd = (strncmp(req->path, "/sd", 3) == 0);
-    xfer_fd    = xfer_is_sd ? bl_sd_fopen(req->path, "w+b") : fopen(req->path, "w+b");
+    snprintf(xfer_part_path, sizeof(xfer_part_path), "%s" FS_PART_SUFFIX, xfer_path);
+    xfer_file = req->delta ? xfer_path : xfer_part_path;
+    struct stat statbuf;
+    if (!req->delta && !stat(xfer_path, &statbuf) && S_ISDIR(statbuf.st_mode)) {
+        badgelink_status_is_dir();
+        return;
+    }
+
+    // A resumable upload continues where an aborted upload of the same file stopped, if that part is still there.
+    badgelink_journal_t journal;
+    bool                resume = req->resumable &&
+                  badgelink_journal_find(BADGELINK_XFER_FS, req->path, req->size, req->crc32, &journal) &&
+                  !stat(xfer_file, &statbuf) && !S_ISDIR(statbuf.st_mode) && statbuf.st_size >= journal.pos;
+
+    // Open the file for writing; a delta or resumed upload patches the existing file instead of replacing it.
+    char const* mode = req->delta || resume ? "r+b" : "w+b";
+    xfer_is_sd       = (strncmp(req->path, "/sd", 3) == 0);
+    xfer_fd          = xfer_is_sd ? bl_sd_fopen(xfer_file, mode) : fopen(xfer_file, mode);
     if (!xfer_fd) {
         if (errno == ENOENT) {
             badgelink_status_not_found();
@@ -319,24 +1101,137 @@ void badgelink_fs_upload() {
         return;
     }
 
+    // Allocate the whole file up front, so FAT doesn't have to extend its cluster chain for every write.
+    if (!req->delta && !resume && req->size && ftruncate(fileno(xfer_fd), req->size)) {
+        if (errno == ENOSPC) {
+            if (xfer_is_sd) {
+                bl_sd_fclose(xfer_fd);
+            } else {
+                fclose(xfer_fd);
+            }
+            unlink(xfer_file);
+            badgelink_status_no_space();
+            return;
+        }
+        ESP_LOGW(TAG, "Cannot preallocate %" PRIu32 " bytes; errno %d", req->size, errno);
+    }
+
+    // The part a resumed upload already wrote is hashed again, which also checks the file wasn't changed since.
+    uint8_t const* expected_sha256 = req->sha256.size ? req->sha256.bytes : NULL;
+    uint32_t       pos             = 0;
+    running_crc                    = 0;
+    badgelink_digest_begin(BADGELINK_XFER_FS, expected_sha256);
+    if (resume) {
+        if (xfer_hash_skipped(0, journal.pos) && running_crc == journal.running_crc &&
+            !fseek(xfer_fd, journal.pos, SEEK_SET)) {
+            pos = journal.pos;
+        } else if (!fflush(xfer_fd) && !ftruncate(fileno(xfer_fd), req->size) && !fseek(xfer_fd, 0, SEEK_SET)) {
+            ESP_LOGW(TAG, "FS upload cannot be resumed; starting over");
+            running_crc = 0;
+            badgelink_digest_begin(BADGELINK_XFER_FS, expected_sha256);
+        } else {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            if (xfer_is_sd) {
+                bl_sd_fclose(xfer_fd);
+            } else {
+                fclose(xfer_fd);
+            }
+            badgelink_digest_abort(BADGELINK_XFER_FS);
+            badgelink_status_int_err();
+            return;
+        }
+    }
+
+    // Set up transfer.
+    badgelink_xfer_state_t* xfer = badgelink_xfer_begin(BADGELINK_XFER_FS, true, req->size);
+    xfer->skip_align             = req->delta ? block_size : 0;
+    xfer->pos                    = pos;
+    xfer_crc32                   = req->crc32;
+    xfer_delta                   = req->delta;
+    xfer_resumable               = req->resumable;
+    xfer_written                 = pos;
+    if (xfer_resumable) {
+        badgelink_journal_clear(BADGELINK_XFER_FS);
+    }
+    badgelink_storage_begin(xfer_write);
+
+    // This response officially starts the transfer; a resumable upload is told where to continue from.
+    ESP_LOGI(TAG, "FS upload started at %" PRIu32, pos);
+    if (!xfer_resumable) {
+        badgelink_status_ok();
+        return;
+    }
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_resp_tag;
+    badgelink_FsActionResp* resp                  = &badgelink_packet->packet.response.resp.fs_resp;
+    resp->which_val                               = 0;
+    resp->size                                    = pos;
+    badgelink_send_packet();
+}
+
+// Handle a FS tree upload request.
+void badgelink_fs_tree_upload() {
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    if (badgelink_xfer_busy(BADGELINK_XFER_FS)) {
+        badgelink_status_ill_state();
+        return;
+    } else if (!badgelink_digest_valid(req->sha256.size)) {
+        badgelink_status_malformed();
+        return;
+    }
+
+    // The tree is uploaded into an existing directory.
+    struct stat statbuf;
+    if (stat(req->path, &statbuf)) {
+        if (errno == ENOENT) {
+            badgelink_status_not_found();
+        } else {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            badgelink_status_int_err();
+        }
+        return;
+    } else if (!S_ISDIR(statbuf.st_mode)) {
+        badgelink_status_is_file();
+        return;
+    }
+
+    // The path of each record is put after the root directory, without its trailing slashes.
+    tree_root_len = strlen(req->path);
+    while (tree_root_len && req->path[tree_root_len - 1] == '/') {
+        tree_root_len--;
+    }
+    tree_path = malloc(tree_root_len + 2 + FS_TREE_PATH_MAX);
+    if (!tree_path) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        badgelink_status_int_err();
+        return;
+    }
+    memcpy(tree_path, req->path, tree_root_len);
+    tree_path[tree_root_len] = '/';
+
     // Set up transfer.
-    badgelink_xfer_type      = BADGELINK_XFER_FS;
-    badgelink_xfer_is_upload = true;
-    badgelink_xfer_size      = req->size;
-    badgelink_xfer_pos       = 0;
-    xfer_crc32               = req->crc32;
-    running_crc              = 0;
+    xfer_is_sd     = (strncmp(req->path, "/sd", 3) == 0);
+    xfer_tree      = true;
+    tree_have      = 0;
+    tree_file_open = false;
+    xfer_crc32     = req->crc32;
+    running_crc    = 0;
+    badgelink_xfer_begin(BADGELINK_XFER_FS, true, req->size);
+    badgelink_digest_begin(BADGELINK_XFER_FS, req->sha256.size ? req->sha256.bytes : NULL);
+    badgelink_storage_begin(xfer_tree_write);
 
     // This OK response officially starts the transfer.
-    ESP_LOGI(TAG, "FS upload started");
+    ESP_LOGI(TAG, "FS tree upload started");
     badgelink_status_ok();
 }
 
 // Handle a FS download request.
 void badgelink_fs_download() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
-    if (badgelink_xfer_type != BADGELINK_XFER_NONE) {
+    if (badgelink_xfer_busy(BADGELINK_XFER_FS)) {
         badgelink_status_ill_state();
         return;
     }
@@ -357,14 +1252,35 @@ void badgelink_fs_download() {
         return;
     }
 
-    uint32_t crc  = 0;
-    uint32_t size = 0;
+    uint32_t    crc = 0;
+    struct stat statbuf;
+    if (fstat(fileno(xfer_fd), &statbuf)) {
+        ESP_LOGE(TAG, "%s: fstat failed, errno %d", __FUNCTION__, errno);
+        if (xfer_is_sd) {
+            bl_sd_fclose(xfer_fd);
+        } else {
+            fclose(xfer_fd);
+        }
+        badgelink_status_int_err();
+        return;
+    }
+    uint32_t             size;
+    badgelink_StatusCode code = badgelink_download_range(req->offset, req->length, statbuf.st_size, &size);
+    if (code != badgelink_StatusCode_StatusOk) {
+        if (xfer_is_sd) {
+            bl_sd_fclose(xfer_fd);
+        } else {
+            fclose(xfer_fd);
+        }
+        badgelink_send_status(code);
+        return;
+    }
 
     if (badgelink_get_protocol_version() >= 2) {
-        // Protocol version 2+: use stat() for size, CRC will be computed during transfer.
-        struct stat statbuf;
-        if (fstat(fileno(xfer_fd), &statbuf)) {
-            ESP_LOGE(TAG, "%s: fstat failed, errno %d", __FUNCTION__, errno);
+        // Protocol version 2+: CRC will be computed during transfer, over just the range that is sent.
+        running_crc = 0;
+        if (fseek(xfer_fd, req->offset, SEEK_SET)) {
+            ESP_LOGE(TAG, "%s: fseek failed, errno %d", __FUNCTION__, errno);
             if (xfer_is_sd) {
                 bl_sd_fclose(xfer_fd);
             } else {
@@ -373,34 +1289,33 @@ void badgelink_fs_download() {
             badgelink_status_int_err();
             return;
         }
-        size        = statbuf.st_size;
-        running_crc = 0;
-    } else {
-        // Protocol version 1: calculate CRC32 upfront by reading entire file.
-        uint8_t  tmp[128];
-        uint32_t rcount = 1;
-        while (rcount) {
-            rcount = fread(tmp, 1, sizeof(tmp), xfer_fd);
-            crc    = esp_crc32_le(crc, tmp, rcount);
-            size  += rcount;
+    } else if (!calc_file_crc32(xfer_fd, req->path, &statbuf, &crc) || fseek(xfer_fd, 0, SEEK_SET)) {
+        // Protocol version 1: the CRC32 is calculated upfront by reading the entire file, which failed.
+        ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+        if (xfer_is_sd) {
+            bl_sd_fclose(xfer_fd);
+        } else {
+            fclose(xfer_fd);
         }
-        fseek(xfer_fd, 0, SEEK_SET);
+        badgelink_status_int_err();
+        return;
     }
 
-    // Set up transfer.
-    badgelink_xfer_type      = BADGELINK_XFER_FS;
-    badgelink_xfer_is_upload = false;
-    badgelink_xfer_pos       = 0;
-    badgelink_xfer_size      = size;
+    // Set up transfer; chunks of a range have the position in the file, so a host can resume where it left off.
+    badgelink_xfer_state_t* xfer = badgelink_xfer_begin(BADGELINK_XFER_FS, false, size);
+    xfer->pos                    = req->offset;
+    xfer->start                  = req->offset;
+    badgelink_digest_begin(BADGELINK_XFER_FS, NULL);
+    badgelink_storage_begin(xfer_read);
 
     // Format response.
-    badgelink_packet.which_packet                = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.which_resp  = badgelink_Response_fs_resp_tag;
-    badgelink_packet.packet.response.status_code = badgelink_StatusCode_StatusOk;
-    badgelink_FsActionResp* resp                 = &badgelink_packet.packet.response.resp.fs_resp;
-    resp->which_val                              = badgelink_FsActionResp_crc32_tag;
-    resp->val.crc32                              = crc;
-    resp->size                                   = size;
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_resp_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_FsActionResp* resp                  = &badgelink_packet->packet.response.resp.fs_resp;
+    resp->which_val                               = badgelink_FsActionResp_crc32_tag;
+    resp->val.crc32                               = crc;
+    resp->size                                    = size;
 
     ESP_LOGI(TAG, "FS download started");
     badgelink_send_packet();
@@ -408,7 +1323,7 @@ void badgelink_fs_download() {
 
 // Handle a FS stat request.
 void badgelink_fs_stat() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
     // Stat the file.
     struct stat statbuf;
@@ -423,33 +1338,285 @@ void badgelink_fs_stat() {
     }
 
     // Format response.
-    badgelink_packet.which_packet                           = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code            = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp             = badgelink_Response_fs_resp_tag;
-    badgelink_packet.packet.response.resp.fs_resp.which_val = badgelink_FsActionResp_stat_tag;
-    badgelink_FsStat* resp                                  = &badgelink_packet.packet.response.resp.fs_resp.val.stat;
-
-    // Convert stat.
-    resp->size   = statbuf.st_size;
-    resp->mtime  = statbuf.st_mtim.tv_sec * 1000 + statbuf.st_mtim.tv_nsec / 1000000l;
-    resp->ctime  = statbuf.st_ctim.tv_sec * 1000 + statbuf.st_ctim.tv_nsec / 1000000l;
-    resp->atime  = statbuf.st_atim.tv_sec * 1000 + statbuf.st_atim.tv_nsec / 1000000l;
-    resp->is_dir = (statbuf.st_mode & S_IFMT) == S_IFDIR;
+    badgelink_packet->which_packet                           = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code            = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp             = badgelink_Response_fs_resp_tag;
+    badgelink_packet->packet.response.resp.fs_resp.which_val = badgelink_FsActionResp_stat_tag;
+    convert_stat(&badgelink_packet->packet.response.resp.fs_resp.val.stat, &statbuf);
+
+    badgelink_send_packet();
+}
+
+// Decode the paths of a request to stat many paths without copying them into the packet.
+bool badgelink_FsStatManyReq_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_FsStatManyReq_paths_tag) {
+        return true;
+    }
+    return badgelink_data_callback(istream, ostream, field);
+}
+
+// Encode the results that `badgelink_fs_stat_many` stored in the arena as an array of `badgelink_FsStatResult`.
+bool badgelink_FsStatManyResp_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_FsStatManyResp_results_tag) {
+        return true;
+    }
+    if (istream) {
+        // Stat results are only ever sent by the badge.
+        return pb_read(istream, NULL, istream->bytes_left);
+    }
+
+    badgelink_list_arena_t const* list = field->pData;
+    for (size_t pos = 0; pos < list->len; pos += sizeof(badgelink_FsStatResult)) {
+        badgelink_FsStatResult res;
+        memcpy(&res, list->arena + pos, sizeof(res));
+        if (!pb_encode_tag_for_field(ostream, field) ||
+            !pb_encode_submessage(ostream, badgelink_FsStatResult_fields, &res)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stat one path of a request to stat many paths, with the CRC32 of the file if it is remembered.
+static void stat_one(char const* path, badgelink_FsStatResult* res) {
+    struct stat statbuf;
+    if (stat(path, &statbuf)) {
+        if (errno == ENOENT) {
+            res->status = badgelink_StatusCode_StatusNotFound;
+        } else {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            res->status = badgelink_StatusCode_StatusInternalError;
+        }
+        return;
+    }
+    res->status   = badgelink_StatusCode_StatusOk;
+    res->has_stat = true;
+    convert_stat(&res->stat, &statbuf);
+    res->has_crc32 = !res->stat.is_dir && crc_cache_find(path, &statbuf, &res->crc32);
+}
+
+// Handle a request to stat many paths at once.
+void badgelink_fs_stat_many() {
+    // The paths are used right where they are in the frame, which the response doesn't overwrite.
+    badgelink_chunk_data_t paths = badgelink_packet->packet.request.req.fs_stat_many.paths;
+    if (!paths.size || paths.bytes[paths.size - 1] != 0) {
+        badgelink_status_malformed();
+        return;
+    }
+
+    // The results are only stored for as long as it takes to send them; paths after the ones that fit are left out.
+    size_t     max   = badgelink_chunk_size / FS_STAT_RESULT_MAX;
+    pb_byte_t* arena = malloc(max * sizeof(badgelink_FsStatResult) + 1);
+    if (!arena) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        badgelink_status_int_err();
+        return;
+    }
+
+    size_t count = 0;
+    for (size_t pos = 0; pos < paths.size && count < max; count++) {
+        char const*            path = (char const*)paths.bytes + pos;
+        badgelink_FsStatResult res  = badgelink_FsStatResult_init_zero;
+        stat_one(path, &res);
+        memcpy(arena + count * sizeof(res), &res, sizeof(res));
+        pos += strlen(path) + 1;
+    }
+
+    // Format response.
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_stats_tag;
+    badgelink_FsStatManyResp* resp                = &badgelink_packet->packet.response.resp.fs_stats;
+    resp->results.arena                           = arena;
+    resp->results.len                             = count * sizeof(badgelink_FsStatResult);
 
     badgelink_send_packet();
+    free(arena);
+}
+
+// Open a file to read for a FS crc32 or sector CRC32s request and get its size.
+// Sends the error status and returns NULL if it can't be opened.
+static FILE* open_for_crc32(char const* path, uint32_t* size, struct stat* statbuf) {
+    FILE* fd = strncmp(path, "/sd", 3) == 0 ? bl_sd_fopen(path, "rb") : fopen(path, "rb");
+    if (!fd) {
+        if (errno == ENOENT) {
+            badgelink_status_not_found();
+        } else if (errno == EISDIR) {
+            badgelink_status_is_dir();
+        } else {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            badgelink_status_int_err();
+        }
+        return NULL;
+    }
+
+    if (fstat(fileno(fd), statbuf)) {
+        ESP_LOGE(TAG, "%s: fstat failed, errno %d", __FUNCTION__, errno);
+        bl_sd_fclose(fd);
+        badgelink_status_int_err();
+        return NULL;
+    } else if ((statbuf->st_mode & S_IFMT) == S_IFDIR) {
+        bl_sd_fclose(fd);
+        badgelink_status_is_dir();
+        return NULL;
+    }
+    *size = statbuf->st_size;
+    return fd;
 }
 
 // Handle a FS crc32 request.
 void badgelink_fs_crc32() {
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    // A file that didn't change since its CRC32 was calculated doesn't need to be read.
+    struct stat statbuf;
+    uint32_t    size;
+    uint32_t    crc = 0;
+    if (!stat(req->path, &statbuf) && S_ISREG(statbuf.st_mode) && crc_cache_find(req->path, &statbuf, &crc)) {
+        size = statbuf.st_size;
+    } else {
+        FILE* fd = open_for_crc32(req->path, &size, &statbuf);
+        if (!fd) {
+            return;
+        }
+        bool ok = calc_file_crc32(fd, req->path, &statbuf, &crc);
+        bl_sd_fclose(fd);
+        if (!ok) {
+            ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+            badgelink_status_int_err();
+            return;
+        }
+    }
+
+    // Format response.
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_resp_tag;
+    badgelink_FsActionResp* resp                  = &badgelink_packet->packet.response.resp.fs_resp;
+    resp->which_val                               = badgelink_FsActionResp_crc32_tag;
+    resp->val.crc32                               = crc;
+    resp->size                                    = size;
+
+    badgelink_send_packet();
+}
+
+// Handle a FS sector CRC32s request.
+void badgelink_fs_sector_crc32() {
+    badgelink_FsActionReq* req        = &badgelink_packet->packet.request.req.fs_action;
+    uint32_t               block_size = req->block_size ? req->block_size : FS_BLOCK_SIZE_DEFAULT;
+    if (block_size < FS_BLOCK_SIZE_MIN) {
+        badgelink_status_malformed();
+        return;
+    }
+
+    uint32_t    size;
+    struct stat statbuf;
+    FILE*       fd = open_for_crc32(req->path, &size, &statbuf);
+    if (!fd) {
+        return;
+    }
+
+    // Send as many CRC32s from the requested block on as fit in a chunk; they only exist while being sent.
+    uint32_t total = size / block_size + (size % block_size != 0);
+    uint32_t first = req->list_offset < total ? req->list_offset : total;
+    uint32_t count = (badgelink_chunk_size - 8) / sizeof(uint32_t);
+    if (count > total - first) {
+        count = total - first;
+    }
+    pb_byte_t* arena = malloc(count * sizeof(uint32_t) + 1);
+    if (!arena) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        bl_sd_fclose(fd);
+        badgelink_status_int_err();
+        return;
+    }
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint32_t start = (first + i) * block_size;
+        uint32_t len   = size - start < block_size ? size - start : block_size;
+        uint32_t crc   = 0;
+        ok             = calc_crc32_range(fd, &crc, start, len);
+        memcpy(arena + i * sizeof(uint32_t), &crc, sizeof(crc));
+    }
+    bl_sd_fclose(fd);
+    if (!ok) {
+        ESP_LOGE(TAG, "%s: Unknown errno %d", __FUNCTION__, errno);
+        free(arena);
+        badgelink_status_int_err();
+        return;
+    }
+
+    // Format response.
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_resp_tag;
+    badgelink_FsActionResp* resp                  = &badgelink_packet->packet.response.resp.fs_resp;
+    resp->which_val                               = badgelink_FsActionResp_sector_crcs_tag;
+    resp->size                                    = size;
+    resp->val.sector_crcs.offset                  = first;
+    resp->val.sector_crcs.crc32.arena             = arena;
+    resp->val.sector_crcs.crc32.len               = count * sizeof(uint32_t);
+    resp->val.sector_crcs.total_sectors           = total;
+    resp->val.sector_crcs.sector_size             = block_size;
+
+    // Send response.
+    badgelink_send_packet();
+    free(arena);
 }
 
 // Handle a FS usage statistics request.
 void badgelink_fs_usage() {
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    // Usage is per FAT filesystem, which is mounted at the first component of the path.
+    char const* path = req->path[0] ? req->path : FS_USAGE_DEFAULT_PATH;
+    char        mount[sizeof(req->path)];
+    size_t      len = strcspn(path + 1, "/") + 1;
+    if (path[0] != '/') {
+        badgelink_status_malformed();
+        return;
+    }
+    memcpy(mount, path, len);
+    mount[len] = 0;
+
+    uint64_t  total, free_bytes;
+    esp_err_t ec = esp_vfs_fat_info(mount, &total, &free_bytes);
+    if (ec == ESP_ERR_INVALID_STATE) {
+        badgelink_status_not_found();
+        return;
+    } else if (ec) {
+        ESP_LOGE(TAG, "%s: %s", mount, esp_err_to_name(ec));
+        badgelink_status_int_err();
+        return;
+    }
+
+    // SD cards are often bigger than 4 GiB, so count in bigger units until it fits.
+    uint32_t unit = 1;
+    while (total / unit > UINT32_MAX) {
+        unit *= 1024;
+    }
+
+    // Format response.
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_fs_resp_tag;
+    badgelink_FsActionResp* resp                  = &badgelink_packet->packet.response.resp.fs_resp;
+    resp->which_val                               = badgelink_FsActionResp_usage_tag;
+    resp->val.usage.size                          = total / unit;
+    resp->val.usage.used                          = (total - free_bytes) / unit;
+    resp->val.usage.unit                          = unit;
+
+    badgelink_send_packet();
 }
 
 // Handle a FS rmdir request.
 void badgelink_fs_rmdir() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    if (req->recursive) {
+        badgelink_fs_rmdir_recursive();
+        return;
+    }
 
     if (rmdir(req->path)) {
         if (errno == ENOENT) {
@@ -469,9 +1636,9 @@ void badgelink_fs_rmdir() {
     }
 }
 
-// Copy a file from src_path to dst_path on the device.
+// Copy a file from src_path to dst_path on the device, through `buf` of `buf_size` bytes.
 // Returns a StatusCode indicating success or failure.
-static badgelink_StatusCode fs_copy_file(char const* src_path, char const* dst_path) {
+static badgelink_StatusCode fs_copy_file(char const* src_path, char const* dst_path, uint8_t* buf, size_t buf_size) {
     // Open source for reading; use fast I/O if on SD.
     bool  src_is_sd = (strncmp(src_path, "/sd", 3) == 0);
     FILE* src       = src_is_sd ? bl_sd_fopen(src_path, "rb") : fopen(src_path, "rb");
@@ -481,8 +1648,9 @@ static badgelink_StatusCode fs_copy_file(char const* src_path, char const* dst_p
         return badgelink_StatusCode_StatusInternalError;
     }
 
-    // Open destination for writing; use regular fopen because fastopen can only track one file.
-    FILE* dst = fopen(dst_path, "w+b");
+    // Open destination for writing; use fast I/O if on SD.
+    bool  dst_is_sd = (strncmp(dst_path, "/sd", 3) == 0);
+    FILE* dst       = dst_is_sd ? bl_sd_fopen(dst_path, "wb") : fopen(dst_path, "wb");
     if (!dst) {
         badgelink_StatusCode code;
         if (errno == ENOENT) {
@@ -498,10 +1666,9 @@ static badgelink_StatusCode fs_copy_file(char const* src_path, char const* dst_p
     }
 
     // Copy in chunks.
-    uint8_t buf[4096];
-    size_t  n;
-    bool    error = false;
-    while ((n = fread(buf, 1, sizeof(buf), src)) > 0) {
+    size_t n;
+    bool   error = false;
+    while ((n = fread(buf, 1, buf_size, src)) > 0) {
         if (fwrite(buf, 1, n, dst) < n) {
             error = true;
             break;
@@ -509,10 +1676,12 @@ static badgelink_StatusCode fs_copy_file(char const* src_path, char const* dst_p
     }
     if (ferror(src)) error = true;
 
-    // Close both files.
+    // Close both files; flushing the destination may still fail.
     if (src_is_sd) bl_sd_fclose(src);
     else fclose(src);
-    fclose(dst);
+    if (fflush(dst)) error = true;
+    if (dst_is_sd) bl_sd_fclose(dst);
+    else fclose(dst);
 
     if (error) {
         unlink(dst_path);
@@ -521,9 +1690,217 @@ static badgelink_StatusCode fs_copy_file(char const* src_path, char const* dst_p
     return badgelink_StatusCode_StatusOk;
 }
 
+// Copy a file with a buffer of its own.
+static badgelink_StatusCode copy_file_alloc(char const* src_path, char const* dst_path) {
+    size_t   buf_size;
+    uint8_t* buf = copy_buf_alloc(strncmp(src_path, "/sd", 3) == 0 || strncmp(dst_path, "/sd", 3) == 0, &buf_size);
+    if (!buf) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+    badgelink_StatusCode code = fs_copy_file(src_path, dst_path, buf, buf_size);
+    heap_caps_free(buf);
+    return code;
+}
+
+// Append a dirent's name to the path of its directory, which is `len` bytes long and has room for `cap` bytes.
+static bool append_name(char* path, size_t len, size_t cap, char const* name) {
+    size_t name_len = strlen(name);
+    if (len + 1 + name_len >= cap) {
+        ESP_LOGE(TAG, "%s/%s: Path too long", path, name);
+        return false;
+    }
+    path[len] = '/';
+    memcpy(path + len + 1, name, name_len + 1);
+    return true;
+}
+
+// Remove the directory at `path` and everything in it, counting the removed files and directories.
+// `path` has room for `cap` bytes to build the paths in it.
+static badgelink_StatusCode remove_tree(char* path, size_t cap, int depth, uint32_t* count) {
+    if (depth > FS_TREE_DEPTH_MAX) {
+        ESP_LOGE(TAG, "%s: Too deeply nested", path);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+
+    // Some filesystems skip dirents that move while the directory is read, so it is read again until it's empty.
+    size_t len = strlen(path);
+    bool   removed;
+    do {
+        DIR* dp = opendir(path);
+        if (!dp) {
+            return errno_status();
+        }
+        removed = false;
+        for (struct dirent* ent = readdir(dp); ent; ent = readdir(dp)) {
+            if (is_dot_dirent(ent)) {
+                continue;
+            }
+            badgelink_StatusCode code = badgelink_StatusCode_StatusInternalError;
+            bool                 is_dir = ent->d_type == DT_DIR;
+            if (append_name(path, len, cap, ent->d_name)) {
+                code = is_dir ? remove_tree(path, cap, depth + 1, count) : unlink(path) ? errno_status()
+                                                                                          : badgelink_StatusCode_StatusOk;
+            }
+            path[len] = 0;
+            if (code != badgelink_StatusCode_StatusOk) {
+                closedir(dp);
+                return code;
+            }
+            if (!is_dir) {
+                (*count)++;
+            }
+            removed = true;
+        }
+        closedir(dp);
+    } while (removed);
+
+    if (rmdir(path)) {
+        return errno_status();
+    }
+    (*count)++;
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Copy the directory at `src` and everything in it to `dst`, counting the copied files and directories.
+// `src` and `dst` have room for `cap` bytes to build the paths in them.
+static badgelink_StatusCode copy_tree(
+    char* src, char* dst, size_t cap, int depth, uint8_t* buf, size_t buf_size, uint32_t* count
+) {
+    if (depth > FS_TREE_DEPTH_MAX) {
+        ESP_LOGE(TAG, "%s: Too deeply nested", src);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+    if (mkdir(dst, 0777)) {
+        return errno_status();
+    }
+    (*count)++;
+
+    DIR* dp = opendir(src);
+    if (!dp) {
+        return errno_status();
+    }
+    size_t src_len = strlen(src);
+    size_t dst_len = strlen(dst);
+    for (struct dirent* ent = readdir(dp); ent; ent = readdir(dp)) {
+        if (is_dot_dirent(ent)) {
+            continue;
+        }
+        badgelink_StatusCode code   = badgelink_StatusCode_StatusInternalError;
+        bool                 is_dir = ent->d_type == DT_DIR;
+        if (append_name(src, src_len, cap, ent->d_name) && append_name(dst, dst_len, cap, ent->d_name)) {
+            code = is_dir ? copy_tree(src, dst, cap, depth + 1, buf, buf_size, count)
+                          : fs_copy_file(src, dst, buf, buf_size);
+        }
+        src[src_len] = 0;
+        dst[dst_len] = 0;
+        if (code != badgelink_StatusCode_StatusOk) {
+            closedir(dp);
+            return code;
+        }
+        if (!is_dir) {
+            (*count)++;
+        }
+    }
+    closedir(dp);
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Copy a request path into a buffer to build the paths of a tree in, without its trailing slashes.
+static char* tree_path_dup(char const* path, size_t cap) {
+    char* buf = malloc(cap);
+    if (buf) {
+        size_t len = strlen(path);
+        while (len > 1 && path[len - 1] == '/') {
+            len--;
+        }
+        memcpy(buf, path, len);
+        buf[len] = 0;
+    }
+    return buf;
+}
+
+// Send the number of files and directories a recursive rmdir or copy did.
+static void send_count(uint32_t count) {
+    badgelink_packet->which_packet                           = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code            = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp             = badgelink_Response_fs_resp_tag;
+    badgelink_packet->packet.response.resp.fs_resp.which_val = 0;
+    badgelink_packet->packet.response.resp.fs_resp.size      = 0;
+    badgelink_packet->packet.response.resp.fs_resp.count     = count;
+    badgelink_send_packet();
+}
+
+// Handle a recursive FS rmdir request.
+void badgelink_fs_rmdir_recursive() {
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    struct stat statbuf;
+    if (stat(req->path, &statbuf)) {
+        badgelink_send_status(errno_status());
+        return;
+    } else if (!S_ISDIR(statbuf.st_mode)) {
+        badgelink_status_is_file();
+        return;
+    }
+
+    char* path = tree_path_dup(req->path, sizeof(req->path));
+    if (!path) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        badgelink_status_int_err();
+        return;
+    }
+    uint32_t             count = 0;
+    badgelink_StatusCode code  = remove_tree(path, sizeof(req->path), 0, &count);
+    ESP_LOGI(TAG, "%s: Removed %" PRIu32 " files and directories", path, count);
+    free(path);
+    if (code == badgelink_StatusCode_StatusOk) {
+        send_count(count);
+    } else {
+        badgelink_send_status(code);
+    }
+}
+
+// Handle a recursive FS copy request; the source is a directory and the destination doesn't exist.
+void badgelink_fs_copy_recursive() {
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
+
+    size_t   buf_size;
+    char*    src = tree_path_dup(req->path, sizeof(req->path));
+    char*    dst = tree_path_dup(req->dest_path, sizeof(req->dest_path));
+    uint8_t* buf = copy_buf_alloc(strncmp(src ? src : "", "/sd", 3) == 0 || strncmp(dst ? dst : "", "/sd", 3) == 0, &buf_size);
+    if (!src || !dst || !buf) {
+        ESP_LOGE(TAG, "%s: Out of memory", __FUNCTION__);
+        free(src);
+        free(dst);
+        heap_caps_free(buf);
+        badgelink_status_int_err();
+        return;
+    }
+
+    // A directory can't be copied into itself, or the copy would never end.
+    size_t               src_len = strlen(src);
+    uint32_t             count   = 0;
+    badgelink_StatusCode code;
+    if (!strncmp(src, dst, src_len) && (dst[src_len] == '/' || dst[src_len] == 0 || src[src_len - 1] == '/')) {
+        code = badgelink_StatusCode_StatusMalformed;
+    } else {
+        code = copy_tree(src, dst, sizeof(req->path), 0, buf, buf_size, &count);
+        ESP_LOGI(TAG, "%s: Copied %" PRIu32 " files and directories", src, count);
+    }
+    free(src);
+    free(dst);
+    heap_caps_free(buf);
+    if (code == badgelink_StatusCode_StatusOk) {
+        send_count(count);
+    } else {
+        badgelink_send_status(code);
+    }
+}
+
 // Handle a FS copy request.
 void badgelink_fs_copy() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
     if (req->path[0] == '\0' || req->dest_path[0] == '\0') {
         badgelink_status_malformed();
@@ -537,7 +1914,7 @@ void badgelink_fs_copy() {
         else badgelink_status_int_err();
         return;
     }
-    if (S_ISDIR(src_stat.st_mode)) {
+    if (S_ISDIR(src_stat.st_mode) && !req->recursive) {
         badgelink_status_is_dir();
         return;
     }
@@ -549,13 +1926,18 @@ void badgelink_fs_copy() {
         return;
     }
 
-    badgelink_StatusCode code = fs_copy_file(req->path, req->dest_path);
+    if (S_ISDIR(src_stat.st_mode)) {
+        badgelink_fs_copy_recursive();
+        return;
+    }
+
+    badgelink_StatusCode code = copy_file_alloc(req->path, req->dest_path);
     badgelink_send_status(code);
 }
 
 // Handle a FS rename request.
 void badgelink_fs_rename() {
-    badgelink_FsActionReq* req = &badgelink_packet.packet.request.req.fs_action;
+    badgelink_FsActionReq* req = &badgelink_packet->packet.request.req.fs_action;
 
     if (req->path[0] == '\0' || req->dest_path[0] == '\0') {
         badgelink_status_malformed();
@@ -582,7 +1964,7 @@ void badgelink_fs_rename() {
         }
 
         // Copy file, then delete source.
-        badgelink_StatusCode code = fs_copy_file(req->path, req->dest_path);
+        badgelink_StatusCode code = copy_file_alloc(req->path, req->dest_path);
         if (code != badgelink_StatusCode_StatusOk) {
             badgelink_send_status(code);
             return;
@@ -5,15 +5,31 @@
 #pragma once
 
 #include "badgelink_internal.h"
+#include "stdio.h"
+
+// Without CONFIG_BADGELINK_FS, FS requests are unsupported.
+#ifdef CONFIG_BADGELINK_FS
 
 // Handle a FS request packet.
 void badgelink_fs_handle();
 // Handle a FS upload (host->badge) transfer.
-void badgelink_fs_xfer_upload();
+// Hands the chunk to the storage worker but does not respond; the caller acknowledges it.
+badgelink_StatusCode badgelink_fs_xfer_upload();
 // Handle a FS download (badge->host) transfer.
-void badgelink_fs_xfer_download();
+// Prepares the chunk response with data from the storage worker but does not send it.
+badgelink_StatusCode badgelink_fs_xfer_download();
 // Finish a FS transfer.
 void badgelink_fs_xfer_stop(bool abnormal);
+// Close the directory kept open for a FS list cursor, if any.
+void badgelink_fs_release_cursor();
+// Close the directory kept open for a FS list cursor if transport `t` was handed it.
+void badgelink_fs_release_cursor_of(badgelink_transport_t* t);
+// Forget all remembered CRC32s, freeing their memory.
+void badgelink_fs_forget_crcs();
+// Open a file the way transfers do, with a fast stdio buffer if it is on the SD card.
+FILE* badgelink_fs_fopen(char const* path, char const* mode);
+// Close a file opened with `badgelink_fs_fopen`.
+void  badgelink_fs_fclose(FILE* fd);
 
 // Handle a FS list request.
 void badgelink_fs_list();
@@ -27,13 +43,37 @@ void badgelink_fs_upload();
 void badgelink_fs_download();
 // Handle a FS stat request.
 void badgelink_fs_stat();
+// Handle a request to stat many paths at once.
+void badgelink_fs_stat_many();
 // Handle a FS crc32 request.
 void badgelink_fs_crc32();
 // Handle a FS usage statistics request.
 void badgelink_fs_usage();
 // Handle a FS rmdir request.
 void badgelink_fs_rmdir();
+// Handle a recursive FS rmdir request.
+void badgelink_fs_rmdir_recursive();
 // Handle a FS copy request.
 void badgelink_fs_copy();
+// Handle a recursive FS copy request.
+void badgelink_fs_copy_recursive();
 // Handle a FS rename request.
 void badgelink_fs_rename();
+// Handle a FS sector CRC32s request.
+void badgelink_fs_sector_crc32();
+// Handle a FS tree upload request.
+void badgelink_fs_tree_upload();
+
+#else
+
+static inline void badgelink_fs_release_cursor() {
+}
+
+static inline void badgelink_fs_release_cursor_of(badgelink_transport_t* t) {
+    (void)t;
+}
+
+static inline void badgelink_fs_forget_crcs() {
+}
+
+#endif
@@ -0,0 +1,97 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_histogram.h"
+#include "badgelink_stats.h"
+#include "string.h"
+
+// Number of buckets of each histogram.
+#define BUCKETS       (sizeof(((badgelink_Histogram*)0)->buckets) / sizeof(uint32_t))
+// Number of histograms that fit in one page.
+#define PER_PAGE      (sizeof(((badgelink_Histograms*)0)->histograms) / sizeof(badgelink_Histogram))
+// Number of request types that get their own histogram; `which_req` of later ones is counted as the last.
+#define REQUEST_TYPES 16
+// Number of histograms: one for each stage and one for each type of request.
+#define HISTOGRAMS    (_badgelink_HistogramStage_ARRAYSIZE + REQUEST_TYPES)
+
+// A histogram as it is kept between requests.
+typedef struct {
+    uint64_t total_us;
+    uint32_t buckets[BUCKETS];
+} histogram_t;
+
+// The stages come first, in the order of `badgelink_HistogramStage`, followed by the request types.
+static histogram_t histograms[HISTOGRAMS];
+// Time the histograms were last reset.
+static int64_t     reset_time;
+
+// Count `us` microseconds in histogram `h`.
+static void count(histogram_t* h, uint64_t us) {
+    size_t bucket = us ? 64 - __builtin_clzll(us) : 0;
+    h->buckets[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+    h->total_us += us;
+}
+
+// Count a time of `us` microseconds spent in `stage`; `which_req` is the type of request for `StageHandle`.
+void badgelink_histogram_record(badgelink_HistogramStage stage, pb_size_t which_req, uint64_t us) {
+    count(&histograms[stage], us);
+    // Packets other than requests have a `which_req` of 0 and are only counted for the stage.
+    if (stage == badgelink_HistogramStage_StageHandle && which_req) {
+        size_t index = which_req < REQUEST_TYPES ? which_req : REQUEST_TYPES - 1;
+        count(&histograms[_badgelink_HistogramStage_ARRAYSIZE + index], us);
+    }
+}
+
+// Whether histogram `h` counted anything.
+static bool is_empty(histogram_t const* h) {
+    for (size_t i = 0; i < BUCKETS; i++) {
+        if (h->buckets[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Handle a histogram request.
+void badgelink_histogram_handle() {
+    badgelink_HistogramReq* req    = &badgelink_packet->packet.request.req.histogram_req;
+    uint32_t                offset = req->offset;
+    bool                    reset  = req->reset;
+
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_histograms_tag;
+    badgelink_Histograms* resp                    = &badgelink_packet->packet.response.resp.histograms;
+    resp->period_ms                               = badgelink_stats_since(reset_time) / 1000;
+    resp->histograms_count                        = 0;
+    resp->next                                    = 0;
+
+    // Empty histograms are skipped, so a page usually holds all of them.
+    for (uint32_t i = offset; i < HISTOGRAMS; i++) {
+        if (is_empty(&histograms[i])) {
+            continue;
+        }
+        if (resp->histograms_count == PER_PAGE) {
+            resp->next = i;
+            break;
+        }
+        badgelink_Histogram* out = &resp->histograms[resp->histograms_count++];
+        if (i < _badgelink_HistogramStage_ARRAYSIZE) {
+            out->stage     = i;
+            out->which_req = 0;
+        } else {
+            out->stage     = badgelink_HistogramStage_StageHandle;
+            out->which_req = i - _badgelink_HistogramStage_ARRAYSIZE;
+        }
+        out->total_us      = histograms[i].total_us;
+        out->buckets_count = BUCKETS;
+        memcpy(out->buckets, histograms[i].buckets, sizeof(out->buckets));
+    }
+
+    // Reset after the last page, so the response itself is counted in the next period.
+    if (reset && resp->next == 0) {
+        memset(histograms, 0, sizeof(histograms));
+        reset_time = badgelink_stats_now();
+    }
+    badgelink_send_packet();
+}
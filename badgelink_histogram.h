@@ -0,0 +1,27 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+
+// Latency histograms of each stage and of handling each type of request, with log2 buckets of microseconds.
+// Unlike the totals in `badgelink_stats`, they show whether a stage is slow every time or only now and then.
+// Without CONFIG_BADGELINK_HISTOGRAMS, recording compiles to nothing and histogram requests are unsupported.
+#ifdef CONFIG_BADGELINK_HISTOGRAMS
+
+// Count a time of `us` microseconds spent in `stage`; `which_req` is the type of request for `StageHandle`.
+// Like the stats counters, the histograms are updated without locking.
+void badgelink_histogram_record(badgelink_HistogramStage stage, pb_size_t which_req, uint64_t us);
+// Handle a histogram request.
+void badgelink_histogram_handle();
+
+#else
+
+static inline void badgelink_histogram_record(badgelink_HistogramStage stage, pb_size_t which_req, uint64_t us) {
+    (void)stage;
+    (void)which_req;
+    (void)us;
+}
+
+#endif
@@ -16,29 +16,147 @@ typedef enum {
     BADGELINK_XFER_APPFS,
     // Internal filesystem file transfer.
     BADGELINK_XFER_FS,
+    // NVS snapshot transfer.
+    BADGELINK_XFER_NVS,
 } badgelink_xfer_t;
 
+// Outside of ESP-IDF, like in the mock badge, there is no sdkconfig and every type of request is built.
+#ifndef ESP_PLATFORM
+#define CONFIG_BADGELINK_FS           1
+#define CONFIG_BADGELINK_APPFS        1
+#define CONFIG_BADGELINK_NVS          1
+#define CONFIG_BADGELINK_STARTAPP     1
+#define CONFIG_BADGELINK_BENCH        1
+#define CONFIG_BADGELINK_TRACE        1
+#define CONFIG_BADGELINK_TRACE_EVENTS 1024
+#define CONFIG_BADGELINK_HISTOGRAMS   1
+#endif
+
+#define BADGELINK_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// Default task priorities if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_TASK_PRIORITY
+#define CONFIG_BADGELINK_TASK_PRIORITY 0
+#endif
+#ifndef CONFIG_BADGELINK_TASK_BOOST_PRIORITY
+#define CONFIG_BADGELINK_TASK_BOOST_PRIORITY 0
+#endif
+// Priority of the BadgeLink tasks while a transfer is in progress.
+#define BADGELINK_XFER_TASK_PRIORITY BADGELINK_MAX(CONFIG_BADGELINK_TASK_PRIORITY, CONFIG_BADGELINK_TASK_BOOST_PRIORITY)
+
+// Largest fixed-size message of each type of request that is built, or 0 if it isn't.
+// An AppFS list response has up to 15 bytes of other fields and nesting around its list.
+#ifdef CONFIG_BADGELINK_FS
+#define BADGELINK_FS_MSG_MAX_SIZE badgelink_FsActionReq_size
+#else
+#define BADGELINK_FS_MSG_MAX_SIZE 0
+#endif
+#ifdef CONFIG_BADGELINK_APPFS
+#define BADGELINK_APPFS_MSG_MAX_SIZE (badgelink_AppfsList_size + 15)
+#else
+#define BADGELINK_APPFS_MSG_MAX_SIZE 0
+#endif
+#ifdef CONFIG_BADGELINK_TRACE
+#define BADGELINK_TRACE_MSG_MAX_SIZE badgelink_TraceDump_size
+#else
+#define BADGELINK_TRACE_MSG_MAX_SIZE 0
+#endif
+#ifdef CONFIG_BADGELINK_HISTOGRAMS
+#define BADGELINK_HISTOGRAM_MSG_MAX_SIZE badgelink_Histograms_size
+#else
+#define BADGELINK_HISTOGRAM_MSG_MAX_SIZE 0
+#endif
+
+// Largest fixed-size message that can be sent or received, so that the frame buffers shrink along with the
+// requests that are built. The bench request, with its path, is larger than any of the requests that are always built.
+#define BADGELINK_MSG_MAX_SIZE                                                                                         \
+    BADGELINK_MAX(BADGELINK_MAX(BADGELINK_FS_MSG_MAX_SIZE, BADGELINK_APPFS_MSG_MAX_SIZE),                            \
+                  BADGELINK_MAX(BADGELINK_MAX(BADGELINK_TRACE_MSG_MAX_SIZE, BADGELINK_HISTOGRAM_MSG_MAX_SIZE),       \
+                                badgelink_BenchReq_size))
+
+// If this fails, a message was made larger than the FS request and should be added to `BADGELINK_MSG_MAX_SIZE`.
+_Static_assert(BADGELINK_BADGELINK_PB_H_MAX_SIZE == badgelink_FsActionReq_size, "Largest message changed");
+
+// Maximum encoded size of a packet.
+// nanopb cannot compute this because chunk data, NVS values and listings are callback fields, so it's derived from
+// the largest messages: an up to 11-byte serial and then up to 3 bytes of tag and length for each level of nesting
+// around either the largest fixed-size message or up to `BADGELINK_CHUNK_DATA_MAX` bytes of callback data with at most
+// 56 bytes of other fields (which is what an NVS write needs for its namespace, key and value type), plus the up to
+// 6-byte session ID of the request or response.
+#define BADGELINK_PACKET_MAX_SIZE                                                                                      \
+    (11 + 3 + 2 + 3 + 6 + BADGELINK_MAX(BADGELINK_MSG_MAX_SIZE, BADGELINK_CHUNK_DATA_MAX + 56))
+
 // Capacity for the transmit/receive buffer.
-#define BADGELINK_BUF_CAP COBS_ENCODED_MAX_LENGTH(badgelink_Packet_size + 4)
+#define BADGELINK_BUF_CAP COBS_ENCODED_MAX_LENGTH(BADGELINK_PACKET_MAX_SIZE + 4)
+
+// Number of transfers that can be in progress at once; one of each kind.
+// The modules keep the open file of their transfer to themselves, so two transfers of the same kind can't overlap.
+#define BADGELINK_XFER_SLOTS 3
+// Index of the slot in `badgelink_xfers` for transfers of type `type`.
+#define BADGELINK_XFER_SLOT(type) ((type) - BADGELINK_XFER_APPFS)
+
+// State of a file transfer.
+typedef struct {
+    // What the transfer is for, or `BADGELINK_XFER_NONE` if the slot is free.
+    badgelink_xfer_t       type;
+    // Nonzero ID the host uses to tell the transfers apart.
+    uint32_t               session;
+    // Whether the transfer is host->badge.
+    bool                   is_upload;
+    // Current transfer position.
+    uint32_t               pos;
+    // Position the transfer started at, which is only nonzero for a download of a range.
+    uint32_t               start;
+    // Transfer file size, or where the range ends for a download of a range.
+    uint32_t               size;
+    // Alignment upload chunks may skip ahead to, leaving the data in between as it is, or 0 if they can't.
+    uint32_t               skip_align;
+    // Number of download chunks the host has granted but not yet received.
+    uint32_t               credits;
+    // Transport the transfer was started over, which is the only one that can continue it.
+    badgelink_transport_t* transport;
+    // Protocol version of `transport` when the transfer started, for the storage worker, which can't look at it.
+    uint16_t               version;
+} badgelink_xfer_state_t;
 
 // Badgelink packet singleton used for both the request and its response.
-extern badgelink_Packet badgelink_packet;
-// What the current file transfer is for.
-extern badgelink_xfer_t badgelink_xfer_type;
-// Whether the current file transfer is host->badge.
-extern bool             badgelink_xfer_is_upload;
-// Current transfer position.
-extern uint32_t         badgelink_xfer_pos;
-// Transfer file size.
-extern uint32_t         badgelink_xfer_size;
+extern badgelink_Packet*       badgelink_packet;
+// Transfers that are in progress, indexed by `BADGELINK_XFER_SLOT`.
+extern badgelink_xfer_state_t  badgelink_xfers[BADGELINK_XFER_SLOTS];
+// Transfer the current request is for, or NULL if it isn't for one.
+extern badgelink_xfer_state_t* badgelink_xfer;
+// Maximum size of chunk data sent to the host, as negotiated with the version request.
+extern uint32_t                badgelink_chunk_size;
+
+// Whether a transfer of type `type` is in progress.
+static inline bool badgelink_xfer_busy(badgelink_xfer_t type) {
+    return badgelink_xfers[BADGELINK_XFER_SLOT(type)].type != BADGELINK_XFER_NONE;
+}
+
+// Set up a new transfer of type `type` and make it the one the current request is for.
+// The start of the transfer is reported to the host with its session ID.
+badgelink_xfer_state_t* badgelink_xfer_begin(badgelink_xfer_t type, bool is_upload, uint32_t size);
+// Check the range a download request asks for and work out where it ends in a `size`-byte file.
+// A `length` of 0 is up to the end of the file; returns the status to refuse the request with if the range is invalid.
+badgelink_StatusCode    badgelink_download_range(uint32_t offset, uint32_t length, uint32_t size, uint32_t* end);
 
 // Send raw bytes of data.
 void   badgelink_raw_tx(void const* buf, size_t len);
 // Receive raw bytes of data.
 size_t badgelink_raw_rx(void* buf, size_t max_len);
 
-// Encode and send a packet.
-void badgelink_send_packet();
+// Encode and queue a packet for sending.
+// Returns false if the packet could not be encoded, which for a chunk means the data could not be read.
+bool badgelink_send_packet();
+// Get the transport of the request being handled, which owns what the request leaves behind for the next one.
+badgelink_transport_t* badgelink_request_transport();
+// Wait until all frames queued for transmission have been sent.
+void badgelink_tx_flush();
+// Wait until all frames queued for transmission have been sent and have left the device over the current transport.
+// Returns false if the transport can't tell, or they didn't leave within `timeout_ms` milliseconds.
+bool badgelink_tx_drain(uint32_t timeout_ms);
+// Encode or decode a `badgelink_chunk_data_t` field; used by the name-bound callbacks of messages that have one.
+bool badgelink_data_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field);
 // Send a status response packet.
 void badgelink_send_status(badgelink_StatusCode code);
 
@@ -0,0 +1,61 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_journal.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "string.h"
+
+static char const TAG[] = "badgelink_journal";
+
+// NVS namespace the journals are kept in.
+#define JOURNAL_NAMESPACE "badgelink"
+
+// NVS key of the journal of uploads of type `type`.
+static char const* journal_key(badgelink_xfer_t type) {
+    return type == BADGELINK_XFER_APPFS ? "resume_appfs" : "resume_fs";
+}
+
+// Remember the progress of an upload of type `type` that was cut off.
+void badgelink_journal_save(badgelink_xfer_t type, badgelink_journal_t const* journal) {
+    nvs_handle_t handle;
+    esp_err_t    ec = nvs_open(JOURNAL_NAMESPACE, NVS_READWRITE, &handle);
+    if (ec == ESP_OK) {
+        ec = nvs_set_blob(handle, journal_key(type), (void*)journal, sizeof(*journal));
+        if (ec == ESP_OK) {
+            ec = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ec != ESP_OK) {
+        // The upload can still be started over, so this isn't worth failing anything for.
+        ESP_LOGW(TAG, "Cannot save upload progress: %s", esp_err_to_name(ec));
+    }
+}
+
+// Find the progress of an upload of type `type` of `name` that was cut off, which must be the same size and CRC32.
+bool badgelink_journal_find(
+    badgelink_xfer_t type, char const* name, uint32_t size, uint32_t crc32, badgelink_journal_t* journal
+) {
+    nvs_handle_t handle;
+    if (nvs_open(JOURNAL_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t    len = sizeof(*journal);
+    esp_err_t ec  = nvs_get_blob(handle, journal_key(type), journal, &len);
+    nvs_close(handle);
+    return ec == ESP_OK && len == sizeof(*journal) && !strncmp(journal->name, name, sizeof(journal->name)) &&
+           journal->size == size && journal->crc32 == crc32 && journal->pos <= size;
+}
+
+// Forget the progress of an upload of type `type`, because it finished or a different one started.
+void badgelink_journal_clear(badgelink_xfer_t type) {
+    nvs_handle_t handle;
+    if (nvs_open(JOURNAL_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_erase_key(handle, journal_key(type)) == ESP_OK) {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
@@ -0,0 +1,31 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+
+// Progress of a resumable upload that was cut off, kept in NVS so the host can continue it later.
+// There is one journal for each kind of transfer, like there is one transfer of each kind at a time.
+typedef struct {
+    // Path or slug of the file being uploaded.
+    char     name[256];
+    // Size and CRC32 of the whole file, which the upload that continues it must ask for as well.
+    uint32_t size;
+    uint32_t crc32;
+    // How much of the file was written, and the CRC32 of that part.
+    uint32_t pos;
+    uint32_t running_crc;
+    // How much of the file was erased; only used for AppFS.
+    uint32_t erased;
+} badgelink_journal_t;
+
+// Remember the progress of an upload of type `type` that was cut off.
+void badgelink_journal_save(badgelink_xfer_t type, badgelink_journal_t const* journal);
+// Find the progress of an upload of type `type` of `name` that was cut off, which must be the same size and CRC32.
+// Returns false if there is none.
+bool badgelink_journal_find(
+    badgelink_xfer_t type, char const* name, uint32_t size, uint32_t crc32, badgelink_journal_t* journal
+);
+// Forget the progress of an upload of type `type`, because it finished or a different one started.
+void badgelink_journal_clear(badgelink_xfer_t type);
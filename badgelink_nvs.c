@@ -3,14 +3,26 @@
 // SPDX-License-Identifier: MIT
 
 #include "badgelink_nvs.h"
+#include "esp_crc.h"
 #include "esp_log.h"
 #include "nvs.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+#include "stdlib.h"
+#include "string.h"
 
 static char const TAG[] = "badgelink_nvs";
 
 // Handle an NVS request packet.
 void badgelink_nvs_handle() {
-    switch (badgelink_packet.packet.request.req.nvs_action.type) {
+    // A listing kept for a cursor can't continue past changes to NVS.
+    badgelink_NvsActionType type = badgelink_packet->packet.request.req.nvs_action.type;
+    if (type != badgelink_NvsActionType_NvsActionList && type != badgelink_NvsActionType_NvsActionRead &&
+        type != badgelink_NvsActionType_NvsActionExport) {
+        badgelink_nvs_release_cursor();
+    }
+
+    switch (type) {
         case badgelink_NvsActionType_NvsActionList:
             badgelink_nvs_list();
             break;
@@ -23,167 +35,311 @@ void badgelink_nvs_handle() {
         case badgelink_NvsActionType_NvsActionDelete:
             badgelink_nvs_delete();
             break;
+        case badgelink_NvsActionType_NvsActionBatch:
+            badgelink_nvs_batch();
+            break;
+        case badgelink_NvsActionType_NvsActionExport:
+            badgelink_nvs_export();
+            break;
+        case badgelink_NvsActionType_NvsActionImport:
+            badgelink_nvs_import();
+            break;
         default:
             badgelink_status_unsupported();
             break;
     }
 }
 
+// Encode or decode the string or blob of an NVS value without copying it into the packet.
+bool badgelink_NvsValue_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_NvsValue_stringval_tag && field->tag != badgelink_NvsValue_blobval_tag) {
+        return true;
+    }
+    return badgelink_data_callback(istream, ostream, field);
+}
+
+// Encode the entries that `badgelink_nvs_list` packed into the arena as `type, namespc, 0, key, 0` records.
+bool badgelink_NvsEntriesList_callback(pb_istream_t* istream, pb_ostream_t* ostream, pb_field_t const* field) {
+    if (field->tag != badgelink_NvsEntriesList_entries_tag) {
+        return true;
+    }
+    if (istream) {
+        // Listings are only ever sent by the badge.
+        return pb_read(istream, NULL, istream->bytes_left);
+    }
+
+    badgelink_list_arena_t const* list = field->pData;
+    size_t                        pos  = 0;
+    while (pos < list->len) {
+        badgelink_NvsEntry ent = badgelink_NvsEntry_init_zero;
+        ent.type               = list->arena[pos++];
+        strlcpy(ent.namespc, (char const*)list->arena + pos, sizeof(ent.namespc));
+        pos += strlen(ent.namespc) + 1;
+        strlcpy(ent.key, (char const*)list->arena + pos, sizeof(ent.key));
+        pos += strlen(ent.key) + 1;
+        if (!pb_encode_tag_for_field(ostream, field) ||
+            !pb_encode_submessage(ostream, badgelink_NvsEntry_fields, &ent)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Listing kept between pages for a client that uses cursors, so the next page continues where the last one ended.
+static nvs_iterator_t list_iter;
+// Whether `list_iter` holds a listing.
+static bool           list_open;
+// Cursor the client sends back to continue with `list_iter`, or 0 if there is none.
+static uint32_t       list_cursor;
+// Last cursor handed out.
+static uint32_t       last_cursor;
+// Index of the entry `list_iter` is at.
+static uint32_t       list_pos;
+// Total number of entries, if counted when the listing started.
+static uint32_t       list_total;
+// Namespace being listed, or empty for all of them.
+static char           list_namespc[17];
+
+// Transport that was handed `list_cursor`, which is the only one that can continue the listing.
+static badgelink_transport_t* list_owner;
+
+// Release the listing kept for a cursor, if any.
+void badgelink_nvs_release_cursor() {
+    if (list_open) {
+        nvs_release_iterator(list_iter);
+        list_open = false;
+    }
+    list_cursor = 0;
+}
+
+// Release the listing kept for a cursor if transport `t` was handed it.
+void badgelink_nvs_release_cursor_of(badgelink_transport_t* t) {
+    if (list_owner == t) {
+        badgelink_nvs_release_cursor();
+    }
+}
+
+// Count the entries in a namespace, or in all of them if `namespc` is NULL.
+static esp_err_t count_entries(char const* namespc, uint32_t* count) {
+    nvs_iterator_t iter;
+    *count       = 0;
+    esp_err_t ec = nvs_entry_find(NVS_DEFAULT_PART_NAME, namespc, NVS_TYPE_ANY, &iter);
+    while (ec == ESP_OK) {
+        (*count)++;
+        ec = nvs_entry_next(&iter);
+    }
+    nvs_release_iterator(iter);
+    return ec == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : ec;
+}
+
+// Translate an NVS entry type.
+static bool entry_type(nvs_type_t nvs_type, badgelink_NvsValueType* type) {
+    switch (nvs_type) {
+        case NVS_TYPE_U8:
+            *type = badgelink_NvsValueType_NvsValueUint8;
+            return true;
+        case NVS_TYPE_I8:
+            *type = badgelink_NvsValueType_NvsValueInt8;
+            return true;
+        case NVS_TYPE_U16:
+            *type = badgelink_NvsValueType_NvsValueUint16;
+            return true;
+        case NVS_TYPE_I16:
+            *type = badgelink_NvsValueType_NvsValueInt16;
+            return true;
+        case NVS_TYPE_U32:
+            *type = badgelink_NvsValueType_NvsValueUint32;
+            return true;
+        case NVS_TYPE_I32:
+            *type = badgelink_NvsValueType_NvsValueInt32;
+            return true;
+        case NVS_TYPE_U64:
+            *type = badgelink_NvsValueType_NvsValueUint64;
+            return true;
+        case NVS_TYPE_I64:
+            *type = badgelink_NvsValueType_NvsValueInt64;
+            return true;
+        case NVS_TYPE_STR:
+            *type = badgelink_NvsValueType_NvsValueString;
+            return true;
+        case NVS_TYPE_BLOB:
+            *type = badgelink_NvsValueType_NvsValueBlob;
+            return true;
+        default:
+            return false;
+    }
+}
+
 // Handle an NVS list request.
 void badgelink_nvs_list() {
     // Validate request.
-    badgelink_NvsActionReq* req = &badgelink_packet.packet.request.req.nvs_action;
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
     if (req->has_wdata || req->key[0]) {
         badgelink_status_malformed();
         return;
     }
 
-    // Try to open NVS.
-    uint32_t       offset = req->list_offset;
+    // Without a cursor, every page walks the whole listing to count the entries, like it always has.
+    // With one, the entries are counted once when the listing starts, if at all, and the next page continues here.
+    bool           use_cursor = req->use_cursor;
+    uint32_t       total      = 0;
+    uint32_t       pos        = 0;
+    bool           end        = false;
     nvs_iterator_t iter;
-    esp_err_t ec = nvs_entry_find(NVS_DEFAULT_PART_NAME, req->namespc[0] ? req->namespc : NULL, NVS_TYPE_ANY, &iter);
-    if (ec == ESP_ERR_NVS_NOT_FOUND) {
-        badgelink_status_ok();
-        return;
-    } else if (ec != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_entry_find error: %s", esp_err_to_name(ec));
-        badgelink_status_int_err();
-        return;
-    }
+    esp_err_t      ec;
+    if (use_cursor && req->cursor && req->cursor == list_cursor && req->list_offset == list_pos &&
+        !strcmp(req->namespc, list_namespc) && list_owner == badgelink_request_transport()) {
+        iter        = list_iter;
+        pos         = list_pos;
+        total       = list_total;
+        list_open   = false;
+        list_cursor = 0;
 
-    // Format response.
-    badgelink_packet.which_packet                            = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code             = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp              = badgelink_Response_nvs_resp_tag;
-    badgelink_packet.packet.response.resp.nvs_resp.which_val = badgelink_NvsActionResp_entries_tag;
-    badgelink_NvsEntriesList* entries     = &badgelink_packet.packet.response.resp.nvs_resp.val.entries;
-    size_t const              max_entries = sizeof(entries->entries) / sizeof(badgelink_NvsEntry);
-    entries->entries_count                = 0;
-
-    // Skip until the desired offset.
-    while (offset) {
-        ec = nvs_entry_next(&iter);
+    } else {
+        badgelink_nvs_release_cursor();
+        char const* namespc = req->namespc[0] ? req->namespc : NULL;
+        if (use_cursor && !req->skip_total) {
+            ec = count_entries(namespc, &total);
+            if (ec != ESP_OK) {
+                ESP_LOGE(TAG, "nvs_entry_find error: %s", esp_err_to_name(ec));
+                badgelink_status_int_err();
+                return;
+            }
+        }
+
+        // Try to open NVS.
+        ec = nvs_entry_find(NVS_DEFAULT_PART_NAME, namespc, NVS_TYPE_ANY, &iter);
         if (ec == ESP_ERR_NVS_NOT_FOUND) {
-            break;
+            badgelink_status_ok();
+            return;
         } else if (ec != ESP_OK) {
-            ESP_LOGE(TAG, "nvs_entry_next error: %s", esp_err_to_name(ec));
-            nvs_release_iterator(iter);
+            ESP_LOGE(TAG, "nvs_entry_find error: %s", esp_err_to_name(ec));
             badgelink_status_int_err();
             return;
         }
-        entries->entries_count++;
-        offset--;
-    }
+        strlcpy(list_namespc, req->namespc, sizeof(list_namespc));
 
-    // Read entries from NVS.
-    while (1) {
-        if (entries->entries_count < max_entries) {
-            nvs_entry_info_t info;
-            ec = nvs_entry_info(iter, &info);
-            if (ec != ESP_OK) {
-                ESP_LOGE(TAG, "nvs_entry_info error: %s", esp_err_to_name(ec));
+        // Skip until the desired offset.
+        while (pos < req->list_offset) {
+            pos++;
+            ec = nvs_entry_next(&iter);
+            if (ec == ESP_ERR_NVS_NOT_FOUND) {
+                end = true;
+                break;
+            } else if (ec != ESP_OK) {
+                ESP_LOGE(TAG, "nvs_entry_next error: %s", esp_err_to_name(ec));
                 nvs_release_iterator(iter);
                 badgelink_status_int_err();
                 return;
             }
+        }
+    }
+
+    // The entries are only stored for as long as it takes to send them.
+    pb_byte_t* arena = malloc(badgelink_chunk_size);
+    if (!arena) {
+        ESP_LOGE(TAG, "Out of memory");
+        nvs_release_iterator(iter);
+        badgelink_status_int_err();
+        return;
+    }
+
+    // Format response.
+    badgelink_packet->which_packet                            = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code             = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp              = badgelink_Response_nvs_resp_tag;
+    badgelink_packet->packet.response.resp.nvs_resp.which_val = badgelink_NvsActionResp_entries_tag;
+    badgelink_NvsEntriesList* entries = &badgelink_packet->packet.response.resp.nvs_resp.val.entries;
+    entries->entries.arena            = arena;
+    entries->entries.len              = 0;
+    entries->total_entries            = 0;
+    entries->cursor                   = 0;
+    size_t encoded                    = 0;
+    bool   full                       = false;
+
+    // Read entries from NVS.
+    while (!end) {
+        nvs_entry_info_t info;
+        ec = nvs_entry_info(iter, &info);
+        if (ec != ESP_OK) {
+            ESP_LOGE(TAG, "nvs_entry_info error: %s", esp_err_to_name(ec));
+            nvs_release_iterator(iter);
+            free(arena);
+            badgelink_status_int_err();
+            return;
+        }
 
-            // Translate NVS entry type.
+        // An encoded entry takes at most 8 bytes more than its namespace and key.
+        size_t ns_len  = strnlen(info.namespace_name, NVS_NS_NAME_MAX_SIZE - 1);
+        size_t key_len = strnlen(info.key, NVS_KEY_NAME_MAX_SIZE - 1);
+        if (!full && encoded + ns_len + key_len + 8 <= badgelink_chunk_size) {
             badgelink_NvsValueType type;
-            switch (info.type) {
-                case NVS_TYPE_U8:
-                    type = badgelink_NvsValueType_NvsValueUint8;
-                    break;
-                case NVS_TYPE_I8:
-                    type = badgelink_NvsValueType_NvsValueInt8;
-                    break;
-                case NVS_TYPE_U16:
-                    type = badgelink_NvsValueType_NvsValueUint16;
-                    break;
-                case NVS_TYPE_I16:
-                    type = badgelink_NvsValueType_NvsValueInt16;
-                    break;
-                case NVS_TYPE_U32:
-                    type = badgelink_NvsValueType_NvsValueUint32;
-                    break;
-                case NVS_TYPE_I32:
-                    type = badgelink_NvsValueType_NvsValueInt32;
-                    break;
-                case NVS_TYPE_U64:
-                    type = badgelink_NvsValueType_NvsValueUint64;
-                    break;
-                case NVS_TYPE_I64:
-                    type = badgelink_NvsValueType_NvsValueInt64;
-                    break;
-                case NVS_TYPE_STR:
-                    type = badgelink_NvsValueType_NvsValueString;
-                    break;
-                case NVS_TYPE_BLOB:
-                    type = badgelink_NvsValueType_NvsValueBlob;
-                    break;
-                default:
-                    nvs_release_iterator(iter);
-                    badgelink_status_int_err();
-                    return;
+            if (!entry_type(info.type, &type)) {
+                nvs_release_iterator(iter);
+                free(arena);
+                badgelink_status_int_err();
+                return;
             }
 
-            // Copy the other fields.
-            entries->entries[entries->entries_count].type = type;
-            memcpy(entries->entries[entries->entries_count].namespc, info.namespace_name, NVS_NS_NAME_MAX_SIZE);
-            memcpy(entries->entries[entries->entries_count].key, info.key, NVS_KEY_NAME_MAX_SIZE);
+            // Pack the entry as `type, namespc, 0, key, 0`.
+            pb_byte_t* rec = arena + entries->entries.len;
+            rec[0]         = type;
+            memcpy(rec + 1, info.namespace_name, ns_len);
+            rec[1 + ns_len] = 0;
+            memcpy(rec + 2 + ns_len, info.key, key_len);
+            rec[2 + ns_len + key_len] = 0;
+            entries->entries.len     += 3 + ns_len + key_len;
+            encoded                  += 8 + ns_len + key_len;
+        } else if (use_cursor) {
+            // Keep the listing at the entry that didn't fit for the next page.
+            break;
+        } else {
+            // Later entries must not be sent either, or the client would miss the one that did not fit.
+            full = true;
         }
 
         // Count total entries.
-        entries->entries_count++;
+        pos++;
 
         ec = nvs_entry_next(&iter);
         if (ec == ESP_ERR_NVS_NOT_FOUND) {
-            break;
+            end = true;
         } else if (ec != ESP_OK) {
             ESP_LOGE(TAG, "nvs_entry_next error: %s", esp_err_to_name(ec));
             nvs_release_iterator(iter);
+            free(arena);
             badgelink_status_int_err();
             return;
         }
     }
 
+    if (end) {
+        nvs_release_iterator(iter);
+    } else {
+        // Cursors are never 0, which means there are no more entries.
+        list_iter   = iter;
+        list_open   = true;
+        list_pos    = pos;
+        list_total  = total;
+        list_cursor = ++last_cursor ? last_cursor : ++last_cursor;
+        list_owner  = badgelink_request_transport();
+        entries->cursor = list_cursor;
+    }
+    entries->total_entries = use_cursor ? total : pos;
+
     // Send the response.
     badgelink_send_packet();
+    free(arena);
 }
 
-// Handle an NVS read request.
-void badgelink_nvs_read() {
-    // Validate request.
-    badgelink_NvsActionReq* req = &badgelink_packet.packet.request.req.nvs_action;
-    if (req->has_wdata || !req->key[0] || !req->namespc[0]) {
-        badgelink_status_malformed();
-    }
-
-    // Try to open NVS.
-    nvs_handle_t handle;
-    esp_err_t    ec = nvs_open(req->namespc, NVS_READONLY, &handle);
-    if (ec == ESP_ERR_NVS_NOT_FOUND) {
-        badgelink_status_not_found();
-        return;
-    } else if (ec != ESP_OK) {
-        ESP_LOGE(TAG, "Read error: %s", esp_err_to_name(ec));
-        badgelink_status_int_err();
-        return;
-    }
-
-    // Copy key out of request.
-    badgelink_NvsValueType nvs_type                   = req->read_type;
-    char                   key[NVS_KEY_NAME_MAX_SIZE] = {0};
-    strlcpy(key, req->key, sizeof(key));
-
-    // Format response.
-    badgelink_packet.which_packet                            = badgelink_Packet_response_tag;
-    badgelink_packet.packet.response.status_code             = badgelink_StatusCode_StatusOk;
-    badgelink_packet.packet.response.which_resp              = badgelink_Response_nvs_resp_tag;
-    badgelink_packet.packet.response.resp.nvs_resp.which_val = badgelink_NvsActionResp_rdata_tag;
-
-    // Try to read from NVS.
-    badgelink_NvsValue* rdata = &badgelink_packet.packet.response.resp.nvs_resp.val.rdata;
-    rdata->type               = nvs_type;
+// Read a value from NVS into `rdata`.
+// String and blob values are read into a buffer of their exact size, returned in `value`, which the caller frees once
+// they have been sent; values longer than `max_len` bytes are not read and give `ESP_ERR_NO_MEM`.
+static esp_err_t read_value(nvs_handle_t handle, char const* key, badgelink_NvsValueType nvs_type, size_t max_len,
+                            badgelink_NvsValue* rdata, pb_byte_t** value) {
+    esp_err_t ec;
+    *value      = NULL;
+    rdata->type = nvs_type;
     switch (nvs_type) {
         case badgelink_NvsValueType_NvsValueUint8: {
             uint8_t tmp;
@@ -234,33 +390,74 @@ void badgelink_nvs_read() {
             rdata->val.numericval = tmp;
         } break;
         case badgelink_NvsValueType_NvsValueString: {
+            // The length reported by NVS includes the terminator, which is not sent.
             rdata->which_val = badgelink_NvsValue_stringval_tag;
-            size_t len       = sizeof(rdata->val.stringval) - 1;
-            ec               = nvs_get_str(handle, key, rdata->val.stringval, &len);
-            if (ec == ESP_OK) {
-                if (len <= sizeof(rdata->val.stringval) - 1) {
-                    rdata->val.stringval[len] = 0;
-                } else {
-                    ec = ESP_ERR_NO_MEM;
-                }
+            size_t len       = 0;
+            ec               = nvs_get_str(handle, key, NULL, &len);
+            if (ec == ESP_OK && len - 1 > max_len) {
+                ec = ESP_ERR_NO_MEM;
+            } else if (ec == ESP_OK && !(*value = malloc(len))) {
+                ec = ESP_ERR_NO_MEM;
+            } else if (ec == ESP_OK) {
+                ec = nvs_get_str(handle, key, (char*)*value, &len);
             }
+            rdata->val.stringval = (badgelink_chunk_data_t){*value, len - 1, NULL};
         } break;
         case badgelink_NvsValueType_NvsValueBlob: {
             rdata->which_val = badgelink_NvsValue_blobval_tag;
-            size_t len       = sizeof(rdata->val.blobval.bytes);
-            ec               = nvs_get_blob(handle, key, rdata->val.blobval.bytes, &len);
-            if (ec == ESP_OK) {
-                if (len <= sizeof(rdata->val.blobval.bytes)) {
-                    rdata->val.blobval.size = len;
-                } else {
-                    ec = ESP_ERR_NO_MEM;
-                }
+            size_t len       = 0;
+            ec               = nvs_get_blob(handle, key, NULL, &len);
+            if (ec == ESP_OK && len > max_len) {
+                ec = ESP_ERR_NO_MEM;
+            } else if (ec == ESP_OK && !(*value = malloc(len ? len : 1))) {
+                ec = ESP_ERR_NO_MEM;
+            } else if (ec == ESP_OK) {
+                ec = nvs_get_blob(handle, key, *value, &len);
             }
+            rdata->val.blobval = (badgelink_chunk_data_t){*value, len, NULL};
         } break;
         default:
             ec = ESP_FAIL;
             break;
     }
+    return ec;
+}
+
+// Handle an NVS read request.
+void badgelink_nvs_read() {
+    // Validate request.
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
+    if (req->has_wdata || !req->key[0] || !req->namespc[0]) {
+        badgelink_status_malformed();
+    }
+
+    // Try to open NVS.
+    nvs_handle_t handle;
+    esp_err_t    ec = nvs_open(req->namespc, NVS_READONLY, &handle);
+    if (ec == ESP_ERR_NVS_NOT_FOUND) {
+        badgelink_status_not_found();
+        return;
+    } else if (ec != ESP_OK) {
+        ESP_LOGE(TAG, "Read error: %s", esp_err_to_name(ec));
+        badgelink_status_int_err();
+        return;
+    }
+
+    // Copy key out of request.
+    badgelink_NvsValueType nvs_type                   = req->read_type;
+    char                   key[NVS_KEY_NAME_MAX_SIZE] = {0};
+    strlcpy(key, req->key, sizeof(key));
+
+    // Format response.
+    badgelink_packet->which_packet                            = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code             = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp              = badgelink_Response_nvs_resp_tag;
+    badgelink_packet->packet.response.resp.nvs_resp.which_val = badgelink_NvsActionResp_rdata_tag;
+
+    // Try to read from NVS.
+    pb_byte_t* value;
+    ec = read_value(handle, key, nvs_type, BADGELINK_CHUNK_DATA_MAX,
+                    &badgelink_packet->packet.response.resp.nvs_resp.val.rdata, &value);
     nvs_close(handle);
 
     // Send response packet.
@@ -272,20 +469,12 @@ void badgelink_nvs_read() {
         ESP_LOGE(TAG, "Read error: %s", esp_err_to_name(ec));
         badgelink_status_int_err();
     }
+    free(value);
 }
 
-// Handle an NVS write request.
-void badgelink_nvs_write() {
-    // Validate request.
-    badgelink_NvsActionReq* req = &badgelink_packet.packet.request.req.nvs_action;
-    if (!req->has_wdata || !req->key[0] || !req->namespc[0]) {
-        ESP_LOGE(TAG, "Malformed NVS write: missing wdata, key or namespc");
-        badgelink_status_malformed();
-        return;
-    }
-
-    // Validate write data type.
-    switch (req->wdata.type) {
+// Check that the data of an NVS write matches its type.
+static bool check_wdata(badgelink_NvsValue const* wdata) {
+    switch (wdata->type) {
         case badgelink_NvsValueType_NvsValueUint8:
         case badgelink_NvsValueType_NvsValueInt8:
         case badgelink_NvsValueType_NvsValueUint16:
@@ -294,76 +483,87 @@ void badgelink_nvs_write() {
         case badgelink_NvsValueType_NvsValueInt32:
         case badgelink_NvsValueType_NvsValueUint64:
         case badgelink_NvsValueType_NvsValueInt64:
-            if (req->wdata.which_val != badgelink_NvsValue_numericval_tag) {
+            if (wdata->which_val != badgelink_NvsValue_numericval_tag) {
                 ESP_LOGE(TAG, "Malformed NVS write: Expected numericval");
-                badgelink_status_malformed();
-                return;
+                return false;
             }
-            break;
+            return true;
         case badgelink_NvsValueType_NvsValueString:
-            if (req->wdata.which_val != badgelink_NvsValue_stringval_tag) {
+            if (wdata->which_val != badgelink_NvsValue_stringval_tag) {
                 ESP_LOGE(TAG, "Malformed NVS write: Expected stringval");
-                badgelink_status_malformed();
-                return;
+                return false;
             }
-            break;
+            return true;
         case badgelink_NvsValueType_NvsValueBlob:
-            if (req->wdata.which_val != badgelink_NvsValue_blobval_tag) {
+            if (wdata->which_val != badgelink_NvsValue_blobval_tag) {
                 ESP_LOGE(TAG, "Malformed NVS write: Expected blobval");
-                badgelink_status_malformed();
-                return;
+                return false;
             }
-            break;
+            return true;
         default:
             ESP_LOGE(TAG, "Malformed NVS write: Invalid type");
-            badgelink_status_malformed();
-            return;
-    }
-
-    // Try to open NVS.
-    nvs_handle_t handle;
-    esp_err_t    ec = nvs_open(req->namespc, NVS_READWRITE, &handle);
-    if (ec != ESP_OK) {
-        ESP_LOGE(TAG, "Write error: %s", esp_err_to_name(ec));
-        badgelink_status_int_err();
-        return;
+            return false;
     }
+}
 
-    // Try to write NVS.
-    switch (req->wdata.type) {
+// Write a value that passed `check_wdata` to NVS.
+static esp_err_t write_value(nvs_handle_t handle, char const* key, badgelink_NvsValue* wdata) {
+    switch (wdata->type) {
         case badgelink_NvsValueType_NvsValueUint8:
-            ec = nvs_set_u8(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_u8(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueInt8:
-            ec = nvs_set_i8(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_i8(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueUint16:
-            ec = nvs_set_u16(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_u16(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueInt16:
-            ec = nvs_set_i16(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_i16(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueUint32:
-            ec = nvs_set_u32(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_u32(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueInt32:
-            ec = nvs_set_i32(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_i32(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueUint64:
-            ec = nvs_set_u64(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_u64(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueInt64:
-            ec = nvs_set_i64(handle, req->key, req->wdata.val.numericval);
-            break;
+            return nvs_set_i64(handle, key, wdata->val.numericval);
         case badgelink_NvsValueType_NvsValueString:
-            ec = nvs_set_str(handle, req->key, req->wdata.val.stringval);
-            break;
+            // The string points into the received frame, where it is followed by the tag of the next field or the
+            // packet's CRC, so it can be terminated in place now that the rest of the packet has been decoded.
+            wdata->val.stringval.bytes[wdata->val.stringval.size] = 0;
+            return nvs_set_str(handle, key, (char*)wdata->val.stringval.bytes);
         case badgelink_NvsValueType_NvsValueBlob:
-            ec = nvs_set_blob(handle, req->key, req->wdata.val.blobval.bytes, req->wdata.val.blobval.size);
-            break;
+            return nvs_set_blob(handle, key, wdata->val.blobval.bytes, wdata->val.blobval.size);
         default:
             __builtin_unreachable();
     }
+}
+
+// Handle an NVS write request.
+void badgelink_nvs_write() {
+    // Validate request.
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
+    if (!req->has_wdata || !req->key[0] || !req->namespc[0]) {
+        ESP_LOGE(TAG, "Malformed NVS write: missing wdata, key or namespc");
+        badgelink_status_malformed();
+        return;
+    }
+
+    // Validate write data type.
+    if (!check_wdata(&req->wdata)) {
+        badgelink_status_malformed();
+        return;
+    }
+
+    // Try to open NVS.
+    nvs_handle_t handle;
+    esp_err_t    ec = nvs_open(req->namespc, NVS_READWRITE, &handle);
+    if (ec != ESP_OK) {
+        ESP_LOGE(TAG, "Write error: %s", esp_err_to_name(ec));
+        badgelink_status_int_err();
+        return;
+    }
+
+    // Try to write NVS.
+    ec = write_value(handle, req->key, &req->wdata);
 
     // Clean up and report status.
     nvs_close(handle);
@@ -378,7 +578,7 @@ void badgelink_nvs_write() {
 // Handle an NVS delete request.
 void badgelink_nvs_delete() {
     // Validate request.
-    badgelink_NvsActionReq* req = &badgelink_packet.packet.request.req.nvs_action;
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
     if (req->has_wdata || !req->key[0] || !req->namespc[0]) {
         badgelink_status_malformed();
         return;
@@ -407,3 +607,524 @@ void badgelink_nvs_delete() {
         badgelink_status_ok();
     }
 }
+
+// Upper bound on the encoded size of a batch result without its string or blob value.
+#define NVS_BATCH_RESULT_OVERHEAD 24
+
+// Status of a batch operation that failed with `ec`.
+static badgelink_StatusCode batch_status(esp_err_t ec) {
+    switch (ec) {
+        case ESP_OK:
+            return badgelink_StatusCode_StatusOk;
+        case ESP_ERR_NVS_NOT_FOUND:
+            return badgelink_StatusCode_StatusNotFound;
+        case ESP_ERR_NO_MEM:
+            // The value read doesn't fit in the response next to the others.
+            return badgelink_StatusCode_StatusNoSpace;
+        default:
+            ESP_LOGE(TAG, "Batch error: %s", esp_err_to_name(ec));
+            return badgelink_StatusCode_StatusInternalError;
+    }
+}
+
+// Check an operation of an NVS batch request.
+static bool check_batch_op(badgelink_NvsBatchOp const* op) {
+    if (!op->key[0] || !op->namespc[0]) {
+        ESP_LOGE(TAG, "Malformed NVS batch: missing key or namespc");
+        return false;
+    }
+    switch (op->type) {
+        case badgelink_NvsActionType_NvsActionRead:
+        case badgelink_NvsActionType_NvsActionDelete:
+            if (op->has_wdata) {
+                ESP_LOGE(TAG, "Malformed NVS batch: unexpected wdata");
+                return false;
+            }
+            return true;
+        case badgelink_NvsActionType_NvsActionWrite:
+            if (!op->has_wdata) {
+                ESP_LOGE(TAG, "Malformed NVS batch: missing wdata");
+                return false;
+            }
+            return check_wdata(&op->wdata);
+        default:
+            ESP_LOGE(TAG, "Malformed NVS batch: invalid type");
+            return false;
+    }
+}
+
+// Handle an NVS batch request.
+void badgelink_nvs_batch() {
+    // Validate request; nothing is done if any of the operations is malformed.
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
+    if (req->has_wdata || req->key[0] || req->namespc[0]) {
+        badgelink_status_malformed();
+        return;
+    }
+    for (pb_size_t i = 0; i < req->batch_count; i++) {
+        if (!check_batch_op(&req->batch[i])) {
+            badgelink_status_malformed();
+            return;
+        }
+    }
+
+    // The response overwrites the request, so the results are collected separately.
+    pb_size_t                 count   = req->batch_count;
+    badgelink_NvsBatchResult* results = calloc(count ? count : 1, sizeof(badgelink_NvsBatchResult));
+    pb_byte_t*                values[sizeof(req->batch) / sizeof(req->batch[0])] = {0};
+    if (!results) {
+        ESP_LOGE(TAG, "Out of memory");
+        badgelink_status_int_err();
+        return;
+    }
+
+    // Strings and blobs are read for as long as they fit in the response.
+    size_t budget = count * NVS_BATCH_RESULT_OVERHEAD < badgelink_chunk_size
+                        ? badgelink_chunk_size - count * NVS_BATCH_RESULT_OVERHEAD
+                        : 0;
+
+    // Each namespace is opened and committed once, doing its operations in the order they were requested.
+    bool done[sizeof(req->batch) / sizeof(req->batch[0])] = {0};
+    for (pb_size_t first = 0; first < count; first++) {
+        if (done[first]) {
+            continue;
+        }
+        char const* namespc = req->batch[first].namespc;
+        bool        writes  = false;
+        for (pb_size_t i = first; i < count; i++) {
+            if (!strcmp(req->batch[i].namespc, namespc) &&
+                req->batch[i].type != badgelink_NvsActionType_NvsActionRead) {
+                writes = true;
+            }
+        }
+
+        nvs_handle_t handle;
+        esp_err_t    open_ec = nvs_open(namespc, writes ? NVS_READWRITE : NVS_READONLY, &handle);
+        for (pb_size_t i = first; i < count; i++) {
+            badgelink_NvsBatchOp* op = &req->batch[i];
+            if (done[i] || strcmp(op->namespc, namespc)) {
+                continue;
+            }
+            done[i] = true;
+
+            esp_err_t ec = open_ec;
+            if (ec == ESP_OK && op->type == badgelink_NvsActionType_NvsActionRead) {
+                ec = read_value(handle, op->key, op->read_type, budget, &results[i].rdata, &values[i]);
+                results[i].has_rdata = ec == ESP_OK;
+                if (ec == ESP_OK && results[i].rdata.which_val != badgelink_NvsValue_numericval_tag) {
+                    budget -= results[i].rdata.val.blobval.size;
+                }
+            } else if (ec == ESP_OK && op->type == badgelink_NvsActionType_NvsActionWrite) {
+                ec = write_value(handle, op->key, &op->wdata);
+            } else if (ec == ESP_OK) {
+                ec = nvs_erase_key(handle, op->key);
+            }
+            results[i].status = batch_status(ec);
+        }
+        if (open_ec != ESP_OK) {
+            continue;
+        }
+
+        // If the changes can't be committed, none of them can be relied on.
+        esp_err_t ec = writes ? nvs_commit(handle) : ESP_OK;
+        nvs_close(handle);
+        if (ec != ESP_OK) {
+            ESP_LOGE(TAG, "Batch commit error: %s", esp_err_to_name(ec));
+            for (pb_size_t i = first; i < count; i++) {
+                if (!strcmp(req->batch[i].namespc, namespc) &&
+                    req->batch[i].type != badgelink_NvsActionType_NvsActionRead &&
+                    results[i].status == badgelink_StatusCode_StatusOk) {
+                    results[i].status = badgelink_StatusCode_StatusInternalError;
+                }
+            }
+        }
+    }
+
+    // Send the results.
+    badgelink_packet->which_packet                            = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code             = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp              = badgelink_Response_nvs_resp_tag;
+    badgelink_packet->packet.response.resp.nvs_resp.which_val = badgelink_NvsActionResp_batch_tag;
+    badgelink_NvsBatchResp* resp = &badgelink_packet->packet.response.resp.nvs_resp.val.batch;
+    resp->results_count          = count;
+    memcpy(resp->results, results, count * sizeof(badgelink_NvsBatchResult));
+    badgelink_send_packet();
+
+    for (pb_size_t i = 0; i < count; i++) {
+        free(values[i]);
+    }
+    free(results);
+}
+
+// Size of the header of a snapshot record: the value type, the lengths of the namespace and key, each 1 byte, and the
+// length of the value, 4 bytes little-endian.
+#define SNAPSHOT_HEADER_SIZE 7
+
+// Snapshot being sent or received by the NVS transfer, which is kept in memory as a whole.
+// An upload has a byte to spare after the end, so the last string in it can be terminated in place.
+static uint8_t* snapshot;
+// Number of bytes used in `snapshot` while it is built, and how many it has room for.
+static size_t   snapshot_len;
+static size_t   snapshot_cap;
+// CRC32 the snapshot being uploaded should have.
+static uint32_t snapshot_crc32;
+
+// Size of a numeric value of type `type` in a snapshot, or 0 if it is a string or blob.
+static size_t numeric_size(badgelink_NvsValueType type) {
+    switch (type) {
+        case badgelink_NvsValueType_NvsValueUint8:
+        case badgelink_NvsValueType_NvsValueInt8:
+            return 1;
+        case badgelink_NvsValueType_NvsValueUint16:
+        case badgelink_NvsValueType_NvsValueInt16:
+            return 2;
+        case badgelink_NvsValueType_NvsValueUint32:
+        case badgelink_NvsValueType_NvsValueInt32:
+            return 4;
+        case badgelink_NvsValueType_NvsValueUint64:
+        case badgelink_NvsValueType_NvsValueInt64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// Make room for `len` more bytes at the end of the snapshot being built.
+static bool snapshot_reserve(size_t len) {
+    if (snapshot_len + len <= snapshot_cap) {
+        return true;
+    }
+    size_t cap = snapshot_cap ? snapshot_cap : 256;
+    while (cap < snapshot_len + len) {
+        cap *= 2;
+    }
+    uint8_t* mem = realloc(snapshot, cap);
+    if (!mem) {
+        return false;
+    }
+    snapshot     = mem;
+    snapshot_cap = cap;
+    return true;
+}
+
+// Append a record for the value `rdata` of `namespc` and `key` to the snapshot being built.
+static bool snapshot_add(char const* namespc, char const* key, badgelink_NvsValue const* rdata) {
+    size_t ns_len    = strlen(namespc);
+    size_t key_len   = strlen(key);
+    size_t value_len = numeric_size(rdata->type);
+    if (!value_len) {
+        value_len = rdata->val.blobval.size;
+    }
+    if (!snapshot_reserve(SNAPSHOT_HEADER_SIZE + ns_len + key_len + value_len)) {
+        return false;
+    }
+
+    uint8_t* rec = snapshot + snapshot_len;
+    rec[0]       = rdata->type;
+    rec[1]       = ns_len;
+    rec[2]       = key_len;
+    for (size_t i = 0; i < 4; i++) {
+        rec[3 + i] = value_len >> (8 * i);
+    }
+    rec += SNAPSHOT_HEADER_SIZE;
+    memcpy(rec, namespc, ns_len);
+    memcpy(rec + ns_len, key, key_len);
+    rec += ns_len + key_len;
+    if (rdata->which_val == badgelink_NvsValue_numericval_tag) {
+        // Numbers are stored little-endian in their own size; signed ones are sign-extended again when imported.
+        for (size_t i = 0; i < value_len; i++) {
+            rec[i] = rdata->val.numericval >> (8 * i);
+        }
+    } else if (value_len) {
+        memcpy(rec, rdata->val.blobval.bytes, value_len);
+    }
+    snapshot_len += SNAPSHOT_HEADER_SIZE + ns_len + key_len + value_len;
+    return true;
+}
+
+// Read every entry of a namespace, or of all of them if `namespc` is NULL, into a new snapshot.
+static esp_err_t snapshot_build(char const* namespc) {
+    snapshot     = NULL;
+    snapshot_len = 0;
+    snapshot_cap = 0;
+
+    nvs_iterator_t iter;
+    esp_err_t      ec = nvs_entry_find(NVS_DEFAULT_PART_NAME, namespc, NVS_TYPE_ANY, &iter);
+    if (ec == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_OK;
+    }
+
+    // Entries of a namespace tend to be next to each other, so its handle is kept open until another one comes up.
+    char         open_ns[NVS_NS_NAME_MAX_SIZE] = {0};
+    nvs_handle_t handle;
+    while (ec == ESP_OK) {
+        nvs_entry_info_t info;
+        ec = nvs_entry_info(iter, &info);
+        if (ec == ESP_OK && strcmp(info.namespace_name, open_ns)) {
+            if (open_ns[0]) {
+                nvs_close(handle);
+                open_ns[0] = 0;
+            }
+            ec = nvs_open(info.namespace_name, NVS_READONLY, &handle);
+            if (ec == ESP_OK) {
+                strlcpy(open_ns, info.namespace_name, sizeof(open_ns));
+            }
+        }
+
+        badgelink_NvsValueType type;
+        if (ec == ESP_OK && !entry_type(info.type, &type)) {
+            ec = ESP_FAIL;
+        }
+        if (ec == ESP_OK) {
+            badgelink_NvsValue rdata = badgelink_NvsValue_init_zero;
+            pb_byte_t*         value;
+            ec = read_value(handle, info.key, type, SIZE_MAX, &rdata, &value);
+            if (ec == ESP_OK && !snapshot_add(info.namespace_name, info.key, &rdata)) {
+                ec = ESP_ERR_NO_MEM;
+            }
+            free(value);
+        }
+        if (ec == ESP_OK) {
+            ec = nvs_entry_next(&iter);
+        }
+    }
+    nvs_release_iterator(iter);
+    if (open_ns[0]) {
+        nvs_close(handle);
+    }
+
+    if (ec != ESP_ERR_NVS_NOT_FOUND) {
+        free(snapshot);
+        snapshot = NULL;
+        return ec;
+    }
+    return ESP_OK;
+}
+
+// Handle an NVS export request.
+void badgelink_nvs_export() {
+    // Validate request.
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
+    if (req->has_wdata || req->key[0]) {
+        badgelink_status_malformed();
+        return;
+    } else if (badgelink_xfer_busy(BADGELINK_XFER_NVS)) {
+        badgelink_status_ill_state();
+        return;
+    }
+
+    // The whole snapshot is read up front, so it is one consistent state of NVS however slowly it is downloaded.
+    esp_err_t ec = snapshot_build(req->namespc[0] ? req->namespc : NULL);
+    if (ec != ESP_OK) {
+        ESP_LOGE(TAG, "Export error: %s", esp_err_to_name(ec));
+        badgelink_status_int_err();
+        return;
+    }
+    uint32_t crc = snapshot_len ? esp_crc32_le(0, snapshot, snapshot_len) : 0;
+    badgelink_xfer_begin(BADGELINK_XFER_NVS, false, snapshot_len);
+
+    // Format response.
+    badgelink_packet->which_packet                            = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code             = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp              = badgelink_Response_nvs_resp_tag;
+    badgelink_packet->packet.response.resp.nvs_resp.which_val = 0;
+    badgelink_packet->packet.response.resp.nvs_resp.size      = snapshot_len;
+    badgelink_packet->packet.response.resp.nvs_resp.crc32     = crc;
+
+    ESP_LOGI(TAG, "NVS export of %zu bytes started", snapshot_len);
+    badgelink_send_packet();
+}
+
+// Handle an NVS import request.
+void badgelink_nvs_import() {
+    // Validate request.
+    badgelink_NvsActionReq* req = &badgelink_packet->packet.request.req.nvs_action;
+    if (req->has_wdata || req->key[0] || req->namespc[0]) {
+        badgelink_status_malformed();
+        return;
+    } else if (badgelink_xfer_busy(BADGELINK_XFER_NVS)) {
+        badgelink_status_ill_state();
+        return;
+    }
+
+    // Nothing is written until the whole snapshot is received and checked.
+    snapshot = malloc((size_t)req->size + 1);
+    if (!snapshot) {
+        ESP_LOGE(TAG, "Not enough memory for a %" PRIu32 "-byte snapshot", req->size);
+        badgelink_status_no_space();
+        return;
+    }
+    snapshot_crc32 = req->crc32;
+    badgelink_xfer_begin(BADGELINK_XFER_NVS, true, req->size);
+
+    // This OK response officially starts the transfer.
+    ESP_LOGI(TAG, "NVS import of %" PRIu32 " bytes started", req->size);
+    badgelink_status_ok();
+}
+
+// Handle an NVS snapshot upload (host->badge) transfer.
+badgelink_StatusCode badgelink_nvs_xfer_upload() {
+    badgelink_Chunk* chunk = &badgelink_packet->packet.request.req.upload_chunk;
+    if (chunk->data.size) {
+        memcpy(snapshot + badgelink_xfer->pos, chunk->data.bytes, chunk->data.size);
+    }
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Handle an NVS snapshot download (badge->host) transfer.
+badgelink_StatusCode badgelink_nvs_xfer_download() {
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_download_chunk_tag;
+    badgelink_Chunk* chunk                        = &badgelink_packet->packet.response.resp.download_chunk;
+
+    uint32_t remaining = badgelink_xfer->size - badgelink_xfer->pos;
+    chunk->position    = badgelink_xfer->pos;
+    chunk->data.bytes  = snapshot + badgelink_xfer->pos;
+    chunk->data.size   = badgelink_chunk_size < remaining ? badgelink_chunk_size : remaining;
+    chunk->data.read   = NULL;
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Length of the value of the snapshot record at `rec`.
+static uint32_t record_value_len(uint8_t const* rec) {
+    return rec[3] | rec[4] << 8 | rec[5] << 16 | (uint32_t)rec[6] << 24;
+}
+
+// Length of the whole snapshot record at `rec`.
+static size_t record_len(uint8_t const* rec) {
+    return SNAPSHOT_HEADER_SIZE + rec[1] + rec[2] + record_value_len(rec);
+}
+
+// Whether the snapshot records at `a` and `b` are in the same namespace.
+static bool record_same_ns(uint8_t const* a, uint8_t const* b) {
+    return a[1] == b[1] && !memcmp(a + SNAPSHOT_HEADER_SIZE, b + SNAPSHOT_HEADER_SIZE, a[1]);
+}
+
+// Check the records of a received snapshot, so that a malformed one is refused before anything is written.
+static bool snapshot_check(size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        if (len - pos < SNAPSHOT_HEADER_SIZE) {
+            return false;
+        }
+        uint8_t const* rec       = snapshot + pos;
+        uint32_t       value_len = record_value_len(rec);
+        size_t         numeric   = numeric_size(rec[0]);
+        if (rec[0] > badgelink_NvsValueType_NvsValueBlob || !rec[1] || rec[1] >= NVS_NS_NAME_MAX_SIZE || !rec[2] ||
+            rec[2] >= NVS_KEY_NAME_MAX_SIZE || (numeric && value_len != numeric) ||
+            len - pos - SNAPSHOT_HEADER_SIZE < (size_t)rec[1] + rec[2] ||
+            len - pos - SNAPSHOT_HEADER_SIZE - rec[1] - rec[2] < value_len) {
+            return false;
+        }
+        // Namespaces, keys and strings can't contain a terminator.
+        size_t text_len = rec[1] + rec[2] + (rec[0] == badgelink_NvsValueType_NvsValueString ? value_len : 0);
+        if (memchr(rec + SNAPSHOT_HEADER_SIZE, 0, text_len)) {
+            return false;
+        }
+        pos += SNAPSHOT_HEADER_SIZE + rec[1] + rec[2] + value_len;
+    }
+    return true;
+}
+
+// Whether a record before the one at `end` is in the same namespace as it.
+static bool snapshot_ns_seen(size_t end) {
+    for (size_t pos = 0; pos < end; pos += record_len(snapshot + pos)) {
+        if (record_same_ns(snapshot + pos, snapshot + end)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Write the entries of a checked snapshot of `len` bytes to NVS.
+// Each namespace is opened and committed once, writing its entries in the order they are in the snapshot.
+static esp_err_t snapshot_write(size_t len) {
+    for (size_t first = 0; first < len; first += record_len(snapshot + first)) {
+        uint8_t const* first_rec = snapshot + first;
+        if (snapshot_ns_seen(first)) {
+            continue;
+        }
+
+        char namespc[NVS_NS_NAME_MAX_SIZE] = {0};
+        memcpy(namespc, first_rec + SNAPSHOT_HEADER_SIZE, first_rec[1]);
+        nvs_handle_t handle;
+        esp_err_t    ec = nvs_open(namespc, NVS_READWRITE, &handle);
+        if (ec != ESP_OK) {
+            return ec;
+        }
+
+        for (size_t pos = first; pos < len && ec == ESP_OK; pos += record_len(snapshot + pos)) {
+            uint8_t* rec = snapshot + pos;
+            if (!record_same_ns(rec, first_rec)) {
+                continue;
+            }
+            uint32_t value_len = record_value_len(rec);
+
+            char key[NVS_KEY_NAME_MAX_SIZE] = {0};
+            memcpy(key, rec + SNAPSHOT_HEADER_SIZE + rec[1], rec[2]);
+            badgelink_NvsValue wdata = badgelink_NvsValue_init_zero;
+            uint8_t*           value = rec + SNAPSHOT_HEADER_SIZE + rec[1] + rec[2];
+            wdata.type               = rec[0];
+            if (numeric_size(wdata.type)) {
+                wdata.which_val = badgelink_NvsValue_numericval_tag;
+                for (size_t i = 0; i < value_len; i++) {
+                    wdata.val.numericval |= (uint64_t)value[i] << (8 * i);
+                }
+                ec = write_value(handle, key, &wdata);
+            } else {
+                // A string is terminated in place, over the start of the next record or the byte to spare at the end,
+                // which is put back for the next record.
+                wdata.which_val   = wdata.type == badgelink_NvsValueType_NvsValueString ? badgelink_NvsValue_stringval_tag
+                                                                                        : badgelink_NvsValue_blobval_tag;
+                wdata.val.blobval = (badgelink_chunk_data_t){value, value_len, NULL};
+                uint8_t after     = value[value_len];
+                ec                = write_value(handle, key, &wdata);
+                value[value_len]  = after;
+            }
+        }
+
+        if (ec == ESP_OK) {
+            ec = nvs_commit(handle);
+        }
+        nvs_close(handle);
+        if (ec != ESP_OK) {
+            return ec;
+        }
+    }
+    return ESP_OK;
+}
+
+// Finish an NVS snapshot transfer; a complete upload is written to NVS.
+void badgelink_nvs_xfer_stop(bool abnormal) {
+    if (abnormal) {
+        ESP_LOGE(TAG, "NVS %s aborted", badgelink_xfer->is_upload ? "import" : "export");
+
+    } else if (badgelink_xfer->is_upload) {
+        size_t    len = badgelink_xfer->size;
+        uint32_t  crc = len ? esp_crc32_le(0, snapshot, len) : 0;
+        esp_err_t ec;
+        if (crc != snapshot_crc32) {
+            ESP_LOGE(TAG, "NVS import CRC32 mismatch; expected %08" PRIx32 ", actual %08" PRIx32, snapshot_crc32, crc);
+            badgelink_status_int_err();
+        } else if (!snapshot_check(len)) {
+            ESP_LOGE(TAG, "Malformed NVS snapshot");
+            badgelink_status_malformed();
+        } else if ((ec = snapshot_write(len)) == ESP_ERR_NVS_NOT_ENOUGH_SPACE) {
+            badgelink_status_no_space();
+        } else if (ec != ESP_OK) {
+            ESP_LOGE(TAG, "Import error: %s", esp_err_to_name(ec));
+            badgelink_status_int_err();
+        } else {
+            ESP_LOGI(TAG, "NVS import finished");
+            badgelink_status_ok();
+        }
+
+    } else {
+        ESP_LOGI(TAG, "NVS export finished");
+        badgelink_status_ok();
+    }
+
+    free(snapshot);
+    snapshot = NULL;
+}
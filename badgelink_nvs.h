@@ -6,8 +6,23 @@
 
 #include "badgelink_internal.h"
 
+// Without CONFIG_BADGELINK_NVS, NVS requests are unsupported.
+#ifdef CONFIG_BADGELINK_NVS
+
 // Handle an NVS request packet.
 void badgelink_nvs_handle();
+// Release the listing kept for an NVS list cursor, if any.
+void badgelink_nvs_release_cursor();
+// Release the listing kept for an NVS list cursor if transport `t` was handed it.
+void badgelink_nvs_release_cursor_of(badgelink_transport_t* t);
+// Handle an NVS snapshot upload (host->badge) transfer.
+// Keeps the chunk with the rest of the snapshot but does not respond; the caller acknowledges it.
+badgelink_StatusCode badgelink_nvs_xfer_upload();
+// Handle an NVS snapshot download (badge->host) transfer.
+// Prepares the chunk response with the next part of the snapshot but does not send it.
+badgelink_StatusCode badgelink_nvs_xfer_download();
+// Finish an NVS snapshot transfer; a complete upload is written to NVS.
+void badgelink_nvs_xfer_stop(bool abnormal);
 
 // Handle an NVS list request.
 void badgelink_nvs_list();
@@ -17,3 +32,20 @@ void badgelink_nvs_read();
 void badgelink_nvs_write();
 // Handle an NVS delete request.
 void badgelink_nvs_delete();
+// Handle an NVS batch request.
+void badgelink_nvs_batch();
+// Handle an NVS export request.
+void badgelink_nvs_export();
+// Handle an NVS import request.
+void badgelink_nvs_import();
+
+#else
+
+static inline void badgelink_nvs_release_cursor() {
+}
+
+static inline void badgelink_nvs_release_cursor_of(badgelink_transport_t* t) {
+    (void)t;
+}
+
+#endif
@@ -7,12 +7,18 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 static char const TAG[] = "badgelink_startapp";
 
+// Longest time to wait for the response to leave the device over a transport that can tell when it has.
+#define STARTAPP_DRAIN_TIMEOUT_MS 200
+// Time to wait before restarting over transports that can't tell, so the response has time to get back to the host.
+#define STARTAPP_RESTART_DELAY_MS 200
+
 // Handle a start app request.
 void badgelink_startapp_handle() {
-    badgelink_StartAppReq* req = &badgelink_packet.packet.request.req.start_app;
+    badgelink_StartAppReq* req = &badgelink_packet->packet.request.req.start_app;
 
     // Try to find the file to start.
     appfs_handle_t fd = appfsOpen(req->slug);
@@ -28,10 +34,10 @@ void badgelink_startapp_handle() {
         return;
     }
 
-    // Boot select set successfully.
+    // Boot select set successfully; restart as soon as the response is on its way to the host.
     badgelink_status_ok();
-
-    // Way a bit restarting so the response has time to get back to the host.
-    vTaskDelay(pdMS_TO_TICKS(200));
+    if (!badgelink_tx_drain(STARTAPP_DRAIN_TIMEOUT_MS)) {
+        vTaskDelay(pdMS_TO_TICKS(STARTAPP_RESTART_DELAY_MS));
+    }
     esp_restart();
 }
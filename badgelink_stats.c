@@ -0,0 +1,29 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_stats.h"
+#include "string.h"
+
+badgelink_Stats badgelink_stats;
+
+// Time the counters were last reset.
+static int64_t reset_time;
+
+// Handle a stats request.
+void badgelink_stats_handle() {
+    bool reset = badgelink_packet->packet.request.req.stats_req.reset;
+
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_stats_tag;
+    badgelink_Stats* resp                         = &badgelink_packet->packet.response.resp.stats;
+    *resp                                         = badgelink_stats;
+    resp->period_ms                               = badgelink_stats_since(reset_time) / 1000;
+
+    // Reset before sending, so the response itself is counted in the next period.
+    if (reset) {
+        memset(&badgelink_stats, 0, sizeof(badgelink_stats));
+        reset_time = badgelink_stats_now();
+    }
+    badgelink_send_packet();
+}
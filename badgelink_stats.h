@@ -0,0 +1,25 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+#include "esp_timer.h"
+
+// Counters of what BadgeLink has been doing, to find out why transfers are slow.
+// They are updated without locking by whichever task does the work, so they are approximate when tasks race.
+// `period_ms` is filled in when they are sent.
+extern badgelink_Stats badgelink_stats;
+
+// Get a timestamp to measure the time a stage takes with `badgelink_stats_since`.
+static inline int64_t badgelink_stats_now() {
+    return esp_timer_get_time();
+}
+
+// Get the microseconds since `start`, which came from `badgelink_stats_now`.
+static inline uint64_t badgelink_stats_since(int64_t start) {
+    return esp_timer_get_time() - start;
+}
+
+// Handle a stats request.
+void badgelink_stats_handle();
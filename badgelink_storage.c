@@ -0,0 +1,291 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_storage.h"
+#include "badgelink_histogram.h"
+#include "badgelink_stats.h"
+#include "badgelink_trace.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "string.h"
+
+// Default number of storage buffers if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_STORAGE_BUFFERS
+#define CONFIG_BADGELINK_STORAGE_BUFFERS 2
+#endif
+
+// Default storage task core if not configured via sdkconfig; -1 means any core
+#ifndef CONFIG_BADGELINK_STORAGE_TASK_CORE
+#define CONFIG_BADGELINK_STORAGE_TASK_CORE -1
+#endif
+#if CONFIG_BADGELINK_STORAGE_TASK_CORE < 0
+#define BADGELINK_STORAGE_TASK_CORE tskNO_AFFINITY
+#else
+#define BADGELINK_STORAGE_TASK_CORE CONFIG_BADGELINK_STORAGE_TASK_CORE
+#endif
+
+static char const TAG[] = "badgelink_storage";
+
+// A read or write for the storage worker to do.
+typedef struct {
+    // Position in the file.
+    uint32_t             pos;
+    // Length of the data.
+    size_t               len;
+    // Result of the read or write.
+    badgelink_StatusCode status;
+    // The data, which is up to `BADGELINK_CHUNK_DATA_MAX` bytes.
+    uint8_t*             buf;
+} storage_job_t;
+
+// Storage worker state of a transfer slot.
+typedef struct {
+    // Transfer the I/O is for.
+    badgelink_xfer_state_t* xfer;
+    // Reads or writes the file of the transfer.
+    badgelink_storage_io_t  io;
+    // Jobs and their buffers, or NULL if the I/O is done on the BadgeLink thread.
+    storage_job_t*          jobs;
+    // Queue of jobs for the storage worker to do; a NULL job makes it exit.
+    QueueHandle_t           todo;
+    // Queue of jobs that are free to be used.
+    QueueHandle_t           idle;
+    // Queue of download data that has been read ahead, in file order.
+    QueueHandle_t           done;
+    // Given by the storage worker when it exits.
+    SemaphoreHandle_t       exited;
+    // Position of the next download chunk to read ahead.
+    uint32_t                read_pos;
+    // Download chunk being sent.
+    storage_job_t*          current;
+    // First error of a read or write, after which no more I/O is done.
+    badgelink_StatusCode    error;
+} storage_t;
+
+// Storage state of each transfer slot, so an AppFS and a filesystem transfer each get their own worker.
+static storage_t storages[BADGELINK_XFER_SLOTS];
+
+// Storage state of the transfer the current request is for.
+static inline storage_t* current_storage() {
+    return &storages[BADGELINK_XFER_SLOT(badgelink_xfer->type)];
+}
+
+// Do a read or write of the transfer, counting, tracing and timing it.
+static badgelink_StatusCode timed_io(storage_t* st, uint32_t pos, uint8_t* buf, size_t len) {
+    int64_t start = badgelink_stats_now();
+    badgelink_trace(badgelink_TraceEventType_TraceStorageBegin, len);
+    badgelink_StatusCode status = st->io(pos, buf, len);
+    badgelink_trace(badgelink_TraceEventType_TraceStorageEnd, status);
+    uint64_t us                 = badgelink_stats_since(start);
+    badgelink_stats.storage_us += us;
+    badgelink_histogram_record(
+        st->xfer->type == BADGELINK_XFER_APPFS ? badgelink_HistogramStage_StageStorageAppfs
+                                               : badgelink_HistogramStage_StageStorageFs,
+        0, us
+    );
+    return status;
+}
+
+// Main function for the storage worker.
+static void storage_thread_main(void* arg) {
+    storage_t* st = arg;
+
+    storage_job_t* job;
+    while (1) {
+        xQueueReceive(st->todo, &job, portMAX_DELAY);
+        if (job == NULL) {
+            // Stopped by `badgelink_storage_end`.
+            break;
+        }
+        job->status =
+            st->error != badgelink_StatusCode_StatusOk ? st->error : timed_io(st, job->pos, job->buf, job->len);
+        if (job->status != badgelink_StatusCode_StatusOk) {
+            st->error = job->status;
+        }
+        if (st->xfer->is_upload) {
+            xQueueSend(st->idle, &job, portMAX_DELAY);
+        } else {
+            xQueueSend(st->done, &job, portMAX_DELAY);
+        }
+    }
+
+    xSemaphoreGive(st->exited);
+    vTaskDelete(NULL);
+}
+
+// Queue a read of the next download chunk, if the file isn't fully read yet.
+static void read_ahead(storage_t* st, storage_job_t* job) {
+    uint32_t size = st->xfer->size;
+    if (st->read_pos >= size) {
+        xQueueSend(st->idle, &job, 0);
+        return;
+    }
+    job->pos      = st->read_pos;
+    job->len      = badgelink_chunk_size < size - st->read_pos ? badgelink_chunk_size : size - st->read_pos;
+    st->read_pos += job->len;
+    xQueueSend(st->todo, &job, 0);
+}
+
+// Free everything `badgelink_storage_begin` allocated.
+static void storage_free(storage_t* st) {
+    if (st->todo) {
+        vQueueDelete(st->todo);
+    }
+    if (st->idle) {
+        vQueueDelete(st->idle);
+    }
+    if (st->done) {
+        vQueueDelete(st->done);
+    }
+    if (st->exited) {
+        vSemaphoreDelete(st->exited);
+    }
+    heap_caps_free(st->jobs);
+    st->todo   = NULL;
+    st->idle   = NULL;
+    st->done   = NULL;
+    st->exited = NULL;
+    st->jobs   = NULL;
+}
+
+// Start doing the I/O for the transfer that was just set up through the storage worker.
+void badgelink_storage_begin(badgelink_storage_io_t io) {
+    storage_t* st = current_storage();
+    st->xfer      = badgelink_xfer;
+    st->io        = io;
+    st->read_pos  = badgelink_xfer->pos;
+    st->current   = NULL;
+    st->error     = badgelink_StatusCode_StatusOk;
+    if (CONFIG_BADGELINK_STORAGE_BUFFERS < 1) {
+        return;
+    }
+
+    // The jobs are followed by their buffers in the same allocation.
+    size_t n   = CONFIG_BADGELINK_STORAGE_BUFFERS;
+    st->jobs   = heap_caps_malloc(n * (sizeof(storage_job_t) + BADGELINK_CHUNK_DATA_MAX), MALLOC_CAP_DEFAULT);
+    st->todo   = xQueueCreate(n + 1, sizeof(storage_job_t*));
+    st->idle   = xQueueCreate(n, sizeof(storage_job_t*));
+    st->done   = xQueueCreate(n, sizeof(storage_job_t*));
+    st->exited = xSemaphoreCreateBinary();
+    if (!st->jobs || !st->todo || !st->idle || !st->done || !st->exited) {
+        ESP_LOGW(TAG, "Out of memory; not using the storage worker");
+        storage_free(st);
+        return;
+    }
+
+    // The worker only runs while its transfer is in progress, so it starts at the priority the BadgeLink threads are
+    // raised to for transfers, which they may only reach once the request that started this one was handled.
+    if (xTaskCreatePinnedToCore(storage_thread_main, "BadgeLinkIO", 4096, st, BADGELINK_XFER_TASK_PRIORITY, NULL,
+                                BADGELINK_STORAGE_TASK_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "Out of memory; not using the storage worker");
+        storage_free(st);
+        return;
+    }
+
+    uint8_t* bufs = (uint8_t*)(st->jobs + n);
+    for (size_t i = 0; i < n; i++) {
+        st->jobs[i].buf = bufs + i * BADGELINK_CHUNK_DATA_MAX;
+        if (st->xfer->is_upload) {
+            storage_job_t* job = &st->jobs[i];
+            xQueueSend(st->idle, &job, 0);
+        } else {
+            read_ahead(st, &st->jobs[i]);
+        }
+    }
+}
+
+// Write upload data at `pos`; with the storage worker, the data is copied and written in the background.
+badgelink_StatusCode badgelink_storage_write(uint32_t pos, uint8_t const* data, size_t len) {
+    storage_t* st = current_storage();
+    if (!len) {
+        // Empty chunks have no data pointer at all.
+        return st->error;
+    }
+    if (!st->jobs) {
+        // Streams like compressed and tree uploads can't be written again from the middle, so the error sticks.
+        if (st->error == badgelink_StatusCode_StatusOk) {
+            st->error = timed_io(st, pos, (uint8_t*)data, len);
+        }
+        return st->error;
+    }
+
+    // Wait for a buffer to be written, then check whether that or any earlier write failed.
+    storage_job_t* job;
+    xQueueReceive(st->idle, &job, portMAX_DELAY);
+    if (st->error != badgelink_StatusCode_StatusOk) {
+        xQueueSend(st->idle, &job, 0);
+        return st->error;
+    }
+    job->pos = pos;
+    job->len = len;
+    memcpy(job->buf, data, len);
+    xQueueSend(st->todo, &job, 0);
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Read the data for a download chunk straight into the packet being encoded.
+static bool sync_read(pb_byte_t* buf, pb_size_t len) {
+    return timed_io(current_storage(), badgelink_xfer->pos, buf, len) == badgelink_StatusCode_StatusOk;
+}
+
+// Set up `data` with the next download chunk, which the storage worker will have read ahead.
+badgelink_StatusCode badgelink_storage_read(badgelink_chunk_data_t* data) {
+    storage_t* st        = current_storage();
+    uint32_t   remaining = badgelink_xfer->size - badgelink_xfer->pos;
+    if (!st->jobs) {
+        data->bytes = NULL;
+        data->read  = sync_read;
+        data->size  = badgelink_chunk_size < remaining ? badgelink_chunk_size : remaining;
+        return badgelink_StatusCode_StatusOk;
+    }
+
+    data->bytes = NULL;
+    data->read  = NULL;
+    data->size  = 0;
+    if (remaining == 0) {
+        return badgelink_StatusCode_StatusOk;
+    }
+    if (!st->current) {
+        xQueueReceive(st->done, &st->current, portMAX_DELAY);
+    }
+    if (st->current->status != badgelink_StatusCode_StatusOk) {
+        return st->current->status;
+    } else if (st->current->pos != badgelink_xfer->pos) {
+        ESP_LOGE(TAG, "[BUG] Read ahead %" PRIu32 " but sending %" PRIu32, st->current->pos, badgelink_xfer->pos);
+        return badgelink_StatusCode_StatusInternalError;
+    }
+    data->bytes = st->current->buf;
+    data->size  = st->current->len;
+    return badgelink_StatusCode_StatusOk;
+}
+
+// Release the download chunk from `badgelink_storage_read` once it is sent, and read ahead the one after.
+void badgelink_storage_release() {
+    storage_t* st = current_storage();
+    if (st->current) {
+        read_ahead(st, st->current);
+        st->current = NULL;
+    }
+}
+
+// Wait for all queued writes, stop the storage worker and free its buffers.
+badgelink_StatusCode badgelink_storage_end() {
+    storage_t* st = current_storage();
+    if (st->jobs) {
+        // The worker finishes the jobs queued before it exits.
+        storage_job_t* end = NULL;
+        xQueueSend(st->todo, &end, portMAX_DELAY);
+        xSemaphoreTake(st->exited, portMAX_DELAY);
+        storage_free(st);
+    }
+    badgelink_StatusCode code = st->error;
+    st->xfer                  = NULL;
+    st->io                    = NULL;
+    st->current               = NULL;
+    st->error                 = badgelink_StatusCode_StatusOk;
+    return code;
+}
@@ -0,0 +1,25 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+
+// Reads or writes `len` bytes of the file being transferred at `pos`.
+// Runs on the storage worker if there is one, in the order the data was queued.
+typedef badgelink_StatusCode (*badgelink_storage_io_t)(uint32_t pos, uint8_t* buf, size_t len);
+
+// Start doing the I/O for the transfer that was just set up through a storage worker of its own.
+// `io` is the write function for uploads and the read function for downloads.
+// Falls back to doing the I/O on the BadgeLink thread if the worker is disabled or there is not enough memory.
+void badgelink_storage_begin(badgelink_storage_io_t io);
+// Write upload data at `pos`; with the storage worker, the data is copied and written in the background.
+// Returns the error of an earlier write that failed, if any.
+badgelink_StatusCode badgelink_storage_write(uint32_t pos, uint8_t const* data, size_t len);
+// Set up `data` with the next download chunk, which the storage worker will have read ahead.
+badgelink_StatusCode badgelink_storage_read(badgelink_chunk_data_t* data);
+// Release the download chunk from `badgelink_storage_read` once it is sent, and read ahead the one after.
+void badgelink_storage_release();
+// Wait for all queued writes, stop the storage worker and free its buffers.
+// Returns the error of a write that failed, if any.
+badgelink_StatusCode badgelink_storage_end();
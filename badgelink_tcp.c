@@ -0,0 +1,146 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_tcp.h"
+#include "badgelink.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "stdlib.h"
+
+// Default socket receive buffer size if not configured via sdkconfig
+#ifndef CONFIG_BADGELINK_TCP_RCVBUF
+#define CONFIG_BADGELINK_TCP_RCVBUF 32768
+#endif
+
+// Amount of data to receive from the socket at once.
+#define TCP_RX_SIZE 4096
+
+static char const TAG[] = "badgelink_tcp";
+
+// Listening socket.
+static int                    listen_fd = -1;
+// Socket of the connected host, or -1 if there is none.
+static volatile int           client_fd = -1;
+// Transport the TCP connection is to BadgeLink.
+static badgelink_transport_t* tcp_transport;
+// Buffer for data received from the socket.
+static uint8_t*               rx_buf;
+// Handle to the BadgeLink TCP thread.
+static TaskHandle_t           tcp_task;
+
+// Send data to the connected host, if any.
+static void tcp_send(uint8_t const* data, size_t len) {
+    int fd = client_fd;
+    while (fd >= 0 && len) {
+        ssize_t sent = send(fd, data, len, 0);
+        if (sent < 0) {
+            // The receiving side notices the connection is gone and closes it.
+            ESP_LOGW(TAG, "Send failed; errno %d", errno);
+            return;
+        }
+        data += sent;
+        len  -= sent;
+    }
+}
+
+// Pass everything received from a connected host to BadgeLink until it disconnects.
+static void tcp_serve(int fd) {
+    // Frames are sent as soon as they're encoded, so don't let Nagle hold back the last part of a response.
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    // A large receive window lets the host keep a whole upload window in flight; lwIP may not support setting it.
+    opt = CONFIG_BADGELINK_TCP_RCVBUF;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &opt, sizeof(opt))) {
+        ESP_LOGD(TAG, "Can't set receive buffer size; errno %d", errno);
+    }
+
+    client_fd = fd;
+    while (1) {
+        ssize_t len = recv(fd, rx_buf, TCP_RX_SIZE, 0);
+        if (len <= 0) {
+            break;
+        }
+        // Wait for room in the RX buffer instead of dropping data; TCP throttles the host meanwhile.
+        for (size_t done = 0; done < (size_t)len;) {
+            done += badgelink_transport_rxdata(tcp_transport, rx_buf + done, len - done, 100);
+        }
+    }
+    // Responses that are still being sent are dropped, and the transfers of this host aborted.
+    client_fd = -1;
+    badgelink_transport_reset(tcp_transport);
+}
+
+// Main function for the BadgeLink TCP thread.
+static void tcp_thread_main(void* ignored) {
+    (void)ignored;
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            ESP_LOGE(TAG, "Accept failed; errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        ESP_LOGI(TAG, "Host connected");
+        tcp_serve(fd);
+        close(fd);
+        ESP_LOGI(TAG, "Host disconnected");
+    }
+}
+
+// Free what `badgelink_tcp_start` allocated when it fails.
+static void tcp_free() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    free(rx_buf);
+    rx_buf = NULL;
+}
+
+// Serve BadgeLink over TCP on `port`, as a transport next to the one passed to `badgelink_start`.
+bool badgelink_tcp_start(uint16_t port) {
+    if (tcp_transport) {
+        ESP_LOGE(TAG, "Already started");
+        return false;
+    }
+    rx_buf = malloc(TCP_RX_SIZE);
+    if (!rx_buf) {
+        ESP_LOGE(TAG, "Out of memory");
+        return false;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family      = AF_INET,
+        .sin_port        = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    int opt   = 1;
+    listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_fd < 0 || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+        bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(listen_fd, 1)) {
+        ESP_LOGE(TAG, "Can't listen on port %u; errno %d", port, errno);
+        tcp_free();
+        return false;
+    }
+
+    // The transport can't be removed again, so it's added last.
+    if (xTaskCreate(tcp_thread_main, "BadgeLinkTCP", 4096, NULL, uxTaskPriorityGet(NULL), &tcp_task) != pdPASS) {
+        ESP_LOGE(TAG, "Out of memory");
+        tcp_free();
+        return false;
+    }
+    tcp_transport = badgelink_add_transport(tcp_send);
+    if (!tcp_transport) {
+        vTaskDelete(tcp_task);
+        tcp_free();
+        return false;
+    }
+    // The thread waits for the transport before accepting connections.
+    xTaskNotifyGive(tcp_task);
+    ESP_LOGI(TAG, "Listening on port %u", port);
+    return true;
+}
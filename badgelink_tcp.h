@@ -0,0 +1,13 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Serve BadgeLink over TCP on `port`, as a transport next to the one passed to `badgelink_start`.
+// One host is served at a time; others wait until it disconnects.
+// Needs `CONFIG_BADGELINK_TCP`; hosts can connect once the network is up.
+// Returns false if there is not enough memory or the port can't be listened on.
+bool badgelink_tcp_start(uint16_t port);
@@ -0,0 +1,104 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "badgelink_trace.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "string.h"
+
+// A recorded event; this is also the layout of the events in a trace dump.
+typedef struct {
+    // Low 32 bits of `esp_timer_get_time`; the host unwraps them.
+    uint32_t time_us;
+    // Argument of the event, which depends on its type.
+    uint32_t arg;
+    // A `badgelink_TraceEventType`.
+    uint8_t  type;
+    // Core the event was recorded on.
+    uint8_t  core;
+    uint16_t reserved;
+} trace_event_t;
+
+_Static_assert(sizeof(trace_event_t) == 12, "Trace events must be 12 bytes");
+
+// Number of events that fit in one page of a dump.
+#define EVENTS_PER_PAGE (sizeof(((badgelink_TraceDump_events_t*)0)->bytes) / sizeof(trace_event_t))
+
+// Ring of the last `CONFIG_BADGELINK_TRACE_EVENTS` events.
+static trace_event_t events[CONFIG_BADGELINK_TRACE_EVENTS];
+// Number of events recorded; the next one goes at `recorded % CONFIG_BADGELINK_TRACE_EVENTS`.
+static uint32_t      recorded;
+// Recording is paused while a dump is in progress, so the pages fit together.
+static volatile bool paused;
+// Value of `recorded` when the dump in progress started.
+static uint32_t      dump_recorded;
+
+// Transport that started the dump in progress, which is the only one that can continue it.
+static badgelink_transport_t* dump_owner;
+
+// Record an event of type `type` with argument `arg`; may be called from any task.
+void badgelink_trace(badgelink_TraceEventType type, uint32_t arg) {
+    if (paused) {
+        return;
+    }
+    uint32_t       index = __atomic_fetch_add(&recorded, 1, __ATOMIC_RELAXED) % CONFIG_BADGELINK_TRACE_EVENTS;
+    trace_event_t* event = &events[index];
+    event->time_us       = esp_timer_get_time();
+    event->arg           = arg;
+    event->type          = type;
+    event->core          = xPortGetCoreID();
+}
+
+// Handle a trace dump request.
+void badgelink_trace_handle() {
+    badgelink_TraceReq* req = &badgelink_packet->packet.request.req.trace_req;
+    uint32_t            offset = req->offset;
+    bool                clear  = req->clear;
+
+    if (offset == 0) {
+        // Start a new dump of what was recorded up to now.
+        paused        = true;
+        dump_recorded = recorded;
+        dump_owner    = badgelink_request_transport();
+    } else if (!paused || dump_owner != badgelink_request_transport()) {
+        badgelink_status_ill_state();
+        return;
+    }
+
+    uint32_t total = dump_recorded < CONFIG_BADGELINK_TRACE_EVENTS ? dump_recorded : CONFIG_BADGELINK_TRACE_EVENTS;
+    if (offset > total) {
+        badgelink_status_ill_state();
+        return;
+    }
+    uint32_t first = dump_recorded - total + offset;
+    uint32_t count = total - offset < EVENTS_PER_PAGE ? total - offset : EVENTS_PER_PAGE;
+
+    badgelink_packet->which_packet                = badgelink_Packet_response_tag;
+    badgelink_packet->packet.response.status_code = badgelink_StatusCode_StatusOk;
+    badgelink_packet->packet.response.which_resp  = badgelink_Response_trace_tag;
+    badgelink_TraceDump* resp                     = &badgelink_packet->packet.response.resp.trace;
+    resp->total                                   = total;
+    resp->recorded                                = dump_recorded;
+    resp->next                                    = offset + count < total ? offset + count : 0;
+    resp->events.size                             = count * sizeof(trace_event_t);
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(resp->events.bytes + i * sizeof(trace_event_t), &events[(first + i) % CONFIG_BADGELINK_TRACE_EVENTS],
+               sizeof(trace_event_t));
+    }
+
+    // Resume recording after the last page.
+    if (resp->next == 0) {
+        if (clear) {
+            recorded = 0;
+        }
+        paused = false;
+    }
+    badgelink_send_packet();
+}
+
+// Resume recording if transport `t` left a dump unfinished, for a new session.
+void badgelink_trace_resume(badgelink_transport_t* t) {
+    if (dump_owner == t) {
+        paused = false;
+    }
+}
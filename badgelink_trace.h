@@ -0,0 +1,31 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "badgelink_internal.h"
+
+// Events of what BadgeLink was doing and when, kept in a ring to be dumped over the link.
+// Recording one costs a timestamp and an atomic increment, so it can stay on while measuring a transfer.
+// Without CONFIG_BADGELINK_TRACE, recording compiles to nothing and trace requests are unsupported.
+#ifdef CONFIG_BADGELINK_TRACE
+
+// Record an event of type `type` with argument `arg`; may be called from any task.
+void badgelink_trace(badgelink_TraceEventType type, uint32_t arg);
+// Handle a trace dump request.
+void badgelink_trace_handle();
+// Resume recording if transport `t` left a dump unfinished, for a new session.
+void badgelink_trace_resume(badgelink_transport_t* t);
+
+#else
+
+static inline void badgelink_trace(badgelink_TraceEventType type, uint32_t arg) {
+    (void)type;
+    (void)arg;
+}
+
+static inline void badgelink_trace_resume(badgelink_transport_t* t) {
+    (void)t;
+}
+
+#endif
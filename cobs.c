@@ -4,10 +4,268 @@
 
 #include "cobs.h"
 #include <string.h>
+#include "esp_crc.h"
+
+// Whether any of the bytes in a 32-bit word is zero.
+#define HAS_ZERO_BYTE(word) (((word) - 0x01010101) & ~(word) & 0x80808080)
+
+// Find the index of the first zero byte in `data`, or `len` if there is none.
+// Checks four bytes at a time where possible.
+static inline size_t find_zero(uint8_t const* data, size_t len) {
+    size_t i = 0;
+
+    // Check byte by byte until the data is word-aligned.
+    while (i < len && ((uintptr_t)(data + i) & 3)) {
+        if (data[i] == 0) {
+            return i;
+        }
+        i++;
+    }
+
+    // Check whole words until one contains a zero.
+    while (i + 4 <= len) {
+        uint32_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (HAS_ZERO_BYTE(word)) {
+            break;
+        }
+        i += 4;
+    }
+
+    // Find the exact zero byte, if any.
+    while (i < len && data[i] != 0) {
+        i++;
+    }
+    return i;
+}
 
 // Encode some binary data with COBS.
 // Adds a null-terminator at the end of the output.
 size_t cobs_encode(uint8_t* output, uint8_t const* input, size_t input_len) {
+    size_t output_len = 0;
+    size_t pos        = 0;
+
+    while (1) {
+        // Find the next run of at most 254 non-zero bytes.
+        size_t remaining = input_len - pos;
+        size_t run       = find_zero(input + pos, remaining < 254 ? remaining : 254);
+
+        // The code byte is written before the run is moved, like in the reference implementation,
+        // so that the output may overlap with the input as long as it starts far enough before it.
+        output[output_len++] = run + 1;
+        memmove(output + output_len, input + pos, run);
+        output_len += run;
+
+        if (run == 254) {
+            // Maximum length run; no zero byte is implied.
+            pos += run;
+            if (pos == input_len) {
+                break;
+            }
+        } else if (run == remaining) {
+            // End of data.
+            break;
+        } else {
+            // Skip the zero byte.
+            pos += run + 1;
+        }
+    }
+
+    output[output_len++] = 0;
+    return output_len;
+}
+
+// Decode some binary data with COBS.
+// Assumes the null-terminator is still present.
+size_t cobs_decode(uint8_t* output, uint8_t const* input, size_t input_len) {
+    if (input_len < 1) {
+        return 0;
+    }
+    input_len--;
+
+    size_t output_len = 0;
+    size_t idx        = 0;
+    while (idx < input_len) {
+        // Get length of non-zero byte span.
+        uint8_t code = input[idx++];
+        if (code == 0) {
+            // Malformed; zero bytes are only allowed at the end.
+            break;
+        }
+        size_t length = code - 1;
+        if (length > input_len - idx) {
+            // Malformed; span goes past the end of the data.
+            length = input_len - idx;
+        }
+
+        // Copy the non-zero bytes.
+        memmove(output + output_len, input + idx, length);
+        output_len += length;
+        idx        += length;
+        if (idx >= input_len) {
+            break;
+        }
+        if (code < 255) {
+            // Add the zero byte at the end.
+            output[output_len++] = 0;
+        }
+    }
+
+    return output_len;
+}
+
+// Encode data into the frame, optionally adding it to the CRC32.
+static void encoder_write(cobs_encoder_t* enc, uint8_t const* data, size_t len, bool add_crc) {
+    while (len) {
+        if (enc->block_full) {
+            // Start a new block.
+            enc->code_idx   = enc->len++;
+            enc->block_full = false;
+        }
+
+        // Find the next zero byte in what fits in this block.
+        size_t space = 254 - (enc->len - enc->code_idx - 1);
+        size_t max   = len < space ? len : space;
+        size_t run   = find_zero(data, max);
+        bool   zero  = run < max;
+        if (add_crc) {
+            // The data is computed over while it is in cache anyway.
+            enc->crc = esp_crc32_le(enc->crc, data, run + zero);
+        }
+
+        // Copy the non-zero bytes.
+        memmove(enc->output + enc->len, data, run);
+        enc->len += run;
+        data     += run + zero;
+        len      -= run + zero;
+
+        if (zero) {
+            // Finish the block at the zero byte and start a new one.
+            enc->output[enc->code_idx] = enc->len - enc->code_idx;
+            enc->code_idx              = enc->len++;
+        } else if (run == space) {
+            // Maximum length block; no zero byte is implied.
+            enc->output[enc->code_idx] = 255;
+            enc->block_full            = true;
+        }
+    }
+}
+
+// Start encoding a new frame into `output`.
+void cobs_encoder_init(cobs_encoder_t* enc, uint8_t* output) {
+    enc->output     = output;
+    enc->len        = 1;
+    enc->code_idx   = 0;
+    enc->block_full = false;
+    enc->crc        = 0;
+}
+
+// Encode more data into the frame.
+void cobs_encoder_write(cobs_encoder_t* enc, void const* data, size_t len) {
+    encoder_write(enc, data, len, true);
+}
+
+// Append the CRC32 and the null-terminator and return the length of the frame.
+size_t cobs_encoder_finish(cobs_encoder_t* enc) {
+    uint8_t crc[4] = {enc->crc, enc->crc >> 8, enc->crc >> 16, enc->crc >> 24};
+    encoder_write(enc, crc, sizeof(crc), false);
+    if (!enc->block_full) {
+        enc->output[enc->code_idx] = enc->len - enc->code_idx;
+    }
+    enc->output[enc->len++] = 0;
+    return enc->len;
+}
+
+// Start decoding a new frame into `output`, which may be the same buffer the frame is received in.
+void cobs_decoder_init(cobs_decoder_t* dec, uint8_t* output, size_t cap) {
+    dec->output    = output;
+    dec->cap       = cap;
+    dec->len       = 0;
+    dec->crc_len   = 0;
+    dec->crc       = 0;
+    dec->frame_crc = 0;
+    dec->code      = 0;
+    dec->remaining = 0;
+    dec->complete  = false;
+    dec->malformed = false;
+}
+
+// Decode received data up to and including the null-terminator.
+// Returns how many bytes were consumed; `complete` is set once the null-terminator is consumed.
+size_t cobs_decoder_feed(cobs_decoder_t* dec, uint8_t const* input, size_t len) {
+    size_t i = 0;
+    while (i < len && !dec->complete) {
+        if (dec->malformed) {
+            // Skip the rest of the frame.
+            i += find_zero(input + i, len - i);
+            if (i < len) {
+                i++;
+                dec->complete = true;
+            }
+            break;
+        }
+
+        if (dec->remaining) {
+            // Copy the non-zero bytes of the current block.
+            size_t max = len - i < dec->remaining ? len - i : dec->remaining;
+            size_t run = find_zero(input + i, max);
+            if (run > dec->cap - dec->len) {
+                dec->malformed = true;
+                continue;
+            }
+            memmove(dec->output + dec->len, input + i, run);
+            dec->len       += run;
+            dec->remaining -= run;
+            i              += run;
+            if (run < max) {
+                // The frame ended in the middle of a block.
+                dec->malformed = true;
+            }
+            continue;
+        }
+
+        uint8_t code = input[i++];
+        if (code == 0) {
+            dec->complete = true;
+            break;
+        }
+        if (dec->code != 0 && dec->code < 255) {
+            // Add the zero byte implied by the previous block.
+            if (dec->len >= dec->cap) {
+                dec->malformed = true;
+                continue;
+            }
+            dec->output[dec->len++] = 0;
+        }
+        dec->code      = code;
+        dec->remaining = code - 1;
+    }
+
+    // Update the CRC32 with everything except the last four bytes, which may be the CRC32 itself.
+    if (!dec->malformed && dec->len > dec->crc_len + 4) {
+        dec->crc     = esp_crc32_le(dec->crc, dec->output + dec->crc_len, dec->len - 4 - dec->crc_len);
+        dec->crc_len = dec->len - 4;
+    }
+
+    return i;
+}
+
+// Check the CRC32 of a complete frame and strip it from the decoded data.
+cobs_frame_status_t cobs_decoder_finish(cobs_decoder_t* dec) {
+    if (!dec->complete || dec->malformed || dec->remaining || dec->len < 5) {
+        // Any frame must contain at least one byte of data and a 4-byte CRC32.
+        return COBS_FRAME_MALFORMED;
+    }
+
+    dec->len       -= 4;
+    uint8_t* crc    = dec->output + dec->len;
+    dec->frame_crc  = crc[0] | (crc[1] << 8) | (crc[2] << 16) | ((uint32_t)crc[3] << 24);
+    return dec->crc == dec->frame_crc ? COBS_FRAME_OK : COBS_FRAME_CRC_ERROR;
+}
+
+// Encode some binary data with COBS, one byte at a time.
+// Reference implementation for `cobs_encode`.
+size_t cobs_encode_ref(uint8_t* output, uint8_t const* input, size_t input_len) {
     bool   final_zero = true;
     size_t output_len = 0;
     size_t search_idx = 0;
@@ -43,8 +301,8 @@ size_t cobs_encode(uint8_t* output, uint8_t const* input, size_t input_len) {
 }
 
 // Decode some binary data with COBS.
-// Assumes the null-terminator is still present.
-size_t cobs_decode(uint8_t* output, uint8_t const* input, size_t input_len) {
+// Reference implementation for `cobs_decode`.
+size_t cobs_decode_ref(uint8_t* output, uint8_t const* input, size_t input_len) {
     if (input_len < 1) {
         return 0;
     }
@@ -2,6 +2,8 @@
 // SPDX-Copyright-Text: 2025 Julian Scheffers
 // SPDX-License-Identifier: MIT
 
+#pragma once
+
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -10,6 +12,54 @@
 extern "C" {
 #endif
 
+// Streaming COBS encoder that appends a CRC32 of the data to the frame.
+typedef struct {
+    // Output buffer.
+    uint8_t* output;
+    // Number of bytes written to the output so far.
+    size_t   len;
+    // Index of the code byte of the current block.
+    size_t   code_idx;
+    // Whether the current block is full and the next byte starts a new one.
+    bool     block_full;
+    // CRC32 of the data written so far.
+    uint32_t crc;
+} cobs_encoder_t;
+
+// Status of a frame decoded by the streaming COBS decoder.
+typedef enum {
+    // Frame decoded and the CRC32 matches.
+    COBS_FRAME_OK,
+    // Frame is too short, does not fit in the output buffer or is not valid COBS.
+    COBS_FRAME_MALFORMED,
+    // Frame decoded but the CRC32 does not match.
+    COBS_FRAME_CRC_ERROR,
+} cobs_frame_status_t;
+
+// Streaming COBS decoder that checks the CRC32 at the end of the frame.
+typedef struct {
+    // Output buffer.
+    uint8_t* output;
+    // Capacity of the output buffer.
+    size_t   cap;
+    // Number of bytes decoded so far; after `cobs_decoder_finish`, the length without the CRC32.
+    size_t   len;
+    // Number of decoded bytes included in `crc`.
+    size_t   crc_len;
+    // CRC32 of the decoded data; it lags four bytes behind because those may be the CRC32 itself.
+    uint32_t crc;
+    // CRC32 stored in the frame, valid after `cobs_decoder_finish`.
+    uint32_t frame_crc;
+    // Code byte of the current block, or 0 at the start of the frame.
+    uint8_t  code;
+    // Number of bytes left in the current block.
+    uint8_t  remaining;
+    // Whether the null-terminator has been received.
+    bool     complete;
+    // Whether the frame is malformed; the rest of it is skipped.
+    bool     malformed;
+} cobs_decoder_t;
+
 // Calculates how long some binary data could maximally be when COBS-encoded.
 #define COBS_ENCODED_MAX_LENGTH(len) ((len) + (((len) + 253) / 254) + 1)
 
@@ -24,6 +74,31 @@ size_t cobs_encode(uint8_t* output, uint8_t const* input, size_t input_len);
 // Assumes the null-terminator is still present.
 size_t cobs_decode(uint8_t* output, uint8_t const* input, size_t input_len);
 
+// Start encoding a new frame into `output`, which must be at least
+// `COBS_ENCODED_MAX_LENGTH(len + 4)` bytes for `len` bytes of data.
+// The data may be in the same buffer as long as it starts at least that many bytes minus `len` after `output`.
+void                cobs_encoder_init(cobs_encoder_t* enc, uint8_t* output);
+// Encode more data into the frame.
+void                cobs_encoder_write(cobs_encoder_t* enc, void const* data, size_t len);
+// Append the CRC32 and the null-terminator and return the length of the frame.
+size_t              cobs_encoder_finish(cobs_encoder_t* enc);
+
+// Start decoding a new frame into `output`, which may be the same buffer the frame is received in.
+void                cobs_decoder_init(cobs_decoder_t* dec, uint8_t* output, size_t cap);
+// Decode received data up to and including the null-terminator.
+// Returns how many bytes were consumed; `complete` is set once the null-terminator is consumed.
+size_t              cobs_decoder_feed(cobs_decoder_t* dec, uint8_t const* input, size_t len);
+// Check the CRC32 of a complete frame and strip it from the decoded data.
+cobs_frame_status_t cobs_decoder_finish(cobs_decoder_t* dec);
+
+// Encode some binary data with COBS, one byte at a time.
+// Reference implementation for `cobs_encode`.
+size_t cobs_encode_ref(uint8_t* output, uint8_t const* input, size_t input_len);
+
+// Decode some binary data with COBS.
+// Reference implementation for `cobs_decode`.
+size_t cobs_decode_ref(uint8_t* output, uint8_t const* input, size_t input_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,134 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "lzf.h"
+#include <string.h>
+
+// The LZF format is a sequence of literal runs and back-references:
+// - `000LLLLL` followed by L+1 literal bytes;
+// - `LLLOOOOO OOOOOOOO` copies L+2 bytes from O+1 bytes back, for L from 1 to 6;
+// - `111OOOOO LLLLLLLL OOOOOOOO` copies L+9 bytes from O+1 bytes back.
+
+// Maximum length of a literal run.
+#define LZF_MAX_LIT 32
+// Maximum distance of a back-reference.
+#define LZF_MAX_OFF (1 << 13)
+// Maximum length of a back-reference.
+#define LZF_MAX_REF (7 + 255 + 2)
+
+// Hash the three bytes at `p` into an index of the hash table.
+#define LZF_HASH(p) ((((uint32_t)(p)[0] << 16 | (uint32_t)(p)[1] << 8 | (p)[2]) * 2654435761u) >> (32 - 12))
+
+// Append `len` literal bytes as runs of up to `LZF_MAX_LIT` bytes.
+static bool write_literals(uint8_t* output, size_t output_cap, size_t* out_pos, uint8_t const* lit, size_t len) {
+    while (len) {
+        size_t run = len < LZF_MAX_LIT ? len : LZF_MAX_LIT;
+        if (*out_pos + 1 + run > output_cap) {
+            return false;
+        }
+        output[(*out_pos)++] = run - 1;
+        memcpy(output + *out_pos, lit, run);
+        *out_pos += run;
+        lit      += run;
+        len      -= run;
+    }
+    return true;
+}
+
+// Compress data in the LZF format.
+// Positions in `input` are stored in `htab` as 16 bits, so it must be at most 64 KiB.
+// Returns the compressed length, or 0 if it doesn't fit in `output_cap` bytes.
+size_t lzf_compress(uint8_t* output, size_t output_cap, uint8_t const* input, size_t input_len, uint16_t* htab) {
+    memset(htab, 0, LZF_HTAB_SIZE * sizeof(*htab));
+    size_t in_pos  = 0;
+    size_t out_pos = 0;
+    size_t lit     = 0;
+
+    while (in_pos + 2 < input_len) {
+        // Look up the last position with the same next three bytes.
+        uint32_t hash = LZF_HASH(input + in_pos);
+        size_t   ref  = htab[hash];
+        size_t   off  = in_pos - ref - 1;
+        htab[hash]    = in_pos;
+        if (ref >= in_pos || off >= LZF_MAX_OFF || memcmp(input + ref, input + in_pos, 3)) {
+            in_pos++;
+            continue;
+        }
+
+        // Extend the match as far as it goes.
+        size_t max = input_len - in_pos < LZF_MAX_REF ? input_len - in_pos : LZF_MAX_REF;
+        size_t len = 3;
+        while (len < max && input[ref + len] == input[in_pos + len]) {
+            len++;
+        }
+
+        // Write the literals before it and then the back-reference.
+        if (!write_literals(output, output_cap, &out_pos, input + lit, in_pos - lit) || out_pos + 3 > output_cap) {
+            return 0;
+        }
+        if (len - 2 < 7) {
+            output[out_pos++] = (len - 2) << 5 | off >> 8;
+        } else {
+            output[out_pos++] = 7 << 5 | off >> 8;
+            output[out_pos++] = len - 2 - 7;
+        }
+        output[out_pos++] = off;
+
+        // Hash the positions inside the match as well, so later data can refer back into it.
+        for (size_t i = in_pos + 1; i < in_pos + len && i + 2 < input_len; i++) {
+            htab[LZF_HASH(input + i)] = i;
+        }
+        in_pos += len;
+        lit     = in_pos;
+    }
+
+    if (!write_literals(output, output_cap, &out_pos, input + lit, input_len - lit)) {
+        return 0;
+    }
+    return out_pos;
+}
+
+// Decompress LZF data.
+// Returns false if the data is malformed or does not fit in `output_cap` bytes.
+bool lzf_decompress(uint8_t* output, size_t output_cap, size_t* output_len, uint8_t const* input, size_t input_len) {
+    size_t in_pos  = 0;
+    size_t out_pos = 0;
+
+    while (in_pos < input_len) {
+        uint8_t ctrl = input[in_pos++];
+        if (ctrl < LZF_MAX_LIT) {
+            // Literal run.
+            size_t len = ctrl + 1;
+            if (in_pos + len > input_len || out_pos + len > output_cap) {
+                return false;
+            }
+            memcpy(output + out_pos, input + in_pos, len);
+            in_pos  += len;
+            out_pos += len;
+            continue;
+        }
+
+        // Back-reference; it may overlap the bytes it writes, so copy one byte at a time.
+        size_t len = ctrl >> 5;
+        if (len == 7) {
+            if (in_pos >= input_len) {
+                return false;
+            }
+            len += input[in_pos++];
+        }
+        if (in_pos >= input_len) {
+            return false;
+        }
+        size_t off  = ((size_t)(ctrl & 0x1f) << 8 | input[in_pos++]) + 1;
+        len        += 2;
+        if (off > out_pos || out_pos + len > output_cap) {
+            return false;
+        }
+        for (size_t i = 0; i < len; i++, out_pos++) {
+            output[out_pos] = output[out_pos - off];
+        }
+    }
+
+    *output_len = out_pos;
+    return true;
+}
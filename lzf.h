@@ -0,0 +1,28 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of entries in the hash table `lzf_compress` needs.
+#define LZF_HTAB_SIZE (1 << 12)
+
+// Compress data in the LZF format.
+// Positions in `input` are stored in `htab` as 16 bits, so it must be at most 64 KiB.
+// Returns the compressed length, or 0 if it doesn't fit in `output_cap` bytes.
+size_t lzf_compress(uint8_t* output, size_t output_cap, uint8_t const* input, size_t input_len, uint16_t* htab);
+
+// Decompress LZF data.
+// Returns false if the data is malformed or does not fit in `output_cap` bytes.
+bool lzf_decompress(uint8_t* output, size_t output_cap, size_t* output_len, uint8_t const* input, size_t input_len);
+
+#ifdef __cplusplus
+}
+#endif
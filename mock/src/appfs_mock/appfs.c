@@ -4,52 +4,185 @@
 
 #include "appfs.h"
 #include <malloc.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include "../sim.h"
+
+// Size of the simulated AppFS partition.
+#define APPFS_MOCK_SIZE    (16 * 1024 * 1024)
+// Every file takes up at least one page, so this many files fit at most.
+#define APPFS_MOCK_FILES   (APPFS_MOCK_SIZE / SPI_FLASH_MMU_PAGE_SIZE)
+// Flash is erased per sector and programmed per page.
+#define FLASH_SECTOR_SIZE  4096
+#define FLASH_PAGE_SIZE    256
+
+// An AppFS file kept in RAM.
+typedef struct {
+    char*    name;
+    char*    title;
+    uint16_t version;
+    int      size;
+    // Space taken up in the partition; a whole number of MMU pages.
+    size_t   alloc;
+    uint8_t* data;
+} appfs_mock_file_t;
+
+static appfs_mock_file_t files[APPFS_MOCK_FILES];
+static size_t            used_mem;
+// The storage task and the BadgeLink task may both use AppFS.
+static pthread_mutex_t   mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static bool valid_fd(appfs_handle_t fd) {
+    return fd >= 0 && fd < APPFS_MOCK_FILES && files[fd].name;
+}
+
+static appfs_handle_t find_file(const char* filename) {
+    for (appfs_handle_t fd = 0; fd < APPFS_MOCK_FILES; fd++) {
+        if (files[fd].name && !strcmp(files[fd].name, filename)) {
+            return fd;
+        }
+    }
+    return APPFS_INVALID_FD;
+}
+
+static void free_file(appfs_handle_t fd) {
+    used_mem -= files[fd].alloc;
+    free(files[fd].name);
+    free(files[fd].title);
+    free(files[fd].data);
+    memset(&files[fd], 0, sizeof(appfs_mock_file_t));
+}
 
 int appfsExists(const char* filename) {
-    printf("TODO\n");
-    abort();
+    return appfsOpen(filename) != APPFS_INVALID_FD;
 }
 appfs_handle_t appfsOpen(const char* filename) {
-    printf("TODO\n");
-    abort();
+    pthread_mutex_lock(&mtx);
+    appfs_handle_t fd = find_file(filename);
+    pthread_mutex_unlock(&mtx);
+    return fd;
 }
 esp_err_t appfsDeleteFile(const char* filename) {
-    printf("TODO\n");
-    abort();
+    pthread_mutex_lock(&mtx);
+    appfs_handle_t fd = find_file(filename);
+    if (fd != APPFS_INVALID_FD) {
+        free_file(fd);
+    }
+    pthread_mutex_unlock(&mtx);
+    return fd != APPFS_INVALID_FD ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 esp_err_t appfsCreateFileExt(const char* filename, const char* title, uint16_t version, size_t size,
                              appfs_handle_t* handle) {
-    printf("TODO\n");
-    abort();
+    size_t alloc = (size + SPI_FLASH_MMU_PAGE_SIZE - 1) / SPI_FLASH_MMU_PAGE_SIZE * SPI_FLASH_MMU_PAGE_SIZE;
+    if (!alloc) {
+        alloc = SPI_FLASH_MMU_PAGE_SIZE;
+    }
+
+    pthread_mutex_lock(&mtx);
+    // Like AppFS, creating a file replaces the one with the same name.
+    appfs_handle_t fd = find_file(filename);
+    if (fd != APPFS_INVALID_FD) {
+        free_file(fd);
+    }
+    if (used_mem + alloc > APPFS_MOCK_SIZE) {
+        pthread_mutex_unlock(&mtx);
+        return ESP_ERR_NO_MEM;
+    }
+    for (fd = 0; files[fd].name; fd++);
+
+    // New files are not erased, so the data that was there before stays until the file is erased.
+    files[fd] = (appfs_mock_file_t){
+        .name    = strdup(filename),
+        .title   = strdup(title),
+        .version = version,
+        .size    = size,
+        .alloc   = alloc,
+        .data    = malloc(alloc),
+    };
+    if (!files[fd].name || !files[fd].title || !files[fd].data) {
+        free_file(fd);
+        pthread_mutex_unlock(&mtx);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(files[fd].data, 0, alloc);
+    used_mem += alloc;
+    pthread_mutex_unlock(&mtx);
+
+    *handle = fd;
+    return ESP_OK;
 }
 esp_err_t appfsErase(appfs_handle_t fd, size_t start, size_t len) {
-    printf("TODO\n");
-    abort();
+    if (start % FLASH_SECTOR_SIZE || len % FLASH_SECTOR_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&mtx);
+    if (!valid_fd(fd) || start > files[fd].alloc || len > files[fd].alloc - start) {
+        pthread_mutex_unlock(&mtx);
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(files[fd].data + start, 0xff, len);
+    pthread_mutex_unlock(&mtx);
+
+    mock_sim_sleep((uint64_t)mock_sim.flash_erase_us * (len / FLASH_SECTOR_SIZE));
+    return ESP_OK;
 }
 esp_err_t appfsWrite(appfs_handle_t fd, size_t start, uint8_t* buf, size_t len) {
-    printf("TODO\n");
-    abort();
+    pthread_mutex_lock(&mtx);
+    if (!valid_fd(fd) || start > files[fd].alloc || len > files[fd].alloc - start) {
+        pthread_mutex_unlock(&mtx);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Programming can only clear bits, so writing over data that wasn't erased corrupts it like on real flash.
+    for (size_t i = 0; i < len; i++) {
+        files[fd].data[start + i] &= buf[i];
+    }
+    pthread_mutex_unlock(&mtx);
+
+    size_t pages = (start % FLASH_PAGE_SIZE + len + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+    mock_sim_sleep((uint64_t)mock_sim.flash_program_us * pages);
+    return ESP_OK;
 }
 esp_err_t appfsRead(appfs_handle_t fd, size_t start, void* buf, size_t len) {
-    printf("TODO\n");
-    abort();
+    pthread_mutex_lock(&mtx);
+    if (!valid_fd(fd) || start > files[fd].alloc || len > files[fd].alloc - start) {
+        pthread_mutex_unlock(&mtx);
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(buf, files[fd].data + start, len);
+    pthread_mutex_unlock(&mtx);
+    return ESP_OK;
 }
 
 void appfsEntryInfoExt(appfs_handle_t fd, const char** name, const char** title, uint16_t* version, int* size) {
-    printf("TODO\n");
-    abort();
+    pthread_mutex_lock(&mtx);
+    if (name) {
+        *name = files[fd].name;
+    }
+    if (title) {
+        *title = files[fd].title;
+    }
+    if (version) {
+        *version = files[fd].version;
+    }
+    if (size) {
+        *size = files[fd].size;
+    }
+    pthread_mutex_unlock(&mtx);
 }
 appfs_handle_t appfsNextEntry(appfs_handle_t fd) {
-    printf("TODO\n");
-    abort();
+    pthread_mutex_lock(&mtx);
+    for (fd = fd == APPFS_INVALID_FD ? 0 : fd + 1; fd < APPFS_MOCK_FILES && !files[fd].name; fd++);
+    pthread_mutex_unlock(&mtx);
+    return fd < APPFS_MOCK_FILES ? fd : APPFS_INVALID_FD;
 }
 size_t appfsGetFreeMem() {
-    printf("TODO\n");
-    abort();
+    return APPFS_MOCK_SIZE - used_mem;
 }
 size_t appfsGetTotalMem() {
-    printf("TODO\n");
-    abort();
+    return APPFS_MOCK_SIZE;
+}
+bool appfsBootSelect(appfs_handle_t fd, char const* arg) {
+    // There is no bootloader to pass the app on to; the mock badge just exits when it restarts.
+    return valid_fd(fd);
 }
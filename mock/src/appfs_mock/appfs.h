@@ -25,6 +25,7 @@ void appfsEntryInfoExt(appfs_handle_t fd, const char** name, const char** title,
 appfs_handle_t appfsNextEntry(appfs_handle_t fd);
 size_t         appfsGetFreeMem();
 size_t         appfsGetTotalMem();
+bool           appfsBootSelect(appfs_handle_t fd, char const* arg);
 
 static inline void appfsEntryInfo(appfs_handle_t fd, const char** name, int* size) {
     appfsEntryInfoExt(fd, name, NULL, NULL, size);
@@ -0,0 +1,132 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+// Compares the optimized COBS implementation against the reference one on random data.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cobs.h"
+#include "esp_crc.h"
+
+#define MAX_LEN 5000
+
+static uint8_t input[MAX_LEN + 4];
+static uint8_t encoded[COBS_ENCODED_MAX_LENGTH(MAX_LEN + 4) + 4];
+static uint8_t encoded_ref[COBS_ENCODED_MAX_LENGTH(MAX_LEN + 4)];
+static uint8_t decoded[COBS_ENCODED_MAX_LENGTH(MAX_LEN + 4)];
+static uint8_t decoded_ref[COBS_ENCODED_MAX_LENGTH(MAX_LEN + 4)];
+// Buffer for in-place encoding, with the input placed at the end like `badgelink_send_packet` does.
+static uint8_t inplace[COBS_ENCODED_MAX_LENGTH(MAX_LEN + 4)];
+
+static void fail(char const* what, size_t len, unsigned seed) {
+    printf("Mismatch in %s for %zu-byte input (seed %u)\n", what, len, seed);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 100000;
+    for (long iter = 0; iter < iterations; iter++) {
+        unsigned seed = iter;
+        srand(seed);
+
+        // Random length and zero density, so both long runs and many short runs are covered.
+        size_t len      = rand() % (MAX_LEN + 1);
+        int    zero_pct = rand() % 4 == 0 ? 0 : rand() % 100;
+        size_t offset   = rand() % 4;
+        for (size_t i = 0; i < len; i++) {
+            input[i] = rand() % 100 < zero_pct ? 0 : 1 + rand() % 255;
+        }
+
+        // Encoding must produce identical output.
+        size_t enc_len     = cobs_encode(encoded + offset, input, len);
+        size_t enc_ref_len = cobs_encode_ref(encoded_ref, input, len);
+        if (enc_len != enc_ref_len || memcmp(encoded + offset, encoded_ref, enc_len)) {
+            fail("encode", len, seed);
+        }
+
+        // Encoding in place must too.
+        size_t inplace_off = sizeof(inplace) - len;
+        memcpy(inplace + inplace_off, input, len);
+        if (cobs_encode(inplace, inplace + inplace_off, len) != enc_len || memcmp(inplace, encoded_ref, enc_len)) {
+            fail("in-place encode", len, seed);
+        }
+
+        // Decoding must round-trip and match the reference.
+        size_t dec_len     = cobs_decode(decoded, encoded_ref, enc_len);
+        size_t dec_ref_len = cobs_decode_ref(decoded_ref, encoded_ref, enc_len);
+        if (dec_len != len || dec_ref_len != len || memcmp(decoded, input, len) || memcmp(decoded_ref, input, len)) {
+            fail("decode", len, seed);
+        }
+
+        // Decoding in place must too.
+        if (cobs_decode(encoded_ref, encoded_ref, enc_len) != len || memcmp(encoded_ref, input, len)) {
+            fail("in-place decode", len, seed);
+        }
+
+        // The streaming encoder must match the reference encoder on the data with its CRC32 appended,
+        // also when the data is written in pieces and in place.
+        uint32_t crc     = esp_crc32_le(0, input, len);
+        input[len]       = crc;
+        input[len + 1]   = crc >> 8;
+        input[len + 2]   = crc >> 16;
+        input[len + 3]   = crc >> 24;
+        enc_ref_len      = cobs_encode_ref(encoded_ref, input, len + 4);
+        inplace_off      = sizeof(inplace) - len;
+        memcpy(inplace + inplace_off, input, len);
+        cobs_encoder_t enc;
+        cobs_encoder_init(&enc, inplace);
+        size_t written = 0;
+        while (written < len) {
+            size_t piece = 1 + rand() % 600;
+            if (piece > len - written) {
+                piece = len - written;
+            }
+            cobs_encoder_write(&enc, inplace + inplace_off + written, piece);
+            written += piece;
+        }
+        if (cobs_encoder_finish(&enc) != enc_ref_len || memcmp(inplace, encoded_ref, enc_ref_len)) {
+            fail("streaming encode", len, seed);
+        }
+
+        // The streaming decoder must recover the data and accept the CRC32, also when fed in pieces.
+        cobs_decoder_t dec;
+        cobs_decoder_init(&dec, decoded, sizeof(decoded));
+        size_t fed = 0;
+        while (fed < enc_ref_len && !dec.complete) {
+            size_t piece = 1 + rand() % 600;
+            if (piece > enc_ref_len - fed) {
+                piece = enc_ref_len - fed;
+            }
+            fed += cobs_decoder_feed(&dec, encoded_ref + fed, piece);
+        }
+        cobs_frame_status_t status = cobs_decoder_finish(&dec);
+        if (fed != enc_ref_len || (len ? status != COBS_FRAME_OK : status != COBS_FRAME_MALFORMED) ||
+            (len && (dec.len != len || memcmp(decoded, input, len)))) {
+            fail("streaming decode", len, seed);
+        }
+
+        // Decoding in place must too, and a flipped bit must be caught by the CRC32.
+        if (len) {
+            encoded_ref[rand() % (enc_ref_len - 1)] ^= 1 << (rand() % 8);
+            cobs_decoder_init(&dec, encoded_ref, enc_ref_len);
+            cobs_decoder_feed(&dec, encoded_ref, enc_ref_len);
+            if (cobs_decoder_finish(&dec) == COBS_FRAME_OK) {
+                fail("corrupt streaming decode", len, seed);
+            }
+        }
+
+        // Corrupt frames must not be decoded past their end.
+        for (size_t i = 0; i + 1 < enc_len; i++) {
+            if (encoded[offset + i] == 0 || rand() % 16 == 0) {
+                encoded[offset + i] = 1 + rand() % 255;
+            }
+        }
+        if (cobs_decode(decoded, encoded + offset, enc_len) > enc_len) {
+            fail("corrupt decode", len, seed);
+        }
+    }
+
+    printf("%ld iterations OK\n", iterations);
+    return 0;
+}
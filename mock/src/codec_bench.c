@@ -0,0 +1,254 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+// Times the codecs every packet goes through on the badge: CRC32, COBS and nanopb for every message type.
+// Usage: codec_bench [seconds per case] [filter]; only cases whose name contains the filter are run.
+// Messages are filled with as much data as their static fields hold, so the numbers are for the largest packets.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "badgelink.pb.h"
+#include "badgelink_internal.h"
+#include "cobs.h"
+#include "esp_crc.h"
+#include "pb_common.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+// Every message type, to time encoding and decoding of each.
+#define MESSAGES(X)                                                                                                    \
+    X(Packet) X(Request) X(Response) X(StartAppReq) X(VersionReq) X(VersionResp) X(XferAck) X(XferResult) X(Nak)       \
+    X(StatsReq) X(Stats) X(TraceReq) X(TraceDump) X(HistogramReq) X(Histogram) X(Histograms) X(BenchReq)             \
+    X(BenchResult) X(EchoReq) X(EchoResp) X(Chunk) X(FsUsage) X(AppfsMetadata) X(AppfsActionReq) X(AppfsList)       \
+    X(AppfsSectorCrcs) X(AppfsActionResp) X(FsStat) X(FsActionReq) X(FsDirent) X(FsDirentList) X(FsActionResp)      \
+    X(FsStatManyReq) X(FsStatResult) X(FsStatManyResp) X(NvsValue) X(NvsEntry) X(NvsActionReq) X(NvsBatchOp)        \
+    X(NvsEntriesList) X(NvsActionResp) X(NvsBatchResp) X(NvsBatchResult)
+
+static double       budget = 0.2;
+static char const*  filter = "";
+// Large enough for any message struct.
+static uint8_t      message[sizeof(badgelink_Packet)];
+static uint8_t      decoded[sizeof(badgelink_Packet)];
+static uint8_t*     packed;
+static size_t       packed_len;
+static uint8_t      chunk_data[BADGELINK_CHUNK_DATA_MAX];
+static uint8_t      data[BADGELINK_PACKET_MAX_SIZE + 4];
+static uint8_t      encoded[BADGELINK_BUF_CAP];
+static uint8_t      scratch[BADGELINK_BUF_CAP];
+static size_t       encoded_len;
+static volatile int sink;
+
+static void fill(pb_msgdesc_t const* desc, void* msg);
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Run `func` until it took at least `budget` seconds and print the time per call.
+// `bytes` is how much data one call processes, for the throughput; 0 to leave it out.
+static void bench(char const* name, void (*func)(), size_t bytes) {
+    if (!strstr(name, filter)) {
+        return;
+    }
+    func();
+    long   iterations = 1;
+    double elapsed;
+    while (1) {
+        double start = now();
+        for (long i = 0; i < iterations; i++) {
+            func();
+        }
+        elapsed = now() - start;
+        if (elapsed >= budget) {
+            break;
+        }
+        iterations *= 2;
+    }
+    double ns = elapsed / iterations * 1e9;
+    if (bytes) {
+        printf("%-36s %6zu B %10.0f ns %9.1f MB/s\n", name, bytes, ns, bytes / ns * 1e3);
+    } else {
+        printf("%-36s %19.0f ns\n", name, ns);
+    }
+}
+
+// Fill one static field value at `ptr`.
+static void fill_value(pb_field_iter_t const* field, void* ptr) {
+    switch (PB_LTYPE(field->type)) {
+        case PB_LTYPE_BOOL:
+            *(bool*)ptr = true;
+            break;
+        case PB_LTYPE_BYTES: {
+            pb_bytes_array_t* bytes = ptr;
+            bytes->size             = field->data_size - offsetof(pb_bytes_array_t, bytes);
+            memset(bytes->bytes, 0x55, bytes->size);
+        } break;
+        case PB_LTYPE_STRING:
+            memset(ptr, 'a', field->data_size - 1);
+            ((char*)ptr)[field->data_size - 1] = 0;
+            break;
+        case PB_LTYPE_SUBMESSAGE:
+            fill(field->submsg_desc, ptr);
+            break;
+        default:
+            // Varints, fixed-size numbers and enums; not all valid enum values, which nanopb doesn't check.
+            memset(ptr, 0x55, field->data_size);
+            break;
+    }
+}
+
+// Fill every static field of a message, with repeated fields at their maximum count.
+// Only the first static member of a oneof is used; callback fields are left empty.
+static void fill(pb_msgdesc_t const* desc, void* msg) {
+    pb_field_iter_t field;
+    if (!pb_field_iter_begin(&field, desc, msg)) {
+        return;
+    }
+    do {
+        if (PB_ATYPE(field.type) != PB_ATYPE_STATIC) {
+            continue;
+        }
+        switch (PB_HTYPE(field.type)) {
+            case PB_HTYPE_ONEOF:
+                if (*(pb_size_t*)field.pSize) {
+                    continue;
+                }
+                *(pb_size_t*)field.pSize = field.tag;
+                break;
+            case PB_HTYPE_REPEATED:
+                if (field.pSize) {
+                    *(pb_size_t*)field.pSize = field.array_size;
+                }
+                for (pb_size_t i = 0; i < field.array_size; i++) {
+                    fill_value(&field, (uint8_t*)field.pData + i * field.data_size);
+                }
+                continue;
+            case PB_HTYPE_OPTIONAL:
+                if (field.pSize) {
+                    *(bool*)field.pSize = true;
+                }
+                break;
+        }
+        fill_value(&field, field.pData);
+    } while (pb_field_iter_next(&field));
+}
+
+// Message being timed by `encode_message` and `decode_message`.
+static pb_msgdesc_t const* current;
+
+static void encode_message() {
+    pb_ostream_t os = pb_ostream_from_buffer(packed, packed_len);
+    if (!pb_encode(&os, current, message)) {
+        fprintf(stderr, "Cannot encode: %s\n", PB_GET_ERROR(&os));
+        exit(1);
+    }
+}
+
+static void decode_message() {
+    pb_istream_t is = pb_istream_from_buffer(packed, packed_len);
+    if (!pb_decode(&is, current, decoded)) {
+        fprintf(stderr, "Cannot decode: %s\n", PB_GET_ERROR(&is));
+        exit(1);
+    }
+}
+
+// Time encoding and decoding of the message in `message`.
+static void bench_message(char const* name, pb_msgdesc_t const* desc) {
+    char encode_name[64], decode_name[64];
+    snprintf(encode_name, sizeof(encode_name), "pb_encode %s", name);
+    snprintf(decode_name, sizeof(decode_name), "pb_decode %s", name);
+    if (!strstr(encode_name, filter) && !strstr(decode_name, filter)) {
+        return;
+    }
+    current = desc;
+    if (!pb_get_encoded_size(&packed_len, desc, message)) {
+        fprintf(stderr, "Cannot size %s\n", name);
+        exit(1);
+    }
+    packed = realloc(packed, packed_len ? packed_len : 1);
+    bench(encode_name, encode_message, packed_len);
+    bench(decode_name, decode_message, packed_len);
+}
+
+static void crc() {
+    sink = esp_crc32_le(0, data, 4096);
+}
+
+static void encode_oneshot() {
+    encoded_len = cobs_encode(encoded, data, sizeof(data));
+}
+
+static void decode_oneshot() {
+    sink = cobs_decode(scratch, encoded, encoded_len);
+}
+
+static void encode_stream() {
+    cobs_encoder_t enc;
+    cobs_encoder_init(&enc, encoded);
+    cobs_encoder_write(&enc, data, sizeof(data) - 4);
+    encoded_len = cobs_encoder_finish(&enc);
+}
+
+static void decode_stream() {
+    cobs_decoder_t dec;
+    cobs_decoder_init(&dec, scratch, sizeof(scratch));
+    cobs_decoder_feed(&dec, encoded, encoded_len);
+    sink = cobs_decoder_finish(&dec);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        budget = atof(argv[1]);
+    }
+    if (argc > 2) {
+        filter = argv[2];
+    }
+
+    // Random data, which has a zero every 256 bytes on average, like compressed chunks.
+    srand(0);
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+    memcpy(chunk_data, data, sizeof(chunk_data));
+
+    bench("esp_crc32_le", crc, 4096);
+    bench("cobs_encode", encode_oneshot, sizeof(data));
+    bench("cobs_decode", decode_oneshot, sizeof(data));
+    bench("cobs_encoder", encode_stream, sizeof(data) - 4);
+    // Checks the CRC32 as well, so the decoder's own work is the difference with cobs_decode plus esp_crc32_le.
+    bench("cobs_decoder", decode_stream, sizeof(data) - 4);
+
+#define BENCH_MESSAGE(name)                                                                                            \
+    memset(message, 0, sizeof(message));                                                                               \
+    fill(&badgelink_##name##_msg, message);                                                                            \
+    bench_message(#name, &badgelink_##name##_msg);
+    MESSAGES(BENCH_MESSAGE)
+#undef BENCH_MESSAGE
+
+    // Chunk data is a callback field the filler leaves empty, so time the packets that carry the most data too.
+    badgelink_Packet* packet = (badgelink_Packet*)message;
+    badgelink_Chunk   chunk  = {
+          .position = 1 << 20,
+          .data     = {.bytes = chunk_data, .size = sizeof(chunk_data)},
+    };
+    memset(message, 0, sizeof(message));
+    packet->serial                          = 1000;
+    packet->which_packet                    = badgelink_Packet_request_tag;
+    packet->packet.request.which_req        = badgelink_Request_upload_chunk_tag;
+    packet->packet.request.req.upload_chunk = chunk;
+    bench_message("Packet with upload chunk", &badgelink_Packet_msg);
+
+    memset(message, 0, sizeof(message));
+    packet->serial                              = 1000;
+    packet->which_packet                        = badgelink_Packet_response_tag;
+    packet->packet.response.which_resp          = badgelink_Response_download_chunk_tag;
+    packet->packet.response.resp.download_chunk = chunk;
+    bench_message("Packet with download chunk", &badgelink_Packet_msg);
+
+    free(packed);
+    return 0;
+}
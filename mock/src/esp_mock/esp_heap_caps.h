@@ -0,0 +1,30 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// The mock has one heap, so the capabilities are ignored.
+#define MALLOC_CAP_DEFAULT  (1 << 0)
+#define MALLOC_CAP_8BIT     (1 << 1)
+#define MALLOC_CAP_DMA      (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 4)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return malloc(size);
+}
+
+static inline void* heap_caps_calloc(size_t count, size_t size, uint32_t caps) {
+    return calloc(count, size);
+}
+
+static inline void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
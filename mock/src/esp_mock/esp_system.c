@@ -0,0 +1,9 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "esp_system.h"
+#include <stdlib.h>
+
+void esp_restart() {
+    exit(0);
+}
@@ -0,0 +1,7 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Restarting the mock exits it, like a badge that drops off the bus to start an app.
+void esp_restart();
@@ -0,0 +1,8 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,15 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "esp_vfs_fat.h"
+#include <sys/statvfs.h>
+
+esp_err_t esp_vfs_fat_info(char const* base_path, uint64_t* out_total_bytes, uint64_t* out_free_bytes) {
+    struct statvfs info;
+    if (statvfs(base_path, &info)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *out_total_bytes = (uint64_t)info.f_blocks * info.f_frsize;
+    *out_free_bytes  = (uint64_t)info.f_bfree * info.f_frsize;
+    return ESP_OK;
+}
@@ -0,0 +1,7 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include <stdint.h>
+#include "esp_err.h"
+
+esp_err_t esp_vfs_fat_info(char const* base_path, uint64_t* out_total_bytes, uint64_t* out_free_bytes);
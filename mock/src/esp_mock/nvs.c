@@ -7,32 +7,111 @@
 #include <stdlib.h>
 #include <string.h>
 
+// A namespace, with a circular list of its entries around a sentinel that has an empty key.
+typedef struct mock__ns mock__ns_t;
+struct mock__ns {
+    mock__ns_t* next;
+    char        name[NVS_NS_NAME_MAX_SIZE];
+    mock__ent_t sentinel;
+};
+
+struct mock__iter {
+    // Namespace to list, or NULL for all of them.
+    mock__ns_t* only;
+    mock__ns_t* ns;
+    mock__ent_t* cur;
+    nvs_type_t  type;
+};
+
+// Namespaces in the order they were created; the mock's NVS lives in memory only.
+static mock__ns_t* namespaces;
+
 /* ==== NVS read ==== */
 
+static mock__ns_t* nvs_ns_lookup(char const* namespace) {
+    for (mock__ns_t* ns = namespaces; ns; ns = ns->next) {
+        if (!strcmp(ns->name, namespace)) {
+            return ns;
+        }
+    }
+    return NULL;
+}
+
 esp_err_t nvs_open(char const* namespace, bool writeable, nvs_handle_t* out_handle) {
-    printf("TODO\n");
-    abort();
+    mock__ns_t* ns = nvs_ns_lookup(namespace);
+    if (!ns) {
+        if (!writeable) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        ns = calloc(1, sizeof(mock__ns_t));
+        strncpy(ns->name, namespace, sizeof(ns->name) - 1);
+        ns->sentinel.next = &ns->sentinel;
+        ns->sentinel.prev = &ns->sentinel;
+        // Append, so listings are in creation order.
+        mock__ns_t** tail = &namespaces;
+        while (*tail) {
+            tail = &(*tail)->next;
+        }
+        *tail = ns;
+    }
+    out_handle->sentinel = &ns->sentinel;
+    return ESP_OK;
 }
 void nvs_close(nvs_handle_t handle) {
-    printf("TODO\n");
-    abort();
+}
+
+// Move `iter` to the first entry at or after `iter->cur` that matches; returns false if there is none.
+static bool nvs_iter_settle(struct mock__iter* iter) {
+    while (iter->ns) {
+        while (*iter->cur->key) {
+            if (iter->type == NVS_TYPE_ANY || iter->cur->type == iter->type) {
+                return true;
+            }
+            iter->cur = iter->cur->next;
+        }
+        iter->ns = iter->only ? NULL : iter->ns->next;
+        if (iter->ns) {
+            iter->cur = iter->ns->sentinel.next;
+        }
+    }
+    return false;
 }
 
 esp_err_t nvs_entry_find(char const* part, char const* namespace, nvs_type_t type, nvs_iterator_t* out_iter) {
-    printf("TODO\n");
-    abort();
+    *out_iter              = NULL;
+    struct mock__iter iter = {.type = type};
+    if (namespace) {
+        iter.only = iter.ns = nvs_ns_lookup(namespace);
+    } else {
+        iter.ns = namespaces;
+    }
+    if (iter.ns) {
+        iter.cur = iter.ns->sentinel.next;
+    }
+    if (!nvs_iter_settle(&iter)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_iter  = malloc(sizeof(iter));
+    **out_iter = iter;
+    return ESP_OK;
 }
 void nvs_release_iterator(nvs_iterator_t iter) {
-    printf("TODO\n");
-    abort();
+    free(iter);
 }
 esp_err_t nvs_entry_info(nvs_iterator_t iter, nvs_entry_info_t* out_info) {
-    printf("TODO\n");
-    abort();
+    out_info->type = iter->cur->type;
+    strcpy(out_info->namespace_name, iter->ns->name);
+    strcpy(out_info->key, iter->cur->key);
+    return ESP_OK;
 }
 esp_err_t nvs_entry_next(nvs_iterator_t* iter) {
-    printf("TODO\n");
-    abort();
+    (*iter)->cur = (*iter)->cur->next;
+    if (!nvs_iter_settle(*iter)) {
+        free(*iter);
+        *iter = NULL;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
 }
 
 static mock__ent_t* nvs_lookup(nvs_handle_t handle, char const* key) {
@@ -88,9 +167,8 @@ esp_err_t nvs_get_str(nvs_handle_t handle, char const* key, char* buffer, size_t
     if (*inout_length > ent->data.var.size) {
         *inout_length = ent->data.var.size;
     }
-    if (*inout_length) {
+    if (buffer && *inout_length) {
         memcpy(buffer, ent->data.var.data, *inout_length);
-        buffer[*inout_length] = 0;
     }
     *inout_length = ent->data.var.size;
     return ESP_OK;
@@ -104,7 +182,7 @@ esp_err_t nvs_get_blob(nvs_handle_t handle, char const* key, void* buffer, size_
     if (*inout_size > ent->data.var.size) {
         *inout_size = ent->data.var.size;
     }
-    if (*inout_size) {
+    if (buffer && *inout_size) {
         memcpy(buffer, ent->data.var.data, *inout_size);
     }
     *inout_size = ent->data.var.size;
@@ -114,8 +192,30 @@ esp_err_t nvs_get_blob(nvs_handle_t handle, char const* key, void* buffer, size_
 /* ==== NVS write ==== */
 
 static mock__ent_t* nvs_alloc(nvs_handle_t handle, char const* key) {
-    printf("TODO\n");
-    abort();
+    mock__ent_t* ent = nvs_lookup(handle, key);
+    if (ent) {
+        return ent;
+    }
+    ent = calloc(1, sizeof(mock__ent_t));
+    strncpy(ent->key, key, sizeof(ent->key) - 1);
+    ent->type             = NVS_TYPE_MAX;
+    ent->prev             = handle.sentinel->prev;
+    ent->next             = handle.sentinel;
+    ent->prev->next       = ent;
+    handle.sentinel->prev = ent;
+    return ent;
+}
+
+static esp_err_t nvs_set_var(nvs_handle_t handle, char const* key, void const* data, size_t size, nvs_type_t type) {
+    mock__ent_t* ent = nvs_alloc(handle, key);
+    if (ent->type == NVS_TYPE_STR || ent->type == NVS_TYPE_BLOB) {
+        free(ent->data.var.data);
+    }
+    ent->type          = type;
+    ent->data.var.data = malloc(size ? size : 1);
+    ent->data.var.size = size;
+    memcpy(ent->data.var.data, data, size);
+    return ESP_OK;
 }
 
 static esp_err_t nvs_set_scalar(nvs_handle_t handle, char const* key, void const* value, nvs_type_t type) {
@@ -154,19 +254,27 @@ esp_err_t nvs_set_i64(nvs_handle_t handle, char const* key, int64_t value) {
 }
 
 esp_err_t nvs_set_str(nvs_handle_t handle, char const* key, char* value) {
-    printf("TODO\n");
-    abort();
-    return 0;
+    return nvs_set_var(handle, key, value, strlen(value) + 1, NVS_TYPE_STR);
 }
 
 esp_err_t nvs_set_blob(nvs_handle_t handle, char const* key, void* data, size_t length) {
-    printf("TODO\n");
-    abort();
-    return 0;
+    return nvs_set_var(handle, key, data, length, NVS_TYPE_BLOB);
 }
 
 esp_err_t nvs_erase_key(nvs_handle_t handle, char const* key) {
-    printf("TODO\n");
-    abort();
-    return 0;
+    mock__ent_t* ent = nvs_lookup(handle, key);
+    if (!ent) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    ent->prev->next = ent->next;
+    ent->next->prev = ent->prev;
+    if (ent->type == NVS_TYPE_STR || ent->type == NVS_TYPE_BLOB) {
+        free(ent->data.var.data);
+    }
+    free(ent);
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return ESP_OK;
 }
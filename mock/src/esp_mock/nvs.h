@@ -2,6 +2,8 @@
 // SPDX-Copyright-Text: 2025 Julian Scheffers
 // SPDX-License-Identifier: MIT
 
+#pragma once
+
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -46,10 +48,7 @@ struct mock__ent {
     nvs_type_t type;
 };
 
-typedef struct {
-    char* namespace;
-    mock__ent_t* cur;
-} nvs_iterator_t;
+typedef struct mock__iter* nvs_iterator_t;
 
 typedef struct {
     mock__ent_t* sentinel;
@@ -92,3 +91,4 @@ esp_err_t nvs_set_str(nvs_handle_t handle, char const* key, char* value);
 esp_err_t nvs_set_blob(nvs_handle_t handle, char const* key, void* data, size_t length);
 
 esp_err_t nvs_erase_key(nvs_handle_t handle, char const* key);
+esp_err_t nvs_commit(nvs_handle_t handle);
@@ -0,0 +1,11 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include_next <string.h>
+
+// glibc only has strlcpy since 2.38; newlib, which ESP-IDF uses, has always had it.
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, char const* src, size_t size);
+#endif
@@ -0,0 +1,321 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+// Feeds frames through the BadgeLink frame handler and checks that every frame it sends back is well-formed.
+// Built with clang and -fsanitize=fuzzer, this is a libFuzzer target that takes a mode byte and a packet as input;
+// otherwise `main` mutates a few seed packets at random, like the other fuzz targets.
+// Requests that reach outside of `SANDBOX`, use AppFS (which the mock doesn't implement) or start an app are skipped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "badgelink.h"
+#include "badgelink_internal.h"
+#include "cobs.h"
+#include "esp_crc.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+// Directory FS requests are confined to, so the fuzzer can't touch any other files of the host.
+#define SANDBOX "/tmp/badgelink-fuzz/"
+
+// How the frame around the input packet is sent.
+typedef enum {
+    // Sent as is.
+    MODE_OK,
+    // Sent with a bit flipped, so the CRC32 doesn't match or the COBS is malformed.
+    MODE_FLIP,
+    // Sent without the last byte of data, then ended by an empty frame.
+    MODE_TRUNCATE,
+    MODE_COUNT,
+} frame_mode_t;
+
+// Packet decoded from the input, to check it is safe to send.
+static badgelink_Packet input;
+// Packet decoded from a response, on the TX thread.
+static badgelink_Packet output;
+static uint8_t          packed[BADGELINK_PACKET_MAX_SIZE + 4];
+static uint8_t          frame[BADGELINK_BUF_CAP + 1];
+static uint8_t          decoded[BADGELINK_BUF_CAP];
+// Serial number of the last request that was sent.
+static uint64_t         serial;
+
+// The mock FreeRTOS leaks the handles of tasks on purpose, and every transfer starts a storage task.
+char const* __lsan_default_suppressions() {
+    return "leak:task_alloc\n";
+}
+
+// Called from the BadgeLink TX thread with every frame the badge sends.
+static void check_response(uint8_t const* data, size_t len) {
+    cobs_decoder_t dec;
+    cobs_decoder_init(&dec, decoded, sizeof(decoded));
+    size_t consumed = cobs_decoder_feed(&dec, data, len);
+    if (consumed != len || !dec.complete || cobs_decoder_finish(&dec) != COBS_FRAME_OK) {
+        fprintf(stderr, "Badge sent a malformed %zu-byte frame\n", len);
+        abort();
+    }
+    pb_istream_t is = pb_istream_from_buffer(decoded, dec.len);
+    if (!pb_decode(&is, &badgelink_Packet_msg, &output)) {
+        fprintf(stderr, "Badge sent a %zu-byte packet that doesn't decode: %s\n", dec.len, PB_GET_ERROR(&is));
+        abort();
+    }
+}
+
+// Whether a request may use `path`.
+static bool sandboxed(char const* path) {
+    return !strncmp(path, SANDBOX, strlen(SANDBOX)) && !strstr(path, "..");
+}
+
+// Whether a decoded request is one the fuzzer may send.
+static bool request_allowed(badgelink_Request const* req) {
+    switch (req->which_req) {
+        case badgelink_Request_appfs_action_tag:
+        case badgelink_Request_start_app_tag:
+            return false;
+        case badgelink_Request_fs_action_tag:
+            return sandboxed(req->req.fs_action.path) &&
+                   (!req->req.fs_action.dest_path[0] || sandboxed(req->req.fs_action.dest_path));
+        case badgelink_Request_bench_req_tag:
+            return !req->req.bench_req.appfs && (!req->req.bench_req.path[0] || sandboxed(req->req.bench_req.path));
+        default:
+            return true;
+    }
+}
+
+static void fuzz_init() {
+    // The badge logs every error it runs into, which is most of them.
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("Cannot silence the log");
+    }
+    mkdir(SANDBOX, 0755);
+    badgelink_init();
+    badgelink_fuzz_start(check_response);
+}
+
+// Send one packet to the badge in a frame, mangled according to `mode`.
+// Returns false if the packet was skipped.
+static bool fuzz_packet(frame_mode_t mode, uint8_t const* data, size_t len) {
+    if (len > BADGELINK_PACKET_MAX_SIZE) {
+        return false;
+    }
+
+    // Anything that decodes is checked and sent with a fresh serial number, so it isn't dropped as a retransmission.
+    // Anything else can't do harm, since the badge decodes it the same way.
+    pb_istream_t is = pb_istream_from_buffer(data, len);
+    if (pb_decode(&is, &badgelink_Packet_msg, &input)) {
+        if (input.which_packet == badgelink_Packet_request_tag && !request_allowed(&input.packet.request)) {
+            return false;
+        }
+        input.serial    = ++serial;
+        pb_ostream_t os = pb_ostream_from_buffer(packed, sizeof(packed) - 4);
+        if (!pb_encode(&os, &badgelink_Packet_msg, &input)) {
+            return false;
+        }
+        len = os.bytes_written;
+    } else {
+        memcpy(packed, data, len);
+    }
+
+    cobs_encoder_t enc;
+    cobs_encoder_init(&enc, frame);
+    cobs_encoder_write(&enc, packed, len);
+    size_t frame_len = cobs_encoder_finish(&enc);
+    switch (mode) {
+        case MODE_FLIP:
+            frame[len % (frame_len - 1)] ^= 1 << (len % 8);
+            break;
+        case MODE_TRUNCATE:
+            frame[frame_len - 2] = 0;
+            frame_len--;
+            break;
+        default:
+            break;
+    }
+    // A corrupted code byte may swallow the terminator, so always end with an extra one.
+    frame[frame_len++] = 0;
+    badgelink_fuzz_rxdata(frame, frame_len);
+    return true;
+}
+
+#ifdef BADGELINK_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(uint8_t const* data, size_t len) {
+    static bool initialized;
+    if (!initialized) {
+        fuzz_init();
+        initialized = true;
+    }
+    if (len < 1) {
+        return -1;
+    }
+    return fuzz_packet(data[0] % MODE_COUNT, data + 1, len - 1) ? 0 : -1;
+}
+
+#else
+
+// Maximum number of seed packets.
+#define MAX_SEEDS 32
+
+static uint8_t seeds[MAX_SEEDS][512];
+static size_t  seed_lens[MAX_SEEDS];
+static size_t  seed_count;
+static uint8_t mutated[BADGELINK_PACKET_MAX_SIZE];
+
+// Add a request as a seed packet.
+static void seed(badgelink_Request req) {
+    badgelink_Packet packet = badgelink_Packet_init_zero;
+    packet.which_packet     = badgelink_Packet_request_tag;
+    packet.packet.request   = req;
+    pb_ostream_t os         = pb_ostream_from_buffer(seeds[seed_count], sizeof(seeds[0]));
+    if (!pb_encode(&os, &badgelink_Packet_msg, &packet)) {
+        fprintf(stderr, "Cannot encode seed %zu: %s\n", seed_count, PB_GET_ERROR(&os));
+        exit(1);
+    }
+    seed_lens[seed_count++] = os.bytes_written;
+}
+
+// Add a FS request as a seed packet.
+static void seed_fs(badgelink_FsActionType type, char const* path, uint32_t size) {
+    badgelink_Request req  = badgelink_Request_init_zero;
+    req.which_req          = badgelink_Request_fs_action_tag;
+    req.req.fs_action.type = type;
+    req.req.fs_action.size = size;
+    snprintf(req.req.fs_action.path, sizeof(req.req.fs_action.path), SANDBOX "%s", path);
+    seed(req);
+}
+
+static void make_seeds() {
+    static uint8_t    chunk_data[100];
+    badgelink_Request req = badgelink_Request_init_zero;
+
+    req.which_req                      = badgelink_Request_version_req_tag;
+    req.req.version_req.client_version = 6;
+    req.req.version_req.max_chunk_size = 4096;
+    req.req.version_req.compression    = badgelink_ChunkCompression_CompressionLzf;
+    req.req.version_req.digest         = badgelink_DigestType_DigestSha256;
+    seed(req);
+
+    seed_fs(badgelink_FsActionType_FsActionMkdir, "dir", 0);
+    seed_fs(badgelink_FsActionType_FsActionUpload, "dir/file", sizeof(chunk_data));
+    req                             = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req                   = badgelink_Request_upload_chunk_tag;
+    req.req.upload_chunk.data.bytes = chunk_data;
+    req.req.upload_chunk.data.size  = sizeof(chunk_data);
+    seed(req);
+    req               = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req     = badgelink_Request_xfer_ctrl_tag;
+    req.req.xfer_ctrl = badgelink_XferReq_XferFinish;
+    seed(req);
+    seed_fs(badgelink_FsActionType_FsActionStat, "dir/file", 0);
+    seed_fs(badgelink_FsActionType_FsActionCrc23, "dir/file", 0);
+    seed_fs(badgelink_FsActionType_FsActionList, "dir", 0);
+    seed_fs(badgelink_FsActionType_FsActionDownload, "dir/file", 0);
+    seed_fs(badgelink_FsActionType_FsActionSectorCrc32, "dir/file", 0);
+    seed_fs(badgelink_FsActionType_FsActionDelete, "dir/file", 0);
+    seed_fs(badgelink_FsActionType_FsActionRmdir, "dir", 0);
+    seed_fs(badgelink_FsActionType_FsActionGetUsage, "", 0);
+
+    req                     = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req           = badgelink_Request_nvs_action_tag;
+    req.req.nvs_action.type = badgelink_NvsActionType_NvsActionWrite;
+    strcpy(req.req.nvs_action.namespc, "fuzz");
+    strcpy(req.req.nvs_action.key, "key");
+    req.req.nvs_action.has_wdata            = true;
+    req.req.nvs_action.wdata.type           = badgelink_NvsValueType_NvsValueUint32;
+    req.req.nvs_action.wdata.which_val      = badgelink_NvsValue_numericval_tag;
+    req.req.nvs_action.wdata.val.numericval = 42;
+    seed(req);
+    req.req.nvs_action.type = badgelink_NvsActionType_NvsActionList;
+    seed(req);
+    req.req.nvs_action.type      = badgelink_NvsActionType_NvsActionExport;
+    req.req.nvs_action.has_wdata = false;
+    req.req.nvs_action.key[0]    = 0;
+    seed(req);
+
+    req                         = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req               = badgelink_Request_echo_req_tag;
+    req.req.echo_req.data.bytes = chunk_data;
+    req.req.echo_req.data.size  = sizeof(chunk_data);
+    req.req.echo_req.reply_size = 200;
+    seed(req);
+    req                              = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req                    = badgelink_Request_fs_stat_many_tag;
+    req.req.fs_stat_many.paths.bytes = (pb_byte_t*)SANDBOX "\0" SANDBOX "x\0";
+    req.req.fs_stat_many.paths.size  = sizeof(SANDBOX "\0" SANDBOX "x");
+    seed(req);
+    req           = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req = badgelink_Request_stats_req_tag;
+    seed(req);
+    req           = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req = badgelink_Request_trace_req_tag;
+    seed(req);
+    req.req.trace_req.offset = 100;
+    req.req.trace_req.clear  = true;
+    seed(req);
+    req           = (badgelink_Request)badgelink_Request_init_zero;
+    req.which_req = badgelink_Request_histogram_req_tag;
+    seed(req);
+    req.req.histogram_req.offset = 8;
+    req.req.histogram_req.reset  = true;
+    seed(req);
+}
+
+// Mutate a random seed into `mutated` and return its length.
+static size_t mutate() {
+    size_t i   = rand() % seed_count;
+    size_t len = seed_lens[i];
+    memcpy(mutated, seeds[i], len);
+    int mutations = rand() % 4;
+    for (int m = 0; m < mutations; m++) {
+        size_t pos = len ? rand() % len : 0;
+        switch (rand() % 4) {
+            case 0:
+                // Flip a bit.
+                if (len) {
+                    mutated[pos] ^= 1 << (rand() % 8);
+                }
+                break;
+            case 1:
+                // Replace a byte, often with one that's special in varints.
+                if (len) {
+                    mutated[pos] = rand() % 2 ? 0xff : rand();
+                }
+                break;
+            case 2:
+                // Insert a byte.
+                if (len < sizeof(mutated)) {
+                    memmove(mutated + pos + 1, mutated + pos, len - pos);
+                    mutated[pos] = rand();
+                    len++;
+                }
+                break;
+            default:
+                // Cut off the end.
+                len = pos;
+                break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 10000;
+    make_seeds();
+    fuzz_init();
+    long skipped = 0;
+    for (long iter = 0; iter < iterations; iter++) {
+        srand(iter);
+        // Mostly well-formed frames, since those get past the checks to the handlers.
+        frame_mode_t mode = rand() % 8 ? MODE_OK : 1 + rand() % (MODE_COUNT - 1);
+        size_t       len  = mutate();
+        if (!fuzz_packet(mode, mutated, len)) {
+            skipped++;
+        }
+    }
+
+    fprintf(stderr, "%ld iterations OK, %ld skipped\n", iterations, skipped);
+    return 0;
+}
+
+#endif
@@ -1,42 +1,300 @@
-
 // SPDX-Copyright-Text: 2025 Julian Scheffers
 // SPDX-License-Identifier: MIT
 
 #include "freertos/FreeRTOS.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+#include <time.h>
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+
+struct mock__task {
+    pthread_t       thread;
+    void            (*main_func)(void*);
+    void*           arg;
+    UBaseType_t     prio;
+    // Task notification value, protected by `lock`.
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        notify;
+};
+
+struct mock__queue {
+    pthread_mutex_t lock;
+    // Signalled whenever an item is added or removed.
+    pthread_cond_t  cond;
+    size_t          cap;
+    size_t          ent_size;
+    size_t          head;
+    size_t          count;
+    uint8_t*        data;
+};
 
-typedef struct {
-    uint8_t data[31];
-    uint8_t len;
-} fragment_t;
+struct mock__stream_buffer {
+    pthread_mutex_t lock;
+    // Signalled whenever data is added or removed.
+    pthread_cond_t  cond;
+    size_t          cap;
+    size_t          trigger_level;
+    size_t          head;
+    size_t          count;
+    uint8_t*        data;
+};
 
-extern void (*mock__thread_func)(void*);
-extern FILE* mock__infd;
+// Task the calling thread runs, or NULL if it wasn't started by `xTaskCreate` and didn't need one yet.
+static __thread TaskHandle_t current_task;
+
+// Get the time `ticks` from now to wait until.
+static struct timespec deadline(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+// Wait for `cond` until `until`, or forever if `ticks` is `portMAX_DELAY`.
+// Returns false if the time ran out.
+static bool wait(pthread_cond_t* cond, pthread_mutex_t* lock, TickType_t ticks, struct timespec const* until) {
+    if (ticks == 0) {
+        return false;
+    } else if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, until) != ETIMEDOUT;
+}
+
+/* ==== Tasks ==== */
+
+static TaskHandle_t task_alloc(void (*main_func)(void*), void* arg, UBaseType_t prio) {
+    TaskHandle_t task = calloc(1, sizeof(struct mock__task));
+    task->main_func   = main_func;
+    task->arg         = arg;
+    task->prio        = prio;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    return task;
+}
+
+static void* task_main(void* arg) {
+    current_task = arg;
+    current_task->main_func(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*main_func)(void*), char const* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* out_handle, BaseType_t core) {
+    TaskHandle_t task = task_alloc(main_func, arg, prio);
+    if (out_handle) {
+        *out_handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_main, task)) {
+        perror("Cannot create task");
+        abort();
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(void (*main_func)(void*), char const* name, uint32_t stack_depth, void* arg, UBaseType_t prio,
+                       TaskHandle_t* out_handle) {
+    return xTaskCreatePinnedToCore(main_func, name, stack_depth, arg, prio, out_handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL && task != current_task) {
+        printf("TODO: Deleting another task\n");
+        abort();
+    }
+    // The handle is leaked, since other tasks may still refer to it.
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = {.tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+}
+
+TickType_t xTaskGetTickCount() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (!current_task) {
+        current_task         = task_alloc(NULL, NULL, 1);
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t prio) {
+    (task ? task : xTaskGetCurrentTaskHandle())->prio = prio;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return (task ? task : xTaskGetCurrentTaskHandle())->prio;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    TaskHandle_t    task  = xTaskGetCurrentTaskHandle();
+    struct timespec until = deadline(ticks);
+    pthread_mutex_lock(&task->lock);
+    while (!task->notify && wait(&task->cond, &task->lock, ticks, &until));
+    uint32_t value = task->notify;
+    if (value) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+/* ==== Queues and semaphores ==== */
 
 QueueHandle_t xQueueCreate(size_t cap, size_t ent_size) {
-    return 1;
+    QueueHandle_t queue = calloc(1, sizeof(struct mock__queue));
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    queue->cap      = cap;
+    queue->ent_size = ent_size;
+    queue->data     = malloc(cap * ent_size + 1);
+    return queue;
 }
 
-int xQueueSend(QueueHandle_t queue, void const* message, uint64_t delay) {
-    __builtin_trap();
+BaseType_t xQueueSend(QueueHandle_t queue, void const* message, TickType_t ticks) {
+    struct timespec until = deadline(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->cap) {
+        if (!wait(&queue->cond, &queue->lock, ticks, &until)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    size_t index = (queue->head + queue->count) % queue->cap;
+    if (queue->ent_size) {
+        memcpy(queue->data + index * queue->ent_size, message, queue->ent_size);
+    }
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
 }
 
-int xQueueReceive(QueueHandle_t queue, void* message, uint64_t delay) {
-    fragment_t frag;
-    while ((frag.len = fread(frag.data, 1, sizeof(frag.data), mock__infd)) == 0) {
-        if (feof(mock__infd)) {
-            exit(0);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* message, TickType_t ticks) {
+    struct timespec until = deadline(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!wait(&queue->cond, &queue->lock, ticks, &until)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
         }
-        usleep(100000);
     }
-    memcpy(message, &frag, sizeof(frag));
-    return 1;
+    if (queue->ent_size) {
+        memcpy(message, queue->data + queue->head * queue->ent_size, queue->ent_size);
+    }
+    queue->head = (queue->head + 1) % queue->cap;
+    queue->count--;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue->data);
+    free(queue);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    SemaphoreHandle_t sem = xQueueCreate(max_count, 0);
+    sem->count            = initial_count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+/* ==== Stream buffers ==== */
+
+StreamBufferHandle_t xStreamBufferCreate(size_t cap, size_t trigger_level) {
+    StreamBufferHandle_t stream = calloc(1, sizeof(struct mock__stream_buffer));
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+    stream->cap           = cap;
+    stream->trigger_level = trigger_level ? trigger_level : 1;
+    stream->data          = malloc(cap);
+    return stream;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t stream, void const* data, size_t len, TickType_t ticks) {
+    struct timespec until = deadline(ticks);
+    pthread_mutex_lock(&stream->lock);
+    // Like FreeRTOS, wait for room for all of the data, but send what fits if the time runs out.
+    while (stream->cap - stream->count < len && wait(&stream->cond, &stream->lock, ticks, &until));
+    size_t space = stream->cap - stream->count;
+    if (len > space) {
+        len = space;
+    }
+    for (size_t i = 0; i < len; i++) {
+        stream->data[(stream->head + stream->count + i) % stream->cap] = ((uint8_t const*)data)[i];
+    }
+    stream->count += len;
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    return len;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t stream, void* data, size_t len, TickType_t ticks) {
+    struct timespec until = deadline(ticks);
+    pthread_mutex_lock(&stream->lock);
+    while (stream->count < stream->trigger_level && wait(&stream->cond, &stream->lock, ticks, &until));
+    if (len > stream->count) {
+        len = stream->count;
+    }
+    for (size_t i = 0; i < len; i++) {
+        ((uint8_t*)data)[i] = stream->data[(stream->head + i) % stream->cap];
+    }
+    stream->head   = (stream->head + len) % stream->cap;
+    stream->count -= len;
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    return len;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t stream) {
+    pthread_mutex_lock(&stream->lock);
+    size_t count = stream->count;
+    pthread_mutex_unlock(&stream->lock);
+    return count;
 }
 
-void xTaskCreate(void (*main_func)(void*), char const* name, size_t stack_depth, void* arg, int prio,
-                 TaskHandle_t* out_handle) {
-    mock__thread_func = main_func;
+void vStreamBufferDelete(StreamBufferHandle_t stream) {
+    pthread_mutex_destroy(&stream->lock);
+    pthread_cond_destroy(&stream->cond);
+    free(stream->data);
+    free(stream);
 }
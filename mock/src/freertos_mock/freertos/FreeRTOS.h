@@ -1,22 +1,32 @@
-
 // SPDX-Copyright-Text: 2025 Julian Scheffers
 // SPDX-License-Identifier: MIT
 
+#pragma once
+
 #include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
-typedef pthread_t TaskHandle_t;
-typedef int       QueueHandle_t;
-
-#define portMAX_DELAY UINT64_MAX
-#define pdTRUE        1
-#define pdFALSE       0
+// Tasks are pthreads and ticks are milliseconds.
+typedef struct mock__task*          TaskHandle_t;
+typedef struct mock__queue*         QueueHandle_t;
+typedef struct mock__stream_buffer* StreamBufferHandle_t;
+typedef uint32_t                    TickType_t;
+typedef int                         BaseType_t;
+typedef unsigned                    UBaseType_t;
 
-QueueHandle_t xQueueCreate(size_t cap, size_t ent_size);
-int           xQueueReceive(QueueHandle_t queue, void* message, uint64_t delay);
-int           xQueueSend(QueueHandle_t queue, void const* message, uint64_t delay);
+#define portMAX_DELAY        UINT32_MAX
+#define portTICK_PERIOD_MS   1
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms))
+#define pdTRUE               1
+#define pdFALSE              0
+#define pdPASS               pdTRUE
+#define pdFAIL               pdFALSE
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY       0x7fffffff
 
-void xTaskCreate(void (*main_func)(void*), char const* name, size_t stack_depth, void* arg, int prio,
-                 TaskHandle_t* out_handle);
+// The mock doesn't know which core a thread runs on.
+static inline BaseType_t xPortGetCoreID() {
+    return 0;
+}
@@ -0,0 +1,12 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+QueueHandle_t xQueueCreate(size_t cap, size_t ent_size);
+BaseType_t    xQueueSend(QueueHandle_t queue, void const* message, TickType_t ticks);
+BaseType_t    xQueueReceive(QueueHandle_t queue, void* message, TickType_t ticks);
+void          vQueueDelete(QueueHandle_t queue);
@@ -0,0 +1,18 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "queue.h"
+
+// Semaphores are queues of empty items, like in FreeRTOS.
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+// Mutexes aren't recursive and have no priority inheritance.
+SemaphoreHandle_t xSemaphoreCreateMutex();
+
+#define xSemaphoreTake(sem, ticks) xQueueReceive((sem), NULL, (ticks))
+#define xSemaphoreGive(sem)        xQueueSend((sem), NULL, 0)
+#define vSemaphoreDelete(sem)      vQueueDelete(sem)
@@ -0,0 +1,12 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+StreamBufferHandle_t xStreamBufferCreate(size_t cap, size_t trigger_level);
+size_t               xStreamBufferSend(StreamBufferHandle_t stream, void const* data, size_t len, TickType_t ticks);
+size_t               xStreamBufferReceive(StreamBufferHandle_t stream, void* data, size_t len, TickType_t ticks);
+size_t               xStreamBufferBytesAvailable(StreamBufferHandle_t stream);
+void                 vStreamBufferDelete(StreamBufferHandle_t stream);
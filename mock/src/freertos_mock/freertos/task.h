@@ -0,0 +1,23 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Priorities are remembered but don't affect scheduling, and the core is ignored.
+BaseType_t xTaskCreatePinnedToCore(void (*main_func)(void*), char const* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* out_handle, BaseType_t core);
+BaseType_t xTaskCreate(void (*main_func)(void*), char const* name, uint32_t stack_depth, void* arg, UBaseType_t prio,
+                       TaskHandle_t* out_handle);
+// Only deleting the calling task is supported.
+void       vTaskDelete(TaskHandle_t task);
+void       vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+void         vTaskPrioritySet(TaskHandle_t task, UBaseType_t prio);
+UBaseType_t  uxTaskPriorityGet(TaskHandle_t task);
+
+uint32_t   ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
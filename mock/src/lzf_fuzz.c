@@ -0,0 +1,60 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+// Checks that LZF compression round-trips on random data and that decompressing random garbage is safe.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lzf.h"
+
+#define MAX_LEN 32768
+
+static uint8_t  input[MAX_LEN];
+static uint8_t  compressed[MAX_LEN];
+static uint8_t  decompressed[MAX_LEN];
+static uint16_t htab[LZF_HTAB_SIZE];
+
+static void fail(char const* what, size_t len, unsigned seed) {
+    printf("Mismatch in %s for %zu-byte input (seed %u)\n", what, len, seed);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 10000;
+    for (long iter = 0; iter < iterations; iter++) {
+        unsigned seed = iter;
+        srand(seed);
+
+        // Random length and alphabet size, so both incompressible data and long repeats are covered.
+        size_t len      = rand() % (MAX_LEN + 1);
+        int    alphabet = 1 + rand() % 256;
+        for (size_t i = 0; i < len; i++) {
+            input[i] = rand() % alphabet;
+        }
+
+        // Compressing must round-trip, or report that it doesn't fit.
+        size_t cap      = rand() % 2 ? len : rand() % (len + 1);
+        size_t comp_len = lzf_compress(compressed, cap, input, len, htab);
+        if (comp_len > cap) {
+            fail("compress", len, seed);
+        } else if (comp_len) {
+            size_t dec_len;
+            if (!lzf_decompress(decompressed, sizeof(decompressed), &dec_len, compressed, comp_len) ||
+                dec_len != len || memcmp(decompressed, input, len)) {
+                fail("decompress", len, seed);
+            }
+
+            // Too small an output buffer must be detected.
+            if (len && lzf_decompress(decompressed, len - 1, &dec_len, compressed, comp_len)) {
+                fail("decompress overflow", len, seed);
+            }
+        }
+
+        // Garbage must not be decompressed out of bounds; the sanitizers catch that.
+        size_t dec_len;
+        lzf_decompress(decompressed, rand() % (MAX_LEN + 1), &dec_len, input, len);
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -1,63 +1,261 @@
-
 // SPDX-Copyright-Text: 2025 Julian Scheffers
 // SPDX-License-Identifier: MIT
 
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
-#include <sched.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <termios.h>
 #include <unistd.h>
 #include "badgelink.h"
+#include "sim.h"
 
 static void help(char const* name) {
-    printf("Usage: %s <port> OR %s <input> <output>\n", name, name);
+    printf("Usage: %s [options] <port> OR %s [options] <input> <output>\n", name, name);
     printf("Badgelink test setup\n");
+    printf("Options to simulate the timing of a badge:\n");
+    mock_sim_help();
+}
+
+static int infd;
+static int outfd;
+// The simulated USB link in each direction, if USB timing is simulated.
+static mock_sim_link_t* tx_link;
+static mock_sim_link_t* rx_link;
+
+// Write all of `data` to the host.
+static void write_all(uint8_t const* data, size_t len) {
+    while (len) {
+        ssize_t sent = write(outfd, data, len);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Cannot write to host");
+            _exit(1);
+        }
+        data += sent;
+        len  -= sent;
+    }
+}
+
+// Send data to the host; called from the BadgeLink TX thread.
+static void send_data(uint8_t const* data, size_t len) {
+    if (tx_link) {
+        mock_sim_link_put(tx_link, data, len);
+    } else {
+        write_all(data, len);
+    }
+}
+
+// Frames passed to the USB driver thread at once.
+typedef struct usb_xfer {
+    struct usb_xfer*       next;
+    void*                  token;
+    size_t                 count;
+    badgelink_tx_segment_t segments[];
+} usb_xfer_t;
+
+static pthread_mutex_t usb_mtx  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  usb_cond = PTHREAD_COND_INITIALIZER;
+static usb_xfer_t*     usb_head;
+static usb_xfer_t*     usb_tail;
+static bool            usb_closed;
+
+// Queue frames for the USB driver thread, which sends them from the TX buffers like a USB stack with DMA does.
+// Called from the BadgeLink TX thread.
+static void send_data_async(badgelink_tx_segment_t const* segments, size_t count, void* token) {
+    usb_xfer_t* xfer = malloc(sizeof(usb_xfer_t) + count * sizeof(badgelink_tx_segment_t));
+    if (!xfer) {
+        perror("Cannot send to host");
+        _exit(1);
+    }
+    xfer->next  = NULL;
+    xfer->token = token;
+    xfer->count = count;
+    memcpy(xfer->segments, segments, count * sizeof(badgelink_tx_segment_t));
+
+    pthread_mutex_lock(&usb_mtx);
+    if (usb_tail) {
+        usb_tail->next = xfer;
+    } else {
+        usb_head = xfer;
+    }
+    usb_tail = xfer;
+    pthread_cond_signal(&usb_cond);
+    pthread_mutex_unlock(&usb_mtx);
+}
+
+// Send the frames queued by `send_data_async` and tell BadgeLink when they're out of its buffers.
+static void* usb_task(void* arg) {
+    while (1) {
+        pthread_mutex_lock(&usb_mtx);
+        while (!usb_head && !usb_closed) {
+            pthread_cond_wait(&usb_cond, &usb_mtx);
+        }
+        usb_xfer_t* xfer = usb_head;
+        if (xfer) {
+            usb_head = xfer->next;
+            if (!usb_head) {
+                usb_tail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&usb_mtx);
+        if (!xfer) {
+            return NULL;
+        }
+
+        for (size_t i = 0; i < xfer->count; i++) {
+            send_data(xfer->segments[i].data, xfer->segments[i].len);
+        }
+        badgelink_tx_complete(xfer->token);
+        free(xfer);
+    }
 }
 
-void (*mock__thread_func)(void*);
-FILE* mock__infd;
-FILE* mock__outfd;
+// Wait for sent data to have left; a serial port drains its output, and pipes and files have it once written.
+static bool flush_data(uint32_t timeout_ms) {
+    if (tx_link && !mock_sim_link_drain(tx_link, timeout_ms)) {
+        return false;
+    }
+    return tcdrain(outfd) == 0 || errno == ENOTTY;
+}
 
-void usb_send_data(uint8_t const* data, size_t len) {
-    fwrite(data, 1, len, mock__outfd);
+// Read data from the host, returning 0 once the host closed the connection.
+static size_t read_host(uint8_t* buf, size_t max) {
+    while (1) {
+        ssize_t len = read(infd, buf, max);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        return len > 0 ? len : 0;
+    }
+}
+
+// Carry data over the simulated USB link to the host.
+static void* tx_link_task(void* arg) {
+    uint8_t buf[4096];
+    size_t  len;
+    while ((len = mock_sim_link_get(tx_link, buf, sizeof(buf)))) {
+        write_all(buf, len);
+    }
+    return NULL;
+}
+
+// Carry data from the host over the simulated USB link.
+static void* rx_link_task(void* arg) {
+    uint8_t buf[4096];
+    size_t  len;
+    while ((len = read_host(buf, sizeof(buf)))) {
+        mock_sim_link_put(rx_link, buf, len);
+    }
+    mock_sim_link_close(rx_link);
+    return NULL;
+}
+
+// Writes to files stand in for the SD card; the mock badge is linked with `--wrap=fwrite` to make them as slow.
+size_t __real_fwrite(void const* ptr, size_t size, size_t n, FILE* stream);
+size_t __wrap_fwrite(void const* ptr, size_t size, size_t n, FILE* stream) {
+    size_t res = __real_fwrite(ptr, size, n, stream);
+    if (stream != stdout && stream != stderr && (mock_sim.sd_write_us || mock_sim.sd_write_kib_us)) {
+        mock_sim_sleep(mock_sim.sd_write_us + (uint64_t)size * res * mock_sim.sd_write_kib_us / 1024);
+    }
+    return res;
 }
 
 int main(int argc, char** argv) {
+    char const* name = *argv;
+    while (argc > 1 && !strncmp(argv[1], "--", 2)) {
+        if (!strcmp(argv[1], "--help")) {
+            help(name);
+            return 0;
+        } else if (!mock_sim_option(argv[1])) {
+            fprintf(stderr, "Invalid option: %s\n", argv[1]);
+            help(name);
+            return 1;
+        }
+        argc--;
+        argv++;
+    }
     if (argc != 2 && argc != 3) {
-        help(*argv);
+        help(name);
+        return 1;
     }
 
     if (argc == 2) {
-        mock__infd  = fopen(argv[1], "r+b");
-        mock__outfd = mock__infd;
-        if (!mock__infd) {
+        infd  = open(argv[1], O_RDWR | O_NOCTTY);
+        outfd = infd;
+        if (infd < 0) {
             perror("Cannot open serial port");
             return 1;
         }
     } else {
-        mock__infd = fopen(argv[1], "rb");
-        if (!mock__infd) {
+        infd = open(argv[1], O_RDONLY);
+        if (infd < 0) {
             perror("Cannot open input file");
             return 1;
         }
-        mock__outfd = fopen(argv[2], "wb");
-        if (!mock__outfd) {
+        outfd = open(argv[2], O_WRONLY);
+        if (outfd < 0) {
             perror("Cannot open output file");
             return 1;
         }
     }
 
     struct termios attr;
-    tcgetattr(mock__infd->_fileno, &attr);
-    cfmakeraw(&attr);
-    tcsetattr(mock__infd->_fileno, TCSANOW, &attr);
-    fcntl(mock__infd->_fileno, F_SETFL, O_NONBLOCK);
+    if (tcgetattr(infd, &attr) == 0) {
+        cfmakeraw(&attr);
+        tcsetattr(infd, TCSANOW, &attr);
+    }
+
+    pthread_t tx_thread, rx_thread, usb_thread;
+    if (pthread_create(&usb_thread, NULL, usb_task, NULL)) {
+        perror("Cannot start USB driver");
+        return 1;
+    }
+    if (mock_sim.usb_bandwidth || mock_sim.usb_latency_us) {
+        tx_link = mock_sim_link_create();
+        rx_link = mock_sim_link_create();
+        if (!tx_link || !rx_link || pthread_create(&tx_thread, NULL, tx_link_task, NULL) ||
+            pthread_create(&rx_thread, NULL, rx_link_task, NULL)) {
+            perror("Cannot simulate USB");
+            return 1;
+        }
+    }
 
     badgelink_init();
-    badgelink_start();
+    badgelink_start(send_data);
+    badgelink_set_async_send_callback(send_data_async);
+    badgelink_set_flush_callback(flush_data);
 
-    mock__thread_func(NULL);
+    // Pass received data on like a USB driver would, waiting for room in the RX buffer instead of dropping it.
+    uint8_t buf[4096];
+    while (1) {
+        size_t len = rx_link ? mock_sim_link_get(rx_link, buf, sizeof(buf)) : read_host(buf, sizeof(buf));
+        if (!len) {
+            // The host closed the connection.
+            break;
+        }
+        for (size_t pos = 0; pos < len;) {
+            pos += badgelink_rxdata_cb_timeout(buf + pos, len - pos, 1000);
+        }
+    }
 
+    // Stopping waits for the USB driver to send the last responses.
+    badgelink_stop();
+    pthread_mutex_lock(&usb_mtx);
+    usb_closed = true;
+    pthread_cond_signal(&usb_cond);
+    pthread_mutex_unlock(&usb_mtx);
+    pthread_join(usb_thread, NULL);
+    if (tx_link) {
+        // Let the responses still on their way arrive.
+        mock_sim_link_close(tx_link);
+        pthread_join(tx_thread, NULL);
+        pthread_join(rx_thread, NULL);
+    }
     return 0;
 }
@@ -0,0 +1,219 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#include "sim.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Data a USB driver holds on to before the sender has to wait for it to go out.
+#define USB_FIFO_SIZE 4096
+
+mock_sim_t mock_sim;
+
+// Timing of a typical badge: an ESP32-S3 on full speed USB CDC with a quad SPI NOR flash and an SD card over SPI.
+static mock_sim_t const realistic = {
+    // Full speed USB tops out at about 1 MB/s for bulk transfers, and a transfer waits for the next 1 ms frame.
+    .usb_bandwidth    = 1000000,
+    .usb_latency_us   = 1000,
+    // Typical sector erase and page program times from SPI NOR flash datasheets.
+    .flash_erase_us   = 45000,
+    .flash_program_us = 700,
+    // An SD card in SPI mode spends about a millisecond per write and manages about 10 MB/s.
+    .sd_write_us      = 1000,
+    .sd_write_kib_us  = 100,
+};
+
+static struct {
+    char const* name;
+    uint32_t*   value;
+    char const* help;
+} const options[] = {
+    {"usb-bandwidth", &mock_sim.usb_bandwidth, "USB bytes per second in each direction"},
+    {"usb-latency", &mock_sim.usb_latency_us, "USB latency in microseconds"},
+    {"flash-erase", &mock_sim.flash_erase_us, "Microseconds per 4 KiB flash sector erased"},
+    {"flash-program", &mock_sim.flash_program_us, "Microseconds per 256-byte flash page programmed"},
+    {"sd-write", &mock_sim.sd_write_us, "Microseconds per write to a file"},
+    {"sd-write-kib", &mock_sim.sd_write_kib_us, "Microseconds per KiB written to a file"},
+};
+
+bool mock_sim_option(char const* arg) {
+    if (!strcmp(arg, "--realistic")) {
+        mock_sim = realistic;
+        return true;
+    }
+    if (strncmp(arg, "--", 2)) {
+        return false;
+    }
+    arg += 2;
+    for (size_t i = 0; i < sizeof(options) / sizeof(*options); i++) {
+        size_t len = strlen(options[i].name);
+        if (strncmp(arg, options[i].name, len) || arg[len] != '=') {
+            continue;
+        }
+        char*         end;
+        unsigned long value = strtoul(arg + len + 1, &end, 0);
+        if (end == arg + len + 1 || *end || value > UINT32_MAX) {
+            return false;
+        }
+        *options[i].value = value;
+        return true;
+    }
+    return false;
+}
+
+void mock_sim_help() {
+    printf("  --realistic          Simulate the timing of a typical badge\n");
+    for (size_t i = 0; i < sizeof(options) / sizeof(*options); i++) {
+        printf("  --%s=N%*s%s\n", options[i].name, (int)(17 - strlen(options[i].name)), "", options[i].help);
+    }
+}
+
+static uint64_t now_us() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+static struct timespec to_timespec(uint64_t us) {
+    return (struct timespec){
+        .tv_sec  = us / 1000000,
+        .tv_nsec = us % 1000000 * 1000,
+    };
+}
+
+void mock_sim_sleep(uint64_t us) {
+    if (!us) {
+        return;
+    }
+    struct timespec until = to_timespec(now_us() + us);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR);
+}
+
+// Data on its way over the link.
+typedef struct link_seg {
+    struct link_seg* next;
+    // When the last byte arrives.
+    uint64_t         due_us;
+    size_t           len;
+    size_t           pos;
+    uint8_t          data[];
+} link_seg_t;
+
+struct mock_sim_link {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+    link_seg_t*     head;
+    link_seg_t*     tail;
+    // When the link is done sending everything put in so far.
+    uint64_t        busy_until_us;
+    bool            closed;
+};
+
+mock_sim_link_t* mock_sim_link_create() {
+    mock_sim_link_t* link = calloc(1, sizeof(mock_sim_link_t));
+    if (!link) {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&link->mtx, NULL);
+    pthread_cond_init(&link->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return link;
+}
+
+void mock_sim_link_put(mock_sim_link_t* link, uint8_t const* data, size_t len) {
+    link_seg_t* seg = malloc(sizeof(link_seg_t) + len);
+    if (!seg) {
+        perror("Cannot simulate USB");
+        abort();
+    }
+    memcpy(seg->data, data, len);
+    seg->next = NULL;
+    seg->len  = len;
+    seg->pos  = 0;
+
+    pthread_mutex_lock(&link->mtx);
+    uint64_t now = now_us();
+    if (link->busy_until_us < now) {
+        link->busy_until_us = now;
+    }
+    if (mock_sim.usb_bandwidth) {
+        link->busy_until_us += len * 1000000ULL / mock_sim.usb_bandwidth;
+    }
+    seg->due_us = link->busy_until_us + mock_sim.usb_latency_us;
+    if (link->tail) {
+        link->tail->next = seg;
+    } else {
+        link->head = seg;
+    }
+    link->tail = seg;
+    pthread_cond_broadcast(&link->cond);
+    uint64_t busy_until = link->busy_until_us;
+    pthread_mutex_unlock(&link->mtx);
+
+    // Wait while more than the FIFO is still waiting to go out.
+    if (mock_sim.usb_bandwidth) {
+        uint64_t fifo_us = USB_FIFO_SIZE * 1000000ULL / mock_sim.usb_bandwidth;
+        if (busy_until > now + fifo_us) {
+            mock_sim_sleep(busy_until - now - fifo_us);
+        }
+    }
+}
+
+size_t mock_sim_link_get(mock_sim_link_t* link, uint8_t* buf, size_t max) {
+    pthread_mutex_lock(&link->mtx);
+    while (!link->head && !link->closed) {
+        pthread_cond_wait(&link->cond, &link->mtx);
+    }
+    link_seg_t* seg = link->head;
+    if (!seg) {
+        pthread_mutex_unlock(&link->mtx);
+        return 0;
+    }
+    struct timespec due = to_timespec(seg->due_us);
+    while (now_us() < seg->due_us) {
+        pthread_cond_timedwait(&link->cond, &link->mtx, &due);
+    }
+
+    size_t len = seg->len - seg->pos;
+    if (len > max) {
+        len = max;
+    }
+    memcpy(buf, seg->data + seg->pos, len);
+    seg->pos += len;
+    if (seg->pos == seg->len) {
+        link->head = seg->next;
+        if (!link->head) {
+            link->tail = NULL;
+        }
+        free(seg);
+        pthread_cond_broadcast(&link->cond);
+    }
+    pthread_mutex_unlock(&link->mtx);
+    return len;
+}
+
+bool mock_sim_link_drain(mock_sim_link_t* link, uint32_t timeout_ms) {
+    struct timespec limit = to_timespec(now_us() + timeout_ms * 1000ULL);
+    pthread_mutex_lock(&link->mtx);
+    int res = 0;
+    while (link->head && res != ETIMEDOUT) {
+        res = pthread_cond_timedwait(&link->cond, &link->mtx, &limit);
+    }
+    bool drained = !link->head;
+    pthread_mutex_unlock(&link->mtx);
+    return drained;
+}
+
+void mock_sim_link_close(mock_sim_link_t* link) {
+    pthread_mutex_lock(&link->mtx);
+    link->closed = true;
+    pthread_cond_broadcast(&link->cond);
+    pthread_mutex_unlock(&link->mtx);
+}
@@ -0,0 +1,51 @@
+// SPDX-Copyright-Text: 2025 Julian Scheffers
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Timing of the hardware the mock badge stands in for, so protocol changes can be judged without a badge.
+// Everything is as fast as the host while these are all 0.
+typedef struct {
+    // Bytes per second the USB link carries in each direction, or 0 for no limit.
+    uint32_t usb_bandwidth;
+    // Time from data being sent on one end of the USB link until it arrives at the other, in microseconds.
+    uint32_t usb_latency_us;
+    // Time to erase a 4 KiB flash sector, in microseconds.
+    uint32_t flash_erase_us;
+    // Time to program a 256-byte flash page, in microseconds.
+    uint32_t flash_program_us;
+    // Time every write to a file takes on top of the host's, in microseconds.
+    uint32_t sd_write_us;
+    // Time every KiB written to a file takes on top of that, in microseconds.
+    uint32_t sd_write_kib_us;
+} mock_sim_t;
+
+extern mock_sim_t mock_sim;
+
+// Apply a `--name=value` command line option to `mock_sim`, or `--realistic` for the timing of a typical badge.
+// Returns false if `arg` isn't one of the options.
+bool mock_sim_option(char const* arg);
+// Print the options `mock_sim_option` takes.
+void mock_sim_help();
+// Sleep for `us` microseconds.
+void mock_sim_sleep(uint64_t us);
+
+// One direction of the simulated USB link, which delivers data `usb_latency_us` after it was sent and no faster than
+// `usb_bandwidth` allows.
+typedef struct mock_sim_link mock_sim_link_t;
+
+// Create one direction of the simulated USB link.
+mock_sim_link_t* mock_sim_link_create();
+// Send data over the link; blocks while the sender's FIFO is full, like a USB driver does.
+void             mock_sim_link_put(mock_sim_link_t* link, uint8_t const* data, size_t len);
+// Receive up to `max` bytes from the link, waiting until they arrive.
+// Returns 0 once the link is closed and everything sent before that was received.
+size_t           mock_sim_link_get(mock_sim_link_t* link, uint8_t* buf, size_t max);
+// Wait up to `timeout_ms` for everything sent to have been received; returns false if the time ran out.
+bool             mock_sim_link_drain(mock_sim_link_t* link, uint32_t timeout_ms);
+// Close the sending end of the link.
+void             mock_sim_link_close(mock_sim_link_t* link);
@@ -1,12 +1,18 @@
 #!/usr/bin/env python3
 
 # System libraries
+import io
+import hashlib
 import struct
 import time
 import os
 import sys
 import random
 import socket
+import select
+import threading
+import queue
+import json
 from serial import Serial, SerialException
 from cobs import cobs
 from zlib import crc32
@@ -18,6 +24,7 @@ from typing import BinaryIO
 # Custom libraries
 from libraries.badgelink_pb2 import *
 from libraries.device import BadgeUSB
+from libraries import lzf
 
 
 nvs_untypes = {
@@ -73,6 +80,16 @@ class CommunicationError(BadgelinkError):
     def __init__(self, reason):
         super().__init__(reason)
 
+class NakError(CommunicationError):
+    """
+    Raised if the badge reported that a frame it received was corrupted.
+    `serial` is that of the last request the badge handled before it, and `nak` says where its last upload is at.
+    """
+    def __init__(self, packet: Packet):
+        self.serial = packet.serial
+        self.nak = packet.nak
+        super().__init__("Badge received a corrupted frame")
+
 class DisconnectedError(BadgelinkError):
     """
     Raised if the badge has been disconnected and a request is made.
@@ -175,10 +192,19 @@ class DualPipeConnection:
     def read_all(self) -> bytes:
         return self.infd.read()
 
+    def read_wait(self, timeout: float) -> bytes:
+        # Block until data arrives instead of polling; only works with pipes on POSIX systems.
+        if not select.select([self.infd], [], [], timeout)[0]:
+            return b''
+        return os.read(self.infd.fileno(), 65536)
+
 
 class TCPConnection:
     def __init__(self, host: str, port: int):
         self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        # Large buffers keep whole upload windows and download bursts in flight.
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_SNDBUF, 1 << 20)
         self.sock.connect((host, port))
         self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
         self.sock.setblocking(False)
@@ -190,32 +216,51 @@ class TCPConnection:
         self.sock.sendall(data)
 
     def read_all(self) -> bytes:
-        data = b''
+        data = bytearray()
         while True:
             try:
-                chunk = self.sock.recv(32)
+                chunk = self.sock.recv(65536)
                 if not chunk:
                     break
                 data += chunk
             except BlockingIOError:
                 break
+        return bytes(data)
+
+    def read_wait(self, timeout: float) -> bytes:
+        if not select.select([self.sock], [], [], timeout)[0]:
+            return b''
+        data = self.sock.recv(65536)
+        if not data:
+            raise ConnectionResetError("Connection closed by badge")
         return data
 
 
 class BadgelinkConnection:
     """
     Helper class that deals with sending and receiving packets over Badgelink.
+    A background thread blocks on the connection and queues the frames it receives, so waiting for a response doesn't
+    keep a core busy, and several badges can be driven from one process with a thread for each.
     """
+    
+    # How often the reader thread checks whether it should stop.
+    READ_INTERVAL = 0.1
 
-    def __init__(self, conn: Serial|BadgeUSB|DualPipeConnection|TCPConnection):
+    def __init__(self, conn: Serial|BadgeUSB|DualPipeConnection|TCPConnection, hello: VersionReq = None):
         # Underlying serial bus connection.
         self.conn       = conn
-        # Received data buffer.
-        self.rxbuf      = b""
+        # Version request sent along with every sync, so the badge negotiates without another round trip.
+        self.hello      = hello
+        # Badge's answer to `hello` with the last sync, or `None` if it didn't answer it.
+        self.welcome    = None
+        # Frames received by the reader thread, or `None` once the badge has been disconnected.
+        self.rxqueue    = queue.Queue()
         # Serial number counter for requests.
         self.serial_no  = 0
         # Do not dump raw bytes by default.
         self.dump_raw   = False
+        # Tells the reader thread to stop.
+        self.closed     = False
         
         # Send a zero byte to deliminate from any previous data the badge might have seen.
         self.conn.write(b'\0')
@@ -223,22 +268,73 @@ class BadgelinkConnection:
         # Discard all the bytes previously sent by the badge.
         self.conn.read_all()
         
+        if isinstance(self.conn, Serial):
+            self.conn.timeout = self.READ_INTERVAL
+        self.reader = threading.Thread(target=self._reader_main, daemon=True)
+        self.reader.start()
+        
         # Send the initial sync packet.
         self.sync()
     
+    def close(self):
+        """
+        Stop the reader thread; the connection can't be used afterwards.
+        """
+        self.closed = True
+        self.reader.join()
+    
+    def _read_wait(self) -> bytes:
+        """
+        Wait up to `READ_INTERVAL` for data from the badge and return what arrived.
+        """
+        if isinstance(self.conn, Serial):
+            data = self.conn.read(1)
+            return data + self.conn.read(self.conn.in_waiting) if data else data
+        return self.conn.read_wait(self.READ_INTERVAL)
+    
+    def _reader_main(self):
+        """
+        Main function of the reader thread; splits the received data into frames and queues them.
+        """
+        # Start of a frame that hasn't been terminated yet.
+        rxbuf = bytearray()
+        while not self.closed:
+            try:
+                data = self._read_wait()
+            except (SerialException, USBError, OSError):
+                self.rxqueue.put(None)
+                return
+            if not data:
+                continue
+            if b'\0' not in data:
+                rxbuf += data
+                continue
+            # Only the new data is scanned, so every byte is looked at once however a frame arrives.
+            first, *frames, rest = data.split(b'\0')
+            if rxbuf:
+                rxbuf += first
+                first = bytes(rxbuf)
+            self.rxqueue.put(first)
+            for frame in frames:
+                self.rxqueue.put(frame)
+            rxbuf = bytearray(rest)
+    
     def sync(self, tries = 3):
         """
         Synchronize the serial number between the host and badge.
+        With `hello` set, the badge also negotiates the protocol version if it can, and its answer goes in `welcome`.
         """
         self.serial_no = random.randint(0, (1 << 32) - 1)
         last_err = None
         
         for _ in range(tries):
-            self.send_packet(Packet(serial=self.serial_no, sync=True))
+            self.send_packet(Packet(serial=self.serial_no, sync=True, hello=self.hello))
             try:
                 sync_resp = self.recv_packet(0.5)
                 if not sync_resp.sync or sync_resp.serial != self.serial_no:
                     raise CommunicationError("Invalid sync")
+                # Badges that don't know about it ignore the version request and answer with a plain sync.
+                self.welcome = sync_resp.welcome if sync_resp.HasField('welcome') else None
                 return
             except TimeoutError as e:
                 last_err = e
@@ -253,12 +349,13 @@ class BadgelinkConnection:
         - `DisconnectedError` if the badge has been disconnected.
         """
         ecc = struct.pack("<I", crc32(payload) & 0xffffffff)
+        frame = cobs.encode(payload + ecc)
         if self.dump_raw:
             print("TX payload: " + (payload + ecc).hex(' '))
-            print("TX frame: " + cobs.encode(payload + ecc).hex(' '))
+            print("TX frame: " + frame.hex(' '))
         try:
-            self.conn.write(cobs.encode(payload + ecc))
-            self.conn.write(b'\0')
+            # One write per frame, so it goes out in as few transfers as the link allows.
+            self.conn.write(frame + b'\0')
             self.conn.flush()
         except SerialException:
             raise DisconnectedError()
@@ -284,17 +381,15 @@ class BadgelinkConnection:
         - `CommunicationError` if the frame is too short, COBS decoding failed or the CRC32 is incorrect;
         - `DisconnectedError` if the badge has been disconnected.
         """
-        # Wait for a frame to be received.
-        timeout += time.time()
-        while time.time() < timeout:
-            self.rxbuf += self.conn.read_all()
-            zero = self.rxbuf.find(b'\0')
-            if zero != -1:
-                break
-        if zero == -1:
+        # Wait for the reader thread to receive a frame.
+        try:
+            buffer = self.rxqueue.get(timeout=timeout)
+        except queue.Empty:
             raise TimeoutError("Receive timed out")
-        buffer = self.rxbuf[:zero]
-        self.rxbuf = self.rxbuf[zero+1:]
+        if buffer is None:
+            # Leave the disconnect for the next call too.
+            self.rxqueue.put(None)
+            raise DisconnectedError()
         
         if self.dump_raw:
             print("RX frame: " + buffer.hex(' '))
@@ -333,22 +428,18 @@ class BadgelinkConnection:
         packet.ParseFromString(payload)
         return packet
     
-    def simple_request(self, request: Request|FsActionReq|AppfsActionReq|NvsActionReq|Chunk, to_find: str = None, timeout = 1, tries = 3) -> Response:
+    @staticmethod
+    def is_stale(serial: int, expected: int) -> bool:
         """
-        Perform a simple request; send one request packet and wait for its response.
-        Returns the response data on success.
-        
-        Raises an error if:
-        - `MalformedResponseError` if the response is missing;
-        - `BadgeInternalError` if the badge indicated an internal error;
-        - `MalformedRequestError` if (the badge indicated that) the request was malformed;
-        - `NotSupportedError` if the badge indicated it doesn't support the request;
-        - `NotFoundError` if the badge indicated it couldn't find the resource.
-        
-        If `to_find` is not `None` when `NotFoundError` is raised, the exception message will report `to_find` as the thing that was not found.
+        Whether `serial` belongs to a request sent before the one with serial `expected`.
+        """
+        return 0 < (expected - serial) % (1 << 32) < (1 << 31)
+    
+    @staticmethod
+    def to_request(request: Request|FsActionReq|AppfsActionReq|NvsActionReq|Chunk) -> Request:
+        """
+        Implicitly convert a request type to `Request`.
         """
-        
-        # Implicitly convert request type.
         if type(request) == FsActionReq:
             request = Request(fs_action=request)
         elif type(request) == AppfsActionReq:
@@ -361,8 +452,148 @@ class BadgelinkConnection:
             request = Request(start_app=request)
         elif type(request) == VersionReq:
             request = Request(version_req=request)
+        elif type(request) == StatsReq:
+            request = Request(stats_req=request)
+        elif type(request) == TraceReq:
+            request = Request(trace_req=request)
+        elif type(request) == HistogramReq:
+            request = Request(histogram_req=request)
+        elif type(request) == BenchReq:
+            request = Request(bench_req=request)
+        elif type(request) == EchoReq:
+            request = Request(echo_req=request)
+        elif type(request) == FsStatManyReq:
+            request = Request(fs_stat_many=request)
         elif type(request) != Request:
             raise TypeError("Invalid request type")
+        return request
+    
+    @staticmethod
+    def check_status(response: Response, to_find: str = None):
+        """
+        Raise the exception matching the response's status code, if it is not `StatusOk`.
+        """
+        match response.status_code:
+            case StatusCode.StatusOk: pass
+            case StatusCode.StatusInternalError: raise BadgeInternalError()
+            case StatusCode.StatusMalformed: raise MalformedRequestError()
+            case StatusCode.StatusNotSupported: raise NotSupportedError()
+            case StatusCode.StatusNotFound: raise NotFoundError(to_find)
+            case StatusCode.StatusIllegalState: raise IllegalStateError()
+            case StatusCode.StatusNoSpace: raise NoSpaceError()
+            case StatusCode.StatusNotEmpty: raise NotEmptyError()
+            case StatusCode.StatusIsFile: raise IsFileError()
+            case StatusCode.StatusIsDir: raise IsDirError()
+            case StatusCode.StatusExists: raise ExistsError()
+    
+    def send_request(self, request: Request|FsActionReq|AppfsActionReq|NvsActionReq|Chunk) -> int:
+        """
+        Send a request without waiting for its response.
+        Returns the serial number the response will carry.
+        """
+        self.serial_no = (self.serial_no + 1) % (1 << 32)
+        self.send_packet(Packet(request=self.to_request(request), serial=self.serial_no))
+        return self.serial_no
+    
+    def resend_request(self, request: Request|FsActionReq|AppfsActionReq|NvsActionReq|Chunk, serial: int):
+        """
+        Send a request again under the serial number it was sent with before.
+        The badge handles it if it didn't already, even after requests with a larger serial number.
+        """
+        self.send_packet(Packet(request=self.to_request(request), serial=serial))
+    
+    def recv_response(self, timeout = 1) -> Packet:
+        """
+        Wait for the next response packet to any request sent with `send_request`.
+        The caller is responsible for checking the status code.
+        
+        Raises an error if:
+        - `TimeoutError` if the timeout expired;
+        - `NakError` if the badge received a corrupted frame;
+        - `CommunicationError` if the frame was corrupted or the badge unexpectedly re-synced;
+        - `MalformedResponseError` if the packet is not a response.
+        """
+        resp_packet = self.recv_packet(timeout)
+        if resp_packet.sync:
+            raise CommunicationError("Unexpected sync")
+        elif resp_packet.HasField("nak"):
+            raise NakError(resp_packet)
+        elif not resp_packet.HasField("response"):
+            raise MalformedResponseError("Packet is missing response")
+        return resp_packet
+    
+    def pipeline(self, requests: list[Request|FsActionReq|AppfsActionReq|NvsActionReq], timeout = 1, window = 8, tries = 3) -> list[Response|BadgelinkError]:
+        """
+        Perform independent requests with up to `window` of them in flight, matching the responses by serial number.
+        The badge handles them in order, but the host doesn't wait for a response before sending the next request.
+        Requests must be safe to repeat, like stats and reads, because one whose response was lost is sent again.
+        Returns the response to each request, or the exception its status code maps to.
+        
+        Raises an error if:
+        - `TimeoutError` if a request got no response after `tries` tries;
+        - `CommunicationError` if the badge unexpectedly re-synced.
+        """
+        requests = [self.to_request(request) for request in requests]
+        results  = [None] * len(requests)
+        # Index and number of tries of each request in flight, by serial number.
+        pending  = {}
+        next_req = 0
+        while next_req < len(requests) or pending:
+            # Fill up the window.
+            while next_req < len(requests) and len(pending) < window:
+                pending[self.send_request(requests[next_req])] = (next_req, 1)
+                next_req += 1
+            
+            try:
+                packet = self.recv_packet(timeout)
+            except CommunicationError:
+                # A corrupted response; the request is sent again once the rest has been received.
+                continue
+            except TimeoutError:
+                # Requests or responses were lost; send what's missing again under new serial numbers.
+                for serial, (i, n) in list(pending.items()):
+                    del pending[serial]
+                    if n >= tries:
+                        raise
+                    pending[self.send_request(requests[i])] = (i, n + 1)
+                continue
+            if packet.sync:
+                raise CommunicationError("Unexpected sync")
+            elif packet.HasField("nak"):
+                # The badge got a corrupted frame after the request with this serial; it's the first one sent after it.
+                lost = [serial for serial in pending if self.is_stale(packet.serial, serial)]
+                if lost:
+                    serial = min(lost, key=lambda serial: (serial - packet.serial) % (1 << 32))
+                    self.resend_request(requests[pending[serial][0]], serial)
+                continue
+            elif packet.serial not in pending:
+                # Late response to a request that was sent again.
+                continue
+            
+            i, _ = pending.pop(packet.serial)
+            try:
+                self.check_status(packet.response)
+                results[i] = packet.response
+            except BadgelinkError as e:
+                results[i] = e
+        
+        return results
+    
+    def simple_request(self, request: Request|FsActionReq|AppfsActionReq|NvsActionReq|Chunk, to_find: str = None, timeout = 1, tries = 3) -> Response:
+        """
+        Perform a simple request; send one request packet and wait for its response.
+        Returns the response data on success.
+        
+        Raises an error if:
+        - `MalformedResponseError` if the response is missing;
+        - `BadgeInternalError` if the badge indicated an internal error;
+        - `MalformedRequestError` if (the badge indicated that) the request was malformed;
+        - `NotSupportedError` if the badge indicated it doesn't support the request;
+        - `NotFoundError` if the badge indicated it couldn't find the resource.
+        
+        If `to_find` is not `None` when `NotFoundError` is raised, the exception message will report `to_find` as the thing that was not found.
+        """
+        request = self.to_request(request)
         
         # Send request packet and wait for response.
         self.serial_no = (self.serial_no + 1) % (1 << 32)
@@ -372,12 +603,18 @@ class BadgelinkConnection:
             self.send_packet(req_packet)
             try:
                 resp_packet = self.recv_packet(timeout)
+                while not resp_packet.sync and (resp_packet.HasField("nak") or self.is_stale(resp_packet.serial, req_packet.serial)):
+                    if resp_packet.HasField("nak") and self.is_stale(resp_packet.serial, req_packet.serial):
+                        # The request was corrupted on the way; resend it without waiting for the timeout.
+                        raise NakError(resp_packet)
+                    # Left over response to an earlier pipelined request, or a NAK for a frame after this request.
+                    resp_packet = self.recv_packet(timeout)
                 if resp_packet.sync:
                     self.sync()
                 else:
                     last_err = None
                     break
-            except TimeoutError as e:
+            except (TimeoutError, NakError) as e:
                 last_err = e
         
         if last_err:
@@ -388,72 +625,463 @@ class BadgelinkConnection:
             raise CommunicationError(f"Serial mismatch; received {resp_packet.serial}, expected {req_packet.serial}")
         elif not resp_packet.response:
             raise MalformedResponseError("Packet is missing response")
-        match resp_packet.response.status_code:
-            case StatusCode.StatusOk: pass
-            case StatusCode.StatusInternalError: raise BadgeInternalError()
-            case StatusCode.StatusMalformed: raise MalformedRequestError()
-            case StatusCode.StatusNotSupported: raise NotSupportedError()
-            case StatusCode.StatusNotFound: raise NotFoundError(to_find)
-            case StatusCode.StatusIllegalState: raise IllegalStateError()
-            case StatusCode.StatusNoSpace: raise NoSpaceError()
-            case StatusCode.StatusNotEmpty: raise NotEmptyError()
-            case StatusCode.StatusIsFile: raise IsFileError()
-            case StatusCode.StatusIsDir: raise IsDirError()
-            case StatusCode.StatusExists: raise ExistsError()
-            
+        self.check_status(resp_packet.response, to_find)
+        
         return resp_packet.response
 
 
 class Badgelink:
-    CHUNK_MAX_SIZE = 4096
-    PROTOCOL_VERSION = 3
-
-    def __init__(self, conn: BadgelinkConnection|BadgeUSB|Serial, force_version1: bool = False):
-        if type(conn) != BadgelinkConnection:
-            conn = BadgelinkConnection(conn)
-        self.conn = conn
+    CHUNK_MAX_SIZE = 32768     # Largest chunk this client handles; the badge may allow less
+    DOWNLOAD_CREDITS = 16
+    PROTOCOL_VERSION = 7
+    NVS_BATCH_MAX = 24         # Most NVS operations the badge does in one request
+    FS_STAT_RESULT_MAX = 55    # Largest encoded stat result; the badge answers as many paths as fit in a chunk
+    PIPELINE_WINDOW = 8        # Requests in flight when pipelining; small enough for the badge's RX buffer
+    UPLOAD_BUFFER_MAX = 64 << 20  # Largest file read into memory for an upload, so it's only read from disk once
+    FS_TREE_DIR = 0            # Record types in a tree upload stream
+    FS_TREE_FILE = 1
+    FS_TREE_PATH_MAX = 255     # Longest path of a record in a tree upload stream
+
+    def __init__(self, conn: BadgelinkConnection|BadgeUSB|Serial, force_version1: bool = False, compress: bool = True, digest: bool = True, verbose: bool = True,
+                 max_version: int = PROTOCOL_VERSION, max_chunk_size: int = CHUNK_MAX_SIZE):
         self.def_timeout = 0.25
         self.chunk_timeout = 0.5
         self.xfer_timeout = 10
         self.protocol_version = 1  # Default to v1 for backwards compatibility
+        self.upload_window = 1     # Chunks in flight during uploads; negotiated for v4+
+        self.chunk_size = 4096     # Chunk size; negotiated with badges that support more or less
+        self.compress = compress   # Whether to ask for compressed chunks
+        self.compression = CompressionNone  # Chunk compression; negotiated with badges that support it
+        self.want_digest = digest  # Whether to ask for a SHA-256 of every transfer
+        self.digest = DigestNone   # Transfer digest; negotiated with badges that support it
+        self.session = 0           # Session ID of the transfer in progress; 0 is the last one the badge started
+        self.verbose = verbose     # Whether to print progress and status messages
+        self.progress = 0          # Percentage of the current transfer that is done, for when they aren't printed
+        self.max_version = max_version        # Newest protocol version to ask for, to compare versions
+        self.max_chunk_size = max_chunk_size  # Largest chunk size to ask for, to compare chunk sizes
+        self.capabilities = None   # Bitmap of `Capability` values, or `None` if the badge doesn't say
 
-        if not force_version1:
+        if type(conn) != BadgelinkConnection:
+            # Negotiate along with the sync, which badges that can't do that answer without negotiating.
+            conn = BadgelinkConnection(conn, None if force_version1 else self._version_req())
+        self.conn = conn
+        if conn.welcome is not None:
+            self._use_version(conn.welcome)
+        elif not force_version1:
             self._negotiate_version()
 
+    def _version_req(self) -> VersionReq:
+        """
+        Make the request that negotiates the protocol version.
+        """
+        return VersionReq(client_version=self.max_version, max_chunk_size=self.max_chunk_size,
+                          compression=CompressionLzf if self.compress else CompressionNone,
+                          digest=DigestSha256 if self.want_digest else DigestNone)
+
+    def _use_version(self, resp: VersionResp):
+        """
+        Use what the badge negotiated.
+        """
+        self.protocol_version = resp.negotiated_version
+        if self.protocol_version >= 4:
+            self.upload_window = max(1, resp.upload_window)
+        if resp.chunk_size:
+            # Badges that don't report a chunk size use 4096 bytes.
+            self.chunk_size = min(self.max_chunk_size, resp.chunk_size)
+        self.compression = resp.compression
+        self.digest = resp.digest
+        # Older badges send no capabilities; what they can do is found out by asking.
+        self.capabilities = resp.capabilities or None
+        self._print(f"Negotiated protocol version {self.protocol_version} (server supports v{resp.server_version})")
+
+    def _lacks(self, capability: int) -> bool:
+        """
+        Whether the badge said it can't do `capability`, so there's no need to ask it.
+        """
+        return self.capabilities is not None and not self.capabilities & capability
+
     def _negotiate_version(self):
         """
         Negotiate protocol version with the badge.
         Sends a VersionReq and handles the response.
         """
         try:
-            resp = self.conn.simple_request(
-                VersionReq(client_version=self.PROTOCOL_VERSION),
-                timeout=self.def_timeout
-            )
+            resp = self.conn.simple_request(self._version_req(), timeout=self.def_timeout)
 
             if resp.HasField('version_resp'):
-                self.protocol_version = resp.version_resp.negotiated_version
-                print(f"Negotiated protocol version {self.protocol_version} (server supports v{resp.version_resp.server_version})")
+                self._use_version(resp.version_resp)
             else:
                 # Unexpected response format, fall back to v1
                 self.protocol_version = 1
         except NotSupportedError:
             # Server doesn't support version negotiation, use v1
             self.protocol_version = 1
-            print("Server uses protocol version 1 (legacy)")
+            self._print("Server uses protocol version 1 (legacy)")
         except TimeoutError:
             # Server didn't respond, use v1
             self.protocol_version = 1
-            print("Server uses protocol version 1 (legacy)")
+            self._print("Server uses protocol version 1 (legacy)")
     
-    def start_app(self, slug: str, app_arg: str):
+    def _print(self, *args, **kwargs):
+        """
+        Print a progress or status message, unless this badge is being flashed as part of a fleet.
+        """
+        if self.verbose:
+            print(*args, **kwargs)
+            sys.stdout.flush()
+    
+    def _hasher(self):
+        """
+        Make a SHA-256 hasher for the data of a transfer if the badge sends a digest for it, or return None otherwise.
+        """
+        return hashlib.sha256() if self.digest == DigestSha256 else None
+    
+    def _sha256(self, data: bytes) -> bytes:
+        """
+        Get the SHA-256 an upload of `data` must have if the badge checks it, or nothing otherwise.
+        """
+        return hashlib.sha256(data).digest() if self.digest == DigestSha256 else b''
+    
+    def _check_digest(self, resp: Response, sha256: bytes):
+        """
+        Check the SHA-256 the badge sent when a transfer finished against the one calculated here.
+        """
+        if sha256 and resp.HasField('xfer_result') and resp.xfer_result.sha256 != sha256:
+            self._print(f"SHA-256 mismatch! Expected {sha256.hex()}, got {resp.xfer_result.sha256.hex()}")
+            raise CommunicationError("SHA-256 mismatch")
+    
+    def _start_xfer(self, request: FsActionReq|AppfsActionReq, timeout: float) -> Response:
+        """
+        Start a transfer and remember its session ID, which the requests for the rest of it are sent with.
+        """
+        resp = self.conn.simple_request(request, timeout=timeout)
+        self.session = resp.session
+        return resp
+    
+    def _open_upload(self, path: str|bytes) -> tuple[BinaryIO, int, int, bytes]:
+        """
+        Open a file to upload and compute the CRC32 and SHA-256 the badge needs before the data.
+        Files up to `UPLOAD_BUFFER_MAX` bytes are read into memory in the same pass, so they're only read from disk once.
+        `path` may also be the data itself, like when the same image is flashed to many badges.
+        Returns the file, its size, its CRC32 and its SHA-256, or empty bytes if no digest was negotiated.
+        """
+        if isinstance(path, bytes):
+            return io.BytesIO(path), len(path), crc32(path), self._sha256(path)
+        fd = open(path, "rb")
+        if os.fstat(fd.fileno()).st_size <= self.UPLOAD_BUFFER_MAX:
+            with fd:
+                fd = io.BytesIO(fd.read())
+            with fd.getbuffer() as data:
+                return fd, len(data), crc32(data), self._sha256(data)
+        
+        # Too big to keep in memory; read it twice instead.
+        ecc = 0
+        hasher = self._hasher()
+        while True:
+            chunk = fd.read(1024 * 1024)
+            if not len(chunk):
+                break
+            ecc = crc32(chunk, ecc)
+            if hasher:
+                hasher.update(chunk)
+        return fd, fd.tell(), ecc, hasher.digest() if hasher else b''
+    
+    def _xfer_request(self, **kwargs) -> Request:
+        """
+        Make a request for the transfer in progress, like a transfer control or download credit.
+        """
+        return Request(session=self.session, **kwargs)
+    
+    def _make_chunk(self, pos: int, data: bytes) -> Request:
+        """
+        Make an upload chunk, compressing the data if the badge supports it and it gets smaller.
+        """
+        if self.compression == CompressionLzf and len(data) >= 16:
+            packed = lzf.compress(data)
+            if len(packed) < len(data):
+                return self._xfer_request(upload_chunk=Chunk(position=pos, data=packed, compressed=True))
+        return self._xfer_request(upload_chunk=Chunk(position=pos, data=data))
+    
+    @staticmethod
+    def _chunk_data(chunk: Chunk) -> bytes:
+        """
+        Get the data of a download chunk, decompressing it if needed.
+        """
+        if not chunk.compressed:
+            return chunk.data
+        try:
+            return lzf.decompress(chunk.data)
+        except ValueError as e:
+            raise MalformedResponseError(str(e))
+    
+    def _upload_chunks(self, fd: BinaryIO, size: int, start: int = 0):
+        """
+        Send the contents of `fd` from `start` on as the chunks of an upload that has been started.
+        For protocol version 4+, up to `upload_window` chunks are kept in flight.
+        """
+        fd.seek(start, os.SEEK_SET)
+        progress = -1
+        self.progress = 0
+        
+        if self.protocol_version < 4:
+            # Stop-and-wait; every chunk is acknowledged before the next one is sent.
+            for pos in range(start, size, self.chunk_size):
+                assert pos == fd.tell()
+                self.progress = pos * 100 // size
+                if self.conn.dump_raw:
+                    self._print(f"Uploading at {pos} ({pos * 100 // size}%)")
+                elif pos * 100 // size > progress:
+                    progress = pos * 100 // size
+                    self._print(f"\033[1GUploading {progress}%", end='')
+                self.conn.simple_request(self._make_chunk(pos, fd.read(self.chunk_size)), timeout=self.chunk_timeout)
+            self.progress = 100
+            if not self.conn.dump_raw:
+                self._print()
+            return
+        
+        # Chunks sent so far, to resend without compressing them again.
+        chunks  = {}
+        # Position acknowledged by the badge.
+        acked   = start
+        # Position of the next chunk to send.
+        sent    = start
+        # Position last rewound to because the badge requested a retransmit.
+        rewound = None
+        tries   = 0
+        while acked < size:
+            # Fill up the window.
+            while sent < size and sent - acked < self.upload_window * self.chunk_size:
+                if sent not in chunks:
+                    fd.seek(sent, os.SEEK_SET)
+                    data = fd.read(self.chunk_size)
+                    chunks[sent] = (self._make_chunk(sent, data), len(data))
+                chunk, length = chunks[sent]
+                if self.conn.dump_raw:
+                    self._print(f"Uploading at {sent} ({sent * 100 // size}%)")
+                self.conn.send_request(chunk)
+                sent += length
+            
+            # Wait for the next acknowledgement.
+            try:
+                resp = self.conn.recv_response(self.chunk_timeout).response
+            except NakError as e:
+                # A chunk was corrupted on the way; go back to the first one the badge is missing, like for a retransmit request.
+                if e.nak.session == self.session and e.nak.position >= acked and e.nak.position != rewound:
+                    rewound = e.nak.position
+                    sent    = rewound
+                continue
+            except (TimeoutError, CommunicationError):
+                # Chunks or acknowledgements were lost; resend everything that wasn't acknowledged.
+                tries += 1
+                if tries >= 3:
+                    if not self.conn.dump_raw:
+                        self._print()
+                    raise
+                sent = acked
+                continue
+            self.conn.check_status(resp)
+            if not resp.HasField("xfer_ack"):
+                raise MalformedResponseError("Expected upload acknowledgement")
+            
+            if resp.xfer_ack.position > acked:
+                for pos in [pos for pos in chunks if pos < resp.xfer_ack.position]:
+                    del chunks[pos]
+                acked = resp.xfer_ack.position
+                sent  = max(sent, acked)
+                tries = 0
+            if resp.xfer_ack.retransmit and resp.xfer_ack.position != rewound:
+                # The badge missed a chunk; go back to the first one it is missing.
+                # Further retransmit requests for the same position are for chunks already being resent.
+                rewound = resp.xfer_ack.position
+                sent    = rewound
+            
+            self.progress = acked * 100 // size
+            if not self.conn.dump_raw and acked * 100 // size > progress:
+                progress = acked * 100 // size
+                self._print(f"\033[1GUploading {progress}%", end='')
+        if not self.conn.dump_raw:
+            self._print()
+    
+    def _upload_blocks(self, data: bytes, block_size: int, blocks: list[int]):
+        """
+        Send only the listed blocks of `data` as the chunks of a delta upload that has been started.
+        Skipping ahead can't be told apart from a lost chunk, so each one is acknowledged before the next is sent.
+        """
+        for n, i in enumerate(blocks):
+            if not self.conn.dump_raw:
+                self._print(f"\033[1GUploading {n * 100 // len(blocks)}%", end='')
+            for pos in range(i * block_size, min((i + 1) * block_size, len(data)), self.chunk_size):
+                end = min(pos + self.chunk_size, (i + 1) * block_size, len(data))
+                self.conn.simple_request(self._make_chunk(pos, data[pos:end]), timeout=self.chunk_timeout)
+        if not self.conn.dump_raw and len(blocks):
+            self._print()
+    
+    @staticmethod
+    def _changed_blocks(data: bytes, block_size: int, old_crcs: list[int]) -> list[int]:
+        """
+        List the blocks of `data` whose CRC32 differs from the old one, or that are new.
+        """
+        changed = []
+        for i in range((len(data) + block_size - 1) // block_size):
+            if i >= len(old_crcs) or crc32(data[i * block_size:(i + 1) * block_size]) != old_crcs[i]:
+                changed.append(i)
+        return changed
+    
+    def _open_download(self, host_path: str, offset: int, length: int, resume: bool) -> tuple[BinaryIO, int]:
+        """
+        Open the file a download is written to and work out where in the file on the badge the download starts.
+        With `resume`, what is already in the file is kept and the download continues after it; otherwise the file gets
+        just the data from `offset` on.
+        """
+        fd = None
+        if resume:
+            try:
+                fd = open(host_path, "r+b")
+                offset = fd.seek(0, os.SEEK_END)
+            except FileNotFoundError:
+                pass
+        # Version 7 is the first that can start anywhere but the beginning, or stop before the end.
+        if (offset or length) and self.protocol_version < 7:
+            if fd:
+                fd.close()
+            raise NotSupportedError()
+        return fd or open(host_path, "wb"), offset
+    
+    def _download_chunks(self, fd: BinaryIO, size: int, hasher = None, start: int = 0) -> int:
+        """
+        Receive the chunks of a download that has been started at `start` and write them to `fd` where it is at.
+        `size` is where the download ends, which is the size of the file unless just a range of it was asked for.
+        For protocol version 4+, the badge streams chunks under credits granted in advance.
+        The received data is fed to `hasher` too, if there is one.
+        Returns the CRC32 of the received data.
+        """
+        progress = -1
+        pos = start
+        running_crc = 0
+        # Credits granted to the badge but not used up yet.
+        credits = 0
+        while pos < size:
+            if (pos - start) * 100 // (size - start) > progress:
+                progress = (pos - start) * 100 // (size - start)
+                self._print(f"\033[1GDownloading {progress}%", end='')
+            if self.protocol_version < 4:
+                chunk = self.conn.simple_request(self._xfer_request(xfer_ctrl=XferContinue), timeout=self.chunk_timeout).download_chunk
+            else:
+                # Top up the credits before they run out so the badge never has to wait.
+                if credits <= Badgelink.DOWNLOAD_CREDITS // 2:
+                    credit_req = self._xfer_request(xfer_credit=Badgelink.DOWNLOAD_CREDITS - credits)
+                    credit_serial = self.conn.send_request(credit_req)
+                    credits = Badgelink.DOWNLOAD_CREDITS
+                try:
+                    resp = self.conn.recv_response(self.chunk_timeout).response
+                    self.conn.check_status(resp)
+                except NakError as e:
+                    # The credit request may have been corrupted on the way; if it wasn't handled, resend it.
+                    if self.conn.is_stale(e.serial, credit_serial):
+                        self.conn.resend_request(credit_req, credit_serial)
+                    continue
+                except BadgelinkError:
+                    self._print()
+                    raise
+                if not resp.HasField("download_chunk"):
+                    self._print()
+                    raise MalformedResponseError("Expected download chunk")
+                chunk = resp.download_chunk
+                credits -= 1
+            if chunk.position != pos:
+                self._print()
+                raise MalformedResponseError("Incorrect chunk position")
+            data = self._chunk_data(chunk)
+            fd.write(data)
+            running_crc = crc32(data, running_crc)
+            if hasher:
+                hasher.update(data)
+            pos += len(data)
+        self._print()
+        return running_crc
+    
+    def start_app(self, slug: str, app_arg: str, wait: bool = True):
         """
         Start an app that is installed on the badge.
+        Without `wait`, the request is only sent and the badge isn't waited for, which saves the round trip when
+        starting apps over and over; whether the app exists isn't checked then.
         
         Raises `NotFoundError` if the requested app does not exist.
         """
+        if not wait:
+            self.conn.send_request(StartAppReq(slug=slug, arg=app_arg))
+            return
         self.conn.simple_request(StartAppReq(slug=slug, arg=app_arg), f"App `{slug}`", timeout=self.def_timeout)
     
+    def stats(self, reset: bool = False) -> Stats:
+        """
+        Get the counters the badge keeps of frames, errors and where its time went, since it started or they were reset.
+        With `reset`, the counters start over after being read, so the next call covers just what happened in between.
+        """
+        return self.conn.simple_request(StatsReq(reset=reset), timeout=self.def_timeout).stats
+    
+    def trace_dump(self, clear: bool = False) -> tuple[list[tuple[int, int, int, int]], int]:
+        """
+        Read the badge's trace ring, oldest event first, as tuples of (time_us, arg, type, core).
+        Also returns how many events were recorded in total, so the caller can tell how many were overwritten.
+        With `clear`, the ring is emptied after being read.
+        
+        Raises `UnsupportedError` if the badge was built without CONFIG_BADGELINK_TRACE.
+        """
+        events = []
+        offset = 0
+        while True:
+            page = self.conn.simple_request(TraceReq(offset=offset, clear=clear), timeout=self.def_timeout).trace
+            events += [event[:4] for event in struct.iter_unpack("<IIBBH", page.events)]
+            if not page.next:
+                return events, page.recorded
+            offset = page.next
+    
+    def histograms(self, reset: bool = False) -> tuple[list[Histogram], int]:
+        """
+        Get the badge's latency histograms that aren't empty, and the milliseconds they cover.
+        Bucket 0 counts times under 1 us and bucket n times from 2^(n-1) up to 2^n us.
+        With `reset`, the histograms start over after being read.
+        
+        Raises `UnsupportedError` if the badge was built without CONFIG_BADGELINK_HISTOGRAMS.
+        """
+        histograms = []
+        offset = 0
+        while True:
+            page = self.conn.simple_request(HistogramReq(offset=offset, reset=reset), timeout=self.def_timeout).histograms
+            histograms += page.histograms
+            if not page.next:
+                return histograms, page.period_ms
+            offset = page.next
+    
+    def self_bench(self, path: str = "", size: int = 0, appfs: bool = False) -> BenchResult:
+        """
+        Have the badge time the stages of a transfer on its own: CRC32, protobuf and COBS of full chunks,
+        and if asked, writing and reading `path` and a temporary AppFS file.
+        `size` is how many bytes go through each stage; 0 for the badge's default of 256 KiB.
+        Stages that were skipped take 0 us.
+        
+        Raises `ExistsError` if `path` already exists, and `IllegalStateError` if a transfer is in progress.
+        """
+        # Writing a few MiB to flash or an SD card can take a while.
+        return self.conn.simple_request(BenchReq(path=path, size=size, appfs=appfs), timeout=60).bench
+    
+    def echo(self, data: bytes = b"", reply_size: int = 0) -> EchoResp:
+        """
+        Send `data`, which the badge discards, and get `reply_size` bytes back, to time the link without storage.
+        Both are limited to the chunk size.
+        """
+        return self.conn.simple_request(EchoReq(data=data, reply_size=reply_size), timeout=self.chunk_timeout).echo
+    
+    def echo_many(self, data: bytes, reply_size: int, count: int) -> list[EchoResp|BadgelinkError]:
+        """
+        Like `echo`, `count` times, pipelining the requests.
+        Requests with data are kept as few in flight as chunks of an upload, so they fit in the badge's RX buffer.
+        """
+        window = self.upload_window if data else self.PIPELINE_WINDOW
+        resps = self.conn.pipeline([EchoReq(data=data, reply_size=reply_size)] * count, timeout=self.chunk_timeout, window=window)
+        return [resp if isinstance(resp, BadgelinkError) else resp.echo for resp in resps]
+    
     def nvs_read(self, namespace: str, key: str, nvs_type: NvsValueType) -> NvsValue:
         """
         Read a value from the badge's NVS (Non-Volatile Storage).
@@ -493,13 +1121,17 @@ class Badgelink:
             namespace = str(namespace)
         
         offset = 0
+        cursor = 0
         out = []
         
         while True:
-            resp = self.conn.simple_request(NvsActionReq(type=NvsActionList, namespc=namespace, list_offset=offset), timeout=self.def_timeout).nvs_resp
+            # Badges that don't know about cursors ignore them and count the total instead.
+            request = NvsActionReq(type=NvsActionList, namespc=namespace, list_offset=offset, cursor=cursor, use_cursor=True, skip_total=True)
+            resp = self.conn.simple_request(request, timeout=self.def_timeout).nvs_resp
             out += list(resp.entries.entries)
             offset += len(resp.entries.entries)
-            if offset >= resp.entries.total_entries:
+            cursor = resp.entries.cursor
+            if not cursor and offset >= resp.entries.total_entries:
                 break
         
         return out
@@ -518,6 +1150,93 @@ class Badgelink:
         request = Request(nvs_action=NvsActionReq(type=NvsActionDelete, namespc=namespace, key=key))
         self.conn.simple_request(request, f"NVS entry {repr(namespace)}:{repr(key)}", timeout=self.def_timeout) != None
     
+    def _nvs_batch_op(self, op: NvsBatchOp) -> NvsBatchResult:
+        """
+        Perform a single batch operation on its own, for badges that don't support batches.
+        """
+        try:
+            if op.type == NvsActionRead:
+                return NvsBatchResult(status=StatusOk, rdata=self.nvs_read(op.namespc, op.key, op.read_type))
+            elif op.type == NvsActionWrite:
+                self.nvs_write(op.namespc, op.key, op.wdata)
+            else:
+                self.nvs_delete(op.namespc, op.key)
+            return NvsBatchResult(status=StatusOk)
+        except BadgeError as e:
+            return NvsBatchResult(status=e.code)
+    
+    def nvs_batch(self, ops: list[NvsBatchOp]) -> list[NvsBatchResult]:
+        """
+        Read, write and delete several values in the badge's NVS (Non-Volatile Storage) at once.
+        Returns the result of each operation; failed operations don't raise an exception but have their `status` set.
+        
+        The operations are sent in as few requests as fit in a packet, each of which the badge does under one
+        `nvs_open` and `nvs_commit` per namespace. A request is refused as a whole if any of its operations is malformed.
+        Badges that don't support batches get one request per operation instead.
+        """
+        results = []
+        start = 0
+        while start < len(ops):
+            # Add as many operations as fit in one packet.
+            end = start + 1
+            while end < len(ops) and end - start < self.NVS_BATCH_MAX and \
+                    NvsActionReq(type=NvsActionBatch, batch=ops[start:end + 1]).ByteSize() <= self.chunk_size:
+                end += 1
+            try:
+                if self._lacks(CapNvsBatch):
+                    raise NotSupportedError()
+                resp = self.conn.simple_request(NvsActionReq(type=NvsActionBatch, batch=ops[start:end]), timeout=self.def_timeout)
+            except NotSupportedError:
+                return results + [self._nvs_batch_op(op) for op in ops[start:]]
+            if len(resp.nvs_resp.batch.results) != end - start:
+                raise MalformedResponseError("Expected a result for every NVS operation")
+            results += list(resp.nvs_resp.batch.results)
+            start = end
+        return results
+    
+    def nvs_export(self, namespace: str|None, path: str):
+        """
+        Save a snapshot of one namespace of the badge's NVS (Non-Volatile Storage), or all of it, to a file.
+        The snapshot is taken all at once, so it is consistent even if the badge changes NVS while it's downloaded.
+        
+        Raises `NotSupportedError` if the badge can't make snapshots.
+        """
+        if self._lacks(CapNvsSnapshot):
+            raise NotSupportedError()
+        if namespace and type(namespace) != str:
+            namespace = str(namespace)
+        
+        with open(path, "wb") as fd:
+            # Send initial request; the badge makes the snapshot before it answers.
+            resp = self._start_xfer(NvsActionReq(type=NvsActionExport, namespc=namespace), timeout=self.xfer_timeout).nvs_resp
+            
+            # Initial request succeeded; receive remainder of transfer.
+            running_crc = self._download_chunks(fd, resp.size)
+            self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.def_timeout)
+            
+            if (running_crc & 0xffffffff) != resp.crc32:
+                self._print(f"CRC32 mismatch! Expected 0x{resp.crc32:08x}, got 0x{running_crc & 0xffffffff:08x}")
+                raise CommunicationError("CRC32 mismatch")
+            self._print("Done!")
+    
+    def nvs_import(self, path: str|bytes):
+        """
+        Write every entry of a snapshot made by `nvs_export` to the badge's NVS (Non-Volatile Storage).
+        The badge checks the whole snapshot before writing any of it; entries not in the snapshot are kept.
+        
+        Raises `NotSupportedError` if the badge can't take snapshots.
+        """
+        if self._lacks(CapNvsSnapshot):
+            raise NotSupportedError()
+        fd, size, ecc, _ = self._open_upload(path)
+        with fd:
+            self._start_xfer(NvsActionReq(type=NvsActionImport, size=size, crc32=ecc), timeout=self.xfer_timeout)
+            self._upload_chunks(fd, size)
+            
+            # The entries are written once the badge has all of them.
+            self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout)
+            self._print("Done!")
+    
     def appfs_list(self) -> list[AppfsMetadata]:
         """
         List all AppFS files as an array of file descriptors.
@@ -553,90 +1272,145 @@ class Badgelink:
         """
         self.conn.simple_request(AppfsActionReq(type=FsActionDelete, slug=slug), timeout=self.def_timeout)
     
-    def appfs_upload(self, metadata: AppfsMetadata, path: str):
+    def appfs_sector_crcs(self, slug: str) -> tuple[int, list[int]]:
+        """
+        Get the sector size and the CRC32 checksum of every sector of an AppFS file.
+        
+        Raises `NotFoundError` if the file does not exist.
+        """
+        resp = self.conn.simple_request(AppfsActionReq(type=FsActionSectorCrc32, slug=slug), timeout=self.xfer_timeout)
+        crcs = list(resp.appfs_resp.sector_crcs.crc32)
+        while len(crcs) < resp.appfs_resp.sector_crcs.total_sectors:
+            resp = self.conn.simple_request(AppfsActionReq(type=FsActionSectorCrc32, slug=slug, list_offset=len(crcs)), timeout=self.xfer_timeout)
+            if not len(resp.appfs_resp.sector_crcs.crc32):
+                raise MalformedResponseError("Expected sector CRC32s")
+            crcs += list(resp.appfs_resp.sector_crcs.crc32)
+        return resp.appfs_resp.sector_crcs.sector_size, crcs
+    
+    @staticmethod
+    def _read_source(path: str|bytes) -> bytes:
         """
-        Upload an AppFS executable.
+        Read the file to upload, unless `path` is already the data itself.
         """
+        if isinstance(path, bytes):
+            return path
         with open(path, "rb") as fd:
-            # Get size and calculate checksum.
-            ecc = 0
-            while True:
-                chunk = fd.read(1024 * 1024)
-                if not len(chunk):
-                    break
-                ecc = crc32(chunk, ecc)
-            size = fd.tell()
+            return fd.read()
+    
+    def _appfs_delta_upload(self, metadata: AppfsMetadata, path: str|bytes) -> bool:
+        """
+        Upload only the sectors of an AppFS executable that differ from the app already on the badge.
+        Returns False if that isn't possible and the app has to be uploaded normally instead.
+        """
+        if self.protocol_version < 4 or self._lacks(CapDelta):
+            return False
+        try:
+            old = self.appfs_stat(metadata.slug)
+            sector_size, old_crcs = self.appfs_sector_crcs(metadata.slug)
+        except (NotFoundError, NotSupportedError):
+            return False
+        
+        # AppFS can't resize or rename an app in place; a smaller image is padded to the old size instead.
+        data = self._read_source(path)
+        if len(data) > old.size or old.title != metadata.title or old.version != metadata.version:
+            return False
+        data += b'\xff' * (old.size - len(data))
+        metadata.size = old.size
+        
+        changed = self._changed_blocks(data, sector_size, old_crcs)
+        self._print(f"{len(changed)} of {len(old_crcs)} sectors changed")
+        
+        sha256 = self._sha256(data)
+        try:
+            self._start_xfer(AppfsActionReq(type=FsActionUpload, metadata=metadata, crc32=crc32(data), delta=True, sha256=sha256), timeout=self.xfer_timeout)
+        except IllegalStateError:
+            return False
+        
+        self._upload_blocks(data, sector_size, changed)
+        
+        # Finalize the transfer.
+        self._check_digest(self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout), sha256)
+        self._print("Done!")
+        return True
+    
+    def appfs_upload(self, metadata: AppfsMetadata, path: str|bytes, delta: bool = False, resumable: bool = False):
+        """
+        Upload an AppFS executable from a file, or from memory if `path` is the data itself.
+        With `delta`, only the sectors that differ from the app already on the badge are written, if possible.
+        With `resumable`, the badge keeps what it got if the upload is cut off, and an earlier resumable upload of the
+        same app that was cut off is continued instead of starting over.
+        Otherwise, the app is sent compressed if the badge supports compression.
+        """
+        if delta and not resumable and self._appfs_delta_upload(metadata, path):
+            return
+        fd, size, ecc, sha256 = self._open_upload(path)
+        with fd:
+            if self.compression == CompressionLzf and isinstance(fd, io.BytesIO) and not resumable:
+                # The badge can inflate the app as it writes it, so send it compressed if that's any smaller.
+                stream = lzf.compress_stream(fd.getvalue())
+                if len(stream) < size:
+                    self._print(f"Compressed {size} to {len(stream)} bytes")
+                    metadata.size = size
+                    self._print("Erasing...")
+                    self._start_xfer(AppfsActionReq(type=FsActionUpload, metadata=metadata, crc32=ecc, compressed_size=len(stream), sha256=sha256), timeout=self.xfer_timeout)
+                    self._upload_chunks(io.BytesIO(stream), len(stream))
+                    self._check_digest(self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout), sha256)
+                    self._print("Done!")
+                    return
             
-            # Send initial request.
+            # Send initial request; for a resumable upload, the size in the response is where to continue from.
             metadata.size = size
-            print("Erasing...")
-            self.conn.simple_request(AppfsActionReq(type=FsActionUpload, metadata=metadata, crc32=ecc), timeout=self.xfer_timeout)
+            self._print("Erasing...")
+            resp = self._start_xfer(AppfsActionReq(type=FsActionUpload, metadata=metadata, crc32=ecc, sha256=sha256, resumable=resumable), timeout=self.xfer_timeout)
+            start = resp.appfs_resp.size if resumable and resp.HasField('appfs_resp') else 0
+            if start:
+                self._print(f"Resuming at {start} of {size} bytes")
             
             # Initial request succeeded; send remainder of transfer.
-            fd.seek(0, os.SEEK_SET)
-            progress = -1
-            for pos in range(0, size, Badgelink.CHUNK_MAX_SIZE):
-                assert pos == fd.tell()
-                if self.conn.dump_raw:
-                    print(f"Uploading at {pos} ({pos * 100 // size}%)")
-                elif pos * 100 // size > progress:
-                    progress = pos * 100 // size
-                    print(f"\033[1GUploading {progress}%", end='')
-                    sys.stdout.flush()
-                self.conn.simple_request(Chunk(position=pos, data=fd.read(Badgelink.CHUNK_MAX_SIZE)), timeout=self.chunk_timeout)
-            if not self.conn.dump_raw:
-                print()
+            self._upload_chunks(fd, size, start)
             
             # Finalize the transfer.
-            self.conn.simple_request(Request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout)
-            print("Done!")
+            self._check_digest(self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout), sha256)
+            self._print("Done!")
     
-    def appfs_download(self, slug: str, path: str):
+    def appfs_download(self, slug: str, path: str, offset: int = 0, length: int = 0, resume: bool = False):
         """
-        Download an AppFS executable.
+        Download an AppFS executable, or `length` bytes of it from `offset` on; a `length` of 0 is up to the end.
+        With `resume`, a partial download already in `path` is continued instead of starting over.
+        
+        Raises `NotSupportedError` if a range is asked of a badge older than protocol version 7.
         """
-        with open(path, "wb") as fd:
-            # Send initial request.
-            meta = self.conn.simple_request(AppfsActionReq(type=FsActionDownload, slug=slug), timeout=self.xfer_timeout).appfs_resp
+        fd, offset = self._open_download(path, offset, length, resume)
+        with fd:
+            # Send initial request; the size in the response is where the download ends.
+            meta = self._start_xfer(AppfsActionReq(type=FsActionDownload, slug=slug, offset=offset, length=length),
+                                    timeout=self.xfer_timeout).appfs_resp
 
             # For v1: crc32 is provided upfront
             # For v2: crc32 is 0, will be provided at the end
             expected_crc = meta.crc32 if self.protocol_version == 1 else None
 
             # Initial request succeeded; receive remainder of transfer.
-            fd.seek(0, os.SEEK_SET)
-            progress = -1
-            pos = 0
-            running_crc = 0
-            while pos < meta.size:
-                assert pos == fd.tell()
-                if pos * 100 // meta.size > progress:
-                    progress = pos * 100 // meta.size
-                    print(f"\033[1GDownloading {progress}%", end='')
-                    sys.stdout.flush()
-                chunk = self.conn.simple_request(Request(xfer_ctrl=XferContinue), timeout=self.chunk_timeout).download_chunk
-                if chunk.position != pos:
-                    print()
-                    raise MalformedResponseError("Incorrect chunk position")
-                fd.write(chunk.data)
-                running_crc = crc32(chunk.data, running_crc)
-                pos += len(chunk.data)
-            print()
+            hasher = self._hasher()
+            running_crc = self._download_chunks(fd, meta.size, hasher, offset)
 
             # Finalize the transfer.
-            finish_resp = self.conn.simple_request(Request(xfer_ctrl=XferFinish), timeout=self.def_timeout)
+            finish_resp = self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.def_timeout)
 
-            # For v2, the server sends appfs_resp with crc32 at the end
+            # For v2, the server sends appfs_resp with crc32 at the end, or xfer_result if it also sends a digest
             if self.protocol_version >= 2 and finish_resp.HasField('appfs_resp'):
                 expected_crc = finish_resp.appfs_resp.crc32
+            elif finish_resp.HasField('xfer_result'):
+                expected_crc = finish_resp.xfer_result.crc32
+                self._check_digest(finish_resp, hasher.digest() if hasher else b'')
 
             # Verify CRC
             if expected_crc is not None:
                 if (running_crc & 0xffffffff) != (expected_crc & 0xffffffff):
-                    print(f"CRC32 mismatch! Expected 0x{expected_crc:08x}, got 0x{running_crc & 0xffffffff:08x}")
+                    self._print(f"CRC32 mismatch! Expected 0x{expected_crc:08x}, got 0x{running_crc & 0xffffffff:08x}")
                     raise CommunicationError("CRC32 mismatch")
 
-            print("Done!")
+            self._print("Done!")
     
     def appfs_usage(self) -> FsUsage:
         """
@@ -644,20 +1418,36 @@ class Badgelink:
         """
         return self.conn.simple_request(AppfsActionReq(type=FsActionGetUsage), timeout=self.def_timeout).appfs_resp.usage
 
-    def fs_list(self, path: str) -> list[FsDirent]:
+    def fs_list(self, path: str, with_stat: bool = False) -> list[FsDirent]:
         """
         List a directory.
+        With `with_stat`, the `size` and `mtime` of every dirent are filled in as well.
         """
         offset = 0
+        cursor = 0
         out = []
         
         while True:
-            resp = self.conn.simple_request(FsActionReq(type=FsActionList, path=path, list_offset=offset), timeout=self.chunk_timeout).fs_resp
+            # Badges that don't know about cursors ignore them and count the total instead.
+            request = FsActionReq(type=FsActionList, path=path, list_offset=offset, cursor=cursor, use_cursor=True, skip_total=True, with_stat=with_stat)
+            resp = self.conn.simple_request(request, timeout=self.chunk_timeout).fs_resp
             out += list(resp.list.list)
             offset += len(resp.list.list)
-            if offset >= resp.list.total_size:
+            cursor = resp.list.cursor
+            if not cursor and offset >= resp.list.total_size:
                 break
         
+        # Badges that don't send the stat with the listing need a request for every dirent.
+        if with_stat:
+            missing = [ent for ent in out if not ent.has_stat]
+            stats = self.fs_stat_many([path.rstrip('/') + '/' + ent.name for ent in missing])
+            for ent, stat in zip(missing, stats):
+                if isinstance(stat, BadgelinkError):
+                    raise stat
+                ent.size = stat.size
+                ent.mtime = stat.mtime
+                ent.has_stat = True
+        
         return out
     
     def fs_stat(self, path: str) -> FsStat:
@@ -672,97 +1462,232 @@ class Badgelink:
         """
         return self.conn.simple_request(FsActionReq(type=FsActionCrc23, path=path), timeout=self.def_timeout).fs_resp.crc32
     
+    def _fs_stat_pipelined(self, paths: list[str]) -> list[FsStat|BadgelinkError]:
+        """
+        Get the metadata of many files with a stat request for each, pipelining the requests.
+        """
+        resps = self.conn.pipeline([FsActionReq(type=FsActionStat, path=path) for path in paths], timeout=self.chunk_timeout, window=self.PIPELINE_WINDOW)
+        return [resp if isinstance(resp, BadgelinkError) else resp.fs_resp.stat for resp in resps]
+    
+    def _fs_stat_result(self, result: FsStatResult) -> FsStat|BadgelinkError:
+        """
+        Get the metadata in the result of a stat of many paths, or the error its status means.
+        """
+        try:
+            self.conn.check_status(Response(status_code=result.status))
+        except BadgelinkError as e:
+            return e
+        return result.stat
+    
+    def fs_stat_many(self, paths: list[str]) -> list[FsStat|BadgelinkError]:
+        """
+        Get the metadata of many files at once.
+        Returns the metadata of each file, or the error that getting it raised, like `NotFoundError`.
+        
+        The paths are sent in as few requests as the badge can answer, each of which gets one response.
+        Badges that don't support that get a stat request for every path, pipelined.
+        """
+        results = []
+        start = 0
+        while start < len(paths):
+            # Add as many paths as fit in one packet and have their results fit in the response.
+            packed = bytearray(paths[start].encode() + b'\0')
+            end = start + 1
+            max_end = start + max(1, self.chunk_size // self.FS_STAT_RESULT_MAX)
+            while end < min(len(paths), max_end) and len(packed) + len(paths[end].encode()) + 1 <= self.chunk_size:
+                packed += paths[end].encode() + b'\0'
+                end += 1
+            try:
+                if self._lacks(CapFsStatMany):
+                    raise NotSupportedError()
+                resp = self.conn.simple_request(FsStatManyReq(paths=bytes(packed)), timeout=self.chunk_timeout)
+            except NotSupportedError:
+                return results + self._fs_stat_pipelined(paths[start:])
+            # The badge leaves out the paths whose results didn't fit; they're sent again.
+            answered = resp.fs_stats.results
+            if not answered or len(answered) > end - start:
+                raise MalformedResponseError("Expected a stat result for the first paths")
+            results += [self._fs_stat_result(result) for result in answered]
+            start += len(answered)
+        return results
+    
+    def fs_crc32_many(self, paths: list[str]) -> list[int|BadgelinkError]:
+        """
+        Get the CRC32 checksums of many files at once, pipelining the requests.
+        Returns the CRC32 of each file, or the error that getting it raised, like `NotFoundError`.
+        """
+        resps = self.conn.pipeline([FsActionReq(type=FsActionCrc23, path=path) for path in paths], timeout=self.xfer_timeout, window=self.PIPELINE_WINDOW)
+        return [resp if isinstance(resp, BadgelinkError) else resp.fs_resp.crc32 for resp in resps]
+    
     def fs_delete(self, path: str):
         """
         Delete a file on the badge.
         """
         self.conn.simple_request(FsActionReq(type=FsActionDelete, path=path), timeout=self.def_timeout)
     
-    def fs_usage(self) -> FsUsage:
+    def fs_usage(self, path: str = "") -> tuple[int, int]:
         """
-        Get the badge's filesystem usage statistics.
+        Get the usage statistics of the filesystem `path` is on, or the badge's default filesystem.
+        Returns the size and used amount in bytes.
         """
-        return self.conn.simple_request(FsActionReq(type=FsActionGetUsage), timeout=self.def_timeout).fs_resp.usage
+        usage = self.conn.simple_request(FsActionReq(type=FsActionGetUsage, path=path), timeout=self.def_timeout).fs_resp.usage
+        unit = usage.unit or 1
+        return usage.size * unit, usage.used * unit
     
-    def fs_upload(self, badge_path: str, host_path: str):
+    def fs_sector_crcs(self, path: str, block_size: int = 4096) -> list[int]:
         """
-        Upload a file to the badge.
+        Get the CRC32 checksum of every `block_size` bytes of a file on the badge.
+        
+        Raises `NotFoundError` if the file does not exist.
         """
-        with open(host_path, "rb") as fd:
-            # Get size and calculate checksum.
-            ecc = 0
-            while True:
-                chunk = fd.read(1024 * 1024)
-                if not len(chunk):
-                    break
-                ecc = crc32(chunk, ecc)
-            size = fd.tell()
-            
-            # Send initial request.
-            self.conn.simple_request(FsActionReq(type=FsActionUpload, path=badge_path, crc32=ecc, size=size), timeout=self.xfer_timeout)
+        req  = FsActionReq(type=FsActionSectorCrc32, path=path, block_size=block_size)
+        resp = self.conn.simple_request(req, timeout=self.xfer_timeout)
+        crcs = list(resp.fs_resp.sector_crcs.crc32)
+        while len(crcs) < resp.fs_resp.sector_crcs.total_sectors:
+            req.list_offset = len(crcs)
+            resp = self.conn.simple_request(req, timeout=self.xfer_timeout)
+            if not len(resp.fs_resp.sector_crcs.crc32):
+                raise MalformedResponseError("Expected sector CRC32s")
+            crcs += list(resp.fs_resp.sector_crcs.crc32)
+        return crcs
+    
+    def _fs_delta_upload(self, badge_path: str, host_path: str|bytes, block_size: int) -> bool:
+        """
+        Upload only the blocks of a file that differ from the file already on the badge, patching it in place.
+        Returns False if that isn't possible and the file has to be uploaded normally instead.
+        """
+        if self.protocol_version < 4 or self._lacks(CapDelta):
+            return False
+        try:
+            old_crcs = self.fs_sector_crcs(badge_path, block_size)
+        except (NotFoundError, NotSupportedError):
+            return False
+        
+        data = self._read_source(host_path)
+        changed = self._changed_blocks(data, block_size, old_crcs)
+        self._print(f"{len(changed)} of {(len(data) + block_size - 1) // block_size} blocks changed")
+        
+        sha256 = self._sha256(data)
+        req = FsActionReq(type=FsActionUpload, path=badge_path, crc32=crc32(data), size=len(data), delta=True, block_size=block_size, sha256=sha256)
+        self._start_xfer(req, timeout=self.xfer_timeout)
+        self._upload_blocks(data, block_size, changed)
+        
+        # Finalize the transfer.
+        self._check_digest(self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout), sha256)
+        self._print("Done!")
+        return True
+    
+    def fs_upload(self, badge_path: str, host_path: str|bytes, delta: bool = False, block_size: int = 4096,
+                  resumable: bool = False):
+        """
+        Upload a file to the badge, or data from memory if `host_path` is the data itself.
+        With `delta`, only the blocks that differ from the file already on the badge are sent, if possible.
+        With `resumable`, the badge keeps what it got if the upload is cut off, and an earlier resumable upload of the
+        same file that was cut off is continued instead of starting over.
+        """
+        if delta and not resumable and self._fs_delta_upload(badge_path, host_path, block_size):
+            return
+        fd, size, ecc, sha256 = self._open_upload(host_path)
+        with fd:
+            # Send initial request; for a resumable upload, the size in the response is where to continue from.
+            resp = self._start_xfer(FsActionReq(type=FsActionUpload, path=badge_path, crc32=ecc, size=size, sha256=sha256, resumable=resumable), timeout=self.xfer_timeout)
+            start = resp.fs_resp.size if resumable and resp.HasField('fs_resp') else 0
+            if start:
+                self._print(f"Resuming at {start} of {size} bytes")
             
             # Initial request succeeded; send remainder of transfer.
-            fd.seek(0, os.SEEK_SET)
-            progress = -1
-            for pos in range(0, size, Badgelink.CHUNK_MAX_SIZE):
-                assert pos == fd.tell()
-                if pos * 100 // size > progress:
-                    progress = pos * 100 // size
-                    print(f"\033[1GUploading {progress}%", end='')
-                    sys.stdout.flush()
-                self.conn.simple_request(Chunk(position=pos, data=fd.read(Badgelink.CHUNK_MAX_SIZE)), timeout=self.chunk_timeout)
-            print()
+            self._upload_chunks(fd, size, start)
             
             # Finalize the transfer.
-            self.conn.simple_request(Request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout)
-            print("Done!")
+            self._check_digest(self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout), sha256)
+            self._print("Done!")
     
-    def fs_download(self, badge_path: str, host_path: str):
+    def fs_upload_tree(self, badge_path: str, host_path: str):
         """
-        Download a file from the badge.
+        Upload a directory tree into an existing directory on the badge.
+        It is sent as one stream of directories and files if the badge supports that, or file by file otherwise.
+        """
+        # Every directory comes before what's in it.
+        entries = []
+        for root, dirs, files in os.walk(host_path):
+            dirs.sort()
+            rel = os.path.relpath(root, host_path).replace(os.sep, '/')
+            if rel != '.':
+                entries.append((rel, None))
+            for name in sorted(files):
+                entries.append((name if rel == '.' else rel + '/' + name, os.path.join(root, name)))
+        
+        stream = bytearray()
+        for rel, local in entries:
+            path = rel.encode()
+            if len(path) > self.FS_TREE_PATH_MAX:
+                raise ValueError(f"Path too long: {rel}")
+            if local is None:
+                stream += struct.pack("<BHII", self.FS_TREE_DIR, len(path), 0, 0) + path
+            else:
+                with open(local, "rb") as fd:
+                    data = fd.read()
+                stream += struct.pack("<BHII", self.FS_TREE_FILE, len(path), len(data), crc32(data)) + path + data
+        
+        sha256 = self._sha256(stream)
+        try:
+            if self._lacks(CapTreeUpload):
+                raise NotSupportedError()
+            self._start_xfer(FsActionReq(type=FsActionTreeUpload, path=badge_path, crc32=crc32(stream), size=len(stream), sha256=sha256), timeout=self.xfer_timeout)
+        except NotSupportedError:
+            for rel, local in entries:
+                dest = badge_path.rstrip('/') + '/' + rel
+                if local is None:
+                    try:
+                        self.fs_mkdir(dest)
+                    except ExistsError:
+                        pass
+                else:
+                    self.fs_upload(dest, local)
+            return
+        
+        self._upload_chunks(io.BytesIO(stream), len(stream))
+        self._check_digest(self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout), sha256)
+        self._print(f"Done; {sum(local is not None for _, local in entries)} files")
+    
+    def fs_download(self, badge_path: str, host_path: str, offset: int = 0, length: int = 0, resume: bool = False):
         """
-        with open(host_path, "wb") as fd:
-            # Send initial request.
-            meta = self.conn.simple_request(FsActionReq(type=FsActionDownload, path=badge_path), timeout=self.xfer_timeout).fs_resp
+        Download a file from the badge, or `length` bytes of it from `offset` on; a `length` of 0 is up to the end.
+        With `resume`, a partial download already in `host_path` is continued instead of starting over.
+        
+        Raises `NotSupportedError` if a range is asked of a badge older than protocol version 7.
+        """
+        fd, offset = self._open_download(host_path, offset, length, resume)
+        with fd:
+            # Send initial request; the size in the response is where the download ends.
+            meta = self._start_xfer(FsActionReq(type=FsActionDownload, path=badge_path, offset=offset, length=length),
+                                    timeout=self.xfer_timeout).fs_resp
 
             # For v1: crc32 is provided upfront
             # For v2: crc32 is 0, will be provided at the end
             expected_crc = meta.crc32 if self.protocol_version == 1 else None
 
             # Initial request succeeded; receive remainder of transfer.
-            fd.seek(0, os.SEEK_SET)
-            progress = -1
-            pos = 0
-            running_crc = 0
-            while pos < meta.size:
-                assert pos == fd.tell()
-                if pos * 100 // meta.size > progress:
-                    progress = pos * 100 // meta.size
-                    print(f"\033[1GDownloading {progress}%", end='')
-                    sys.stdout.flush()
-                chunk = self.conn.simple_request(Request(xfer_ctrl=XferContinue), timeout=self.chunk_timeout).download_chunk
-                if chunk.position != pos:
-                    print()
-                    raise MalformedResponseError("Incorrect chunk position")
-                fd.write(chunk.data)
-                running_crc = crc32(chunk.data, running_crc)
-                pos += len(chunk.data)
-            print()
+            hasher = self._hasher()
+            running_crc = self._download_chunks(fd, meta.size, hasher, offset)
 
             # Finalize the transfer.
-            finish_resp = self.conn.simple_request(Request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout)
+            finish_resp = self.conn.simple_request(self._xfer_request(xfer_ctrl=XferFinish), timeout=self.xfer_timeout)
 
-            # For v2, the server sends fs_resp with crc32 at the end
+            # For v2, the server sends fs_resp with crc32 at the end, or xfer_result if it also sends a digest
             if self.protocol_version >= 2 and finish_resp.HasField('fs_resp'):
                 expected_crc = finish_resp.fs_resp.crc32
+            elif finish_resp.HasField('xfer_result'):
+                expected_crc = finish_resp.xfer_result.crc32
+                self._check_digest(finish_resp, hasher.digest() if hasher else b'')
 
             # Verify CRC
             if expected_crc is not None:
                 if (running_crc & 0xffffffff) != (expected_crc & 0xffffffff):
-                    print(f"CRC32 mismatch! Expected 0x{expected_crc:08x}, got 0x{running_crc & 0xffffffff:08x}")
+                    self._print(f"CRC32 mismatch! Expected 0x{expected_crc:08x}, got 0x{running_crc & 0xffffffff:08x}")
                     raise CommunicationError("CRC32 mismatch")
 
-            print("Done!")
+            self._print("Done!")
     
     def fs_mkdir(self, path: str):
         """
@@ -770,17 +1695,23 @@ class Badgelink:
         """
         self.conn.simple_request(FsActionReq(type=FsActionMkdir, path=path), timeout=self.def_timeout)
     
-    def fs_rmdir(self, path: str):
+    def fs_rmdir(self, path: str, recursive = False) -> int:
         """
         Remove a directory on the badge.
+        If `recursive` is set, everything in it is removed on the badge as well.
+        Returns the number of files and directories removed by a recursive rmdir.
         """
-        self.conn.simple_request(FsActionReq(type=FsActionRmdir, path=path), timeout=self.def_timeout)
+        req = FsActionReq(type=FsActionRmdir, path=path, recursive=recursive)
+        return self.conn.simple_request(req, timeout=self.xfer_timeout if recursive else self.def_timeout).fs_resp.count
 
-    def fs_copy(self, source: str, dest: str):
+    def fs_copy(self, source: str, dest: str, recursive = False) -> int:
         """
         Copy a file on the badge.
+        If `recursive` is set, the source may be a directory, which is copied with everything in it on the badge.
+        Returns the number of files and directories copied by a recursive copy.
         """
-        self.conn.simple_request(FsActionReq(type=FsActionCopy, path=source, dest_path=dest), timeout=self.xfer_timeout)
+        req = FsActionReq(type=FsActionCopy, path=source, dest_path=dest, recursive=recursive)
+        return self.conn.simple_request(req, timeout=self.xfer_timeout).fs_resp.count
 
     def fs_rename(self, source: str, dest: str):
         """
@@ -789,6 +1720,97 @@ class Badgelink:
         self.conn.simple_request(FsActionReq(type=FsActionRename, path=source, dest_path=dest), timeout=self.xfer_timeout)
 
 
+class FleetDevice:
+    """
+    A badge that is being flashed as part of a fleet.
+    """
+    def __init__(self, name: str, conn: BadgeUSB|Serial):
+        self.name    = name
+        self.conn    = conn
+        # Connection to the badge once it has been set up.
+        self.link    = None
+        # Error the job failed with, if any.
+        self.error   = None
+        # Seconds the job took, once it has finished.
+        self.elapsed = None
+    
+    def status(self) -> str:
+        if self.error is not None:
+            return f"failed: {' '.join(str(arg) for arg in self.error.args) or type(self.error).__name__}"
+        elif self.elapsed is not None:
+            return "done"
+        elif self.link is None:
+            return "connecting"
+        return f"{self.link.progress}%"
+
+
+class Fleet:
+    """
+    Runs the same job on many badges at once, with a thread for each, showing the progress of every badge.
+    """
+    def __init__(self, devices: list[FleetDevice], **options):
+        self.devices = devices
+        # Options for the `Badgelink` of each badge, like `compress`.
+        self.options = options
+    
+    @staticmethod
+    def discover(serial_ports: list[str] = []) -> list[FleetDevice]:
+        """
+        Find all badges connected over USB, plus the ones on the given serial ports.
+        """
+        devices = [FleetDevice(conn.name, conn) for conn in BadgeUSB.find_all()]
+        devices += [FleetDevice(port, Serial(port=port, baudrate=115200)) for port in serial_ports]
+        return devices
+    
+    def _run_one(self, device: FleetDevice, job):
+        start = time.time()
+        try:
+            device.link = Badgelink(device.conn, verbose=False, **self.options)
+            job(device.link)
+        except Exception as e:
+            # Whatever goes wrong with one badge mustn't stop the others or look like a success.
+            device.error = e
+        finally:
+            device.elapsed = time.time() - start
+            if device.link is not None:
+                device.link.conn.close()
+    
+    def _show(self, redraw: bool):
+        if redraw:
+            print(f"\033[{len(self.devices)}A", end='')
+        width = max(len(device.name) for device in self.devices)
+        for device in self.devices:
+            print(f"\033[2K{device.name.ljust(width)}  {device.status()}")
+        sys.stdout.flush()
+    
+    def run(self, job, size: int) -> bool:
+        """
+        Run `job` with the `Badgelink` of every badge, then print a summary.
+        `size` is how many bytes the job sends to each badge, for the throughput figures.
+        Returns whether the job succeeded on every badge.
+        """
+        threads = [threading.Thread(target=self._run_one, args=(device, job), daemon=True) for device in self.devices]
+        start = time.time()
+        for thread in threads:
+            thread.start()
+        
+        self._show(False)
+        while any(thread.is_alive() for thread in threads):
+            time.sleep(0.25)
+            self._show(True)
+        elapsed = time.time() - start
+        
+        # Summarize the throughput of each badge and of the whole fleet.
+        print()
+        ok = [device for device in self.devices if device.error is None]
+        for device in self.devices:
+            rate = size / device.elapsed / 1024 if device.elapsed else 0
+            print(f"{device.name}: {device.status()} in {device.elapsed:.1f}s ({rate:.0f} KiB/s)")
+        print(f"{len(ok)} of {len(self.devices)} badges succeeded in {elapsed:.1f}s; "
+              f"{size * len(ok) / elapsed / 1024 if elapsed else 0:.0f} KiB/s in total")
+        return len(ok) == len(self.devices)
+
+
 if __name__ == "__main__":
     def todo():
         print("Not supported by this script yet")
@@ -857,6 +1879,14 @@ if __name__ == "__main__":
         else:
             return val
     
+    def bench_path(val: str):
+        if '\0' in val:
+            raise ArgumentTypeError("File path cannot contain null bytes")
+        elif len(val.encode()) > 255:
+            raise ArgumentTypeError("Benchmark file path cannot exceed 255 bytes")
+        else:
+            return val
+    
     def parse_nvs_value(type: str, value: str, file: bool) -> NvsValue:
         if nvs_types[type] == NvsValueBlob:
             # Blob / bytes value.
@@ -900,6 +1930,90 @@ if __name__ == "__main__":
             print(f"NVS {type} must be an integer from {range[0]} to {range[1]}")
             sys.exit(1)
     
+    def trace_to_chrome(events: list[tuple[int, int, int, int]]) -> dict:
+        """
+        Convert trace events to the Chrome trace event format, for Perfetto or chrome://tracing.
+        """
+        # Begin and end events become slices on a track per stage; the others become instants.
+        slices = {
+            TraceFrameStart:   ("RX", "frame", "B"),
+            TraceFrameEnd:     ("RX", "frame", "E"),
+            TraceHandleBegin:  ("Handler", None, "B"),
+            TraceHandleEnd:    ("Handler", None, "E"),
+            TraceStorageBegin: ("Storage", "I/O", "B"),
+            TraceStorageEnd:   ("Storage", "I/O", "E"),
+        }
+        instants = {
+            TraceDecoded:  ("RX", "decoded", "len"),
+            TraceTxQueued: ("Encode", "queued", "len"),
+            TraceTxDone:   ("TX", "sent", "len"),
+        }
+        args = {
+            TraceFrameStart:   "transport",
+            TraceFrameEnd:     "len",
+            TraceHandleBegin:  "which_req",
+            TraceHandleEnd:    "which_req",
+            TraceStorageBegin: "len",
+            TraceStorageEnd:   "status",
+        }
+        requests = {field.number: field.name for field in Request.DESCRIPTOR.oneofs_by_name["req"].fields}
+        
+        out = []
+        tids = {}
+        base = None
+        last = 0
+        wraps = 0
+        for time_us, arg, type, core in events:
+            # Timestamps are the low 32 bits of the badge's microsecond timer.
+            if base is not None and time_us < last:
+                wraps += 1
+            last = time_us
+            ts = time_us + (wraps << 32)
+            if base is None:
+                base = ts
+            if type in slices:
+                track, name, phase = slices[type]
+                if name is None:
+                    name = requests.get(arg, "packet")
+                event = {"name": name, "ph": phase, "args": {args[type]: arg}}
+            elif type in instants:
+                track, name, key = instants[type]
+                event = {"name": name, "ph": "i", "s": "t", "args": {key: arg}}
+            else:
+                track = "Other"
+                event = {"name": f"event {type}", "ph": "i", "s": "t", "args": {"arg": arg}}
+            # Thread IDs must be numbers, so each track gets one and is named with a metadata event.
+            track = f"{track} (core {core})"
+            if track not in tids:
+                tids[track] = len(tids) + 1
+                out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tids[track], "args": {"name": track}})
+            event["ts"] = ts - base
+            event["pid"] = 1
+            event["tid"] = tids[track]
+            out.append(event)
+        return {"traceEvents": out, "displayTimeUnit": "ms"}
+    
+    def format_us(us: float) -> str:
+        if us >= 1000000:
+            return f"{us / 1000000:.1f}s"
+        elif us >= 1000:
+            return f"{us / 1000:.1f}ms"
+        return f"{us:.0f}us"
+    
+    def histogram_percentile(buckets: list[int], fraction: float) -> str:
+        """
+        Upper bound of the bucket the given fraction of the counted times falls in.
+        """
+        target = sum(buckets) * fraction
+        seen = 0
+        for i, n in enumerate(buckets):
+            seen += n
+            if n and seen >= target:
+                if i == len(buckets) - 1:
+                    return f">{format_us(1 << (i - 1))}"
+                return f"<{format_us(1 << i)}"
+        return "-"
+    
     def print_table(header: list[str], rows: list[list[str]]):
         max_width = [len(s) for s in header]
         
@@ -940,6 +2054,10 @@ if __name__ == "__main__":
                         help="Connect via TCP proxy instead of USB (e.g., localhost:4002)")
     parser.add_argument("--version1", action="store_true", default=False,
                         help="Force protocol version 1 (legacy mode, skip version negotiation)")
+    parser.add_argument("--no-compress", action="store_true", default=False,
+                        help="Don't compress chunks, even if the badge supports it")
+    parser.add_argument("--no-digest", action="store_true", default=False,
+                        help="Don't have transfers checked with SHA-256, even if the badge supports it")
     subparsers = parser.add_subparsers(required=True, dest="request")
     
     # ==== Help texts ==== #
@@ -951,6 +2069,24 @@ if __name__ == "__main__":
             help_start              = "Start an app that is installed on the badge"
             help_start_slug         = "ID of the app to start"
             help_start_arg          = "Argument to pass to the app being started"
+            help_start_no_wait      = "Don't wait for the badge to confirm before exiting; whether the app exists isn't checked"
+        
+        if 1:
+            help_stats              = "Show the badge's transfer statistics"
+            help_stats_reset        = "Start counting over after showing them"
+            help_histograms         = "Show the badge's latency histograms"
+            help_histograms_reset   = "Start counting over after showing them"
+            help_bench_link         = "Measure the throughput and round trip time of the link, without storage"
+            help_bench_link_size    = "Bytes of data per request; defaults to the chunk size"
+            help_bench_link_count   = "Number of requests to time"
+            help_bench_link_dir     = "Send data to the badge (up), have it send data (down) or both"
+            help_trace              = "Dump the badge's trace ring as a Chrome trace, for Perfetto or chrome://tracing"
+            help_trace_output       = "JSON file to write the trace to"
+            help_trace_clear        = "Empty the trace ring after dumping it"
+            help_selfbench          = "Time the stages of a transfer on the badge itself, without the link"
+            help_selfbench_path     = "File to create, time writing and reading, and delete; skipped if not given"
+            help_selfbench_size     = "Bytes to put through each stage; the badge defaults to 256 KiB and allows up to 4 MiB"
+            help_selfbench_appfs    = "Also time erasing, writing and reading a temporary AppFS file"
         
         if 1:
             help_nvs                = "Read or write the settings (ESP NVS)"
@@ -961,6 +2097,11 @@ if __name__ == "__main__":
             help_nvs_write_value    = "The value to write"
             help_nvs_list           = "List all entries or entries in a namespace"
             help_nvs_delete         = "Delete an entry"
+            help_nvs_import         = "Write many values at once"
+            help_nvs_import_file    = "File with a `namespace key type value` line for every value to write"
+            help_nvs_save           = "Save a snapshot of all entries or the entries in a namespace to a file"
+            help_nvs_restore        = "Write all entries of a snapshot made by `nvs save` back"
+            help_nvs_snapshot_file  = "The snapshot file"
             help_nvs_ns             = "Acts like a directory"
             help_nvs_key            = "The name associated with a setting"
             help_nvs_type           = "The type of the setting"
@@ -972,7 +2113,12 @@ if __name__ == "__main__":
             help_appfs_crc32        = "Show the CRC32 checksum of an AppFS app"
             help_appfs_delete       = "Delete an AppFS app from the badge"
             help_appfs_upload       = "Upload an AppFS app to the badge"
+            help_appfs_upload_delta = "Only write the sectors that differ from the app already on the badge"
+            help_upload_resumable   = "Keep what was sent if the upload is cut off, and continue one that was"
             help_appfs_download     = "Download an AppFS app from the badge"
+            help_download_offset    = "Start at this many bytes into the file"
+            help_download_length    = "Download at most this many bytes"
+            help_download_resume    = "Continue a download that was cut off, keeping what is already in the host file"
             help_appfs_usage        = "Show usage statistics of AppFS"
             help_appfs_slug         = "ID of the AppFS app"
             help_appfs_title        = "Title of the AppFS app"
@@ -981,22 +2127,69 @@ if __name__ == "__main__":
         if 1:
             help_fs             = "Manage files on the badge"
             help_fs_list        = "List files in a directory on the badge"
+            help_fs_list_long   = "Show the size and modification time of every file"
             help_fs_stat        = "Show details about a file/directory on the badge"
             help_fs_crc32       = "Show the CRC32 checksum of a file on the badge"
             help_fs_delete      = "Delete a file from the badge"
             help_fs_mkdir       = "Make a directory on the badge"
             help_fs_rmdir       = "Remove an empty directory from the badge"
+            help_fs_recursive   = "Include everything in the directory"
             help_fs_upload      = "Upload a file to the badge"
+            help_fs_upload_delta = "Only send the blocks that differ from the file already on the badge"
+            help_fs_block_size  = "Block size in bytes for --delta"
             help_fs_download    = "Download a file from the badge"
+            help_fs_upload_tree = "Upload a directory tree into a directory on the badge"
+            help_host_dir       = "Path to a directory on this computer"
             help_fs_usage       = "Show filesystem usage statistics"
             help_fs_cp          = "Copy a file on the badge"
             help_fs_mv          = "Move/rename a file on the badge"
+        
+        if 1:
+            help_fleet              = "Do the same thing on every connected badge at once"
+            help_fleet_serial       = "Also use the badge on this serial port; may be given more than once"
+            help_fleet_list         = "List the badges that were found"
+            help_fleet_appfs_upload = "Upload an AppFS app to every badge"
+            help_fleet_fs_upload    = "Upload a file to every badge"
     
     # ==== Start app parser ==== #
     if 1:
         p_start = subparsers.add_parser("start", help=help_start)
         p_start.add_argument("slug", type=appfs_slug, help=help_start_slug)
         p_start.add_argument("app_arg", type=app_arg, nargs="?", default="", help=help_start_arg)
+        p_start.add_argument("--no-wait", action="store_true", default=False, help=help_start_no_wait)
+    
+    # ==== Stats parser ==== #
+    if 1:
+        p_stats = subparsers.add_parser("stats", help=help_stats)
+        p_stats.add_argument("--reset", action="store_true", default=False, help=help_stats_reset)
+    
+    # ==== Histograms parser ==== #
+    if 1:
+        p_histograms = subparsers.add_parser("histograms", help=help_histograms)
+        p_histograms.add_argument("--reset", action="store_true", default=False, help=help_histograms_reset)
+    
+    # ==== Self-benchmark parser ==== #
+    if 1:
+        p_selfbench = subparsers.add_parser("selfbench", help=help_selfbench)
+        p_selfbench.add_argument("--path", type=bench_path, default="", help=help_selfbench_path)
+        p_selfbench.add_argument("--size", type=int, default=0, help=help_selfbench_size)
+        p_selfbench.add_argument("--appfs", action="store_true", default=False, help=help_selfbench_appfs)
+    
+    # ==== Bench parser ==== #
+    if 1:
+        p_bench = subparsers.add_parser("bench")
+        sub_bench = p_bench.add_subparsers(required=True, dest="action")
+        
+        p_bench_link = sub_bench.add_parser("link", help=help_bench_link)
+        p_bench_link.add_argument("--size", type=int, default=0, help=help_bench_link_size)
+        p_bench_link.add_argument("--count", type=int, default=256, help=help_bench_link_count)
+        p_bench_link.add_argument("--direction", choices=["up", "down", "both"], default="both", help=help_bench_link_dir)
+    
+    # ==== Trace parser ==== #
+    if 1:
+        p_trace = subparsers.add_parser("trace", help=help_trace)
+        p_trace.add_argument("output", help=help_trace_output)
+        p_trace.add_argument("--clear", action="store_true", default=False, help=help_trace_clear)
     
     # ==== NVS parsers ==== #
     if 1:
@@ -1021,6 +2214,16 @@ if __name__ == "__main__":
         p_nvs_delete = sub_nvs.add_parser("delete", help=help_nvs_delete)
         p_nvs_delete.add_argument("namespace", type=nvs_ns, help=help_nvs_ns)
         p_nvs_delete.add_argument("key", type=nvs_ns, help=help_nvs_key)
+        
+        p_nvs_import = sub_nvs.add_parser("import", help=help_nvs_import)
+        p_nvs_import.add_argument("file", help=help_nvs_import_file)
+        
+        p_nvs_save = sub_nvs.add_parser("save", help=help_nvs_save)
+        p_nvs_save.add_argument("file", help=help_nvs_snapshot_file)
+        p_nvs_save.add_argument("namespace", type=nvs_ns, nargs='?', help=help_nvs_ns)
+        
+        p_nvs_restore = sub_nvs.add_parser("restore", help=help_nvs_restore)
+        p_nvs_restore.add_argument("file", help=help_nvs_snapshot_file)
     
     # ==== AppFS parsers ==== #
     if 1:
@@ -1043,10 +2246,15 @@ if __name__ == "__main__":
         p_appfs_upload.add_argument("title", type=appfs_title, help=help_appfs_title)
         p_appfs_upload.add_argument("version", type=appfs_ver, help=help_appfs_version)
         p_appfs_upload.add_argument("file", help=help_host_file)
+        p_appfs_upload.add_argument("--delta", action="store_true", default=False, help=help_appfs_upload_delta)
+        p_appfs_upload.add_argument("--resumable", action="store_true", default=False, help=help_upload_resumable)
         
         p_appfs_download = sub_appfs.add_parser("download", help=help_appfs_download)
         p_appfs_download.add_argument("slug", type=appfs_slug, help=help_appfs_slug)
         p_appfs_download.add_argument("file", help=help_host_file)
+        p_appfs_download.add_argument("--offset", type=int, default=0, help=help_download_offset)
+        p_appfs_download.add_argument("--length", type=int, default=0, help=help_download_length)
+        p_appfs_download.add_argument("--resume", action="store_true", default=False, help=help_download_resume)
         
         p_appfs_usage = sub_appfs.add_parser("usage", help=help_appfs_usage)
     
@@ -1057,6 +2265,7 @@ if __name__ == "__main__":
         
         p_fs_list = sub_fs.add_parser("list", help=help_fs_list)
         p_fs_list.add_argument("file", type=fs_path, default='/', nargs='?', help=help_badge_file)
+        p_fs_list.add_argument("-l", "--long", action="store_true", default=False, help=help_fs_list_long)
         
         p_fs_stat = sub_fs.add_parser("stat", help=help_fs_stat)
         p_fs_stat.add_argument("file", type=fs_path, help=help_badge_file)
@@ -1072,28 +2281,92 @@ if __name__ == "__main__":
         
         p_fs_mkdir = sub_fs.add_parser("rmdir", help=help_fs_rmdir)
         p_fs_mkdir.add_argument("file", type=fs_path, help=help_badge_file)
+        p_fs_mkdir.add_argument("-r", "--recursive", action="store_true", default=False, help=help_fs_recursive)
         
         p_fs_upload = sub_fs.add_parser("upload", help=help_fs_upload)
         p_fs_upload.add_argument("badge_file", type=fs_path, help=help_badge_file)
         p_fs_upload.add_argument("host_file", help=help_host_file)
+        p_fs_upload.add_argument("--delta", action="store_true", default=False, help=help_fs_upload_delta)
+        p_fs_upload.add_argument("--block-size", type=int, default=4096, help=help_fs_block_size)
+        p_fs_upload.add_argument("--resumable", action="store_true", default=False, help=help_upload_resumable)
+        
+        p_fs_upload_tree = sub_fs.add_parser("upload-tree", help=help_fs_upload_tree)
+        p_fs_upload_tree.add_argument("badge_file", type=fs_path, help=help_badge_file)
+        p_fs_upload_tree.add_argument("host_dir", help=help_host_dir)
         
         p_fs_download = sub_fs.add_parser("download", help=help_fs_download)
         p_fs_download.add_argument("badge_file", type=fs_path, help=help_badge_file)
         p_fs_download.add_argument("host_file", help=help_host_file)
+        p_fs_download.add_argument("--offset", type=int, default=0, help=help_download_offset)
+        p_fs_download.add_argument("--length", type=int, default=0, help=help_download_length)
+        p_fs_download.add_argument("--resume", action="store_true", default=False, help=help_download_resume)
         
-        # p_fs_usage = sub_fs.add_parser("usage", help=help_fs_usage)
+        p_fs_usage = sub_fs.add_parser("usage", help=help_fs_usage)
+        p_fs_usage.add_argument("file", type=fs_path, nargs="?", default="", help=help_badge_file)
 
         p_fs_cp = sub_fs.add_parser("cp", help=help_fs_cp)
         p_fs_cp.add_argument("source", type=fs_path, help="Source file path on badge")
         p_fs_cp.add_argument("dest", type=fs_path, help="Destination file path on badge")
+        p_fs_cp.add_argument("-r", "--recursive", action="store_true", default=False, help=help_fs_recursive)
 
         p_fs_mv = sub_fs.add_parser("mv", help=help_fs_mv)
         p_fs_mv.add_argument("source", type=fs_path, help="Source file path on badge")
         p_fs_mv.add_argument("dest", type=fs_path, help="Destination file path on badge")
+    
+    # ==== Fleet parser ==== #
+    if 1:
+        p_fleet = subparsers.add_parser("fleet", help=help_fleet)
+        p_fleet.add_argument("--serial", action="append", default=[], metavar="PORT", help=help_fleet_serial)
+        sub_fleet = p_fleet.add_subparsers(required=True, dest="action")
+        
+        p_fleet_list = sub_fleet.add_parser("list", help=help_fleet_list)
+        
+        p_fleet_appfs_upload = sub_fleet.add_parser("appfs-upload", help=help_fleet_appfs_upload)
+        p_fleet_appfs_upload.add_argument("slug", type=appfs_slug, help=help_appfs_slug)
+        p_fleet_appfs_upload.add_argument("title", type=appfs_title, help=help_appfs_title)
+        p_fleet_appfs_upload.add_argument("version", type=appfs_ver, help=help_appfs_version)
+        p_fleet_appfs_upload.add_argument("file", help=help_host_file)
+        p_fleet_appfs_upload.add_argument("--delta", action="store_true", default=False, help=help_appfs_upload_delta)
+        
+        p_fleet_fs_upload = sub_fleet.add_parser("fs-upload", help=help_fleet_fs_upload)
+        p_fleet_fs_upload.add_argument("badge_file", type=fs_path, help=help_badge_file)
+        p_fleet_fs_upload.add_argument("host_file", help=help_host_file)
 
     # ==== Implementations ==== #
     args = parser.parse_args()
     
+    if args.request == "fleet":
+        # ==== Fleet implementations ==== #
+        # Every badge gets its own connection, so this doesn't use --port, --tcp or the pipes.
+        try:
+            devices = Fleet.discover(args.serial)
+        except (SerialException, USBError) as e:
+            print(f"Failed to open badge: {e}")
+            sys.exit(1)
+        if not devices:
+            print("No badges found")
+            sys.exit(1)
+        if args.action == "list":
+            for device in devices:
+                print(device.name)
+            sys.exit(0)
+        
+        # Read the image once; every badge is sent the same copy from memory.
+        with open(args.file if args.action == "appfs-upload" else args.host_file, "rb") as fd:
+            data = fd.read()
+        
+        def fleet_job(link: Badgelink):
+            link.def_timeout = args.timeout
+            link.chunk_timeout = args.chunk_timeout
+            link.xfer_timeout = args.xfer_timeout
+            if args.action == "appfs-upload":
+                link.appfs_upload(AppfsMetadata(slug=args.slug, title=args.title, version=args.version), data, args.delta)
+            else:
+                link.fs_upload(args.badge_file, data)
+        
+        fleet = Fleet(devices, force_version1=args.version1, compress=not args.no_compress, digest=not args.no_digest)
+        sys.exit(0 if fleet.run(fleet_job, len(data)) else 1)
+    
     conn_opts = sum(x is not None for x in [args.port, args.tcp, args.inpipe])
     if conn_opts > 1:
         print(f"{sys.argv[0]}: error: --port, --tcp, and --inpipe/--outpipe are mutually exclusive")
@@ -1126,14 +2399,126 @@ if __name__ == "__main__":
         sys.exit(1)
     
     try:
-        link = Badgelink(port, force_version1=args.version1)
+        link = Badgelink(port, force_version1=args.version1, compress=not args.no_compress, digest=not args.no_digest)
         link.conn.dump_raw = args.dump_raw_bytes
         link.def_timeout = args.timeout
         link.chunk_timeout = args.chunk_timeout
         link.xfer_timeout = args.xfer_timeout
         
         if args.request == "start":
-            link.start_app(args.slug, args.app_arg)
+            link.start_app(args.slug, args.app_arg, wait=not args.no_wait)
+        
+        elif args.request == "stats":
+            # ==== Stats implementation ==== #
+            stats = link.stats(args.reset)
+            seconds = stats.period_ms / 1000 or 1
+            print(f"Over {stats.period_ms / 1000:.1f}s:")
+            print(f"  received   {stats.frames_rx} frames, {stats.bytes_rx} bytes ({stats.bytes_rx / seconds / 1024:.1f} KiB/s)")
+            print(f"  sent       {stats.frames_tx} frames, {stats.bytes_tx} bytes ({stats.bytes_tx / seconds / 1024:.1f} KiB/s)")
+            print(f"  transfers  {stats.xfers}")
+            print(f"  errors     {stats.crc_errors} CRC, {stats.framing_errors} framing, {stats.decode_errors} decode; {stats.naks_sent} NAKs sent")
+            print(f"  ignored    {stats.retransmits} retransmitted requests, {stats.rx_overflow} bytes that didn't fit in the RX buffer")
+            print_table(["stage", "time", "per frame"], [
+                [name, f"{us / 1000:.1f}ms", f"{us / frames:.0f}us" if frames else "-"]
+                for name, us, frames in [
+                    ("COBS/CRC32", stats.cobs_us, stats.frames_rx),
+                    ("decode", stats.decode_us, stats.frames_rx),
+                    ("handle", stats.handle_us, stats.frames_rx),
+                    ("encode", stats.encode_us, stats.frames_tx),
+                    ("storage", stats.storage_us, 0),
+                ]
+            ])
+        
+        elif args.request == "histograms":
+            # ==== Histograms implementation ==== #
+            histograms, period_ms = link.histograms(args.reset)
+            requests = {field.number: field.name for field in Request.DESCRIPTOR.oneofs_by_name["req"].fields}
+            print(f"Over {period_ms / 1000:.1f}s:")
+            rows = []
+            # The histograms of each type of request go under the one of all of them.
+            for h in sorted(histograms, key=lambda h: (h.stage, h.which_req)):
+                if h.which_req:
+                    name = f"  {requests.get(h.which_req, h.which_req)}"
+                else:
+                    name = HistogramStage.Name(h.stage).removeprefix("Stage")
+                count = sum(h.buckets)
+                rows.append([
+                    name, str(count), format_us(h.total_us / count),
+                    histogram_percentile(h.buckets, 0.5),
+                    histogram_percentile(h.buckets, 0.9),
+                    histogram_percentile(h.buckets, 0.99),
+                    histogram_percentile(h.buckets, 1),
+                ])
+            print_table(["stage", "count", "mean", "p50", "p90", "p99", "max"], rows)
+        
+        elif args.request == "selfbench":
+            # ==== Self-benchmark implementation ==== #
+            result = link.self_bench(args.path, args.size, args.appfs)
+            print(f"{result.size} bytes in {result.chunk_size}-byte chunks:")
+            rows = []
+            for name, us in [
+                ("CRC32", result.crc32_us),
+                ("protobuf encode", result.pb_encode_us),
+                ("protobuf decode", result.pb_decode_us),
+                ("COBS encode", result.cobs_encode_us),
+                ("COBS decode", result.cobs_decode_us),
+                ("file write", result.fs_write_us),
+                ("file read", result.fs_read_us),
+                ("AppFS erase", result.appfs_erase_us),
+                ("AppFS write", result.appfs_write_us),
+                ("AppFS read", result.appfs_read_us),
+            ]:
+                # Bytes per microsecond are MB/s; skipped stages took no time at all.
+                if us:
+                    rows.append([name, format_us(us), f"{result.size / us:.2f}"])
+            print_table(["stage", "time", "MB/s"], rows)
+        
+        elif args.request == "bench":
+            # ==== Bench implementations ==== #
+            if args.action == "link":
+                size = args.size or link.chunk_size
+                if size > link.chunk_size:
+                    print(f"Size cannot exceed the chunk size of {link.chunk_size} bytes")
+                    sys.exit(1)
+                elif args.count < 1:
+                    print("Count must be at least 1")
+                    sys.exit(1)
+                up = size if args.direction in ["up", "both"] else 0
+                down = size if args.direction in ["down", "both"] else 0
+                data = random.randbytes(up)
+                
+                # Round trips, one request at a time.
+                rtts = []
+                for _ in range(args.count):
+                    start = time.perf_counter()
+                    link.echo(data, down)
+                    rtts.append(time.perf_counter() - start)
+                rtts.sort()
+                
+                # Throughput, with as many requests in flight as the badge allows.
+                start = time.perf_counter()
+                resps = link.echo_many(data, down, args.count)
+                elapsed = time.perf_counter() - start
+                for resp in resps:
+                    if isinstance(resp, BadgelinkError):
+                        raise resp
+                    elif resp.received != up or len(resp.data) != down:
+                        raise MalformedResponseError("Echo response has the wrong size")
+                
+                print(f"{args.count} requests with {up} bytes up and {down} bytes down:")
+                print(f"  round trip  p50 {format_us(rtts[len(rtts) // 2] * 1e6)}, p99 {format_us(rtts[len(rtts) * 99 // 100] * 1e6)}, max {format_us(rtts[-1] * 1e6)}")
+                print(f"  throughput  {up * args.count / elapsed / 1024:.1f} KiB/s up, {down * args.count / elapsed / 1024:.1f} KiB/s down, {args.count / elapsed:.0f} requests/s")
+        
+        elif args.request == "trace":
+            # ==== Trace implementation ==== #
+            events, recorded = link.trace_dump(args.clear)
+            with open(args.output, "w") as fd:
+                json.dump(trace_to_chrome(events), fd)
+            print(f"Wrote {len(events)} events to {args.output}", end="")
+            if recorded > len(events):
+                print(f"; {recorded - len(events)} older events were overwritten")
+            else:
+                print()
             
         elif args.request == "nvs":
             # ==== NVS implementations ==== #
@@ -1159,6 +2544,38 @@ if __name__ == "__main__":
                 entries = link.nvs_list(args.namespace)
                 print_table(["namespace", "key", "type"], [[e.namespc, e.key, nvs_untypes[e.type]] for e in entries])
             
+            elif args.action == "import":
+                # Empty lines and lines starting with `#` are skipped; the value is the rest of the line.
+                ops = []
+                with open(args.file, "r") as fd:
+                    for lineno, line in enumerate(fd, 1):
+                        line = line.strip()
+                        if not line or line.startswith("#"):
+                            continue
+                        fields = line.split(None, 3)
+                        if len(fields) < 4 or fields[2] not in nvs_types:
+                            print(f"{args.file}:{lineno}: expected `namespace key type value`")
+                            sys.exit(1)
+                        try:
+                            ns, key, type = nvs_ns(fields[0]), nvs_ns(fields[1]), fields[2]
+                        except ArgumentTypeError as e:
+                            print(f"{args.file}:{lineno}: {e}")
+                            sys.exit(1)
+                        ops.append(NvsBatchOp(type=NvsActionWrite, namespc=ns, key=key, wdata=parse_nvs_value(type, fields[3], False)))
+                results = link.nvs_batch(ops)
+                failed = [(op, res) for op, res in zip(ops, results) if res.status != StatusOk]
+                for op, res in failed:
+                    print(f"{op.namespc}:{op.key}: {StatusCode.Name(res.status)}")
+                print(f"Wrote {len(ops) - len(failed)} of {len(ops)} values")
+                if failed:
+                    sys.exit(1)
+            
+            elif args.action == "save":
+                link.nvs_export(args.namespace, args.file)
+            
+            elif args.action == "restore":
+                link.nvs_import(args.file)
+            
             else:
                 todo()
         
@@ -1183,10 +2600,10 @@ if __name__ == "__main__":
                 link.appfs_delete(args.slug)
             
             elif args.action == "upload":
-                link.appfs_upload(AppfsMetadata(slug=args.slug, title=args.title, version=args.version), args.file)
+                link.appfs_upload(AppfsMetadata(slug=args.slug, title=args.title, version=args.version), args.file, args.delta, args.resumable)
             
             elif args.action == "download":
-                link.appfs_download(args.slug, args.file)
+                link.appfs_download(args.slug, args.file, args.offset, args.length, args.resume)
             
             elif args.action == "usage":
                 usage = link.appfs_usage()
@@ -1198,8 +2615,13 @@ if __name__ == "__main__":
         elif args.request == "fs":
             # ==== FS implementations ==== #
             if args.action == "list":
-                entries = link.fs_list(args.file)
-                if entries:
+                entries = link.fs_list(args.file, with_stat=args.long)
+                if entries and args.long:
+                    print_table(["type", "size", "modified", "path"], [
+                        ["dir" if e.is_dir else "file", "" if e.is_dir else str(e.size), str(datetime.fromtimestamp(e.mtime / 1000)), e.name]
+                        for e in entries
+                    ])
+                elif entries:
                     print_table(["type", "path"], [["dir" if e.is_dir else "file", e.name] for e in entries])
             
             elif args.action == "stat":
@@ -1220,19 +2642,27 @@ if __name__ == "__main__":
                 link.fs_mkdir(args.file)
             
             elif args.action == "rmdir":
-                link.fs_rmdir(args.file)
+                count = link.fs_rmdir(args.file, args.recursive)
+                if args.recursive:
+                    print(f"Removed {count} files and directories")
             
             elif args.action == "upload":
-                link.fs_upload(args.badge_file, args.host_file)
+                link.fs_upload(args.badge_file, args.host_file, args.delta, args.block_size, args.resumable)
+            
+            elif args.action == "upload-tree":
+                link.fs_upload_tree(args.badge_file, args.host_dir)
             
             elif args.action == "download":
-                link.fs_download(args.badge_file, args.host_file)
+                link.fs_download(args.badge_file, args.host_file, args.offset, args.length, args.resume)
             
             elif args.action == "usage":
-                todo()
+                size, used = link.fs_usage(args.file)
+                print(f"Usage: {used//1024}K / {size//1024}K ({used/size*100 if size else 0:.1f}%)")
 
             elif args.action == "cp":
-                link.fs_copy(args.source, args.dest)
+                count = link.fs_copy(args.source, args.dest, args.recursive)
+                if args.recursive:
+                    print(f"Copied {count} files and directories")
 
             elif args.action == "mv":
                 link.fs_rename(args.source, args.dest)
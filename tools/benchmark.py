@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+
+# Throughput and latency benchmark of BadgeLink against the mock badge (mock/badgemock).
+# Every combination of protocol version and chunk size gets a fresh mock, and the results are written as JSON so
+# they can be compared between releases.
+
+import os
+import sys
+import json
+import time
+import random
+import shlex
+import platform
+import tempfile
+import subprocess
+from argparse import ArgumentParser
+
+from badgelink import AppfsMetadata, Badgelink, DualPipeConnection, NvsValue, NvsValueUint32
+
+default_mock = os.path.join(os.path.dirname(os.path.realpath(__file__)), "..", "mock", "build", "badgemock")
+
+
+class MockBadge:
+    """
+    A mock badge running in a temporary directory, connected over a pair of FIFOs.
+    `sim_args` are the mock's options for simulating the timing of a badge, like `--realistic`.
+    """
+
+    def __init__(self, mock: str, sim_args: list[str] = []):
+        self.dir = tempfile.TemporaryDirectory(prefix="badgelink-bench-")
+        to_badge = os.path.join(self.dir.name, "to_badge")
+        from_badge = os.path.join(self.dir.name, "from_badge")
+        os.mkfifo(to_badge)
+        os.mkfifo(from_badge)
+        self.log = open(os.path.join(self.dir.name, "mock.log"), "w")
+        self.proc = subprocess.Popen([mock, *sim_args, to_badge, from_badge], cwd=self.dir.name, stdout=self.log, stderr=subprocess.STDOUT)
+        # The mock opens its input first, so open it first too or both sides wait for each other.
+        self.outfd = open(to_badge, "wb")
+        self.infd = open(from_badge, "rb")
+        os.set_blocking(self.infd.fileno(), False)
+
+    def path(self, name: str) -> str:
+        """
+        Path on the mock's filesystem, which is the host's.
+        """
+        return os.path.join(self.dir.name, name)
+
+    def close(self, link: Badgelink = None):
+        if link:
+            link.conn.close()
+        # Closing the input makes the mock exit.
+        self.outfd.close()
+        try:
+            self.proc.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+            self.proc.wait()
+        self.infd.close()
+        self.log.close()
+        self.dir.cleanup()
+
+
+def latencies(func, count: int) -> dict:
+    """
+    Call `func` `count` times and summarize how long the calls took.
+    """
+    times = []
+    for _ in range(count):
+        start = time.perf_counter()
+        func()
+        times.append(time.perf_counter() - start)
+    times.sort()
+    return {
+        "ops_per_s": count / sum(times),
+        "p50_ms": times[len(times) // 2] * 1000,
+        "p99_ms": times[min(len(times) - 1, len(times) * 99 // 100)] * 1000,
+    }
+
+
+def run(mock: str, sim_args: list[str], version: int, chunk_size: int, data: bytes, ops: int) -> dict:
+    """
+    Benchmark one protocol version and chunk size against a fresh mock.
+    """
+    badge = MockBadge(mock, sim_args)
+    link = None
+    try:
+        link = Badgelink(DualPipeConnection(badge.infd, badge.outfd), force_version1=version == 1, verbose=False,
+                         max_version=version, max_chunk_size=chunk_size)
+        result = {
+            "requested_version": version,
+            "version": link.protocol_version,
+            "requested_chunk_size": chunk_size,
+            "chunk_size": link.chunk_size,
+        }
+
+        # Throughput of one large file each way; random data so compression doesn't flatter it.
+        badge_file = badge.path("bench.bin")
+        host_file = badge.path("download.bin")
+        start = time.perf_counter()
+        link.fs_upload(badge_file, data)
+        result["upload_mib_s"] = len(data) / (time.perf_counter() - start) / (1 << 20)
+        start = time.perf_counter()
+        link.fs_download(badge_file, host_file)
+        result["download_mib_s"] = len(data) / (time.perf_counter() - start) / (1 << 20)
+        with open(host_file, "rb") as fd:
+            if fd.read() != data:
+                raise RuntimeError("Downloaded file differs from the uploaded one")
+
+        # The same for AppFS, which programs flash instead of writing to a file.
+        start = time.perf_counter()
+        link.appfs_upload(AppfsMetadata(slug="bench", title="Benchmark", version=1, size=len(data)), data)
+        result["appfs_upload_mib_s"] = len(data) / (time.perf_counter() - start) / (1 << 20)
+        start = time.perf_counter()
+        link.appfs_download("bench", host_file)
+        result["appfs_download_mib_s"] = len(data) / (time.perf_counter() - start) / (1 << 20)
+        with open(host_file, "rb") as fd:
+            if fd.read() != data:
+                raise RuntimeError("Downloaded app differs from the uploaded one")
+
+        # Small requests, one at a time, so the latency includes the whole round trip.
+        link.nvs_write("bench", "value", NvsValue(type=NvsValueUint32, numericval=42))
+        os.mkdir(badge.path("dir"))
+        for i in range(16):
+            open(badge.path(f"dir/file{i}"), "wb").close()
+        result["ops"] = {
+            # An empty echo is the round trip of the link and framing alone, which the others build on.
+            "echo": latencies(lambda: link.echo(), ops),
+            "fs_stat": latencies(lambda: link.fs_stat(badge_file), ops),
+            "nvs_read": latencies(lambda: link.nvs_read("bench", "value", NvsValueUint32), ops),
+            "fs_list": latencies(lambda: link.fs_list(badge.path("dir")), ops),
+        }
+        return result
+    finally:
+        badge.close(link)
+
+
+def main():
+    parser = ArgumentParser(description="Benchmark BadgeLink against the mock badge")
+    parser.add_argument("--mock", default=default_mock, help="Path to the badgemock binary")
+    parser.add_argument("--size", type=int, default=4, help="MiB to upload and download")
+    parser.add_argument("--ops", type=int, default=200, help="Number of each small request to time")
+    parser.add_argument("--versions", default=f"1,3,{Badgelink.PROTOCOL_VERSION}",
+                        help="Comma-separated protocol versions to ask for")
+    parser.add_argument("--chunk-sizes", default="1024,4096,16384",
+                        help="Comma-separated chunk sizes to ask for; version 1 always uses 4096")
+    parser.add_argument("--seed", type=int, default=0, help="Seed for the uploaded data")
+    parser.add_argument("--sim", default="",
+                        help="Options for the mock to simulate the timing of a badge, like \"--realistic\" or "
+                             "\"--usb-bandwidth=1000000 --usb-latency=1000\"; see `badgemock --help`")
+    parser.add_argument("--output", default=None, help="File to write the JSON results to instead of stdout")
+    args = parser.parse_args()
+
+    if not os.access(args.mock, os.X_OK):
+        print(f"{sys.argv[0]}: error: {args.mock} is not executable; build it with `make -C mock build`")
+        sys.exit(1)
+
+    sim_args = shlex.split(args.sim)
+    data = random.Random(args.seed).randbytes(args.size << 20)
+    runs = []
+    for version in [int(v) for v in args.versions.split(",")]:
+        # Version 1 doesn't negotiate a chunk size, so there's only one run for it.
+        for chunk_size in [4096] if version == 1 else [int(c) for c in args.chunk_sizes.split(",")]:
+            print(f"Version {version}, {chunk_size}-byte chunks...", file=sys.stderr)
+            runs.append(run(args.mock, sim_args, version, chunk_size, data, args.ops))
+
+    report = {
+        "date": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "host": platform.platform(),
+        "python": platform.python_version(),
+        "size": len(data),
+        "ops": args.ops,
+        "sim": sim_args,
+        "runs": runs,
+    }
+    if args.output:
+        with open(args.output, "w") as fd:
+            json.dump(report, fd, indent=2)
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == "__main__":
+    main()
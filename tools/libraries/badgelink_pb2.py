@@ -24,65 +24,119 @@ _sym_db = _symbol_database.Default()
 
 
 
-DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0f\x62\x61\x64gelink.proto\x12\tbadgelink\"\x9f\x01\n\x0e\x41ppfsActionReq\x12,\n\x08metadata\x18\x02 \x01(\x0b\x32\x18.badgelink.AppfsMetadataH\x00\x12\x0e\n\x04slug\x18\x03 \x01(\tH\x00\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.FsActionType\x12\r\n\x05\x63rc32\x18\x04 \x01(\r\x12\x13\n\x0blist_offset\x18\x05 \x01(\rB\x04\n\x02id\"\xb0\x01\n\x0f\x41ppfsActionResp\x12,\n\x08metadata\x18\x01 \x01(\x0b\x32\x18.badgelink.AppfsMetadataH\x00\x12\x0f\n\x05\x63rc32\x18\x02 \x01(\rH\x00\x12$\n\x04list\x18\x03 \x01(\x0b\x32\x14.badgelink.AppfsListH\x00\x12#\n\x05usage\x18\x04 \x01(\x0b\x32\x12.badgelink.FsUsageH\x00\x12\x0c\n\x04size\x18\x05 \x01(\rB\x05\n\x03val\"G\n\tAppfsList\x12&\n\x04list\x18\x01 \x03(\x0b\x32\x18.badgelink.AppfsMetadata\x12\x12\n\ntotal_size\x18\x02 \x01(\r\"K\n\rAppfsMetadata\x12\x0c\n\x04slug\x18\x01 \x01(\t\x12\r\n\x05title\x18\x02 \x01(\t\x12\x0f\n\x07version\x18\x03 \x01(\r\x12\x0c\n\x04size\x18\x04 \x01(\r\"\'\n\x05\x43hunk\x12\x10\n\x08position\x18\x02 \x01(\r\x12\x0c\n\x04\x64\x61ta\x18\x03 \x01(\x0c\"\x87\x01\n\x0b\x46sActionReq\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.FsActionType\x12\x0c\n\x04path\x18\x02 \x01(\t\x12\r\n\x05\x63rc32\x18\x03 \x01(\r\x12\x13\n\x0blist_offset\x18\x04 \x01(\r\x12\x0c\n\x04size\x18\x05 \x01(\r\x12\x11\n\tdest_path\x18\x06 \x01(\t\"\xa5\x01\n\x0c\x46sActionResp\x12!\n\x04stat\x18\x01 \x01(\x0b\x32\x11.badgelink.FsStatH\x00\x12\x0f\n\x05\x63rc32\x18\x02 \x01(\rH\x00\x12\'\n\x04list\x18\x03 \x01(\x0b\x32\x17.badgelink.FsDirentListH\x00\x12#\n\x05usage\x18\x04 \x01(\x0b\x32\x12.badgelink.FsUsageH\x00\x12\x0c\n\x04size\x18\x05 \x01(\rB\x05\n\x03val\"(\n\x08\x46sDirent\x12\x0c\n\x04name\x18\x01 \x01(\t\x12\x0e\n\x06is_dir\x18\x02 \x01(\x08\"E\n\x0c\x46sDirentList\x12!\n\x04list\x18\x01 \x03(\x0b\x32\x13.badgelink.FsDirent\x12\x12\n\ntotal_size\x18\x02 \x01(\r\"S\n\x06\x46sStat\x12\x0c\n\x04size\x18\x01 \x01(\r\x12\r\n\x05mtime\x18\x02 \x01(\x04\x12\r\n\x05\x63time\x18\x03 \x01(\x04\x12\r\n\x05\x61time\x18\x04 \x01(\x04\x12\x0e\n\x06is_dir\x18\x05 \x01(\x08\"%\n\x07\x46sUsage\x12\x0c\n\x04size\x18\x01 \x01(\r\x12\x0c\n\x04used\x18\x02 \x01(\r\"\xb9\x01\n\x0cNvsActionReq\x12&\n\x04type\x18\x01 \x01(\x0e\x32\x18.badgelink.NvsActionType\x12\x0f\n\x07namespc\x18\x02 \x01(\t\x12\x0b\n\x03key\x18\x03 \x01(\t\x12\"\n\x05wdata\x18\x04 \x01(\x0b\x32\x13.badgelink.NvsValue\x12\x13\n\x0blist_offset\x18\x05 \x01(\r\x12*\n\tread_type\x18\x06 \x01(\x0e\x32\x17.badgelink.NvsValueType\"j\n\rNvsActionResp\x12$\n\x05rdata\x18\x01 \x01(\x0b\x32\x13.badgelink.NvsValueH\x00\x12,\n\x07\x65ntries\x18\x02 \x01(\x0b\x32\x19.badgelink.NvsEntriesListH\x00\x42\x05\n\x03val\"M\n\x0eNvsEntriesList\x12$\n\x07\x65ntries\x18\x01 \x03(\x0b\x32\x13.badgelink.NvsEntry\x12\x15\n\rtotal_entries\x18\x02 \x01(\r\"O\n\x08NvsEntry\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.NvsValueType\x12\x0f\n\x07namespc\x18\x02 \x01(\t\x12\x0b\n\x03key\x18\x03 \x01(\t\"v\n\x08NvsValue\x12\x14\n\nnumericval\x18\x02 \x01(\x04H\x00\x12\x13\n\tstringval\x18\x03 \x01(\tH\x00\x12\x11\n\x07\x62lobval\x18\x04 \x01(\x0cH\x00\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.NvsValueTypeB\x05\n\x03val\"\x82\x01\n\x06Packet\x12%\n\x07request\x18\x02 \x01(\x0b\x32\x12.badgelink.RequestH\x00\x12\'\n\x08response\x18\x03 \x01(\x0b\x32\x13.badgelink.ResponseH\x00\x12\x0e\n\x04sync\x18\x04 \x01(\x08H\x00\x12\x0e\n\x06serial\x18\x01 \x01(\x04\x42\x08\n\x06packet\"\xcd\x02\n\x07Request\x12(\n\x0cupload_chunk\x18\x01 \x01(\x0b\x32\x10.badgelink.ChunkH\x00\x12\x31\n\x0c\x61ppfs_action\x18\x02 \x01(\x0b\x32\x19.badgelink.AppfsActionReqH\x00\x12+\n\tfs_action\x18\x03 \x01(\x0b\x32\x16.badgelink.FsActionReqH\x00\x12-\n\nnvs_action\x18\x04 \x01(\x0b\x32\x17.badgelink.NvsActionReqH\x00\x12+\n\tstart_app\x18\x05 \x01(\x0b\x32\x16.badgelink.StartAppReqH\x00\x12\'\n\txfer_ctrl\x18\x06 \x01(\x0e\x32\x12.badgelink.XferReqH\x00\x12,\n\x0bversion_req\x18\x07 \x01(\x0b\x32\x15.badgelink.VersionReqH\x00\x42\x05\n\x03req\"\xa6\x02\n\x08Response\x12*\n\x0e\x64ownload_chunk\x18\x02 \x01(\x0b\x32\x10.badgelink.ChunkH\x00\x12\x30\n\nappfs_resp\x18\x03 \x01(\x0b\x32\x1a.badgelink.AppfsActionRespH\x00\x12*\n\x07\x66s_resp\x18\x04 \x01(\x0b\x32\x17.badgelink.FsActionRespH\x00\x12,\n\x08nvs_resp\x18\x05 \x01(\x0b\x32\x18.badgelink.NvsActionRespH\x00\x12.\n\x0cversion_resp\x18\x06 \x01(\x0b\x32\x16.badgelink.VersionRespH\x00\x12*\n\x0bstatus_code\x18\x01 \x01(\x0e\x32\x15.badgelink.StatusCodeB\x06\n\x04resp\"(\n\x0bStartAppReq\x12\x0c\n\x04slug\x18\x01 \x01(\t\x12\x0b\n\x03\x61rg\x18\x02 \x01(\t\"$\n\nVersionReq\x12\x16\n\x0e\x63lient_version\x18\x01 \x01(\r\"A\n\x0bVersionResp\x12\x16\n\x0eserver_version\x18\x01 \x01(\r\x12\x1a\n\x12negotiated_version\x18\x02 \x01(\r*\xe5\x01\n\x0c\x46sActionType\x12\x10\n\x0c\x46sActionList\x10\x00\x12\x12\n\x0e\x46sActionDelete\x10\x01\x12\x11\n\rFsActionMkdir\x10\x02\x12\x12\n\x0e\x46sActionUpload\x10\x03\x12\x14\n\x10\x46sActionDownload\x10\x04\x12\x10\n\x0c\x46sActionStat\x10\x05\x12\x11\n\rFsActionCrc23\x10\x06\x12\x14\n\x10\x46sActionGetUsage\x10\x07\x12\x11\n\rFsActionRmdir\x10\x08\x12\x10\n\x0c\x46sActionCopy\x10\t\x12\x12\n\x0e\x46sActionRename\x10\n*^\n\rNvsActionType\x12\x11\n\rNvsActionList\x10\x00\x12\x11\n\rNvsActionRead\x10\x01\x12\x12\n\x0eNvsActionWrite\x10\x02\x12\x13\n\x0fNvsActionDelete\x10\x03*\xce\x01\n\x0cNvsValueType\x12\x11\n\rNvsValueUint8\x10\x00\x12\x10\n\x0cNvsValueInt8\x10\x01\x12\x12\n\x0eNvsValueUint16\x10\x02\x12\x11\n\rNvsValueInt16\x10\x03\x12\x12\n\x0eNvsValueUint32\x10\x04\x12\x11\n\rNvsValueInt32\x10\x05\x12\x12\n\x0eNvsValueUint64\x10\x06\x12\x11\n\rNvsValueInt64\x10\x07\x12\x12\n\x0eNvsValueString\x10\x08\x12\x10\n\x0cNvsValueBlob\x10\t*\xe8\x01\n\nStatusCode\x12\x0c\n\x08StatusOk\x10\x00\x12\x16\n\x12StatusNotSupported\x10\x01\x12\x12\n\x0eStatusNotFound\x10\x02\x12\x13\n\x0fStatusMalformed\x10\x03\x12\x17\n\x13StatusInternalError\x10\x04\x12\x16\n\x12StatusIllegalState\x10\x05\x12\x11\n\rStatusNoSpace\x10\x06\x12\x12\n\x0eStatusNotEmpty\x10\x07\x12\x10\n\x0cStatusIsFile\x10\x08\x12\x0f\n\x0bStatusIsDir\x10\t\x12\x10\n\x0cStatusExists\x10\n*:\n\x07XferReq\x12\x10\n\x0cXferContinue\x10\x00\x12\r\n\tXferAbort\x10\x01\x12\x0e\n\nXferFinish\x10\x02\x62\x06proto3')
+DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0f\x62\x61\x64gelink.proto\x12\tbadgelink\"\x8a\x02\n\x0e\x41ppfsActionReq\x12,\n\x08metadata\x18\x02 \x01(\x0b\x32\x18.badgelink.AppfsMetadataH\x00\x12\x0e\n\x04slug\x18\x03 \x01(\tH\x00\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.FsActionType\x12\r\n\x05\x63rc32\x18\x04 \x01(\r\x12\x13\n\x0blist_offset\x18\x05 \x01(\r\x12\r\n\x05\x64\x65lta\x18\x06 \x01(\x08\x12\x17\n\x0f\x63ompressed_size\x18\x07 \x01(\r\x12\x0e\n\x06sha256\x18\x08 \x01(\x0c\x12\x0e\n\x06offset\x18\t \x01(\r\x12\x0e\n\x06length\x18\n \x01(\r\x12\x11\n\tresumable\x18\x0b \x01(\x08\x42\x04\n\x02id\"\xf2\x01\n\x0f\x41ppfsActionResp\x12,\n\x08metadata\x18\x01 \x01(\x0b\x32\x18.badgelink.AppfsMetadataH\x00\x12\x0f\n\x05\x63rc32\x18\x02 \x01(\rH\x00\x12$\n\x04list\x18\x03 \x01(\x0b\x32\x14.badgelink.AppfsListH\x00\x12#\n\x05usage\x18\x04 \x01(\x0b\x32\x12.badgelink.FsUsageH\x00\x12\x31\n\x0bsector_crcs\x18\x06 \x01(\x0b\x32\x1a.badgelink.AppfsSectorCrcsH\x00\x12\x0c\n\x04size\x18\x05 \x01(\r\x12\r\n\x05\x63ount\x18\x07 \x01(\rB\x05\n\x03val\"\\\n\x0f\x41ppfsSectorCrcs\x12\x0e\n\x06offset\x18\x01 \x01(\r\x12\r\n\x05\x63rc32\x18\x02 \x03(\x07\x12\x15\n\rtotal_sectors\x18\x03 \x01(\r\x12\x13\n\x0bsector_size\x18\x04 \x01(\r\"G\n\tAppfsList\x12&\n\x04list\x18\x01 \x03(\x0b\x32\x18.badgelink.AppfsMetadata\x12\x12\n\ntotal_size\x18\x02 \x01(\r\"K\n\rAppfsMetadata\x12\x0c\n\x04slug\x18\x01 \x01(\t\x12\r\n\x05title\x18\x02 \x01(\t\x12\x0f\n\x07version\x18\x03 \x01(\r\x12\x0c\n\x04size\x18\x04 \x01(\r\";\n\x05\x43hunk\x12\x10\n\x08position\x18\x02 \x01(\r\x12\x0c\n\x04\x64\x61ta\x18\x03 \x01(\x0c\x12\x12\n\ncompressed\x18\x04 \x01(\x08\"\xcb\x02\n\x0b\x46sActionReq\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.FsActionType\x12\x0c\n\x04path\x18\x02 \x01(\t\x12\r\n\x05\x63rc32\x18\x03 \x01(\r\x12\x13\n\x0blist_offset\x18\x04 \x01(\r\x12\x0c\n\x04size\x18\x05 \x01(\r\x12\x11\n\tdest_path\x18\x06 \x01(\t\x12\x12\n\nblock_size\x18\x07 \x01(\r\x12\r\n\x05\x64\x65lta\x18\x08 \x01(\x08\x12\x0e\n\x06\x63ursor\x18\t \x01(\r\x12\x12\n\nuse_cursor\x18\n \x01(\x08\x12\x12\n\nskip_total\x18\x0b \x01(\x08\x12\x11\n\twith_stat\x18\x0c \x01(\x08\x12\x11\n\trecursive\x18\r \x01(\x08\x12\x0e\n\x06sha256\x18\x0e \x01(\x0c\x12\x0e\n\x06offset\x18\x0f \x01(\r\x12\x0e\n\x06length\x18\x10 \x01(\r\x12\x11\n\tresumable\x18\x11 \x01(\x08\"\xd8\x01\n\x0c\x46sActionResp\x12!\n\x04stat\x18\x01 \x01(\x0b\x32\x11.badgelink.FsStatH\x00\x12\x0f\n\x05\x63rc32\x18\x02 \x01(\rH\x00\x12\'\n\x04list\x18\x03 \x01(\x0b\x32\x17.badgelink.FsDirentListH\x00\x12#\n\x05usage\x18\x04 \x01(\x0b\x32\x12.badgelink.FsUsageH\x00\x12\x31\n\x0bsector_crcs\x18\x06 \x01(\x0b\x32\x1a.badgelink.AppfsSectorCrcsH\x00\x12\x0c\n\x04size\x18\x05 \x01(\rB\x05\n\x03val\"W\n\x08\x46sDirent\x12\x0c\n\x04name\x18\x01 \x01(\t\x12\x0e\n\x06is_dir\x18\x02 \x01(\x08\x12\x0c\n\x04size\x18\x03 \x01(\r\x12\r\n\x05mtime\x18\x04 \x01(\x04\x12\x10\n\x08has_stat\x18\x05 \x01(\x08\"U\n\x0c\x46sDirentList\x12!\n\x04list\x18\x01 \x03(\x0b\x32\x13.badgelink.FsDirent\x12\x12\n\ntotal_size\x18\x02 \x01(\r\x12\x0e\n\x06\x63ursor\x18\x03 \x01(\r\"S\n\x06\x46sStat\x12\x0c\n\x04size\x18\x01 \x01(\r\x12\r\n\x05mtime\x18\x02 \x01(\x04\x12\r\n\x05\x63time\x18\x03 \x01(\x04\x12\r\n\x05\x61time\x18\x04 \x01(\x04\x12\x0e\n\x06is_dir\x18\x05 \x01(\x08\"\x1e\n\rFsStatManyReq\x12\r\n\x05paths\x18\x01 \x01(\x0c\"x\n\x0c\x46sStatResult\x12%\n\x06status\x18\x01 \x01(\x0e\x32\x15.badgelink.StatusCode\x12\x1f\n\x04stat\x18\x02 \x01(\x0b\x32\x11.badgelink.FsStat\x12\r\n\x05\x63rc32\x18\x03 \x01(\r\x12\x11\n\thas_crc32\x18\x04 \x01(\x08\":\n\x0e\x46sStatManyResp\x12(\n\x07results\x18\x01 \x03(\x0b\x32\x17.badgelink.FsStatResult\"3\n\x07\x46sUsage\x12\x0c\n\x04size\x18\x01 \x01(\r\x12\x0c\n\x04used\x18\x02 \x01(\r\x12\x0c\n\x04unit\x18\x03 \x01(\r\"\xb4\x02\n\x0cNvsActionReq\x12&\n\x04type\x18\x01 \x01(\x0e\x32\x18.badgelink.NvsActionType\x12\x0f\n\x07namespc\x18\x02 \x01(\t\x12\x0b\n\x03key\x18\x03 \x01(\t\x12\"\n\x05wdata\x18\x04 \x01(\x0b\x32\x13.badgelink.NvsValue\x12\x13\n\x0blist_offset\x18\x05 \x01(\r\x12*\n\tread_type\x18\x06 \x01(\x0e\x32\x17.badgelink.NvsValueType\x12$\n\x05\x62\x61tch\x18\x07 \x03(\x0b\x32\x15.badgelink.NvsBatchOp\x12\x0e\n\x06\x63ursor\x18\x08 \x01(\r\x12\x12\n\nuse_cursor\x18\t \x01(\x08\x12\x12\n\nskip_total\x18\n \x01(\x08\x12\x0c\n\x04size\x18\x0b \x01(\r\x12\r\n\x05\x63rc32\x18\x0c \x01(\r\"\xa2\x01\n\nNvsBatchOp\x12&\n\x04type\x18\x01 \x01(\x0e\x32\x18.badgelink.NvsActionType\x12\x0f\n\x07namespc\x18\x02 \x01(\t\x12\x0b\n\x03key\x18\x03 \x01(\t\x12\"\n\x05wdata\x18\x04 \x01(\x0b\x32\x13.badgelink.NvsValue\x12*\n\tread_type\x18\x05 \x01(\x0e\x32\x17.badgelink.NvsValueType\"\xb1\x01\n\rNvsActionResp\x12$\n\x05rdata\x18\x01 \x01(\x0b\x32\x13.badgelink.NvsValueH\x00\x12,\n\x07\x65ntries\x18\x02 \x01(\x0b\x32\x19.badgelink.NvsEntriesListH\x00\x12(\n\x05\x62\x61tch\x18\x03 \x01(\x0b\x32\x17.badgelink.NvsBatchRespH\x00\x12\x0c\n\x04size\x18\x04 \x01(\r\x12\r\n\x05\x63rc32\x18\x05 \x01(\rB\x05\n\x03val\":\n\x0cNvsBatchResp\x12*\n\x07results\x18\x01 \x03(\x0b\x32\x19.badgelink.NvsBatchResult\"[\n\x0eNvsBatchResult\x12%\n\x06status\x18\x01 \x01(\x0e\x32\x15.badgelink.StatusCode\x12\"\n\x05rdata\x18\x02 \x01(\x0b\x32\x13.badgelink.NvsValue\"]\n\x0eNvsEntriesList\x12$\n\x07\x65ntries\x18\x01 \x03(\x0b\x32\x13.badgelink.NvsEntry\x12\x15\n\rtotal_entries\x18\x02 \x01(\r\x12\x0e\n\x06\x63ursor\x18\x03 \x01(\r\"O\n\x08NvsEntry\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.NvsValueType\x12\x0f\n\x07namespc\x18\x02 \x01(\t\x12\x0b\n\x03key\x18\x03 \x01(\t\"v\n\x08NvsValue\x12\x14\n\nnumericval\x18\x02 \x01(\x04H\x00\x12\x13\n\tstringval\x18\x03 \x01(\tH\x00\x12\x11\n\x07\x62lobval\x18\x04 \x01(\x0cH\x00\x12%\n\x04type\x18\x01 \x01(\x0e\x32\x17.badgelink.NvsValueTypeB\x05\n\x03val\"\xf0\x01\n\x06Packet\x12%\n\x07request\x18\x02 \x01(\x0b\x32\x12.badgelink.RequestH\x00\x12\'\n\x08response\x18\x03 \x01(\x0b\x32\x13.badgelink.ResponseH\x00\x12\x0e\n\x04sync\x18\x04 \x01(\x08H\x00\x12\x1d\n\x03nak\x18\x05 \x01(\x0b\x32\x0e.badgelink.NakH\x00\x12\x0e\n\x06serial\x18\x01 \x01(\x04\x12$\n\x05hello\x18\x06 \x01(\x0b\x32\x15.badgelink.VersionReq\x12\'\n\x07welcome\x18\x07 \x01(\x0b\x32\x16.badgelink.VersionRespB\x08\n\x06packet\"\xff\x04\n\x07Request\x12(\n\x0cupload_chunk\x18\x01 \x01(\x0b\x32\x10.badgelink.ChunkH\x00\x12\x31\n\x0c\x61ppfs_action\x18\x02 \x01(\x0b\x32\x19.badgelink.AppfsActionReqH\x00\x12+\n\tfs_action\x18\x03 \x01(\x0b\x32\x16.badgelink.FsActionReqH\x00\x12-\n\nnvs_action\x18\x04 \x01(\x0b\x32\x17.badgelink.NvsActionReqH\x00\x12+\n\tstart_app\x18\x05 \x01(\x0b\x32\x16.badgelink.StartAppReqH\x00\x12\'\n\txfer_ctrl\x18\x06 \x01(\x0e\x32\x12.badgelink.XferReqH\x00\x12,\n\x0bversion_req\x18\x07 \x01(\x0b\x32\x15.badgelink.VersionReqH\x00\x12\x15\n\x0bxfer_credit\x18\x08 \x01(\rH\x00\x12(\n\tstats_req\x18\n \x01(\x0b\x32\x13.badgelink.StatsReqH\x00\x12(\n\ttrace_req\x18\x0b \x01(\x0b\x32\x13.badgelink.TraceReqH\x00\x12\x30\n\rhistogram_req\x18\x0c \x01(\x0b\x32\x17.badgelink.HistogramReqH\x00\x12(\n\tbench_req\x18\r \x01(\x0b\x32\x13.badgelink.BenchReqH\x00\x12&\n\x08\x65\x63ho_req\x18\x0e \x01(\x0b\x32\x12.badgelink.EchoReqH\x00\x12\x30\n\x0c\x66s_stat_many\x18\x0f \x01(\x0b\x32\x18.badgelink.FsStatManyReqH\x00\x12\x0f\n\x07session\x18\t \x01(\rB\x05\n\x03req\"\x81\x05\n\x08Response\x12*\n\x0e\x64ownload_chunk\x18\x02 \x01(\x0b\x32\x10.badgelink.ChunkH\x00\x12\x30\n\nappfs_resp\x18\x03 \x01(\x0b\x32\x1a.badgelink.AppfsActionRespH\x00\x12*\n\x07\x66s_resp\x18\x04 \x01(\x0b\x32\x17.badgelink.FsActionRespH\x00\x12,\n\x08nvs_resp\x18\x05 \x01(\x0b\x32\x18.badgelink.NvsActionRespH\x00\x12.\n\x0cversion_resp\x18\x06 \x01(\x0b\x32\x16.badgelink.VersionRespH\x00\x12&\n\x08xfer_ack\x18\x07 \x01(\x0b\x32\x12.badgelink.XferAckH\x00\x12,\n\x0bxfer_result\x18\x08 \x01(\x0b\x32\x15.badgelink.XferResultH\x00\x12!\n\x05stats\x18\n \x01(\x0b\x32\x10.badgelink.StatsH\x00\x12%\n\x05trace\x18\x0b \x01(\x0b\x32\x14.badgelink.TraceDumpH\x00\x12+\n\nhistograms\x18\x0c \x01(\x0b\x32\x15.badgelink.HistogramsH\x00\x12\'\n\x05\x62\x65nch\x18\r \x01(\x0b\x32\x16.badgelink.BenchResultH\x00\x12#\n\x04\x65\x63ho\x18\x0e \x01(\x0b\x32\x13.badgelink.EchoRespH\x00\x12-\n\x08\x66s_stats\x18\x0f \x01(\x0b\x32\x19.badgelink.FsStatManyRespH\x00\x12*\n\x0bstatus_code\x18\x01 \x01(\x0e\x32\x15.badgelink.StatusCode\x12\x0f\n\x07session\x18\t \x01(\rB\x06\n\x04resp\"(\n\x0bStartAppReq\x12\x0c\n\x04slug\x18\x01 \x01(\t\x12\x0b\n\x03\x61rg\x18\x02 \x01(\t\"\x95\x01\n\nVersionReq\x12\x16\n\x0e\x63lient_version\x18\x01 \x01(\r\x12\x16\n\x0emax_chunk_size\x18\x02 \x01(\r\x12\x30\n\x0b\x63ompression\x18\x03 \x01(\x0e\x32\x1b.badgelink.ChunkCompression\x12%\n\x06\x64igest\x18\x04 \x01(\x0e\x32\x15.badgelink.DigestType\"\xdb\x01\n\x0bVersionResp\x12\x16\n\x0eserver_version\x18\x01 \x01(\r\x12\x1a\n\x12negotiated_version\x18\x02 \x01(\r\x12\x15\n\rupload_window\x18\x03 \x01(\r\x12\x12\n\nchunk_size\x18\x04 \x01(\r\x12\x30\n\x0b\x63ompression\x18\x05 \x01(\x0e\x32\x1b.badgelink.ChunkCompression\x12%\n\x06\x64igest\x18\x06 \x01(\x0e\x32\x15.badgelink.DigestType\x12\x14\n\x0c\x63\x61pabilities\x18\x07 \x01(\r\"/\n\x07XferAck\x12\x10\n\x08position\x18\x01 \x01(\r\x12\x12\n\nretransmit\x18\x02 \x01(\x08\"9\n\nXferResult\x12\r\n\x05\x63rc32\x18\x01 \x01(\r\x12\x0c\n\x04size\x18\x02 \x01(\r\x12\x0e\n\x06sha256\x18\x03 \x01(\x0c\"N\n\x03Nak\x12$\n\x06reason\x18\x01 \x01(\x0e\x32\x14.badgelink.NakReason\x12\x0f\n\x07session\x18\x02 \x01(\r\x12\x10\n\x08position\x18\x03 \x01(\r\"\x19\n\x08StatsReq\x12\r\n\x05reset\x18\x01 \x01(\x08\"\xd1\x02\n\x05Stats\x12\x11\n\tperiod_ms\x18\x01 \x01(\r\x12\x11\n\tframes_rx\x18\x02 \x01(\r\x12\x11\n\tframes_tx\x18\x03 \x01(\r\x12\x10\n\x08\x62ytes_rx\x18\x04 \x01(\x04\x12\x10\n\x08\x62ytes_tx\x18\x05 \x01(\x04\x12\x13\n\x0brx_overflow\x18\x06 \x01(\x04\x12\x12\n\ncrc_errors\x18\x07 \x01(\r\x12\x16\n\x0e\x66raming_errors\x18\x08 \x01(\r\x12\x15\n\rdecode_errors\x18\t \x01(\r\x12\x13\n\x0bretransmits\x18\n \x01(\r\x12\x11\n\tnaks_sent\x18\x0b \x01(\r\x12\x0f\n\x07\x63obs_us\x18\x0c \x01(\x04\x12\x11\n\tdecode_us\x18\r \x01(\x04\x12\x11\n\thandle_us\x18\x0e \x01(\x04\x12\x11\n\tencode_us\x18\x0f \x01(\x04\x12\x12\n\nstorage_us\x18\x10 \x01(\x04\x12\r\n\x05xfers\x18\x11 \x01(\r\")\n\x08TraceReq\x12\x0e\n\x06offset\x18\x01 \x01(\r\x12\r\n\x05\x63lear\x18\x02 \x01(\x08\"J\n\tTraceDump\x12\r\n\x05total\x18\x01 \x01(\r\x12\x10\n\x08recorded\x18\x02 \x01(\r\x12\x0c\n\x04next\x18\x03 \x01(\r\x12\x0e\n\x06\x65vents\x18\x04 \x01(\x0c\"-\n\x0cHistogramReq\x12\x0e\n\x06offset\x18\x01 \x01(\r\x12\r\n\x05reset\x18\x02 \x01(\x08\"k\n\tHistogram\x12(\n\x05stage\x18\x01 \x01(\x0e\x32\x19.badgelink.HistogramStage\x12\x11\n\twhich_req\x18\x02 \x01(\r\x12\x10\n\x08total_us\x18\x03 \x01(\x04\x12\x0f\n\x07\x62uckets\x18\x04 \x03(\r\"W\n\nHistograms\x12\x11\n\tperiod_ms\x18\x01 \x01(\r\x12(\n\nhistograms\x18\x02 \x03(\x0b\x32\x14.badgelink.Histogram\x12\x0c\n\x04next\x18\x03 \x01(\r\"5\n\x08\x42\x65nchReq\x12\x0c\n\x04path\x18\x01 \x01(\t\x12\x0c\n\x04size\x18\x02 \x01(\r\x12\r\n\x05\x61ppfs\x18\x03 \x01(\x08\"\x8d\x02\n\x0b\x42\x65nchResult\x12\x0c\n\x04size\x18\x01 \x01(\r\x12\x12\n\nchunk_size\x18\x02 \x01(\r\x12\x16\n\x0e\x61ppfs_erase_us\x18\x03 \x01(\r\x12\x16\n\x0e\x61ppfs_write_us\x18\x04 \x01(\r\x12\x15\n\rappfs_read_us\x18\x05 \x01(\r\x12\x13\n\x0b\x66s_write_us\x18\x06 \x01(\r\x12\x12\n\nfs_read_us\x18\x07 \x01(\r\x12\x10\n\x08\x63rc32_us\x18\x08 \x01(\r\x12\x16\n\x0e\x63obs_encode_us\x18\t \x01(\r\x12\x16\n\x0e\x63obs_decode_us\x18\n \x01(\r\x12\x14\n\x0cpb_encode_us\x18\x0b \x01(\r\x12\x14\n\x0cpb_decode_us\x18\x0c \x01(\r\"+\n\x07\x45\x63hoReq\x12\x0c\n\x04\x64\x61ta\x18\x01 \x01(\x0c\x12\x12\n\nreply_size\x18\x02 \x01(\r\"*\n\x08\x45\x63hoResp\x12\x10\n\x08received\x18\x01 \x01(\r\x12\x0c\n\x04\x64\x61ta\x18\x02 \x01(\x0c*\x96\x02\n\x0c\x46sActionType\x12\x10\n\x0c\x46sActionList\x10\x00\x12\x12\n\x0e\x46sActionDelete\x10\x01\x12\x11\n\rFsActionMkdir\x10\x02\x12\x12\n\x0e\x46sActionUpload\x10\x03\x12\x14\n\x10\x46sActionDownload\x10\x04\x12\x10\n\x0c\x46sActionStat\x10\x05\x12\x11\n\rFsActionCrc23\x10\x06\x12\x14\n\x10\x46sActionGetUsage\x10\x07\x12\x11\n\rFsActionRmdir\x10\x08\x12\x10\n\x0c\x46sActionCopy\x10\t\x12\x12\n\x0e\x46sActionRename\x10\n\x12\x17\n\x13\x46sActionSectorCrc32\x10\x0b\x12\x16\n\x12\x46sActionTreeUpload\x10\x0c*\x9c\x01\n\rNvsActionType\x12\x11\n\rNvsActionList\x10\x00\x12\x11\n\rNvsActionRead\x10\x01\x12\x12\n\x0eNvsActionWrite\x10\x02\x12\x13\n\x0fNvsActionDelete\x10\x03\x12\x12\n\x0eNvsActionBatch\x10\x04\x12\x13\n\x0fNvsActionExport\x10\x05\x12\x13\n\x0fNvsActionImport\x10\x06*\xce\x01\n\x0cNvsValueType\x12\x11\n\rNvsValueUint8\x10\x00\x12\x10\n\x0cNvsValueInt8\x10\x01\x12\x12\n\x0eNvsValueUint16\x10\x02\x12\x11\n\rNvsValueInt16\x10\x03\x12\x12\n\x0eNvsValueUint32\x10\x04\x12\x11\n\rNvsValueInt32\x10\x05\x12\x12\n\x0eNvsValueUint64\x10\x06\x12\x11\n\rNvsValueInt64\x10\x07\x12\x12\n\x0eNvsValueString\x10\x08\x12\x10\n\x0cNvsValueBlob\x10\t*\xe8\x01\n\nStatusCode\x12\x0c\n\x08StatusOk\x10\x00\x12\x16\n\x12StatusNotSupported\x10\x01\x12\x12\n\x0eStatusNotFound\x10\x02\x12\x13\n\x0fStatusMalformed\x10\x03\x12\x17\n\x13StatusInternalError\x10\x04\x12\x16\n\x12StatusIllegalState\x10\x05\x12\x11\n\rStatusNoSpace\x10\x06\x12\x12\n\x0eStatusNotEmpty\x10\x07\x12\x10\n\x0cStatusIsFile\x10\x08\x12\x0f\n\x0bStatusIsDir\x10\t\x12\x10\n\x0cStatusExists\x10\n*:\n\x07XferReq\x12\x10\n\x0cXferContinue\x10\x00\x12\r\n\tXferAbort\x10\x01\x12\x0e\n\nXferFinish\x10\x02*;\n\x10\x43hunkCompression\x12\x13\n\x0f\x43ompressionNone\x10\x00\x12\x12\n\x0e\x43ompressionLzf\x10\x01*.\n\nDigestType\x12\x0e\n\nDigestNone\x10\x00\x12\x10\n\x0c\x44igestSha256\x10\x01*6\n\tNakReason\x12\n\n\x06NakCrc\x10\x00\x12\x0e\n\nNakFraming\x10\x01\x12\r\n\tNakDecode\x10\x02*\xc4\x01\n\x0eTraceEventType\x12\x13\n\x0fTraceFrameStart\x10\x00\x12\x11\n\rTraceFrameEnd\x10\x01\x12\x10\n\x0cTraceDecoded\x10\x02\x12\x14\n\x10TraceHandleBegin\x10\x03\x12\x12\n\x0eTraceHandleEnd\x10\x04\x12\x15\n\x11TraceStorageBegin\x10\x05\x12\x13\n\x0fTraceStorageEnd\x10\x06\x12\x11\n\rTraceTxQueued\x10\x07\x12\x0f\n\x0bTraceTxDone\x10\x08*\x8a\x01\n\x0eHistogramStage\x12\r\n\tStageCobs\x10\x00\x12\x0f\n\x0bStageDecode\x10\x01\x12\x0f\n\x0bStageHandle\x10\x02\x12\x0f\n\x0bStageEncode\x10\x03\x12\x15\n\x11StageStorageAppfs\x10\x04\x12\x12\n\x0eStageStorageFs\x10\x05\x12\x0b\n\x07StageTx\x10\x06*\xef\x01\n\nCapability\x12\x0b\n\x07\x43\x61pNone\x10\x00\x12\t\n\x05\x43\x61pFs\x10\x01\x12\x0c\n\x08\x43\x61pAppfs\x10\x02\x12\n\n\x06\x43\x61pNvs\x10\x04\x12\x0f\n\x0b\x43\x61pStartApp\x10\x08\x12\x0c\n\x08\x43\x61pBench\x10\x10\x12\x0c\n\x08\x43\x61pTrace\x10 \x12\x11\n\rCapHistograms\x10@\x12\x10\n\x0b\x43\x61pNvsBatch\x10\x80\x01\x12\r\n\x08\x43\x61pDelta\x10\x80\x02\x12\x12\n\rCapTreeUpload\x10\x80\x04\x12\x11\n\x0c\x43\x61pResumable\x10\x80\x08\x12\x13\n\x0e\x43\x61pNvsSnapshot\x10\x80\x10\x12\x12\n\rCapFsStatMany\x10\x80 b\x06proto3')
 
 _globals = globals()
 _builder.BuildMessageAndEnumDescriptors(DESCRIPTOR, _globals)
 _builder.BuildTopDescriptorsAndMessages(DESCRIPTOR, 'badgelink_pb2', _globals)
 if not _descriptor._USE_C_DESCRIPTORS:
   DESCRIPTOR._loaded_options = None
-  _globals['_FSACTIONTYPE']._serialized_start=2595
-  _globals['_FSACTIONTYPE']._serialized_end=2824
-  _globals['_NVSACTIONTYPE']._serialized_start=2826
-  _globals['_NVSACTIONTYPE']._serialized_end=2920
-  _globals['_NVSVALUETYPE']._serialized_start=2923
-  _globals['_NVSVALUETYPE']._serialized_end=3129
-  _globals['_STATUSCODE']._serialized_start=3132
-  _globals['_STATUSCODE']._serialized_end=3364
-  _globals['_XFERREQ']._serialized_start=3366
-  _globals['_XFERREQ']._serialized_end=3424
+  _globals['_FSACTIONTYPE']._serialized_start=6316
+  _globals['_FSACTIONTYPE']._serialized_end=6594
+  _globals['_NVSACTIONTYPE']._serialized_start=6597
+  _globals['_NVSACTIONTYPE']._serialized_end=6753
+  _globals['_NVSVALUETYPE']._serialized_start=6756
+  _globals['_NVSVALUETYPE']._serialized_end=6962
+  _globals['_STATUSCODE']._serialized_start=6965
+  _globals['_STATUSCODE']._serialized_end=7197
+  _globals['_XFERREQ']._serialized_start=7199
+  _globals['_XFERREQ']._serialized_end=7257
+  _globals['_CHUNKCOMPRESSION']._serialized_start=7259
+  _globals['_CHUNKCOMPRESSION']._serialized_end=7318
+  _globals['_DIGESTTYPE']._serialized_start=7320
+  _globals['_DIGESTTYPE']._serialized_end=7366
+  _globals['_NAKREASON']._serialized_start=7368
+  _globals['_NAKREASON']._serialized_end=7422
+  _globals['_TRACEEVENTTYPE']._serialized_start=7425
+  _globals['_TRACEEVENTTYPE']._serialized_end=7621
+  _globals['_HISTOGRAMSTAGE']._serialized_start=7624
+  _globals['_HISTOGRAMSTAGE']._serialized_end=7762
+  _globals['_CAPABILITY']._serialized_start=7765
+  _globals['_CAPABILITY']._serialized_end=8004
   _globals['_APPFSACTIONREQ']._serialized_start=31
-  _globals['_APPFSACTIONREQ']._serialized_end=190
-  _globals['_APPFSACTIONRESP']._serialized_start=193
-  _globals['_APPFSACTIONRESP']._serialized_end=369
-  _globals['_APPFSLIST']._serialized_start=371
-  _globals['_APPFSLIST']._serialized_end=442
-  _globals['_APPFSMETADATA']._serialized_start=444
-  _globals['_APPFSMETADATA']._serialized_end=519
-  _globals['_CHUNK']._serialized_start=521
-  _globals['_CHUNK']._serialized_end=560
-  _globals['_FSACTIONREQ']._serialized_start=563
-  _globals['_FSACTIONREQ']._serialized_end=698
-  _globals['_FSACTIONRESP']._serialized_start=701
-  _globals['_FSACTIONRESP']._serialized_end=866
-  _globals['_FSDIRENT']._serialized_start=868
-  _globals['_FSDIRENT']._serialized_end=908
-  _globals['_FSDIRENTLIST']._serialized_start=910
-  _globals['_FSDIRENTLIST']._serialized_end=979
-  _globals['_FSSTAT']._serialized_start=981
-  _globals['_FSSTAT']._serialized_end=1064
-  _globals['_FSUSAGE']._serialized_start=1066
-  _globals['_FSUSAGE']._serialized_end=1103
-  _globals['_NVSACTIONREQ']._serialized_start=1106
-  _globals['_NVSACTIONREQ']._serialized_end=1291
-  _globals['_NVSACTIONRESP']._serialized_start=1293
-  _globals['_NVSACTIONRESP']._serialized_end=1399
-  _globals['_NVSENTRIESLIST']._serialized_start=1401
-  _globals['_NVSENTRIESLIST']._serialized_end=1478
-  _globals['_NVSENTRY']._serialized_start=1480
-  _globals['_NVSENTRY']._serialized_end=1559
-  _globals['_NVSVALUE']._serialized_start=1561
-  _globals['_NVSVALUE']._serialized_end=1679
-  _globals['_PACKET']._serialized_start=1682
-  _globals['_PACKET']._serialized_end=1812
-  _globals['_REQUEST']._serialized_start=1815
-  _globals['_REQUEST']._serialized_end=2148
-  _globals['_RESPONSE']._serialized_start=2151
-  _globals['_RESPONSE']._serialized_end=2445
-  _globals['_STARTAPPREQ']._serialized_start=2447
-  _globals['_STARTAPPREQ']._serialized_end=2487
-  _globals['_VERSIONREQ']._serialized_start=2489
-  _globals['_VERSIONREQ']._serialized_end=2525
-  _globals['_VERSIONRESP']._serialized_start=2527
-  _globals['_VERSIONRESP']._serialized_end=2592
+  _globals['_APPFSACTIONREQ']._serialized_end=297
+  _globals['_APPFSACTIONRESP']._serialized_start=300
+  _globals['_APPFSACTIONRESP']._serialized_end=542
+  _globals['_APPFSSECTORCRCS']._serialized_start=544
+  _globals['_APPFSSECTORCRCS']._serialized_end=636
+  _globals['_APPFSLIST']._serialized_start=638
+  _globals['_APPFSLIST']._serialized_end=709
+  _globals['_APPFSMETADATA']._serialized_start=711
+  _globals['_APPFSMETADATA']._serialized_end=786
+  _globals['_CHUNK']._serialized_start=788
+  _globals['_CHUNK']._serialized_end=847
+  _globals['_FSACTIONREQ']._serialized_start=850
+  _globals['_FSACTIONREQ']._serialized_end=1181
+  _globals['_FSACTIONRESP']._serialized_start=1184
+  _globals['_FSACTIONRESP']._serialized_end=1400
+  _globals['_FSDIRENT']._serialized_start=1402
+  _globals['_FSDIRENT']._serialized_end=1489
+  _globals['_FSDIRENTLIST']._serialized_start=1491
+  _globals['_FSDIRENTLIST']._serialized_end=1576
+  _globals['_FSSTAT']._serialized_start=1578
+  _globals['_FSSTAT']._serialized_end=1661
+  _globals['_FSSTATMANYREQ']._serialized_start=1663
+  _globals['_FSSTATMANYREQ']._serialized_end=1693
+  _globals['_FSSTATRESULT']._serialized_start=1695
+  _globals['_FSSTATRESULT']._serialized_end=1815
+  _globals['_FSSTATMANYRESP']._serialized_start=1817
+  _globals['_FSSTATMANYRESP']._serialized_end=1875
+  _globals['_FSUSAGE']._serialized_start=1877
+  _globals['_FSUSAGE']._serialized_end=1928
+  _globals['_NVSACTIONREQ']._serialized_start=1931
+  _globals['_NVSACTIONREQ']._serialized_end=2239
+  _globals['_NVSBATCHOP']._serialized_start=2242
+  _globals['_NVSBATCHOP']._serialized_end=2404
+  _globals['_NVSACTIONRESP']._serialized_start=2407
+  _globals['_NVSACTIONRESP']._serialized_end=2584
+  _globals['_NVSBATCHRESP']._serialized_start=2586
+  _globals['_NVSBATCHRESP']._serialized_end=2644
+  _globals['_NVSBATCHRESULT']._serialized_start=2646
+  _globals['_NVSBATCHRESULT']._serialized_end=2737
+  _globals['_NVSENTRIESLIST']._serialized_start=2739
+  _globals['_NVSENTRIESLIST']._serialized_end=2832
+  _globals['_NVSENTRY']._serialized_start=2834
+  _globals['_NVSENTRY']._serialized_end=2913
+  _globals['_NVSVALUE']._serialized_start=2915
+  _globals['_NVSVALUE']._serialized_end=3033
+  _globals['_PACKET']._serialized_start=3036
+  _globals['_PACKET']._serialized_end=3276
+  _globals['_REQUEST']._serialized_start=3279
+  _globals['_REQUEST']._serialized_end=3918
+  _globals['_RESPONSE']._serialized_start=3921
+  _globals['_RESPONSE']._serialized_end=4562
+  _globals['_STARTAPPREQ']._serialized_start=4564
+  _globals['_STARTAPPREQ']._serialized_end=4604
+  _globals['_VERSIONREQ']._serialized_start=4607
+  _globals['_VERSIONREQ']._serialized_end=4756
+  _globals['_VERSIONRESP']._serialized_start=4759
+  _globals['_VERSIONRESP']._serialized_end=4978
+  _globals['_XFERACK']._serialized_start=4980
+  _globals['_XFERACK']._serialized_end=5027
+  _globals['_XFERRESULT']._serialized_start=5029
+  _globals['_XFERRESULT']._serialized_end=5086
+  _globals['_NAK']._serialized_start=5088
+  _globals['_NAK']._serialized_end=5166
+  _globals['_STATSREQ']._serialized_start=5168
+  _globals['_STATSREQ']._serialized_end=5193
+  _globals['_STATS']._serialized_start=5196
+  _globals['_STATS']._serialized_end=5533
+  _globals['_TRACEREQ']._serialized_start=5535
+  _globals['_TRACEREQ']._serialized_end=5576
+  _globals['_TRACEDUMP']._serialized_start=5578
+  _globals['_TRACEDUMP']._serialized_end=5652
+  _globals['_HISTOGRAMREQ']._serialized_start=5654
+  _globals['_HISTOGRAMREQ']._serialized_end=5699
+  _globals['_HISTOGRAM']._serialized_start=5701
+  _globals['_HISTOGRAM']._serialized_end=5808
+  _globals['_HISTOGRAMS']._serialized_start=5810
+  _globals['_HISTOGRAMS']._serialized_end=5897
+  _globals['_BENCHREQ']._serialized_start=5899
+  _globals['_BENCHREQ']._serialized_end=5952
+  _globals['_BENCHRESULT']._serialized_start=5955
+  _globals['_BENCHRESULT']._serialized_end=6224
+  _globals['_ECHOREQ']._serialized_start=6226
+  _globals['_ECHOREQ']._serialized_end=6269
+  _globals['_ECHORESP']._serialized_start=6271
+  _globals['_ECHORESP']._serialized_end=6313
 # @@protoc_insertion_point(module_scope)
@@ -13,15 +13,14 @@ class BadgeUSB:
     REQUEST_MODE_GET       = 0x26
     REQUEST_FW_VERSION_GET = 0x27
 
-    def __init__(self):
+    # Vendor and product ID of the badges, which the udev rule in 60-badgelink.rules gives access to
+    USB_VID = 0x16d0
+    USB_PID = 0x0f9a
+
+    def __init__(self, usb_device = None):
         device = "tanmatsu"
 
-        if os.name == 'nt':
-            from usb.backend import libusb1
-            be = libusb1.get_backend(find_library=lambda x: os.path.dirname(__file__) + "\\libusb-1.0.dll")
-            self.device = usb.core.find(idVendor=0x16d0, idProduct=0x0f9a, backend=be)
-        else:
-            self.device = usb.core.find(idVendor=0x16d0, idProduct=0x0f9a)
+        self.device = usb_device if usb_device is not None else usb.core.find(idVendor=self.USB_VID, idProduct=self.USB_PID, backend=self._backend())
 
         if self.device is None:
             raise FileNotFoundError("Badge not found")
@@ -36,6 +35,22 @@ class BadgeUSB:
         self.request_type_in = usb.util.build_request_type(usb.util.CTRL_IN, usb.util.CTRL_TYPE_CLASS, usb.util.CTRL_RECIPIENT_INTERFACE)
         self.request_type_out = usb.util.build_request_type(usb.util.CTRL_OUT, usb.util.CTRL_TYPE_CLASS, usb.util.CTRL_RECIPIENT_INTERFACE)
 
+    @staticmethod
+    def _backend():
+        if os.name == 'nt':
+            from usb.backend import libusb1
+            return libusb1.get_backend(find_library=lambda x: os.path.dirname(__file__) + "\\libusb-1.0.dll")
+        return None
+
+    @classmethod
+    def find_all(cls):
+        # Open every badge that is connected, for flashing many at once.
+        return [cls(dev) for dev in usb.core.find(find_all=True, idVendor=cls.USB_VID, idProduct=cls.USB_PID, backend=cls._backend())]
+
+    @property
+    def name(self):
+        return f"usb:{self.device.bus}-{self.device.address}"
+
     def flush(self):
         pass
 
@@ -54,3 +69,11 @@ class BadgeUSB:
             except usb.USBError as e:
                 break
         return data
+
+    def read_wait(self, timeout):
+        # Block in libusb until a transfer completes instead of polling.
+        try:
+            return bytes(self.ep_in.read(self.ep_in.wMaxPacketSize * 64, int(timeout * 1000)))
+        except usb.core.USBTimeoutError:
+            return b''
+
@@ -0,0 +1,119 @@
+# SPDX-Copyright-Text: 2025 Julian Scheffers
+# SPDX-License-Identifier: MIT
+
+"""
+LZF compression of chunk data, matching lzf.c in the BadgeLink component.
+"""
+
+MAX_LIT = 32
+MAX_OFF = 1 << 13
+MAX_REF = 7 + 255 + 2
+
+# Maximum amount of data in one frame of a compressed stream.
+FRAME_SIZE   = 4096
+# Flag in the header of a frame that is stored as-is.
+FRAME_STORED = 0x8000
+
+def compress(data: bytes) -> bytes:
+    """
+    Compress data in the LZF format.
+    """
+    out = bytearray()
+    last = {}
+    pos = 0
+    lit = 0
+
+    def literals(end: int):
+        for start in range(lit, end, MAX_LIT):
+            run = data[start:min(start + MAX_LIT, end)]
+            out.append(len(run) - 1)
+            out.extend(run)
+
+    while pos + 2 < len(data):
+        key = data[pos:pos + 3]
+        ref = last.get(key)
+        last[key] = pos
+        if ref is None or pos - ref - 1 >= MAX_OFF:
+            pos += 1
+            continue
+
+        # Extend the match as far as it goes.
+        max_len = min(len(data) - pos, MAX_REF)
+        length = 3
+        while length < max_len and data[ref + length] == data[pos + length]:
+            length += 1
+
+        # Write the literals before it and then the back-reference.
+        literals(pos)
+        off = pos - ref - 1
+        if length - 2 < 7:
+            out.append((length - 2) << 5 | off >> 8)
+        else:
+            out.append(7 << 5 | off >> 8)
+            out.append(length - 2 - 7)
+        out.append(off & 0xff)
+
+        # Remember the positions inside the match as well, so later data can refer back into it.
+        for i in range(pos + 1, min(pos + length, len(data) - 2)):
+            last[data[i:i + 3]] = i
+        pos += length
+        lit = pos
+
+    literals(len(data))
+    return bytes(out)
+
+def decompress(data: bytes) -> bytes:
+    """
+    Decompress LZF data.
+    Raises `ValueError` if the data is malformed.
+    """
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        ctrl = data[pos]
+        pos += 1
+        if ctrl < MAX_LIT:
+            if pos + ctrl + 1 > len(data):
+                raise ValueError("Truncated LZF literal run")
+            out.extend(data[pos:pos + ctrl + 1])
+            pos += ctrl + 1
+            continue
+
+        length = ctrl >> 5
+        if length == 7:
+            if pos >= len(data):
+                raise ValueError("Truncated LZF back-reference")
+            length += data[pos]
+            pos += 1
+        if pos >= len(data):
+            raise ValueError("Truncated LZF back-reference")
+        off = ((ctrl & 0x1f) << 8 | data[pos]) + 1
+        pos += 1
+        if off > len(out):
+            raise ValueError("LZF back-reference out of range")
+        # Copy whole slices; a reference that overlaps its own output repeats the last `off` bytes.
+        length += 2
+        start = len(out) - off
+        if off >= length:
+            out.extend(out[start:start + length])
+        else:
+            out.extend((out[start:] * (length // off + 1))[:length])
+    return bytes(out)
+
+def compress_stream(data: bytes) -> bytes:
+    """
+    Compress data as a stream of frames, like the badge inflates compressed AppFS uploads.
+    Each frame holds up to `FRAME_SIZE` bytes of data and starts with a 2-byte little-endian header:
+    the length of the rest of the frame, plus `FRAME_STORED` if it isn't compressed.
+    """
+    out = bytearray()
+    for pos in range(0, len(data), FRAME_SIZE):
+        raw = data[pos:pos + FRAME_SIZE]
+        frame = compress(raw)
+        if len(frame) < len(raw):
+            out.extend(len(frame).to_bytes(2, "little"))
+            out.extend(frame)
+        else:
+            out.extend((len(raw) | FRAME_STORED).to_bytes(2, "little"))
+            out.extend(raw)
+    return bytes(out)